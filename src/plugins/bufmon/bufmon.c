@@ -1,6 +1,15 @@
 #include <vlib/vlib.h>
+#include <vlib/stats/stats.h>
 #include <vnet/plugin/plugin.h>
 #include <vpp/app/version.h>
+#include <vppinfra/lock.h>
+
+/* nodes remembered per sampled buffer, the most recent ones are kept */
+#define BUFMON_TRAIL_LEN 8
+/* residency histogram buckets, bucket n counts times < 2^n microseconds */
+#define BUFMON_N_BUCKETS 24
+#define BUFMON_DEFAULT_LEAK_THRESHOLD 10.0
+#define BUFMON_SCAN_INTERVAL 1.0
 
 typedef struct
 {
@@ -15,18 +24,185 @@ typedef struct
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   bufmon_per_node_data_t *pnd;
   u32 cur_node;
+  /* buffers still to be allocated before the next sample */
+  u32 n_until_sample;
 } bufmon_per_thread_data_t;
 
+/* a buffer picked for lifetime tracking, from allocation to free */
+typedef struct
+{
+  f64 alloc_time;
+  /* time the buffer was last seen entering a node */
+  f64 last_time;
+  u32 buffer_index;
+  u32 last_node;
+  u32 n_hops;
+  u32 trail[BUFMON_TRAIL_LEN];
+  u16 alloc_thread;
+} bufmon_sample_t;
+
+typedef struct
+{
+  u64 hist[BUFMON_N_BUCKETS];
+  u64 n_samples;
+  f64 sum;
+  f64 max;
+} bufmon_hist_t;
+
 typedef struct
 {
   bufmon_per_thread_data_t *ptd;
   int enabled;
+
+  /* lifetime tracking, one of every sample_interval buffers, 0 is off */
+  u32 sample_interval;
+  f64 leak_threshold;
+  u32 process_node_index;
+
+  /*
+   * bit per buffer index, set on sampled buffers so the per frame check
+   * does not need the lock. The bits are updated atomically as buffers
+   * sharing a word may be owned by different threads.
+   */
+  uword *sampled;
+
+  /* the rest is shared by all threads and protected by the lock */
+  clib_spinlock_t lock;
+  bufmon_sample_t *samples;
+  uword *sample_by_buffer;
+  /* time sampled buffers spent in each node, by node index */
+  bufmon_hist_t *residency;
+  bufmon_hist_t lifetime;
+  u64 n_sampled;
+
+  /* results of the last leak scan, by node index */
+  u32 *leaks_by_node;
+  u32 n_leaks;
+
+  /* stats segment entries */
+  u32 samples_stat_index;
+  u32 leaks_stat_index;
+  /* residency histogram, a counter vector by node index per bucket */
+  u32 *residency_stat_indices;
+  u32 leaks_by_node_stat_index;
+  uword *node_has_symlinks;
 } bufmon_main_t;
 
 static bufmon_main_t bufmon_main;
 
+static_always_inline int
+bufmon_is_sampled (const bufmon_main_t *bm, u32 bi)
+{
+  uword i = bi / uword_bits;
+  return i < vec_len (bm->sampled) &&
+	 (bm->sampled[i] & (1ULL << (bi % uword_bits)));
+}
+
+static void
+bufmon_hist_add (bufmon_hist_t *h, f64 dt)
+{
+  u64 us = dt > 0 ? dt * 1e6 : 0;
+  u32 bucket = us ? min_log2 (us) + 1 : 0;
+
+  h->hist[clib_min (bucket, BUFMON_N_BUCKETS - 1)]++;
+  h->n_samples++;
+  h->sum += dt;
+  h->max = clib_max (h->max, dt);
+}
+
+/* account the time since the buffer was last seen to the node it was in */
+static void
+bufmon_residency_add (bufmon_main_t *bm, bufmon_sample_t *s, f64 now)
+{
+  vec_validate (bm->residency, s->last_node);
+  bufmon_hist_add (vec_elt_at_index (bm->residency, s->last_node),
+		   now - s->last_time);
+}
+
+static void
+bufmon_sample_alloc (vlib_main_t *vm, u32 bi, u32 node_index)
+{
+  bufmon_main_t *bm = &bufmon_main;
+  bufmon_sample_t *s;
+  f64 now = vlib_time_now (vm);
+  uword i = bi / uword_bits;
+
+  if (i >= vec_len (bm->sampled))
+    return;
+
+  clib_spinlock_lock (&bm->lock);
+  /* a buffer freed outside of the pool put path is sampled again */
+  if (bufmon_is_sampled (bm, bi))
+    {
+      uword *p = hash_get (bm->sample_by_buffer, bi);
+      if (p)
+	s = pool_elt_at_index (bm->samples, p[0]);
+      else
+	pool_get (bm->samples, s);
+    }
+  else
+    pool_get (bm->samples, s);
+  clib_memset (s, 0, sizeof (*s));
+  s->buffer_index = bi;
+  s->alloc_time = s->last_time = now;
+  s->alloc_thread = vm->thread_index;
+  s->last_node = s->trail[0] = node_index;
+  s->n_hops = 1;
+  hash_set (bm->sample_by_buffer, bi, s - bm->samples);
+  bm->n_sampled++;
+  clib_spinlock_unlock (&bm->lock);
+
+  clib_atomic_fetch_or (&bm->sampled[i], 1ULL << (bi % uword_bits));
+}
+
+static void
+bufmon_sample_hop (vlib_main_t *vm, u32 bi, u32 node_index)
+{
+  bufmon_main_t *bm = &bufmon_main;
+  bufmon_sample_t *s;
+  f64 now = vlib_time_now (vm);
+  uword *p;
+
+  clib_spinlock_lock (&bm->lock);
+  p = hash_get (bm->sample_by_buffer, bi);
+  if (p)
+    {
+      s = pool_elt_at_index (bm->samples, p[0]);
+      bufmon_residency_add (bm, s, now);
+      s->last_node = node_index;
+      s->last_time = now;
+      s->trail[s->n_hops++ % BUFMON_TRAIL_LEN] = node_index;
+    }
+  clib_spinlock_unlock (&bm->lock);
+}
+
+static void
+bufmon_sample_free (vlib_main_t *vm, u32 bi)
+{
+  bufmon_main_t *bm = &bufmon_main;
+  bufmon_sample_t *s;
+  f64 now = vlib_time_now (vm);
+  uword *p;
+
+  clib_atomic_fetch_and (&bm->sampled[bi / uword_bits],
+			 ~(1ULL << (bi % uword_bits)));
+
+  clib_spinlock_lock (&bm->lock);
+  p = hash_get (bm->sample_by_buffer, bi);
+  if (p)
+    {
+      s = pool_elt_at_index (bm->samples, p[0]);
+      bufmon_residency_add (bm, s, now);
+      bufmon_hist_add (&bm->lifetime, now - s->alloc_time);
+      hash_unset (bm->sample_by_buffer, bi);
+      pool_put (bm->samples, s);
+    }
+  clib_spinlock_unlock (&bm->lock);
+}
+
 static u32
-bufmon_alloc_free_callback (vlib_main_t *vm, u32 n_buffers, const int is_free)
+bufmon_alloc_free_callback (vlib_main_t *vm, u32 *buffers, u32 n_buffers,
+			    const int is_free)
 {
   bufmon_main_t *bm = &bufmon_main;
   bufmon_per_thread_data_t *ptd;
@@ -56,6 +232,23 @@ bufmon_alloc_free_callback (vlib_main_t *vm, u32 n_buffers, const int is_free)
   else
     pnd->alloc += n_buffers;
 
+  if (!bm->sample_interval)
+    return n_buffers;
+
+  if (is_free)
+    {
+      for (u32 i = 0; i < n_buffers; i++)
+	if (PREDICT_FALSE (bufmon_is_sampled (bm, buffers[i])))
+	  bufmon_sample_free (vm, buffers[i]);
+    }
+  else
+    {
+      u32 i = ptd->n_until_sample;
+      for (; i < n_buffers; i += bm->sample_interval)
+	bufmon_sample_alloc (vm, buffers[i], cur_node);
+      ptd->n_until_sample = i - n_buffers;
+    }
+
   return n_buffers;
 }
 
@@ -63,19 +256,21 @@ static u32
 bufmon_alloc_callback (vlib_main_t *vm, u8 buffer_pool_index, u32 *buffers,
 		       u32 n_buffers)
 {
-  return bufmon_alloc_free_callback (vm, n_buffers, 0 /* is_free */);
+  return bufmon_alloc_free_callback (vm, buffers, n_buffers,
+				     0 /* is_free */);
 }
 
 static u32
 bufmon_free_callback (vlib_main_t *vm, u8 buffer_pool_index, u32 *buffers,
 		      u32 n_buffers)
 {
-  return bufmon_alloc_free_callback (vm, n_buffers, 1 /* is_free */);
+  return bufmon_alloc_free_callback (vm, buffers, n_buffers, 1 /* is_free */);
 }
 
 static u32
-bufmon_count_buffers (vlib_main_t *vm, vlib_frame_t *frame)
+bufmon_count_buffers (vlib_main_t *vm, vlib_frame_t *frame, u32 node_index)
 {
+  const bufmon_main_t *bm = &bufmon_main;
   vlib_buffer_t *b[VLIB_FRAME_SIZE];
   u32 *from = vlib_frame_vector_args (frame);
   const u32 n = frame->n_vectors;
@@ -87,10 +282,17 @@ bufmon_count_buffers (vlib_main_t *vm, vlib_frame_t *frame)
   for (i = 0; i < n; i++)
     {
       const vlib_buffer_t *cb = b[i];
-      while (cb->flags & VLIB_BUFFER_NEXT_PRESENT)
+      u32 bi = from[i];
+      while (1)
 	{
+	  /* only frames entering a node record a hop */
+	  if (PREDICT_FALSE (node_index != ~0 && bufmon_is_sampled (bm, bi)))
+	    bufmon_sample_hop (vm, bi, node_index);
+	  if (!(cb->flags & VLIB_BUFFER_NEXT_PRESENT))
+	    break;
 	  nc++;
-	  cb = vlib_get_buffer (vm, cb->next_buffer);
+	  bi = cb->next_buffer;
+	  cb = vlib_get_buffer (vm, bi);
 	}
     }
 
@@ -114,7 +316,7 @@ bufmon_dispatch_wrapper (vlib_main_t *vm, vlib_node_runtime_t *node,
   pnd = vec_elt_at_index (ptd->pnd, node->node_index);
 
   if (frame)
-    pnd->in += bufmon_count_buffers (vm, frame);
+    pnd->in += bufmon_count_buffers (vm, frame, node->node_index);
 
   pending_frames = vec_len (nm->pending_frames);
   ptd->cur_node = node->node_index;
@@ -126,7 +328,8 @@ bufmon_dispatch_wrapper (vlib_main_t *vm, vlib_node_runtime_t *node,
     {
       vlib_pending_frame_t *p =
 	vec_elt_at_index (nm->pending_frames, pending_frames);
-      pnd->out += bufmon_count_buffers (vm, vlib_get_frame (vm, p->frame));
+      pnd->out +=
+	bufmon_count_buffers (vm, vlib_get_frame (vm, p->frame), ~0);
     }
 
   return rv;
@@ -162,18 +365,66 @@ err0:
   return clib_error_return (0, "failed to register callback");
 }
 
+static void
+bufmon_lifetime_reset (bufmon_main_t *bm)
+{
+  clib_spinlock_lock (&bm->lock);
+  pool_free (bm->samples);
+  hash_free (bm->sample_by_buffer);
+  vec_free (bm->residency);
+  clib_memset (&bm->lifetime, 0, sizeof (bm->lifetime));
+  bm->n_sampled = 0;
+  vec_free (bm->leaks_by_node);
+  bm->n_leaks = 0;
+  clib_spinlock_unlock (&bm->lock);
+}
+
+static void
+bufmon_lifetime_enable_disable (vlib_main_t *vm, u32 sample_interval,
+				f64 leak_threshold)
+{
+  bufmon_main_t *bm = &bufmon_main;
+  bufmon_per_thread_data_t *ptd;
+  u32 n_buffer_indices;
+
+  bm->sample_interval = sample_interval;
+  bm->leak_threshold = leak_threshold;
+
+  bufmon_lifetime_reset (bm);
+  clib_bitmap_zero (bm->sampled);
+
+  if (!sample_interval)
+    return;
+
+  n_buffer_indices =
+    vm->buffer_main->buffer_mem_size >> CLIB_LOG2_CACHE_LINE_BYTES;
+  clib_bitmap_validate (bm->sampled, n_buffer_indices);
+
+  vec_foreach (ptd, bm->ptd)
+    ptd->n_until_sample = 0;
+
+  vlib_process_signal_event (vm, bm->process_node_index, 0, 0);
+}
+
 static clib_error_t *
-bufmon_enable_disable (vlib_main_t *vm, int enable)
+bufmon_enable_disable (vlib_main_t *vm, int enable, u32 sample_interval,
+		       f64 leak_threshold)
 {
   bufmon_main_t *bm = &bufmon_main;
 
   if (enable)
     {
+      /* the callbacks must not see the sampling state change */
       if (bm->enabled)
-	return 0;
+	bufmon_unregister_callbacks (vm);
+      bufmon_lifetime_enable_disable (vm, sample_interval, leak_threshold);
       clib_error_t *error = bufmon_register_callbacks (vm);
       if (error)
-	return error;
+	{
+	  bm->enabled = 0;
+	  bufmon_lifetime_enable_disable (vm, 0, 0);
+	  return error;
+	}
       bm->enabled = 1;
     }
   else
@@ -181,17 +432,155 @@ bufmon_enable_disable (vlib_main_t *vm, int enable)
       if (!bm->enabled)
 	return 0;
       bufmon_unregister_callbacks (vm);
+      bufmon_lifetime_enable_disable (vm, 0, 0);
       bm->enabled = 0;
     }
 
   return 0;
 }
 
+/*
+ * Residency histograms are exported with one /bufmon/residency/lt-<2^n>us
+ * vector per bucket, indexed by node, and symlinked per bucket as
+ * /bufmon/nodes/<node>/residency/lt-<2^n>us.
+ */
+static void
+bufmon_update_stats (vlib_main_t *vm, bufmon_main_t *bm,
+		     bufmon_hist_t *residency_by_node, u32 *leaks_by_node,
+		     u32 n_samples, u32 n_leaks)
+{
+  counter_t **residency, **leaks;
+  u32 n_nodes = vec_len (residency_by_node);
+  u32 ni, i;
+
+  vlib_stats_set_gauge (bm->samples_stat_index, n_samples);
+  vlib_stats_set_gauge (bm->leaks_stat_index, n_leaks);
+
+  if (!n_nodes)
+    return;
+
+  vlib_stats_segment_lock ();
+  for (i = 0; i < BUFMON_N_BUCKETS; i++)
+    vlib_stats_validate (bm->residency_stat_indices[i], 0, n_nodes - 1);
+  vlib_stats_validate (bm->leaks_by_node_stat_index, 0, n_nodes - 1);
+  vec_foreach_index (ni, residency_by_node)
+    {
+      if (!residency_by_node[ni].n_samples ||
+	  clib_bitmap_get (bm->node_has_symlinks, ni))
+	continue;
+      vlib_node_t *n = vlib_get_node (vm, ni);
+      vlib_stats_add_histogram_symlinks (bm->residency_stat_indices, ni,
+					 "/bufmon/nodes/%U/residency",
+					 format_vlib_stats_symlink, n->name);
+      vlib_stats_add_symlink (bm->leaks_by_node_stat_index, ni,
+			      "/bufmon/nodes/%U/suspected-leaks",
+			      format_vlib_stats_symlink, n->name);
+      bm->node_has_symlinks = clib_bitmap_set (bm->node_has_symlinks, ni, 1);
+    }
+  vlib_stats_segment_unlock ();
+
+  for (i = 0; i < BUFMON_N_BUCKETS; i++)
+    {
+      residency =
+	vlib_stats_get_entry_data_pointer (bm->residency_stat_indices[i]);
+      vec_foreach_index (ni, residency_by_node)
+	residency[0][ni] = residency_by_node[ni].hist[i];
+    }
+
+  leaks = vlib_stats_get_entry_data_pointer (bm->leaks_by_node_stat_index);
+  vec_foreach_index (ni, residency_by_node)
+    leaks[0][ni] = ni < vec_len (leaks_by_node) ? leaks_by_node[ni] : 0;
+}
+
+/* count the samples alive for longer than the threshold, by last node */
+static void
+bufmon_scan_leaks (vlib_main_t *vm, bufmon_main_t *bm)
+{
+  f64 now = vlib_time_now (vm);
+  bufmon_sample_t *s;
+  bufmon_hist_t *residency;
+  u32 *leaks_by_node, n_samples, n_leaks;
+
+  clib_spinlock_lock (&bm->lock);
+  vec_validate (bm->leaks_by_node, vec_len (bm->residency));
+  vec_zero (bm->leaks_by_node);
+  bm->n_leaks = 0;
+  pool_foreach (s, bm->samples)
+    {
+      if (now - s->alloc_time < bm->leak_threshold)
+	continue;
+      vec_validate (bm->leaks_by_node, s->last_node);
+      bm->leaks_by_node[s->last_node]++;
+      bm->n_leaks++;
+    }
+
+  /* export a copy, workers must not wait on the stats segment lock */
+  residency = vec_dup (bm->residency);
+  leaks_by_node = vec_dup (bm->leaks_by_node);
+  n_samples = pool_elts (bm->samples);
+  n_leaks = bm->n_leaks;
+  clib_spinlock_unlock (&bm->lock);
+
+  bufmon_update_stats (vm, bm, residency, leaks_by_node, n_samples, n_leaks);
+  vec_free (residency);
+  vec_free (leaks_by_node);
+}
+
+static uword
+bufmon_lifetime_process (vlib_main_t *vm, vlib_node_runtime_t *rt,
+			 vlib_frame_t *f)
+{
+  bufmon_main_t *bm = &bufmon_main;
+
+  while (1)
+    {
+      if (bm->sample_interval)
+	vlib_process_wait_for_event_or_clock (vm, BUFMON_SCAN_INTERVAL);
+      else
+	vlib_process_wait_for_event (vm);
+
+      vlib_process_get_events (vm, 0);
+
+      if (bm->sample_interval)
+	bufmon_scan_leaks (vm, bm);
+    }
+
+  return 0;
+}
+
+VLIB_REGISTER_NODE (bufmon_lifetime_process_node) = {
+  .function = bufmon_lifetime_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "bufmon-lifetime-process",
+};
+
+static clib_error_t *
+bufmon_init (vlib_main_t *vm)
+{
+  bufmon_main_t *bm = &bufmon_main;
+
+  clib_spinlock_init (&bm->lock);
+  bm->leak_threshold = BUFMON_DEFAULT_LEAK_THRESHOLD;
+  bm->process_node_index = bufmon_lifetime_process_node.index;
+  bm->samples_stat_index = vlib_stats_add_gauge ("/bufmon/samples");
+  bm->leaks_stat_index = vlib_stats_add_gauge ("/bufmon/suspected-leaks");
+  bm->residency_stat_indices =
+    vlib_stats_add_histogram (BUFMON_N_BUCKETS, "us", "/bufmon/residency");
+  bm->leaks_by_node_stat_index =
+    vlib_stats_add_counter_vector ("/bufmon/suspected-leaks-by-node");
+
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (bufmon_init);
+
 static clib_error_t *
 set_buffer_traces (vlib_main_t *vm, unformat_input_t *input,
 		   vlib_cli_command_t *cmd)
 {
   unformat_input_t _line_input, *line_input = &_line_input;
+  f64 leak_threshold = BUFMON_DEFAULT_LEAK_THRESHOLD;
+  u32 sample_interval = 0;
   int on = 1;
 
   if (unformat_user (input, unformat_line_input, line_input))
@@ -202,6 +591,11 @@ set_buffer_traces (vlib_main_t *vm, unformat_input_t *input,
 	    on = 1;
 	  else if (unformat (line_input, "off"))
 	    on = 0;
+	  else if (unformat (line_input, "sample %u", &sample_interval))
+	    ;
+	  else if (unformat (line_input, "leak-threshold %f",
+			     &leak_threshold))
+	    ;
 	  else
 	    {
 	      unformat_free (line_input);
@@ -212,12 +606,13 @@ set_buffer_traces (vlib_main_t *vm, unformat_input_t *input,
       unformat_free (line_input);
     }
 
-  return bufmon_enable_disable (vm, on);
+  return bufmon_enable_disable (vm, on, sample_interval, leak_threshold);
 }
 
 VLIB_CLI_COMMAND (set_buffer_traces_command, static) = {
   .path = "set buffer traces",
-  .short_help = "set buffer traces [on|off]",
+  .short_help = "set buffer traces [on|off] [sample <n>] "
+		"[leak-threshold <seconds>]",
   .function = set_buffer_traces,
 };
 
@@ -286,6 +681,140 @@ VLIB_CLI_COMMAND (show_buffer_traces_command, static) = {
   .function = show_buffer_traces,
 };
 
+static u8 *
+format_bufmon_sample (u8 *s, va_list *args)
+{
+  vlib_main_t *vm = va_arg (*args, vlib_main_t *);
+  bufmon_sample_t *bs = va_arg (*args, bufmon_sample_t *);
+  f64 now = va_arg (*args, f64);
+  u32 i, first;
+
+  s = format (s, "%10u%12.3f%8u  ", bs->buffer_index, now - bs->alloc_time,
+	      bs->alloc_thread);
+
+  first = bs->n_hops > BUFMON_TRAIL_LEN ? bs->n_hops - BUFMON_TRAIL_LEN : 0;
+  if (first)
+    s = format (s, "... ");
+  for (i = first; i < bs->n_hops; i++)
+    s = format (s, "%s%U", i == first ? "" : " -> ", format_vlib_node_name,
+		vm, bs->trail[i % BUFMON_TRAIL_LEN]);
+
+  return s;
+}
+
+static u8 *
+format_bufmon_hist (u8 *s, va_list *args)
+{
+  bufmon_hist_t *h = va_arg (*args, bufmon_hist_t *);
+  u32 indent = format_get_indent (s);
+  int first = 1;
+  u32 i;
+
+  for (i = 0; i < BUFMON_N_BUCKETS; i++)
+    {
+      if (!h->hist[i])
+	continue;
+      if (!first)
+	s = format (s, "\n%U", format_white_space, indent);
+      s = format (s, "< %8lluus: %llu", 1ULL << i, h->hist[i]);
+      first = 0;
+    }
+
+  return s;
+}
+
+static clib_error_t *
+show_buffer_lifetime (vlib_main_t *vm, unformat_input_t *input,
+		      vlib_cli_command_t *cmd)
+{
+  bufmon_main_t *bm = &bufmon_main;
+  bufmon_sample_t *bs, *leaks = 0;
+  int verbose = 0, show_leaks = 0;
+  f64 now = vlib_time_now (vm);
+  u32 max = 32;
+  bufmon_hist_t *h;
+  u32 ni;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "verbose"))
+	verbose = 1;
+      else if (unformat (input, "leaks"))
+	show_leaks = 1;
+      else if (unformat (input, "max %u", &max))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (!bm->sample_interval)
+    {
+      vlib_cli_output (vm, "buffer lifetime tracking is off");
+      return 0;
+    }
+
+  clib_spinlock_lock (&bm->lock);
+
+  vlib_cli_output (vm,
+		   "sampling 1 in %u buffers, %llu sampled, %u alive, "
+		   "%u alive for more than %.2fs",
+		   bm->sample_interval, bm->n_sampled, pool_elts (bm->samples),
+		   bm->n_leaks, bm->leak_threshold);
+  if (bm->lifetime.n_samples)
+    vlib_cli_output (vm, "lifetime: avg %.2fus max %.2fus",
+		     bm->lifetime.sum / bm->lifetime.n_samples * 1e6,
+		     bm->lifetime.max * 1e6);
+  if (verbose && bm->lifetime.n_samples)
+    vlib_cli_output (vm, "  %U", format_bufmon_hist, &bm->lifetime);
+
+  vlib_cli_output (vm, "\n%30s%16s%16s%16s%16s", "Node", "Samples",
+		   "Avg-us", "Max-us", "Suspected-leaks");
+  vec_foreach_index (ni, bm->residency)
+    {
+      u32 n_leaks =
+	ni < vec_len (bm->leaks_by_node) ? bm->leaks_by_node[ni] : 0;
+      h = vec_elt_at_index (bm->residency, ni);
+      if (!h->n_samples && !n_leaks)
+	continue;
+      vlib_cli_output (vm, "%30U%16llu%16.2f%16.2f%16u",
+		       format_vlib_node_name, vm, ni, h->n_samples,
+		       h->n_samples ? h->sum / h->n_samples * 1e6 : 0,
+		       h->max * 1e6, n_leaks);
+      if (verbose && h->n_samples)
+	vlib_cli_output (vm, "%32s%U", "", format_bufmon_hist, h);
+    }
+
+  /* copy out, formatting node names must not be done under the lock */
+  if (show_leaks)
+    pool_foreach (bs, bm->samples)
+      {
+	if (vec_len (leaks) >= max)
+	  break;
+	if (now - bs->alloc_time >= bm->leak_threshold)
+	  vec_add1 (leaks, *bs);
+      }
+
+  clib_spinlock_unlock (&bm->lock);
+
+  if (show_leaks)
+    {
+      vlib_cli_output (vm, "\n%10s%12s%8s  %s", "Buffer", "Age-s", "Thread",
+		       "Nodes");
+      vec_foreach (bs, leaks)
+	vlib_cli_output (vm, "%U", format_bufmon_sample, vm, bs, now);
+      vec_free (leaks);
+    }
+
+  return 0;
+}
+
+VLIB_CLI_COMMAND (show_buffer_lifetime_command, static) = {
+  .path = "show buffer lifetime",
+  .short_help = "show buffer lifetime [verbose] [leaks] [max <n>]",
+  .function = show_buffer_lifetime,
+};
+
 static clib_error_t *
 clear_buffer_traces (vlib_main_t *vm, unformat_input_t *input,
 		     vlib_cli_command_t *cmd)
@@ -298,6 +827,13 @@ clear_buffer_traces (vlib_main_t *vm, unformat_input_t *input,
     vec_foreach (pnd, ptd->pnd)
       vec_reset_length (pnd);
 
+  /* samples still alive are kept, they are needed to spot leaks */
+  clib_spinlock_lock (&bufmon_main.lock);
+  vec_zero (bufmon_main.residency);
+  clib_memset (&bufmon_main.lifetime, 0, sizeof (bufmon_main.lifetime));
+  bufmon_main.n_sampled = 0;
+  clib_spinlock_unlock (&bufmon_main.lock);
+
   return 0;
 }
 
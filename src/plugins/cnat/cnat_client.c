@@ -15,6 +15,7 @@
 
 #include <vnet/fib/fib_table.h>
 #include <vnet/dpo/drop_dpo.h>
+#include <vlibmemory/api.h>
 
 #include <cnat/cnat_client.h>
 #include <cnat/cnat_translation.h>
@@ -53,6 +54,20 @@ cnat_client_destroy (cnat_client_t * cc)
   pool_put (cnat_client_pool, cc);
 }
 
+static void
+cnat_client_destroy_if_unused (ip_address_t *addr)
+{
+  cnat_client_t *cc;
+
+  cc = (AF_IP4 == addr->version ? cnat_client_ip4_find (&ip_addr_v4 (addr)) :
+				  cnat_client_ip6_find (&ip_addr_v6 (addr)));
+
+  /* a session or a translation may have taken it while the RPC was queued */
+  if (NULL != cc && 0 == cc->tr_refcnt &&
+      0 == cnat_client_get (cc->parent_cci)->session_refcnt)
+    cnat_client_destroy (cc);
+}
+
 void
 cnat_client_free_by_ip (ip46_address_t * ip, u8 af)
 {
@@ -62,7 +77,20 @@ cnat_client_free_by_ip (ip46_address_t * ip, u8 af)
   ASSERT (NULL != cc);
 
   if (0 == cnat_client_uncnt_session (cc) && 0 == cc->tr_refcnt)
-    cnat_client_destroy (cc);
+    {
+      ip_address_t addr;
+
+      /* sessions are expired on their workers, the DB belongs to main */
+      if (0 == vlib_get_thread_index ())
+	{
+	  cnat_client_destroy (cc);
+	  return;
+	}
+      ip_address_set (&addr, (AF_IP4 == af ? (void *) &ip->ip4 : &ip->ip6),
+		      af);
+      vl_api_rpc_call_main_thread (cnat_client_destroy_if_unused, (u8 *) &addr,
+				   sizeof (addr));
+    }
 }
 
 void
@@ -188,11 +216,29 @@ void
 cnat_client_learn (const ip_address_t *addr)
 {
   /* RPC call to add a client from the dataplane */
+  ip_address_t *learn = NULL, *a;
   index_t cci;
   cnat_client_t *cc;
-  cci = cnat_client_add (addr, 0 /* flags */);
-  cc = pool_elt_at_index (cnat_client_pool, cci);
-  cnat_client_cnt_session (cc);
+  u32 refcnt;
+
+  /* addresses throttled from now on need a new RPC */
+  clib_atomic_store_rel_n (&cnat_client_db.learn_pending, 0);
+
+  /* one RPC learns all the clients throttled so far, addr among them.
+   * The first session of each was not counted */
+  clib_spinlock_lock (&cnat_client_db.throttle_lock);
+  hash_foreach_mem (a, refcnt, cnat_client_db.throttle_mem,
+		    { vec_add1 (learn, *a); });
+  clib_spinlock_unlock (&cnat_client_db.throttle_lock);
+
+  vec_foreach (a, learn)
+    {
+      cci = cnat_client_add (a, 0 /* flags */);
+      cc = pool_elt_at_index (cnat_client_pool, cci);
+      cnat_client_cnt_session (cc);
+    }
+  vec_free (learn);
+
   /* Process throttled calls if any */
   cnat_client_throttle_pool_process ();
 }
@@ -272,7 +318,9 @@ static clib_error_t *
 cnat_client_show (vlib_main_t * vm,
 		  unformat_input_t * input, vlib_cli_command_t * cmd)
 {
+  cnat_per_thread_data_t *ptd;
   index_t cci;
+  uword n_ts;
 
   cci = INDEX_INVALID;
 
@@ -291,7 +339,10 @@ cnat_client_show (vlib_main_t * vm,
         vlib_cli_output(vm, "%U", format_cnat_client, cci, 0);
 
       vlib_cli_output (vm, "%d clients", pool_elts (cnat_client_pool));
-      vlib_cli_output (vm, "%d timestamps", pool_elts (cnat_timestamps));
+      n_ts = pool_elts (cnat_timestamps);
+      vec_foreach (ptd, cnat_main.per_thread_data)
+	n_ts -= vec_len (ptd->ts_cache);
+      vlib_cli_output (vm, "%wd timestamps", n_ts);
     }
   else
     {
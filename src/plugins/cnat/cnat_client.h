@@ -104,7 +104,7 @@ extern void cnat_client_translation_deleted (index_t cci);
 extern void cnat_client_translation_added (index_t cci);
 /**
  * Called in the main thread by RPC from the workers to learn a
- * new client
+ * new client, along with the other clients throttled meanwhile
  */
 extern void cnat_client_learn (const ip_address_t *addr);
 
@@ -139,6 +139,9 @@ typedef struct cnat_client_db_t_
      cnat_client_free_by_ip */
   clib_spinlock_t throttle_lock;
   uword *throttle_mem;
+  /* A learn RPC is on its way to the main thread, no need for
+     another one to learn a throttled address */
+  u8 learn_pending;
 } cnat_client_db_t;
 
 extern cnat_client_db_t cnat_client_db;
@@ -19,30 +19,126 @@
 
 #include <cnat/cnat_types.h>
 
+/* the session timer wheels have a single ring of 2048 slots */
+#define CNAT_EXPIRY_MAX_TICKS 2047
+
+/**
+ * Timer wheel ticks after which to check a session expiring in t
+ * seconds. A timestamp's lifetime may be shortened on another thread
+ * than the owner of its timer, so never wait for longer than the
+ * default session lifetime before checking again.
+ */
+always_inline u32
+cnat_expiry_ticks (f64 t)
+{
+  cnat_main_t *cm = &cnat_main;
+  u32 ticks;
+
+  t = clib_min (t, (f64) cm->session_max_age);
+  ticks = (u32) (t / cm->scanner_timeout) + 1;
+  return clib_min (ticks, CNAT_EXPIRY_MAX_TICKS);
+}
+
+/**
+ * Take a timestamp from the calling thread's cache, refilling it from
+ * the pool a batch at a time. Cached timestamps are allocated in the
+ * pool with no reference and no owner.
+ */
 always_inline u32
 cnat_timestamp_new (f64 t)
 {
-  u32 index;
+  cnat_per_thread_data_t *ptd;
   cnat_timestamp_t *ts;
-  clib_rwlock_writer_lock (&cnat_main.ts_lock);
-  pool_get (cnat_timestamps, ts);
+  u32 index, i;
+
+  ptd = vec_elt_at_index (cnat_main.per_thread_data, vlib_get_thread_index ());
+  if (PREDICT_FALSE (0 == vec_len (ptd->ts_cache)))
+    {
+      clib_rwlock_writer_lock (&cnat_main.ts_lock);
+      for (i = 0; i < CNAT_TIMESTAMP_CACHE_BATCH; i++)
+	{
+	  pool_get (cnat_timestamps, ts);
+	  ts->refcnt = 0;
+	  ts->thread_index = ~0;
+	  ts->timer_handle = ~0;
+	  vec_add1 (ptd->ts_cache, ts - cnat_timestamps);
+	}
+      clib_rwlock_writer_unlock (&cnat_main.ts_lock);
+    }
+  index = vec_pop (ptd->ts_cache);
+
+  clib_rwlock_reader_lock (&cnat_main.ts_lock);
+  ts = pool_elt_at_index (cnat_timestamps, index);
   ts->last_seen = t;
   ts->lifetime = cnat_main.session_max_age;
   ts->refcnt = CNAT_TIMESTAMP_INIT_REFCNT;
-  index = ts - cnat_timestamps;
-  clib_rwlock_writer_unlock (&cnat_main.ts_lock);
+  clib_rwlock_reader_unlock (&cnat_main.ts_lock);
   return index;
 }
 
+/**
+ * Return a timestamp with no reference, owner nor timer to the calling
+ * thread's cache, or to the pool when the cache is full.
+ */
+always_inline void
+cnat_timestamp_put (u32 index)
+{
+  cnat_per_thread_data_t *ptd;
+
+  ptd = vec_elt_at_index (cnat_main.per_thread_data, vlib_get_thread_index ());
+  if (vec_len (ptd->ts_cache) < CNAT_TIMESTAMP_CACHE_MAX)
+    {
+      vec_add1 (ptd->ts_cache, index);
+      return;
+    }
+  clib_rwlock_writer_lock (&cnat_main.ts_lock);
+  pool_put_index (cnat_timestamps, index);
+  clib_rwlock_writer_unlock (&cnat_main.ts_lock);
+}
+
+/**
+ * Start expiring the sessions of a timestamp on the calling thread,
+ * once they are in the session DB. cs_key is the forward session key,
+ * rsession_location where the return session is matched.
+ */
+always_inline void
+cnat_timestamp_start_expiry (u32 index, const u64 *cs_key,
+			     u8 rsession_location,
+			     u32 thread_index)
+{
+  cnat_per_thread_data_t *ptd;
+  cnat_timestamp_t *ts;
+
+  ptd = vec_elt_at_index (cnat_main.per_thread_data, thread_index);
+  clib_rwlock_reader_lock (&cnat_main.ts_lock);
+  ts = pool_elt_at_index (cnat_timestamps, index);
+  clib_memcpy_fast (ts->cs_key, cs_key, sizeof (ts->cs_key));
+  ts->rsession_loc = rsession_location;
+  ts->thread_index = thread_index;
+  ts->timer_handle = tw_timer_start_2t_1w_2048sl (
+    &ptd->tw, index, 0 /* timer id */, cnat_expiry_ticks (ts->lifetime));
+  clib_rwlock_reader_unlock (&cnat_main.ts_lock);
+}
+
 always_inline void
 cnat_timestamp_inc_refcnt (u32 index)
 {
   clib_rwlock_reader_lock (&cnat_main.ts_lock);
   cnat_timestamp_t *ts = pool_elt_at_index (cnat_timestamps, index);
-  ts->refcnt++;
+  clib_atomic_add_fetch (&ts->refcnt, 1);
   clib_rwlock_reader_unlock (&cnat_main.ts_lock);
 }
 
+/**
+ * Prefetch a timestamp about to be refreshed. No lock, a stale pool
+ * only makes for a useless prefetch.
+ */
+always_inline void
+cnat_timestamp_prefetch (u32 index)
+{
+  clib_prefetch_store (cnat_timestamps + index);
+}
+
 always_inline void
 cnat_timestamp_update (u32 index, f64 t)
 {
@@ -57,6 +153,12 @@ cnat_timestamp_set_lifetime (u32 index, u16 lifetime)
 {
   clib_rwlock_reader_lock (&cnat_main.ts_lock);
   cnat_timestamp_t *ts = pool_elt_at_index (cnat_timestamps, index);
+  /* the owner of the timer can bring the expiry forward right away */
+  if (lifetime < ts->lifetime && ts->timer_handle != ~0 &&
+      ts->thread_index == vlib_get_thread_index ())
+    tw_timer_update_2t_1w_2048sl (
+      &cnat_main.per_thread_data[ts->thread_index].tw, ts->timer_handle,
+      cnat_expiry_ticks (lifetime));
   ts->lifetime = lifetime;
   clib_rwlock_reader_unlock (&cnat_main.ts_lock);
 }
@@ -74,17 +176,68 @@ cnat_timestamp_exp (u32 index)
   return t;
 }
 
+/**
+ * Drop a reference. The timer of the last reference is stopped here by
+ * its owner thread, or with the workers stopped. Otherwise the timestamp
+ * is queued to the owner, which stops the timer the next time it expires
+ * sessions, as a timer wheel is only ever used by one thread.
+ */
 always_inline void
 cnat_timestamp_free (u32 index)
 {
+  cnat_per_thread_data_t *ptd;
+  cnat_timestamp_t *ts;
+  u32 owner = ~0;
+  u16 refcnt;
+
   if (INDEX_INVALID == index)
     return;
-  clib_rwlock_writer_lock (&cnat_main.ts_lock);
-  cnat_timestamp_t *ts = pool_elt_at_index (cnat_timestamps, index);
-  ts->refcnt--;
-  if (0 == ts->refcnt)
-    pool_put (cnat_timestamps, ts);
-  clib_rwlock_writer_unlock (&cnat_main.ts_lock);
+  clib_rwlock_reader_lock (&cnat_main.ts_lock);
+  ts = pool_elt_at_index (cnat_timestamps, index);
+  refcnt = clib_atomic_sub_fetch (&ts->refcnt, 1);
+  if (0 == refcnt)
+    {
+      if (ts->timer_handle != ~0 &&
+	  ts->thread_index != vlib_get_thread_index () &&
+	  !vlib_worker_thread_barrier_held ())
+	owner = ts->thread_index;
+      else
+	{
+	  if (ts->timer_handle != ~0)
+	    tw_timer_stop_2t_1w_2048sl (
+	      &cnat_main.per_thread_data[ts->thread_index].tw,
+	      ts->timer_handle);
+	  ts->thread_index = ~0;
+	  ts->timer_handle = ~0;
+	}
+    }
+  clib_rwlock_reader_unlock (&cnat_main.ts_lock);
+
+  if (0 != refcnt)
+    return;
+
+  if (~0 == owner)
+    {
+      cnat_timestamp_put (index);
+      return;
+    }
+
+  ptd = vec_elt_at_index (cnat_main.per_thread_data, owner);
+  clib_spinlock_lock (&ptd->ts_free_lock);
+  vec_add1 (ptd->ts_to_free, index);
+  clib_spinlock_unlock (&ptd->ts_free_lock);
+}
+
+/**
+ * Free a timestamp whose sessions never made it to the session DB
+ */
+always_inline void
+cnat_timestamp_abort (u32 index)
+{
+  clib_rwlock_reader_lock (&cnat_main.ts_lock);
+  cnat_timestamps[index].refcnt = 0;
+  clib_rwlock_reader_unlock (&cnat_main.ts_lock);
+  cnat_timestamp_put (index);
 }
 
 /*
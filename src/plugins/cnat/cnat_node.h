@@ -879,7 +879,10 @@ retry_add_ression:
   if (rv)
     {
       if (!(rsession_flags & CNAT_SESSION_RETRY_SNAT))
-	return;
+	{
+	  cnat_timestamp_abort (session->value.cs_ts_index);
+	  return;
+	}
 
       /* return session add failed pick an new random src port */
       rsession->value.cs_port[VLIB_TX] = session->key.cs_port[VLIB_RX] =
@@ -890,11 +893,14 @@ retry_add_ression:
 	{
 	  clib_warning ("Could not find a free port after 100 tries");
 	  /* translate this packet, but don't create state */
+	  cnat_timestamp_abort (session->value.cs_ts_index);
 	  return;
 	}
     }
 
   cnat_bihash_add_del (&cnat_session_db, bkey, 1 /* add */);
+  cnat_timestamp_start_expiry (session->value.cs_ts_index, bkey->key,
+			       rsession_location, ctx->thread_index);
 
   if (!(rsession_flags & CNAT_SESSION_FLAG_NO_CLIENT))
     {
@@ -926,8 +932,10 @@ retry_add_ression:
 
 	  clib_spinlock_unlock (&cnat_client_db.throttle_lock);
 
-	  /* fire client create to the main thread */
-	  if (!p)
+	  /* fire client create to the main thread, unless one is on its
+	   * way already and will learn this address too */
+	  if (!p &&
+	      !clib_atomic_swap_acq_n (&cnat_client_db.learn_pending, 1))
 	    vl_api_rpc_call_main_thread (cnat_client_learn, (u8 *) &addr,
 					 sizeof (addr));
 	}
@@ -991,22 +999,31 @@ cnat_node_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 
       rv[3] = cnat_bihash_search_i2_hash (&cnat_session_db, hash[3], &bkey[3],
 					  &bvalue[3]);
-      session[3] = (cnat_session_t *) (rv[3] ? &bkey[3] : &bvalue[3]);
-      next[3] = cnat_sub (vm, node, b[3], &ctx, rv[3], session[3]);
-
       rv[2] = cnat_bihash_search_i2_hash (&cnat_session_db, hash[2], &bkey[2],
 					  &bvalue[2]);
-      session[2] = (cnat_session_t *) (rv[2] ? &bkey[2] : &bvalue[2]);
-      next[2] = cnat_sub (vm, node, b[2], &ctx, rv[2], session[2]);
-
       rv[1] = cnat_bihash_search_i2_hash (&cnat_session_db, hash[1], &bkey[1],
 					  &bvalue[1]);
-      session[1] = (cnat_session_t *) (rv[1] ? &bkey[1] : &bvalue[1]);
-      next[1] = cnat_sub (vm, node, b[1], &ctx, rv[1], session[1]);
-
       rv[0] = cnat_bihash_search_i2_hash (&cnat_session_db, hash[0], &bkey[0],
 					  &bvalue[0]);
+
+      session[3] = (cnat_session_t *) (rv[3] ? &bkey[3] : &bvalue[3]);
+      session[2] = (cnat_session_t *) (rv[2] ? &bkey[2] : &bvalue[2]);
+      session[1] = (cnat_session_t *) (rv[1] ? &bkey[1] : &bvalue[1]);
       session[0] = (cnat_session_t *) (rv[0] ? &bkey[0] : &bvalue[0]);
+
+      /* the hits all refresh their timestamp */
+      if (!rv[3])
+	cnat_timestamp_prefetch (session[3]->value.cs_ts_index);
+      if (!rv[2])
+	cnat_timestamp_prefetch (session[2]->value.cs_ts_index);
+      if (!rv[1])
+	cnat_timestamp_prefetch (session[1]->value.cs_ts_index);
+      if (!rv[0])
+	cnat_timestamp_prefetch (session[0]->value.cs_ts_index);
+
+      next[3] = cnat_sub (vm, node, b[3], &ctx, rv[3], session[3]);
+      next[2] = cnat_sub (vm, node, b[2], &ctx, rv[2], session[2]);
+      next[1] = cnat_sub (vm, node, b[1], &ctx, rv[1], session[1]);
       next[0] = cnat_sub (vm, node, b[0], &ctx, rv[0], session[0]);
 
       cnat_session_make_key (b[7], af, cs_loc, &bkey[3]);
@@ -247,6 +247,92 @@ VLIB_REGISTER_NODE (cnat_vip_ip6_node) =
   },
 };
 
+static clib_error_t *
+cnat_session_create_test (vlib_main_t *vm, unformat_input_t *input,
+			  vlib_cli_command_t *cmd)
+{
+  cnat_node_ctx_t ctx = { 0, vm->thread_index, AF_IP4, 0 };
+  cnat_bihash_kv_t bkey, bvalue;
+  cnat_session_t *session = (cnat_session_t *) &bkey;
+  u32 n_sessions = 100000, n_created = 0, i;
+  u64 t0, create_clocks, free_clocks;
+  f64 spc = vm->clib_time.seconds_per_clock;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "count %u", &n_sessions))
+	;
+      else
+	return (clib_error_return (0, "unknown input '%U'",
+				   format_unformat_error, input));
+    }
+
+  /* UDP flows from 198.18.0.0/16 to the backend 198.19.255.254 */
+  clib_memset (&bkey, 0, sizeof (bkey));
+  session->key.cs_proto = IP_PROTOCOL_UDP;
+  session->key.cs_loc = CNAT_LOCATION_FIB;
+  session->key.cs_af = AF_IP4;
+  session->key.cs_port[VLIB_RX] = clib_host_to_net_u16 (1000);
+  session->key.cs_port[VLIB_TX] = clib_host_to_net_u16 (53);
+  session->key.cs_ip[VLIB_TX].ip4.as_u32 = clib_host_to_net_u32 (0xc613fffe);
+  session->value.cs_ip[VLIB_TX] = session->key.cs_ip[VLIB_TX];
+  session->value.cs_port[VLIB_RX] = session->key.cs_port[VLIB_RX];
+  session->value.cs_port[VLIB_TX] = session->key.cs_port[VLIB_TX];
+
+  ctx.now = vlib_time_now (vm);
+  t0 = clib_cpu_time_now ();
+  for (i = 0; i < n_sessions; i++)
+    {
+      session->key.cs_ip[VLIB_RX].ip4.as_u32 =
+	clib_host_to_net_u32 (0xc6120000 + (i & 0xffff));
+      session->key.cs_port[VLIB_RX] = clib_host_to_net_u16 (1000 + (i >> 16));
+      if (!cnat_bihash_search_i2 (&cnat_session_db, &bkey, &bvalue))
+	continue;
+
+      session->value.cs_ip[VLIB_RX] = session->key.cs_ip[VLIB_RX];
+      session->value.cs_port[VLIB_RX] = session->key.cs_port[VLIB_RX];
+      session->value.cs_lbi = INDEX_INVALID;
+      /* no VIP nor source client to refcount */
+      session->value.flags = CNAT_SESSION_FLAG_NO_CLIENT;
+      cnat_session_create (session, &ctx, CNAT_LOCATION_FIB,
+			   CNAT_SESSION_FLAG_NO_CLIENT);
+      n_created++;
+    }
+  create_clocks = clib_cpu_time_now () - t0;
+
+  t0 = clib_cpu_time_now ();
+  for (i = 0; i < n_sessions; i++)
+    {
+      session->key.cs_ip[VLIB_RX].ip4.as_u32 =
+	clib_host_to_net_u32 (0xc6120000 + (i & 0xffff));
+      session->key.cs_port[VLIB_RX] = clib_host_to_net_u16 (1000 + (i >> 16));
+      if (cnat_bihash_search_i2 (&cnat_session_db, &bkey, &bvalue))
+	continue;
+      cnat_reverse_session_free ((cnat_session_t *) &bvalue,
+				 CNAT_LOCATION_FIB);
+      cnat_session_free ((cnat_session_t *) &bvalue);
+    }
+  free_clocks = clib_cpu_time_now () - t0;
+
+  if (0 == n_created)
+    return (clib_error_return (0, "no session created"));
+
+  vlib_cli_output (vm, "%u sessions created and freed", n_created);
+  vlib_cli_output (vm, "  create: %.0f clocks/session, %.2f Msessions/s",
+		   (f64) create_clocks / n_created,
+		   n_created / (create_clocks * spc) * 1e-6);
+  vlib_cli_output (vm, "  free: %.0f clocks/session, %.2f Msessions/s",
+		   (f64) free_clocks / n_created,
+		   n_created / (free_clocks * spc) * 1e-6);
+  return (NULL);
+}
+
+VLIB_CLI_COMMAND (cnat_session_create_test_cmd, static) = {
+  .path = "test cnat session-create",
+  .short_help = "test cnat session-create [count <n>]",
+  .function = cnat_session_create_test,
+};
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
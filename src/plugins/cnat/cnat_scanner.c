@@ -16,36 +16,83 @@
 #include <cnat/cnat_session.h>
 #include <cnat/cnat_client.h>
 
+/**
+ * Session expiry on the workers, bounded per dispatch. Each worker
+ * expires the sessions it created. The node is interrupted by the
+ * scanner process once per timer wheel tick, and by itself while it
+ * has a backlog, so idle workers are left alone.
+ */
+static uword
+cnat_session_expire_node_fn (vlib_main_t *vm, vlib_node_runtime_t *node,
+			     vlib_frame_t *frame)
+{
+  u32 n;
+
+  n = cnat_session_expire (vm, vlib_time_now (vm), CNAT_SESSION_EXPIRE_BATCH);
+  if (n == CNAT_SESSION_EXPIRE_BATCH)
+    vlib_node_set_interrupt_pending (vm, node->node_index);
+  return 0;
+}
+
+VLIB_REGISTER_NODE (cnat_session_expire_node) = {
+  .function = cnat_session_expire_node_fn,
+  .name = "cnat-session-expire",
+  .type = VLIB_NODE_TYPE_INPUT,
+  .state = VLIB_NODE_STATE_DISABLED,
+};
+
+static void
+cnat_session_expire_enable_disable (vlib_main_t *vm, int enable)
+{
+  vlib_node_state_t state;
+
+  state = enable ? VLIB_NODE_STATE_INTERRUPT : VLIB_NODE_STATE_DISABLED;
+
+  vlib_worker_thread_barrier_sync (vm);
+  foreach_vlib_main ()
+    {
+      /* the main thread expires its sessions from the process below */
+      if (this_vlib_main->thread_index)
+	vlib_node_set_state (this_vlib_main, cnat_session_expire_node.index,
+			     state);
+    }
+  vlib_worker_thread_barrier_release (vm);
+}
+
 static uword
 cnat_scanner_process (vlib_main_t * vm,
 		      vlib_node_runtime_t * rt, vlib_frame_t * f)
 {
   uword event_type, *event_data = 0;
   cnat_main_t *cm = &cnat_main;
-  f64 start_time;
-  int enabled = 0, i = 0;
+  int enabled = 0;
+  f64 timeout;
+  u32 n;
 
+  timeout = cm->scanner_timeout;
   while (1)
     {
       if (enabled)
-	vlib_process_wait_for_event_or_clock (vm, cm->scanner_timeout);
+	vlib_process_wait_for_event_or_clock (vm, timeout);
       else
 	vlib_process_wait_for_event (vm);
 
       event_type = vlib_process_get_events (vm, &event_data);
       vec_reset_length (event_data);
 
-      start_time = vlib_time_now (vm);
-
       switch (event_type)
 	{
 	  /* timer expired */
 	case ~0:
 	  break;
 	case CNAT_SCANNER_OFF:
+	  if (enabled)
+	    cnat_session_expire_enable_disable (vm, 0);
 	  enabled = 0;
 	  break;
 	case CNAT_SCANNER_ON:
+	  if (!enabled)
+	    cnat_session_expire_enable_disable (vm, 1);
 	  enabled = 1;
 	  break;
 	default:
@@ -53,7 +100,17 @@ cnat_scanner_process (vlib_main_t * vm,
 	}
 
       cnat_client_throttle_pool_process ();
-      i = cnat_session_scan (vm, start_time, i);
+
+      if (enabled)
+	foreach_vlib_main ()
+	  if (this_vlib_main->thread_index)
+	    vlib_node_set_interrupt_pending (this_vlib_main,
+					     cnat_session_expire_node.index);
+
+      /* come back soon while the main thread has a backlog */
+      n = cnat_session_expire (vm, vlib_time_now (vm),
+			       CNAT_SESSION_EXPIRE_BATCH);
+      timeout = (n == CNAT_SESSION_EXPIRE_BATCH ? 1e-4 : cm->scanner_timeout);
     }
   return 0;
 }
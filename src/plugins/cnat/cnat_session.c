@@ -116,6 +116,7 @@ static clib_error_t *
 cnat_session_show (vlib_main_t * vm,
 		   unformat_input_t * input, vlib_cli_command_t * cmd)
 {
+  cnat_per_thread_data_t *ptd;
   u8 verbose = 0;
   while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
     {
@@ -130,6 +131,14 @@ cnat_session_show (vlib_main_t * vm,
 		   vlib_time_now (vm),
 		   BV (format_bihash), &cnat_session_db, verbose);
 
+  vlib_cli_output (vm, "Session expiry:");
+  vec_foreach (ptd, cnat_main.per_thread_data)
+    vlib_cli_output (
+      vm, "  [%d] expired:%lu restarted:%lu pending:%u lag avg:%.3fs max:%.3fs",
+      ptd - cnat_main.per_thread_data, ptd->n_expired, ptd->n_restarted,
+      vec_len (ptd->expired),
+      ptd->n_expired ? ptd->lag_sum / ptd->n_expired : 0.0, ptd->lag_max);
+
   return (NULL);
 }
 
@@ -160,8 +169,13 @@ cnat_session_purge (void)
 {
   /* flush all the session from the DB */
   cnat_session_purge_walk_ctx_t ctx = { };
+  cnat_per_thread_data_t *ptd;
   cnat_bihash_kv_t *key;
 
+  /* all the timestamps go, forget the ones pending expiry */
+  vec_foreach (ptd, cnat_main.per_thread_data)
+    vec_reset_length (ptd->expired);
+
   BV (clib_bihash_foreach_key_value_pair) (&cnat_session_db,
 					   cnat_session_purge_walk, &ctx);
 
@@ -173,7 +187,8 @@ cnat_session_purge (void)
 }
 
 void
-cnat_reverse_session_free (cnat_session_t *session)
+cnat_reverse_session_free (cnat_session_t *session,
+			   cnat_session_location_t rsession_location)
 {
   cnat_bihash_kv_t bkey, bvalue;
   cnat_session_t *rsession = (cnat_session_t *) &bkey;
@@ -184,9 +199,7 @@ cnat_reverse_session_free (cnat_session_t *session)
   ip46_address_copy (&rsession->key.cs_ip[VLIB_TX],
 		     &session->value.cs_ip[VLIB_RX]);
   rsession->key.cs_proto = session->key.cs_proto;
-  rsession->key.cs_loc = session->key.cs_loc == CNAT_LOCATION_OUTPUT ?
-			   CNAT_LOCATION_INPUT :
-			   CNAT_LOCATION_OUTPUT;
+  rsession->key.cs_loc = rsession_location;
   rsession->key.__cs_pad = 0;
   rsession->key.cs_af = session->key.cs_af;
   rsession->key.cs_port[VLIB_RX] = session->value.cs_port[VLIB_TX];
@@ -201,84 +214,141 @@ cnat_reverse_session_free (cnat_session_t *session)
     }
 }
 
-u64
-cnat_session_scan (vlib_main_t * vm, f64 start_time, int i)
+static void
+cnat_session_expire_one (cnat_per_thread_data_t *ptd, u32 index, f64 now)
 {
-  BVT (clib_bihash) * h = &cnat_session_db;
-  int j, k;
+  cnat_bihash_kv_t bkey, bvalue;
+  cnat_session_t *session;
+  cnat_timestamp_t *ts;
+  u8 rsession_loc;
+  f64 exp;
+
+  clib_rwlock_reader_lock (&cnat_main.ts_lock);
+  if (pool_is_free_index (cnat_timestamps, index))
+    goto unlock;
+  ts = pool_elt_at_index (cnat_timestamps, index);
+  /* freed and reused since its timer expired, or queued to be freed */
+  if (ts->timer_handle != ~0 ||
+      ts->thread_index != ptd - cnat_main.per_thread_data || 0 == ts->refcnt)
+    goto unlock;
+
+  exp = ts->last_seen + (f64) ts->lifetime;
+  if (exp > now)
+    {
+      /* still in use */
+      ts->timer_handle = tw_timer_start_2t_1w_2048sl (
+	&ptd->tw, index, 0 /* timer id */, cnat_expiry_ticks (exp - now));
+      ptd->n_restarted++;
+      goto unlock;
+    }
+  clib_memcpy_fast (bkey.key, ts->cs_key, sizeof (bkey.key));
+  rsession_loc = ts->rsession_loc;
+  clib_rwlock_reader_unlock (&cnat_main.ts_lock);
+
+  if (cnat_bihash_search_i2 (&cnat_session_db, &bkey, &bvalue))
+    return;
+  session = (cnat_session_t *) &bvalue;
+  if (session->value.cs_ts_index != index)
+    return;
+
+  cnat_reverse_session_free (session, rsession_loc);
+  cnat_session_free (session);
+
+  ptd->n_expired++;
+  ptd->lag_sum += now - exp;
+  ptd->lag_max = clib_max (ptd->lag_max, now - exp);
+  return;
+
+unlock:
+  clib_rwlock_reader_unlock (&cnat_main.ts_lock);
+}
+
+/* stop the timers of the timestamps other threads released */
+static void
+cnat_session_free_timestamps (cnat_per_thread_data_t *ptd)
+{
+  cnat_timestamp_t *ts;
+  u32 *to_free, *index;
+
+  if (0 == vec_len (ptd->ts_to_free))
+    return;
 
-  if (alloc_arena (h) == 0)
-    return 0;
+  clib_spinlock_lock (&ptd->ts_free_lock);
+  to_free = ptd->ts_to_free;
+  ptd->ts_to_free = ptd->ts_freeing;
+  clib_spinlock_unlock (&ptd->ts_free_lock);
 
-  for ( /* caller saves starting point */ ; i < h->nbuckets; i++)
+  clib_rwlock_reader_lock (&cnat_main.ts_lock);
+  vec_foreach (index, to_free)
     {
-      /* allow no more than 100us without a pause */
-      if ((vlib_time_now (vm) - start_time) > 10e-5)
-	return (i);
-
-      if (i < (h->nbuckets - 3))
-	{
-	  BVT (clib_bihash_bucket) * b =
-	    BV (clib_bihash_get_bucket) (h, i + 3);
-	  clib_prefetch_load (b);
-	  b = BV (clib_bihash_get_bucket) (h, i + 1);
-	  if (!BV (clib_bihash_bucket_is_empty) (b))
-	    {
-	      BVT (clib_bihash_value) * v =
-		BV (clib_bihash_get_value) (h, b->offset);
-	      clib_prefetch_load (v);
-	    }
-	}
-
-      BVT (clib_bihash_bucket) * b = BV (clib_bihash_get_bucket) (h, i);
-      if (BV (clib_bihash_bucket_is_empty) (b))
-	continue;
-      BVT (clib_bihash_value) * v = BV (clib_bihash_get_value) (h, b->offset);
-      for (j = 0; j < (1 << b->log2_pages); j++)
-	{
-	  for (k = 0; k < BIHASH_KVP_PER_PAGE; k++)
-	    {
-	      if (v->kvp[k].key[0] == ~0ULL && v->kvp[k].value[0] == ~0ULL)
-		continue;
-
-	      cnat_session_t *session = (cnat_session_t *) & v->kvp[k];
-
-	      if (start_time >
-		  cnat_timestamp_exp (session->value.cs_ts_index))
-		{
-		  /* age it */
-		  cnat_reverse_session_free (session);
-		  /* this should be last as deleting the session memset it to
-		   * 0xff */
-		  cnat_session_free (session);
-
-		  /*
-		   * Note: we may have just freed the bucket's backing
-		   * storage, so check right here...
-		   */
-		  if (BV (clib_bihash_bucket_is_empty) (b))
-		    goto doublebreak;
-		}
-	    }
-	  v++;
-	}
-    doublebreak:
-      ;
+      ts = pool_elt_at_index (cnat_timestamps, *index);
+      if (ts->timer_handle != ~0)
+	tw_timer_stop_2t_1w_2048sl (&ptd->tw, ts->timer_handle);
+      ts->thread_index = ~0;
+      ts->timer_handle = ~0;
     }
+  clib_rwlock_reader_unlock (&cnat_main.ts_lock);
 
-  /* start again */
-  return (0);
+  vec_foreach (index, to_free)
+    cnat_timestamp_put (*index);
+  vec_reset_length (to_free);
+  ptd->ts_freeing = to_free;
+}
+
+u32
+cnat_session_expire (vlib_main_t *vm, f64 now, u32 max)
+{
+  cnat_per_thread_data_t *ptd;
+  u32 i, n;
+
+  ptd = vec_elt_at_index (cnat_main.per_thread_data, vm->thread_index);
+  cnat_session_free_timestamps (ptd);
+
+  if (vec_len (ptd->expired) == 0)
+    {
+      ptd->expired =
+	tw_timer_expire_timers_vec_2t_1w_2048sl (&ptd->tw, now, ptd->expired);
+      if (vec_len (ptd->expired) == 0)
+	return 0;
+
+      /* the timers are gone, whatever happens to the timestamps now */
+      clib_rwlock_reader_lock (&cnat_main.ts_lock);
+      vec_foreach_index (i, ptd->expired)
+	if (!pool_is_free_index (cnat_timestamps, ptd->expired[i]) &&
+	    cnat_timestamps[ptd->expired[i]].thread_index == vm->thread_index)
+	  cnat_timestamps[ptd->expired[i]].timer_handle = ~0;
+      clib_rwlock_reader_unlock (&cnat_main.ts_lock);
+    }
+
+  n = clib_min (vec_len (ptd->expired), max);
+  for (i = 0; i < n; i++)
+    cnat_session_expire_one (ptd, ptd->expired[i], now);
+  vec_delete (ptd->expired, n, 0);
+
+  return n;
 }
 
 static clib_error_t *
 cnat_session_init (vlib_main_t * vm)
 {
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
   cnat_main_t *cm = &cnat_main;
+  cnat_per_thread_data_t *ptd;
+
   BV (clib_bihash_init) (&cnat_session_db,
 			 "CNat Session DB", cm->session_hash_buckets,
 			 cm->session_hash_memory);
   BV (clib_bihash_set_kvp_format_fn) (&cnat_session_db, format_cnat_session);
 
+  vec_validate_aligned (cm->per_thread_data, tm->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_foreach (ptd, cm->per_thread_data)
+    {
+      tw_timer_wheel_init_2t_1w_2048sl (&ptd->tw, NULL, cm->scanner_timeout,
+					CNAT_SESSION_EXPIRE_BATCH);
+      clib_spinlock_init (&ptd->ts_free_lock);
+    }
+
   return (NULL);
 }
 
@@ -292,6 +362,9 @@ cnat_timestamp_show (vlib_main_t * vm,
   clib_rwlock_reader_lock (&cnat_main.ts_lock);
   pool_foreach (ts, cnat_timestamps)
     {
+      /* cached for new sessions */
+      if (0 == ts->refcnt)
+	continue;
       vlib_cli_output (vm, "[%d] last_seen:%f lifetime:%u ref:%u",
 		       ts - cnat_timestamps, ts->last_seen, ts->lifetime,
 		       ts->refcnt);
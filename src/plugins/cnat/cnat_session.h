@@ -156,6 +156,9 @@ STATIC_ASSERT (STRUCT_OFFSET_OF (cnat_session_t, value) ==
 	       "value overlaps");
 STATIC_ASSERT (sizeof (cnat_session_t) == sizeof (cnat_bihash_kv_t),
 	       "session kvp");
+STATIC_ASSERT (sizeof (((cnat_session_t *) 0)->key) ==
+		 sizeof (((cnat_timestamp_t *) 0)->cs_key),
+	       "timestamp session key");
 
 /**
  * The DB of sessions
@@ -174,9 +177,10 @@ typedef walk_rc_t (*cnat_session_walk_cb_t) (const cnat_session_t *
 extern void cnat_session_walk (cnat_session_walk_cb_t cb, void *ctx);
 
 /**
- * Scan the session DB for expired sessions
+ * Expire at most max sessions whose timers ran out on the calling
+ * thread. Returns the number of expired timers processed.
  */
-extern u64 cnat_session_scan (vlib_main_t * vm, f64 start_time, int i);
+extern u32 cnat_session_expire (vlib_main_t *vm, f64 now, u32 max);
 
 /**
  * Purge all the sessions
@@ -188,6 +192,12 @@ extern int cnat_session_purge (void);
  */
 extern void cnat_session_free (cnat_session_t * session);
 
+/**
+ * Free the return session of a session, matched at rsession_location
+ */
+extern void cnat_reverse_session_free (cnat_session_t *session,
+				       cnat_session_location_t rsession_location);
+
 /**
  * Port cleanup callback
  */
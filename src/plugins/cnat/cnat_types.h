@@ -22,6 +22,7 @@
 #include <vnet/ip/ip_types.h>
 #include <vnet/ip/ip.h>
 #include <vnet/util/throttle.h>
+#include <vppinfra/tw_timer_2t_1w_2048sl.h>
 
 /* only in the default table for v4 and v6 */
 #define CNAT_FIB_TABLE 0
@@ -34,6 +35,13 @@
 #define CNAT_DEFAULT_TCP_RST_TIMEOUT 5
 #define CNAT_DEFAULT_SCANNER_TIMEOUT (1.0)
 
+/* max expired session timers processed per thread per dispatch */
+#define CNAT_SESSION_EXPIRE_BATCH 256
+
+/* timestamps taken from the pool per writer lock, and kept per thread */
+#define CNAT_TIMESTAMP_CACHE_BATCH 64
+#define CNAT_TIMESTAMP_CACHE_MAX   (4 * CNAT_TIMESTAMP_CACHE_BATCH)
+
 #define CNAT_DEFAULT_SESSION_BUCKETS     1024
 #define CNAT_DEFAULT_TRANSLATION_BUCKETS 1024
 #define CNAT_DEFAULT_SNAT_BUCKETS        1024
@@ -93,6 +101,39 @@ typedef struct
   u16 sequence;
 } cnat_echo_header_t;
 
+/**
+ * Per thread session state. Each thread owns the timers of the
+ * sessions it created, and expires them incrementally.
+ */
+typedef struct cnat_per_thread_data_t_
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+
+  /* Timestamps allocated from the pool, ready for new sessions. This
+   * keeps the pool writer lock, which stops every reader, off the per
+   * session path */
+  u32 *ts_cache;
+
+  tw_timer_wheel_2t_1w_2048sl_t tw;
+
+  /* Expired timestamps not processed yet */
+  u32 *expired;
+
+  /* Timestamps released by other threads while their timer runs on this
+   * thread's wheel. The timer is stopped here before they are reused */
+  clib_spinlock_t ts_free_lock;
+  u32 *ts_to_free;
+  u32 *ts_freeing;
+
+  /* Sessions expired, and timers restarted for sessions still in use */
+  u64 n_expired;
+  u64 n_restarted;
+
+  /* Delay between the end of life and the removal of sessions */
+  f64 lag_sum;
+  f64 lag_max;
+} cnat_per_thread_data_t;
+
 typedef struct cnat_main_
 {
   /* Memory size of the session bihash */
@@ -124,7 +165,8 @@ typedef struct cnat_main_
    * session (in seconds) */
   u32 tcp_max_age;
 
-  /* delay in seconds between two scans of session/clients tables */
+  /* delay in seconds between two runs of the session expiry, this is
+   * also the tick of the session timer wheels */
   f64 scanner_timeout;
 
   /* Lock for the timestamp pool */
@@ -142,6 +184,9 @@ typedef struct cnat_main_
   /* Number of buckets for maglev, should be a
    * prime >= 100 * max num bakends */
   u32 maglev_len;
+
+  /* Session expiry and timestamp caches, per thread */
+  cnat_per_thread_data_t *per_thread_data;
 } cnat_main_t;
 
 typedef struct cnat_timestamp_t_
@@ -152,6 +197,14 @@ typedef struct cnat_timestamp_t_
   u16 lifetime;
   /* Users refcount, initially 3 (session, rsession, dpo) */
   u16 refcnt;
+  /* Location of the return session */
+  u8 rsession_loc;
+  /* Thread whose timer wheel expires the sessions */
+  u32 thread_index;
+  /* Handle of the expiry timer on that wheel, ~0 if not running */
+  u32 timer_handle;
+  /* Key of the forward session, to find it when the timer expires */
+  u64 cs_key[5];
 } cnat_timestamp_t;
 
 typedef struct cnat_node_ctx_
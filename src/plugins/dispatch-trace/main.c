@@ -3,20 +3,82 @@
  */
 
 #include <vnet/plugin/plugin.h>
+#include <vlib/stats/stats.h>
 #include <vpp/app/version.h>
+#include <vppinfra/lock.h>
+
+/* latency histogram buckets, bucket n counts times < 2^n nanoseconds */
+#define DISPATCH_LATENCY_N_BUCKETS 32
+#define DISPATCH_LATENCY_SCAN_INTERVAL 1.0
+/* samples not seen in a node for this long are dropped */
+#define DISPATCH_LATENCY_MAX_AGE 1.0
 
 typedef struct
 {
   u8 *pcap_buffer;
+
+  /* buffers still to be seen entering the graph before the next sample */
+  u32 n_until_sample;
+  /* next frames of the input node being dispatched, and their sizes before */
+  vlib_frame_t **input_frames;
+  u32 *input_n_vectors;
 } dispatch_trace_thread_t;
 
+/* a buffer picked for latency tracing, and where it was last seen */
+typedef struct
+{
+  u64 last_tsc;
+  u32 buffer_index;
+  u32 last_node;
+  u16 last_thread;
+} dispatch_latency_sample_t;
+
+/* time from dispatch of one node to dispatch of the next one */
+typedef struct
+{
+  u64 hist[DISPATCH_LATENCY_N_BUCKETS];
+  u64 n_samples;
+  u64 sum;
+  u64 max;
+  u32 from_node;
+  u32 to_node;
+  u32 n_handoffs;
+} dispatch_latency_pair_t;
+
 typedef struct
 {
   u32 enable : 1;
+  u32 pcap_wrapper : 1;
   pcap_main_t dispatch_pcap_main;
   u32 *dispatch_buffer_trace_nodes;
   dispatch_trace_thread_t *threads;
   u32 epoll_input_node_index;
+
+  /* latency tracing, one of every sample_interval buffers, 0 is off */
+  u32 latency_sample_interval;
+  u32 latency_process_node_index;
+  f64 ns_per_clock;
+
+  /*
+   * bit per buffer index, set on sampled buffers so the per frame check
+   * does not need the lock. The bits are updated atomically as buffers
+   * sharing a word may be owned by different threads.
+   */
+  uword *sampled;
+
+  /* the rest is shared by all threads and protected by the lock */
+  clib_spinlock_t lock;
+  dispatch_latency_sample_t *samples;
+  uword *sample_by_buffer;
+  dispatch_latency_pair_t *pairs;
+  uword *pair_by_nodes;
+  u64 n_sampled;
+
+  /* stats segment entries */
+  u32 samples_stat_index;
+  /* latency histogram, a counter vector by pair index per bucket */
+  u32 *latency_stat_indices;
+  uword *pair_has_symlink;
 } dispatch_trace_main_t;
 
 dispatch_trace_main_t dispatch_trace_main;
@@ -54,6 +116,189 @@ format_buffer_metadata (u8 *s, va_list *args)
   return s;
 }
 
+static_always_inline int
+dispatch_latency_is_sampled (const dispatch_trace_main_t *dtm, u32 bi)
+{
+  uword i = bi / uword_bits;
+  return i < vec_len (dtm->sampled) &&
+	 (dtm->sampled[i] & (1ULL << (bi % uword_bits)));
+}
+
+static void
+dispatch_latency_pair_add (dispatch_trace_main_t *dtm, u32 from_node,
+			   u32 to_node, u64 clocks, int is_handoff)
+{
+  dispatch_latency_pair_t *lp;
+  u64 key = (u64) from_node << 32 | to_node;
+  uword *p = hash_get (dtm->pair_by_nodes, key);
+  u64 ns = clocks * dtm->ns_per_clock;
+  u32 bucket = ns ? min_log2 (ns) + 1 : 0;
+
+  if (p)
+    lp = vec_elt_at_index (dtm->pairs, p[0]);
+  else
+    {
+      vec_add2 (dtm->pairs, lp, 1);
+      lp->from_node = from_node;
+      lp->to_node = to_node;
+      hash_set (dtm->pair_by_nodes, key, lp - dtm->pairs);
+    }
+
+  lp->hist[clib_min (bucket, DISPATCH_LATENCY_N_BUCKETS - 1)]++;
+  lp->n_samples++;
+  lp->sum += ns;
+  lp->max = clib_max (lp->max, ns);
+  lp->n_handoffs += is_handoff;
+}
+
+/* samples start in the input node which enqueued the buffer, the first hop
+ * accounts the time since it was dispatched to the input -> first node pair */
+static void
+dispatch_latency_sample_start (vlib_main_t *vm, u32 bi, u32 node_index,
+			       u64 now)
+{
+  dispatch_trace_main_t *dtm = &dispatch_trace_main;
+  dispatch_latency_sample_t *s;
+  uword i = bi / uword_bits;
+
+  if (i >= vec_len (dtm->sampled))
+    return;
+
+  clib_spinlock_lock (&dtm->lock);
+  pool_get (dtm->samples, s);
+  s->buffer_index = bi;
+  s->last_node = node_index;
+  s->last_tsc = now;
+  s->last_thread = vm->thread_index;
+  hash_set (dtm->sample_by_buffer, bi, s - dtm->samples);
+  dtm->n_sampled++;
+  clib_spinlock_unlock (&dtm->lock);
+
+  clib_atomic_fetch_or (&dtm->sampled[i], 1ULL << (bi % uword_bits));
+}
+
+static void
+dispatch_latency_sample_hop (vlib_main_t *vm, u32 bi, u32 node_index, u64 now)
+{
+  dispatch_trace_main_t *dtm = &dispatch_trace_main;
+  dispatch_latency_sample_t *s;
+  uword *p;
+
+  clib_spinlock_lock (&dtm->lock);
+  p = hash_get (dtm->sample_by_buffer, bi);
+  if (p)
+    {
+      s = pool_elt_at_index (dtm->samples, p[0]);
+      /* time stamps taken on another thread may be slightly ahead */
+      dispatch_latency_pair_add (dtm, s->last_node, node_index,
+				 now > s->last_tsc ? now - s->last_tsc : 0,
+				 s->last_thread != vm->thread_index);
+      s->last_node = node_index;
+      s->last_tsc = now;
+      s->last_thread = vm->thread_index;
+    }
+  clib_spinlock_unlock (&dtm->lock);
+}
+
+static void
+dispatch_latency_sample_drop (u32 bi)
+{
+  dispatch_trace_main_t *dtm = &dispatch_trace_main;
+  uword *p;
+
+  clib_atomic_fetch_and (&dtm->sampled[bi / uword_bits],
+			 ~(1ULL << (bi % uword_bits)));
+
+  clib_spinlock_lock (&dtm->lock);
+  p = hash_get (dtm->sample_by_buffer, bi);
+  if (p)
+    {
+      pool_put_index (dtm->samples, p[0]);
+      hash_unset (dtm->sample_by_buffer, bi);
+    }
+  clib_spinlock_unlock (&dtm->lock);
+}
+
+/* samples end when their buffer is freed, or allocated again after being
+ * freed outside of vlib_buffer_free, e.g. by a driver */
+static u32
+dispatch_latency_alloc_free_callback (vlib_main_t *vm, u8 buffer_pool_index,
+				      u32 *buffers, u32 n_buffers)
+{
+  dispatch_trace_main_t *dtm = &dispatch_trace_main;
+
+  for (u32 i = 0; i < n_buffers; i++)
+    if (PREDICT_FALSE (dispatch_latency_is_sampled (dtm, buffers[i])))
+      dispatch_latency_sample_drop (buffers[i]);
+
+  return n_buffers;
+}
+
+static void
+dispatch_latency_trace (vlib_main_t *vm, vlib_node_runtime_t *node,
+			vlib_frame_t *frame)
+{
+  dispatch_trace_main_t *dtm = &dispatch_trace_main;
+  u64 now = vm->cpu_time_last_node_dispatch;
+  u32 *from = vlib_frame_vector_args (frame);
+
+  for (u32 i = 0; i < frame->n_vectors; i++)
+    if (PREDICT_FALSE (dispatch_latency_is_sampled (dtm, from[i])))
+      dispatch_latency_sample_hop (vm, from[i], node->node_index, now);
+}
+
+/* remember the next frames of an input node before it runs */
+static void
+dispatch_latency_input_before (vlib_main_t *vm, dispatch_trace_thread_t *dtt,
+			       vlib_node_runtime_t *node)
+{
+  vlib_next_frame_t *nf;
+
+  vec_reset_length (dtt->input_frames);
+  vec_reset_length (dtt->input_n_vectors);
+  for (u32 i = 0; i < node->n_next_nodes; i++)
+    {
+      nf = vlib_node_runtime_get_next_frame (vm, node, i);
+      vec_add1 (dtt->input_frames, nf->frame);
+      vec_add1 (dtt->input_n_vectors, nf->frame ? nf->frame->n_vectors : 0);
+    }
+}
+
+/*
+ * Buffers are sampled as they enter the graph: one of every sample interval
+ * buffers the input node just appended to its own next frames. Buffers
+ * moving between later nodes are never counted.
+ */
+static void
+dispatch_latency_input_after (vlib_main_t *vm, dispatch_trace_thread_t *dtt,
+			      vlib_node_runtime_t *node, u64 t)
+{
+  dispatch_trace_main_t *dtm = &dispatch_trace_main;
+  vlib_next_frame_t *nf;
+  vlib_frame_t *f;
+  u32 i, j, *from;
+
+  for (i = 0; i < node->n_next_nodes; i++)
+    {
+      nf = vlib_node_runtime_get_next_frame (vm, node, i);
+      if ((f = nf->frame) == 0)
+	continue;
+
+      /* a frame opened during the call holds only new buffers */
+      j = f == dtt->input_frames[i] ? dtt->input_n_vectors[i] : 0;
+      from = vlib_frame_vector_args (f);
+
+      while (j + dtt->n_until_sample < f->n_vectors)
+	{
+	  j += dtt->n_until_sample;
+	  dispatch_latency_sample_start (vm, from[j], node->node_index, t);
+	  dtt->n_until_sample = dtm->latency_sample_interval - 1;
+	  j++;
+	}
+      dtt->n_until_sample -= f->n_vectors - j;
+    }
+}
+
 #define A(x) vec_add1 (dtt->pcap_buffer, (x))
 
 uword
@@ -79,6 +324,13 @@ dispatch_pcap_trace (vlib_main_t *vm, vlib_node_runtime_t *node,
   if (frame == 0 || frame->n_vectors == 0)
     goto done;
 
+  if (PREDICT_FALSE (dtm->latency_sample_interval))
+    dispatch_latency_trace (vm, node, frame);
+
+  /* latency tracing alone shares the wrapper, capture nothing */
+  if (!dtm->enable)
+    goto done;
+
   from = vlib_frame_vector_args (frame);
   vlib_get_buffers (vm, from, bufs, frame->n_vectors);
   bufp = bufs;
@@ -164,6 +416,17 @@ dispatch_pcap_trace (vlib_main_t *vm, vlib_node_runtime_t *node,
 	}
     }
 done:
+  if (PREDICT_FALSE (dtm->latency_sample_interval) && frame == 0)
+    {
+      u64 t = vm->cpu_time_last_node_dispatch;
+      uword n;
+
+      dispatch_latency_input_before (vm, dtt, node);
+      n = node->function (vm, node, frame);
+      if (n)
+	dispatch_latency_input_after (vm, dtt, node, t);
+      return n;
+    }
   return node->function (vm, node, frame);
 }
 
@@ -270,12 +533,14 @@ vlib_pcap_dispatch_trace_configure (vlib_pcap_dispatch_trace_args_t *a)
 	      tm->filter_count = ~0;
 	    }
 	  tm->trace_enable = 1;
-	  if (vlib_node_set_dispatch_wrapper (this_vlib_main,
+	  if (this_vlib_main->dispatch_wrapper_fn != dispatch_pcap_trace &&
+	      vlib_node_set_dispatch_wrapper (this_vlib_main,
 					      dispatch_pcap_trace))
 	    clib_warning (0, "Dispatch wrapper already in use on thread %u",
 			  this_vlib_main->thread_index);
 	}
       vec_add1 (dtm->dispatch_buffer_trace_nodes, a->buffer_trace_node_index);
+      dtm->pcap_wrapper = 1;
     }
 
   if (a->enable)
@@ -307,9 +572,12 @@ vlib_pcap_dispatch_trace_configure (vlib_pcap_dispatch_trace_args_t *a)
 	  tm = &this_vlib_main->trace_main;
 	  tm->filter_flag = 0;
 	  tm->filter_count = 0;
-	  vlib_node_set_dispatch_wrapper (this_vlib_main, 0);
+	  /* latency tracing shares the wrapper */
+	  if (dtm->latency_sample_interval == 0)
+	    vlib_node_set_dispatch_wrapper (this_vlib_main, 0);
 	}
       vec_reset_length (dtm->dispatch_buffer_trace_nodes);
+      dtm->pcap_wrapper = 0;
       if (pm->n_packets_captured)
 	{
 	  clib_error_t *error;
@@ -502,6 +770,348 @@ VLIB_CLI_COMMAND (pcap_dispatch_trace_command, static) = {
   .function = dispatch_trace_command_fn,
 };
 
+static void
+dispatch_latency_reset (dispatch_trace_main_t *dtm)
+{
+  clib_spinlock_lock (&dtm->lock);
+  pool_free (dtm->samples);
+  hash_free (dtm->sample_by_buffer);
+  clib_bitmap_zero (dtm->sampled);
+  clib_spinlock_unlock (&dtm->lock);
+}
+
+static clib_error_t *
+dispatch_latency_enable_disable (vlib_main_t *vm, u32 sample_interval)
+{
+  dispatch_trace_main_t *dtm = &dispatch_trace_main;
+  vlib_buffer_main_t *bm = vm->buffer_main;
+  dispatch_trace_thread_t *dtt;
+
+  if (sample_interval == 0)
+    {
+      if (dtm->latency_sample_interval == 0)
+	return 0;
+      dtm->latency_sample_interval = 0;
+      if (bm->alloc_callback_fn == dispatch_latency_alloc_free_callback)
+	vlib_buffer_set_alloc_free_callback (vm, 0, 0);
+      if (!dtm->pcap_wrapper)
+	foreach_vlib_main ()
+	  vlib_node_set_dispatch_wrapper (this_vlib_main, 0);
+      dispatch_latency_reset (dtm);
+      return 0;
+    }
+
+  if (dtm->latency_sample_interval)
+    {
+      dtm->latency_sample_interval = sample_interval;
+      return 0;
+    }
+
+  foreach_vlib_main ()
+    if (this_vlib_main->dispatch_wrapper_fn &&
+	this_vlib_main->dispatch_wrapper_fn != dispatch_pcap_trace)
+      return clib_error_return (0, "dispatch wrapper in use on thread %u",
+				this_vlib_main->thread_index);
+
+  if (vlib_buffer_set_alloc_free_callback (
+	vm, dispatch_latency_alloc_free_callback,
+	dispatch_latency_alloc_free_callback))
+    return clib_error_return (0, "buffer alloc/free callbacks in use");
+
+  vec_validate (dtm->threads, vlib_get_n_threads () - 1);
+  vec_foreach (dtt, dtm->threads)
+    dtt->n_until_sample = 0;
+
+  clib_bitmap_validate (dtm->sampled,
+			bm->buffer_mem_size >> CLIB_LOG2_CACHE_LINE_BYTES);
+  dtm->ns_per_clock = vm->clib_time.seconds_per_clock * 1e9;
+  dtm->latency_sample_interval = sample_interval;
+
+  foreach_vlib_main ()
+    vlib_node_set_dispatch_wrapper (this_vlib_main, dispatch_pcap_trace);
+
+  vlib_process_signal_event (vm, dtm->latency_process_node_index, 0, 0);
+  return 0;
+}
+
+/*
+ * Histograms are exported with one /dispatch-trace/latency/lt-<2^n>ns
+ * vector per bucket, indexed by pair, and symlinked per bucket as
+ * /dispatch-trace/latency/<from-node>/<to-node>/lt-<2^n>ns.
+ */
+static void
+dispatch_latency_update_stats (vlib_main_t *vm, dispatch_trace_main_t *dtm,
+			       dispatch_latency_pair_t *pairs, u32 n_samples)
+{
+  dispatch_latency_pair_t *lp;
+  counter_t **latency;
+  u32 n_pairs = vec_len (pairs);
+  u32 i;
+
+  vlib_stats_set_gauge (dtm->samples_stat_index, n_samples);
+
+  if (!n_pairs)
+    return;
+
+  vlib_stats_segment_lock ();
+  for (i = 0; i < DISPATCH_LATENCY_N_BUCKETS; i++)
+    vlib_stats_validate (dtm->latency_stat_indices[i], 0, n_pairs - 1);
+  vec_foreach (lp, pairs)
+    {
+      u32 pi = lp - pairs;
+      if (clib_bitmap_get (dtm->pair_has_symlink, pi))
+	continue;
+      vlib_stats_add_histogram_symlinks (
+	dtm->latency_stat_indices, pi, "/dispatch-trace/latency/%U/%U",
+	format_vlib_stats_symlink, vlib_get_node (vm, lp->from_node)->name,
+	format_vlib_stats_symlink, vlib_get_node (vm, lp->to_node)->name);
+      dtm->pair_has_symlink = clib_bitmap_set (dtm->pair_has_symlink, pi, 1);
+    }
+  vlib_stats_segment_unlock ();
+
+  for (i = 0; i < DISPATCH_LATENCY_N_BUCKETS; i++)
+    {
+      latency =
+	vlib_stats_get_entry_data_pointer (dtm->latency_stat_indices[i]);
+      vec_foreach (lp, pairs)
+	latency[0][lp - pairs] = lp->hist[i];
+    }
+}
+
+/* drop samples whose buffers left the graph without being freed */
+static void
+dispatch_latency_scan (vlib_main_t *vm, dispatch_trace_main_t *dtm)
+{
+  u64 now = clib_cpu_time_now ();
+  u64 max_age = DISPATCH_LATENCY_MAX_AGE * vm->clib_time.clocks_per_second;
+  dispatch_latency_sample_t *s;
+  dispatch_latency_pair_t *pairs;
+  u32 *to_drop = 0, n_samples;
+
+  clib_spinlock_lock (&dtm->lock);
+  pool_foreach (s, dtm->samples)
+    if (now > s->last_tsc + max_age)
+      vec_add1 (to_drop, s->buffer_index);
+  clib_spinlock_unlock (&dtm->lock);
+
+  for (u32 i = 0; i < vec_len (to_drop); i++)
+    dispatch_latency_sample_drop (to_drop[i]);
+  vec_free (to_drop);
+
+  /* export a copy, workers must not wait on the stats segment lock */
+  clib_spinlock_lock (&dtm->lock);
+  pairs = vec_dup (dtm->pairs);
+  n_samples = pool_elts (dtm->samples);
+  clib_spinlock_unlock (&dtm->lock);
+
+  dispatch_latency_update_stats (vm, dtm, pairs, n_samples);
+  vec_free (pairs);
+}
+
+static uword
+dispatch_latency_process (vlib_main_t *vm, vlib_node_runtime_t *rt,
+			  vlib_frame_t *f)
+{
+  dispatch_trace_main_t *dtm = &dispatch_trace_main;
+
+  while (1)
+    {
+      if (dtm->latency_sample_interval)
+	vlib_process_wait_for_event_or_clock (vm,
+					      DISPATCH_LATENCY_SCAN_INTERVAL);
+      else
+	vlib_process_wait_for_event (vm);
+
+      vlib_process_get_events (vm, 0);
+
+      if (dtm->latency_sample_interval)
+	dispatch_latency_scan (vm, dtm);
+    }
+
+  return 0;
+}
+
+VLIB_REGISTER_NODE (dispatch_latency_process_node) = {
+  .function = dispatch_latency_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "dispatch-latency-process",
+  .process_log2_n_stack_bytes = 16,
+};
+
+static clib_error_t *
+dispatch_trace_init (vlib_main_t *vm)
+{
+  dispatch_trace_main_t *dtm = &dispatch_trace_main;
+
+  clib_spinlock_init (&dtm->lock);
+  dtm->latency_process_node_index = dispatch_latency_process_node.index;
+  dtm->samples_stat_index =
+    vlib_stats_add_gauge ("/dispatch-trace/latency-samples");
+  dtm->latency_stat_indices = vlib_stats_add_histogram (
+    DISPATCH_LATENCY_N_BUCKETS, "ns", "/dispatch-trace/latency");
+
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (dispatch_trace_init);
+
+static clib_error_t *
+dispatch_latency_trace_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				   vlib_cli_command_t *cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  u32 sample_interval = 1024;
+  int enable = 1;
+
+  if (unformat_user (input, unformat_line_input, line_input))
+    {
+      while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+	{
+	  if (unformat (line_input, "on"))
+	    enable = 1;
+	  else if (unformat (line_input, "off"))
+	    enable = 0;
+	  else if (unformat (line_input, "sample %u", &sample_interval))
+	    ;
+	  else
+	    {
+	      unformat_free (line_input);
+	      return clib_error_return (0, "unknown input `%U'",
+					format_unformat_error, line_input);
+	    }
+	}
+      unformat_free (line_input);
+    }
+
+  if (enable && sample_interval == 0)
+    return clib_error_return (0, "sample interval must be at least 1");
+
+  return dispatch_latency_enable_disable (vm, enable ? sample_interval : 0);
+}
+
+/*?
+ * Trace the latency of a sample of packets through the node graph. One in
+ * every <em>n</em> packets entering the graph is followed from node to
+ * node, and the time between the dispatch of each node and the dispatch of
+ * the next one it reaches is added to a histogram for that pair of nodes.
+ * This includes the time spent waiting in frames, handoff queues and
+ * asynchronous crypto queues. The first pair of a packet starts at the
+ * input node which received it.
+ *
+ * The histograms are exported to the stats segment as
+ * /dispatch-trace/latency/<from-node>/<to-node>.
+ *
+ * @cliexpar
+ * @cliexstart{dispatch latency trace on sample 1000}
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (dispatch_latency_trace_command, static) = {
+  .path = "dispatch latency trace",
+  .short_help = "dispatch latency trace [on|off] [sample <n>]",
+  .function = dispatch_latency_trace_command_fn,
+};
+
+static u8 *
+format_dispatch_latency_hist (u8 *s, va_list *args)
+{
+  dispatch_latency_pair_t *lp = va_arg (*args, dispatch_latency_pair_t *);
+  u32 indent = format_get_indent (s);
+  int first = 1;
+  u32 i;
+
+  for (i = 0; i < DISPATCH_LATENCY_N_BUCKETS; i++)
+    {
+      if (!lp->hist[i])
+	continue;
+      if (!first)
+	s = format (s, "\n%U", format_white_space, indent);
+      s = format (s, "< %10lluns: %llu", 1ULL << i, lp->hist[i]);
+      first = 0;
+    }
+
+  return s;
+}
+
+static clib_error_t *
+show_dispatch_latency_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				  vlib_cli_command_t *cmd)
+{
+  dispatch_trace_main_t *dtm = &dispatch_trace_main;
+  dispatch_latency_pair_t *lp, *pairs;
+  int verbose = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "verbose"))
+	verbose = 1;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (!dtm->latency_sample_interval)
+    vlib_cli_output (vm, "dispatch latency tracing is off");
+  else
+    vlib_cli_output (vm, "sampling 1 in %u packets, %llu sampled, %u alive",
+		     dtm->latency_sample_interval, dtm->n_sampled,
+		     pool_elts (dtm->samples));
+
+  /* copy out, formatting node names must not be done under the lock */
+  clib_spinlock_lock (&dtm->lock);
+  pairs = vec_dup (dtm->pairs);
+  clib_spinlock_unlock (&dtm->lock);
+
+  vlib_cli_output (vm, "\n%30s%30s%12s%12s%12s%10s", "From", "To", "Samples",
+		   "Avg-ns", "Max-ns", "Handoffs");
+  vec_foreach (lp, pairs)
+    {
+      if (!lp->n_samples)
+	continue;
+      vlib_cli_output (vm, "%30U%30U%12llu%12llu%12llu%10u",
+		       format_vlib_node_name, vm, lp->from_node,
+		       format_vlib_node_name, vm, lp->to_node, lp->n_samples,
+		       lp->sum / lp->n_samples, lp->max, lp->n_handoffs);
+      if (verbose)
+	vlib_cli_output (vm, "%62s%U", "", format_dispatch_latency_hist, lp);
+    }
+  vec_free (pairs);
+
+  return 0;
+}
+
+VLIB_CLI_COMMAND (show_dispatch_latency_command, static) = {
+  .path = "show dispatch latency",
+  .short_help = "show dispatch latency [verbose]",
+  .function = show_dispatch_latency_command_fn,
+};
+
+static clib_error_t *
+clear_dispatch_latency_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				   vlib_cli_command_t *cmd)
+{
+  dispatch_trace_main_t *dtm = &dispatch_trace_main;
+  dispatch_latency_pair_t *lp;
+
+  /* pairs are kept, so their stats segment entries stay in place */
+  clib_spinlock_lock (&dtm->lock);
+  vec_foreach (lp, dtm->pairs)
+    {
+      clib_memset (lp->hist, 0, sizeof (lp->hist));
+      lp->n_samples = lp->sum = lp->max = 0;
+      lp->n_handoffs = 0;
+    }
+  dtm->n_sampled = 0;
+  clib_spinlock_unlock (&dtm->lock);
+
+  return 0;
+}
+
+VLIB_CLI_COMMAND (clear_dispatch_latency_command, static) = {
+  .path = "clear dispatch latency",
+  .short_help = "clear dispatch latency",
+  .function = clear_dispatch_latency_command_fn,
+};
+
 VLIB_PLUGIN_REGISTER () = {
   .version = VPP_BUILD_VER,
   .description = "Dispatch Trace",
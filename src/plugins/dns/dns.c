@@ -53,6 +53,8 @@ dns_cache_clear (dns_main_t * dm)
   /* *INDENT-OFF* */
   pool_foreach (ep, dm->entries)
    {
+    if (ep->expiry_timer_handle != ~0)
+      tw_timer_stop_2t_2w_512sl (&dm->expiry_wheel, ep->expiry_timer_handle);
     vec_free (ep->name);
     vec_free (ep->pending_requests);
   }
@@ -62,6 +64,7 @@ dns_cache_clear (dns_main_t * dm)
   hash_free (dm->cache_entry_by_name);
   dm->cache_entry_by_name = hash_create_string (0, sizeof (uword));
   vec_free (dm->unresolved_entries);
+  dns_cache_bump_epoch (dm);
   dns_cache_unlock (dm);
   return 0;
 }
@@ -104,6 +107,10 @@ dns_enable_disable (vlib_main_t * vm, dns_main_t * dm, int is_enable)
 	    clib_spinlock_init (&dm->cache_lock);
 
 	  dm->cache_entry_by_name = hash_create_string (0, sizeof (uword));
+	  tw_timer_wheel_init_2t_2w_512sl (&dm->expiry_wheel, 0 /* cb */,
+					   1.0 /* seconds per tick */,
+					   ~0 /* max expirations */);
+	  vec_validate (dm->per_thread_data, n_vlib_mains - 1);
 	}
 
       dm->is_enabled = 1;
@@ -594,14 +601,39 @@ vnet_dns_delete_entry_by_index_nolock (dns_main_t * dm, u32 index)
     }
 
 found:
+  if (ep->expiry_timer_handle != ~0)
+    tw_timer_stop_2t_2w_512sl (&dm->expiry_wheel, ep->expiry_timer_handle);
   hash_unset_mem (dm->cache_entry_by_name, ep->name);
   vec_free (ep->name);
+  vec_free (ep->cname);
+  vec_free (ep->dns_request);
+  vec_free (ep->dns_response);
   vec_free (ep->pending_requests);
   pool_put (dm->entries, ep);
 
   return 0;
 }
 
+/**
+ * Set the expiration time of a resolved entry and (re)arm its expiration
+ * timer, so the resolver process can reclaim it without waiting for the
+ * next lookup. Called with the cache locked.
+ */
+void
+vnet_dns_entry_set_expiry_nolock (dns_main_t *dm, dns_cache_entry_t *ep,
+				  f64 now, u32 ttl)
+{
+  ttl = clib_min (ttl, dm->max_ttl_in_seconds);
+  ep->expiration_time = now + ttl;
+
+  if (ep->expiry_timer_handle != ~0)
+    tw_timer_stop_2t_2w_512sl (&dm->expiry_wheel, ep->expiry_timer_handle);
+
+  /* Fire on the first tick past the expiration time */
+  ep->expiry_timer_handle = tw_timer_start_2t_2w_512sl (
+    &dm->expiry_wheel, ep - dm->entries, 0 /* timer id */, ttl + 1);
+}
+
 static int
 dns_delete_by_name (dns_main_t * dm, u8 * name)
 {
@@ -619,16 +651,20 @@ dns_delete_by_name (dns_main_t * dm, u8 * name)
       return VNET_API_ERROR_NO_SUCH_ENTRY;
     }
   rv = vnet_dns_delete_entry_by_index_nolock (dm, p[0]);
+  dns_cache_bump_epoch (dm);
 
   dns_cache_unlock (dm);
 
   return rv;
 }
 
+/**
+ * Evict a random valid, non-static entry to make room.
+ * Called with the cache locked.
+ */
 static int
 delete_random_entry (dns_main_t * dm)
 {
-  int rv;
   u32 victim_index, start_index, i;
   u32 limit;
   dns_cache_entry_t *ep;
@@ -645,7 +681,6 @@ delete_random_entry (dns_main_t * dm)
     return VNET_API_ERROR_UNSPECIFIED;
 #endif
 
-  dns_cache_lock (dm, 3);
   limit = pool_elts (dm->entries);
   start_index = random_u32 (&dm->random_seed) % limit;
 
@@ -660,13 +695,10 @@ delete_random_entry (dns_main_t * dm)
 	  if ((ep->flags & DNS_CACHE_ENTRY_FLAG_VALID)
 	      && ((ep->flags & DNS_CACHE_ENTRY_FLAG_STATIC) == 0))
 	    {
-	      rv = vnet_dns_delete_entry_by_index_nolock (dm, victim_index);
-	      dns_cache_unlock (dm);
-	      return rv;
+	      return vnet_dns_delete_entry_by_index_nolock (dm, victim_index);
 	    }
 	}
     }
-  dns_cache_unlock (dm);
 
   clib_warning ("Couldn't find an entry to delete?");
   return VNET_API_ERROR_UNSPECIFIED;
@@ -711,14 +743,22 @@ dns_add_static_entry (dns_main_t * dm, u8 * name, u8 * dns_reply_data)
   hash_set_mem (dm->cache_entry_by_name, ep->name, ep - dm->entries);
   ep->flags = DNS_CACHE_ENTRY_FLAG_VALID | DNS_CACHE_ENTRY_FLAG_STATIC;
   ep->dns_response = dns_reply_data;
+  ep->expiry_timer_handle = ~0;
+
+  /* Threads may hold a negative answer for this name */
+  dns_cache_bump_epoch (dm);
 
   dns_cache_unlock (dm);
   return 0;
 }
 
+/**
+ * Look up a name, or start resolving it. Called with the cache locked.
+ */
 int
-vnet_dns_resolve_name (vlib_main_t * vm, dns_main_t * dm, u8 * name,
-		       dns_pending_request_t * t, dns_cache_entry_t ** retp)
+vnet_dns_resolve_name_nolock (vlib_main_t *vm, dns_main_t *dm, u8 *name,
+			      dns_pending_request_t *t,
+			      dns_cache_entry_t **retp)
 {
   dns_cache_entry_t *ep;
   int rv;
@@ -736,7 +776,6 @@ vnet_dns_resolve_name (vlib_main_t * vm, dns_main_t * dm, u8 * name,
   if (name[0] == 0)
     return VNET_API_ERROR_INVALID_VALUE;
 
-  dns_cache_lock (dm, 5);
 search_again:
   p = hash_get_mem (dm->cache_entry_by_name, name);
   if (p)
@@ -796,7 +835,6 @@ search_again:
 	      goto search_again;
 	    }
 	  *retp = ep;
-	  dns_cache_unlock (dm);
 	  return (0);
 	}
       else
@@ -807,7 +845,6 @@ search_again:
 	   */
 	  vec_add2 (ep->pending_requests, pr, 1);
 	  memcpy (pr, t, sizeof (*pr));
-	  dns_cache_unlock (dm);
 	  return (0);
 	}
     }
@@ -818,15 +855,13 @@ re_resolve:
       /* Will only fail if the cache is totally filled w/ static entries... */
       rv = delete_random_entry (dm);
       if (rv)
-	{
-	  dns_cache_unlock (dm);
-	  return rv;
-	}
+	return rv;
     }
 
   /* add new hash table entry */
   pool_get (dm->entries, ep);
   clib_memset (ep, 0, sizeof (*ep));
+  ep->expiry_timer_handle = ~0;
 
   ep->name = format (0, "%s%c", name, 0);
   vec_set_len (ep->name, vec_len (ep->name) - 1);
@@ -860,10 +895,22 @@ re_resolve:
     }
 
   vnet_send_dns_request (vm, dm, ep);
-  dns_cache_unlock (dm);
   return 0;
 }
 
+int
+vnet_dns_resolve_name (vlib_main_t * vm, dns_main_t * dm, u8 * name,
+		       dns_pending_request_t * t, dns_cache_entry_t ** retp)
+{
+  int rv;
+
+  dns_cache_lock (dm, 5);
+  rv = vnet_dns_resolve_name_nolock (vm, dm, name, t, retp);
+  dns_cache_unlock (dm);
+
+  return rv;
+}
+
 #define foreach_notification_to_move            \
 _(pending_requests)
 
@@ -997,7 +1044,8 @@ found_last_request:
     vec_free (ep->dns_response);
   ep->dns_response = reply;
   /* Set up expiration time */
-  ep->expiration_time = now + clib_net_to_host_u32 (rr->ttl);
+  vnet_dns_entry_set_expiry_nolock (dm, ep, now,
+				    clib_net_to_host_u32 (rr->ttl));
 
   pool_get (dm->entries, next_ep);
 
@@ -1005,6 +1053,7 @@ found_last_request:
   ep = pool_elt_at_index (dm->entries, ep_index);
 
   clib_memset (next_ep, 0, sizeof (*next_ep));
+  next_ep->expiry_timer_handle = ~0;
   next_ep->name = vec_dup (cname);
   vec_add1 (next_ep->name, 0);
   vec_dec_len (next_ep->name, 1);
@@ -1068,12 +1117,24 @@ found_last_request:
   return (1);
 }
 
+/* Skip a possibly compressed name, return the first byte past it */
+static u8 *
+dns_skip_name (u8 *pos)
+{
+  while (*pos)
+    {
+      if ((*pos & 0xC0) == 0xC0)
+	return pos + 2;
+      pos += *pos + 1;
+    }
+  return pos + 1;
+}
+
 int
 vnet_dns_response_to_reply (u8 *response, dns_resolve_name_t *rn,
 			    u32 *min_ttlp)
 {
   dns_header_t *h;
-  dns_query_t *qp;
   dns_rr_t *rr;
   int i, limit;
   u8 len;
@@ -1110,27 +1171,10 @@ vnet_dns_response_to_reply (u8 *response, dns_resolve_name_t *rn,
 
   curpos = (u8 *) (h + 1);
 
-  /* Skip the name we asked about */
-  pos = curpos;
-  len = *pos++;
-  /* Should never happen, but stil... */
-  if ((len & 0xC0) == 0xC0)
-    curpos += 2;
-  else
-    {
-      /* skip the name / label-set */
-      while (len)
-	{
-	  pos += len;
-	  len = *pos++;
-	}
-      curpos = pos;
-    }
-  /* Skip queries */
+  /* Skip the questions, we ask for A and AAAA records */
   limit = clib_net_to_host_u16 (h->qdcount);
-  qp = (dns_query_t *) curpos;
-  qp += limit;
-  curpos = (u8 *) qp;
+  for (i = 0; i < limit; i++)
+    curpos = dns_skip_name (curpos) + sizeof (dns_query_t);
 
   /* Parse answers */
   limit = clib_net_to_host_u16 (h->anscount);
@@ -1214,7 +1258,6 @@ vnet_dns_response_to_name (u8 * response,
 			   u32 * min_ttlp)
 {
   dns_header_t *h;
-  dns_query_t *qp;
   dns_rr_t *rr;
   int i, limit;
   u8 len;
@@ -1254,27 +1297,10 @@ vnet_dns_response_to_name (u8 * response,
 
   curpos = (u8 *) (h + 1);
 
-  /* Skip the name we asked about */
-  pos = curpos;
-  len = *pos++;
-  /* Should never happen, but stil... */
-  if ((len & 0xC0) == 0xC0)
-    curpos += 2;
-  else
-    {
-      /* skip the name / label-set */
-      while (len)
-	{
-	  pos += len;
-	  len = *pos++;
-	}
-      curpos = pos;
-    }
-  /* Skip queries */
+  /* Skip the questions, we ask for A and AAAA records */
   limit = clib_net_to_host_u16 (h->qdcount);
-  qp = (dns_query_t *) curpos;
-  qp += limit;
-  curpos = (u8 *) qp;
+  for (i = 0; i < limit; i++)
+    curpos = dns_skip_name (curpos) + sizeof (dns_query_t);
 
   /* Parse answers */
   limit = clib_net_to_host_u16 (h->anscount);
@@ -1344,6 +1370,128 @@ vnet_dns_response_to_name (u8 * response,
   return 0;
 }
 
+/**
+ * Dig the TTLs relevant to caching out of a response: the smallest
+ * answer TTL, and the negative caching TTL from the SOA record in the
+ * authority section (RFC 2308, the smaller of the SOA TTL and its
+ * MINIMUM field). Either is left alone when not present.
+ */
+int
+vnet_dns_response_ttls (u8 *response, u32 *min_ttlp, u32 *negative_ttlp)
+{
+  dns_header_t *h;
+  dns_rr_t *rr;
+  u8 *pos;
+  u32 ttl, minimum;
+  int i, n_answers, n_authority;
+
+  if (vec_len (response) < sizeof (*h))
+    return -1;
+
+  h = (dns_header_t *) response;
+  pos = (u8 *) (h + 1);
+
+  for (i = 0; i < clib_net_to_host_u16 (h->qdcount); i++)
+    pos = dns_skip_name (pos) + sizeof (dns_query_t);
+
+  n_answers = clib_net_to_host_u16 (h->anscount);
+  n_authority = clib_net_to_host_u16 (h->nscount);
+
+  for (i = 0; i < n_answers + n_authority; i++)
+    {
+      pos = dns_skip_name (pos);
+      rr = (dns_rr_t *) pos;
+      if ((u8 *) (rr + 1) > vec_end (response))
+	return -1;
+
+      ttl = clib_net_to_host_u32 (rr->ttl);
+      if (i < n_answers)
+	{
+	  if (*min_ttlp > ttl)
+	    *min_ttlp = ttl;
+	}
+      else if (clib_net_to_host_u16 (rr->type) == DNS_TYPE_SOA &&
+	       clib_net_to_host_u16 (rr->rdlength) >= sizeof (u32))
+	{
+	  /* MINIMUM is the last field of the SOA rdata */
+	  pos = rr->rdata + clib_net_to_host_u16 (rr->rdlength);
+	  if (pos > vec_end (response))
+	    return -1;
+	  minimum = clib_net_to_host_u32 (*(u32u *) (pos - sizeof (u32)));
+	  *negative_ttlp = clib_min (ttl, minimum);
+	  return 0;
+	}
+      pos = rr->rdata + clib_net_to_host_u16 (rr->rdlength);
+    }
+  return 0;
+}
+
+/**
+ * Build the answer the request node sends for a name, following CNAME
+ * indirection. Called with the cache locked, after
+ * vnet_dns_resolve_name_nolock() found a valid, unexpired entry.
+ */
+int
+vnet_dns_entry_to_answer_nolock (dns_main_t *dm, u8 *name, u32 request_type,
+				 dns_answer_t *a)
+{
+  dns_cache_entry_t *ep;
+  dns_resolve_name_t _rn, *rn = &_rn;
+  vl_api_dns_resolve_ip_reply_t _rir, *rir = &_rir;
+  f64 expiration_time = 0;
+  u8 *vecname;
+  u32 ttl = 64;
+  uword *p;
+
+  while (1)
+    {
+      p = hash_get_mem (dm->cache_entry_by_name, name);
+      if (!p)
+	return VNET_API_ERROR_NO_SUCH_ENTRY;
+      ep = pool_elt_at_index (dm->entries, p[0]);
+      if (!(ep->flags & DNS_CACHE_ENTRY_FLAG_VALID))
+	return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+      /* The answer expires with the first link of the chain */
+      if (!(ep->flags & DNS_CACHE_ENTRY_FLAG_STATIC) &&
+	  (expiration_time == 0 || ep->expiration_time < expiration_time))
+	expiration_time = ep->expiration_time;
+
+      if (!(ep->flags & DNS_CACHE_ENTRY_FLAG_CNAME))
+	break;
+      name = ep->cname;
+    }
+
+  a->expiration_time = expiration_time;
+  a->rcode = DNS_RCODE_NO_ERROR;
+
+  if (ep->flags & DNS_CACHE_ENTRY_FLAG_NEGATIVE)
+    a->rcode = DNS_RCODE_NAME_ERROR;
+  else if (request_type == DNS_PEER_PENDING_NAME_TO_IP)
+    {
+      clib_memset (rn, 0, sizeof (*rn));
+      if (vnet_dns_response_to_reply (ep->dns_response, rn, &ttl) ||
+	  ip_addr_version (&rn->address) != AF_IP4)
+	a->rcode = DNS_RCODE_NAME_ERROR;
+      else
+	ip_address_copy_addr (&a->address, &rn->address);
+    }
+  else
+    {
+      clib_memset (rir, 0, sizeof (*rir));
+      if (vnet_dns_response_to_name (ep->dns_response, rir, &ttl))
+	a->rcode = DNS_RCODE_NAME_ERROR;
+      else
+	{
+	  vecname = format (0, "%s", rir->name);
+	  a->labels = name_to_labels (vecname);
+	  vec_free (vecname);
+	}
+    }
+  a->ttl = ttl;
+  return 0;
+}
+
 __clib_export int
 dns_resolve_name (u8 *name, dns_cache_entry_t **ep, dns_pending_request_t *t0,
 		  dns_resolve_name_t *rn)
@@ -1491,6 +1639,9 @@ dns_config_fn (vlib_main_t * vm, unformat_input_t * input)
 	;
       else if (unformat (input, "max-ttl %u", &dm->max_ttl_in_seconds))
 	;
+      else if (unformat (input, "negative-ttl %u",
+			 &dm->negative_ttl_in_seconds))
+	;
       else
 	return clib_error_return (0, "unknown input `%U'",
 				  format_unformat_error, input);
@@ -2055,6 +2206,8 @@ format_dns_cache (u8 * s, va_list * args)
 	      ASSERT (ep->dns_response);
 	      if (ep->flags & DNS_CACHE_ENTRY_FLAG_STATIC)
 		ss = "[S] ";
+	      else if (ep->flags & DNS_CACHE_ENTRY_FLAG_NEGATIVE)
+		ss = "[N] ";
 	      else
 		ss = "    ";
 
@@ -2080,6 +2233,7 @@ format_dns_cache (u8 * s, va_list * args)
 	    }
 	  vec_add1 (s, '\n');
 	}
+      dns_cache_unlock (dm);
       return s;
     }
 
@@ -2095,6 +2249,8 @@ format_dns_cache (u8 * s, va_list * args)
             ASSERT (ep->dns_response);
             if (ep->flags & DNS_CACHE_ENTRY_FLAG_STATIC)
               ss = "[S] ";
+            else if (ep->flags & DNS_CACHE_ENTRY_FLAG_NEGATIVE)
+              ss = "[N] ";
             else
               ss = "    ";
 
@@ -2630,6 +2786,10 @@ test_dns_expire_command_fn (vlib_main_t * vm,
   ep = pool_elt_at_index (dm->entries, p[0]);
 
   ep->expiration_time = 0;
+  dns_cache_bump_epoch (dm);
+
+  dns_cache_unlock (dm);
+  vec_free (name);
 
   return 0;
 }
@@ -2745,7 +2905,12 @@ vnet_send_dns4_reply (vlib_main_t * vm, dns_main_t * dm,
 
   if (!ip4_sas (0 /* default VRF for now */, ~0,
 		(const ip4_address_t *) &pr->dst_address, &src_address))
-    return;
+    {
+      vec_free (pr->name);
+      if (is_recycle == 0)
+	vlib_buffer_free_one (vm, bi);
+      return;
+    }
 
   ip = vlib_buffer_get_current (b0);
   udp = (udp_header_t *) (ip + 1);
@@ -2874,6 +3039,7 @@ dns_init (vlib_main_t * vm)
   dm->vnet_main = vnet_get_main ();
   dm->name_cache_size = 1000;
   dm->max_ttl_in_seconds = 86400;
+  dm->negative_ttl_in_seconds = 60;
   dm->random_seed = 0xDEADDABE;
   dm->api_main = vlibapi_get_main ();
 
@@ -24,6 +24,7 @@
 #include <dns/dns_packet.h>
 #include <vnet/ip/ip.h>
 #include <vppinfra/lock.h>
+#include <vppinfra/tw_timer_2t_2w_512sl.h>
 #include <vlibapi/api_common.h>
 
 typedef struct
@@ -81,11 +82,56 @@ typedef struct
 
   /** Clients / peers awaiting responses */
   dns_pending_request_t *pending_requests;
+
+  /** Expiration timer handle, ~0 if not running */
+  u32 expiry_timer_handle;
 } dns_cache_entry_t;
 
 #define DNS_CACHE_ENTRY_FLAG_VALID	(1<<0) /**< we have Actual Data */
 #define DNS_CACHE_ENTRY_FLAG_STATIC	(1<<1) /**< static entry */
 #define DNS_CACHE_ENTRY_FLAG_CNAME	(1<<2) /**< CNAME (indirect) entry */
+#define DNS_CACHE_ENTRY_FLAG_NEGATIVE	(1<<3) /**< cached NXDOMAIN */
+
+/*
+ * Answer synthesized from the shared cache, as served by the request
+ * node. Kept in a per-thread shard so that cache hits need neither the
+ * cache lock nor a re-parse of the cached response.
+ */
+typedef struct
+{
+  /** Lower-cased question labels + request type, the shard key */
+  u8 *key;
+
+  /** Expiration time, 0 for static entries */
+  f64 expiration_time;
+
+  /** TTL to advertise for static entries */
+  u32 ttl;
+
+  /** Non-zero for a negative answer */
+  u8 rcode;
+
+  /** A-record address, for name to ip requests */
+  ip4_address_t address;
+
+  /** PTR target in label format, for ip to name requests */
+  u8 *labels;
+} dns_answer_t;
+
+typedef struct
+{
+  /** Pool of answers */
+  dns_answer_t *answers;
+
+  /** Find answer by key */
+  uword *answer_by_key;
+
+  /** Scratch key vector, reused for lookups */
+  u8 *key;
+
+  /** dns_main_t.cache_epoch the answers were copied under */
+  u32 epoch;
+} dns_per_thread_data_t;
 
 #define DNS_RETRIES_PER_SERVER 3
 
@@ -106,6 +152,20 @@ typedef struct
   clib_spinlock_t cache_lock;
   int cache_lock_tag;
 
+  /**
+   * Bumped whenever entries are removed from the cache by other means
+   * than expiration, or a valid entry's response is replaced. Per-thread
+   * answers copied under an older epoch are flushed.
+   */
+  volatile u32 cache_epoch;
+
+  /** Expiration timers, 1 second ticks, protected by the cache lock */
+  tw_timer_wheel_2t_2w_512sl_t expiry_wheel;
+  u32 *expired_entries;
+
+  /** Per-thread answer caches */
+  dns_per_thread_data_t *per_thread_data;
+
   /** enable / disable flag */
   int is_enabled;
 
@@ -122,6 +182,7 @@ typedef struct
   /** config parameters */
   u32 name_cache_size;
   u32 max_ttl_in_seconds;
+  u32 negative_ttl_in_seconds;
   u32 random_seed;
 
   /** message-ID base */
@@ -145,7 +206,11 @@ _(PROCESSED, "DNS request pkts processed")                              \
 _(IP_OPTIONS, "DNS pkts with ip options (dropped)")                     \
 _(BAD_REQUEST, "DNS pkts with serious discrepancies (dropped)")         \
 _(TOO_MANY_REQUESTS, "DNS pkts asking too many questions")              \
-_(RESOLUTION_REQUIRED, "DNS pkts pending upstream name resolution")
+_(RESOLUTION_REQUIRED, "DNS pkts pending upstream name resolution")  \
+_(CACHE_HIT, "DNS requests answered from the thread cache")             \
+_(CACHE_MISS, "DNS requests looked up in the shared cache")             \
+_(NEGATIVE_HIT, "DNS requests answered with a cached NXDOMAIN")         \
+_(NO_BUFFER_SPACE, "DNS reply does not fit in the request buffer")
 
 typedef enum
 {
@@ -179,9 +244,19 @@ int vnet_dns_cname_indirection_nolock (vlib_main_t * vm, dns_main_t * dm,
 
 int vnet_dns_delete_entry_by_index_nolock (dns_main_t * dm, u32 index);
 
+void vnet_dns_entry_set_expiry_nolock (dns_main_t *dm, dns_cache_entry_t *ep,
+				       f64 now, u32 ttl);
+
 int
 vnet_dns_resolve_name (vlib_main_t * vm, dns_main_t * dm, u8 * name,
 		       dns_pending_request_t * t, dns_cache_entry_t ** retp);
+int vnet_dns_resolve_name_nolock (vlib_main_t *vm, dns_main_t *dm, u8 *name,
+				  dns_pending_request_t *t,
+				  dns_cache_entry_t **retp);
+int vnet_dns_entry_to_answer_nolock (dns_main_t *dm, u8 *name,
+				     u32 request_type, dns_answer_t *a);
+int vnet_dns_response_ttls (u8 *response, u32 *min_ttlp,
+			    u32 *negative_ttlp);
 
 void
 vnet_dns_send_dns6_request (vlib_main_t * vm, dns_main_t * dm,
@@ -228,6 +303,13 @@ dns_cache_unlock (dns_main_t * dm)
     }
 }
 
+/** Invalidate the per-thread answer caches. Call with the cache locked. */
+static inline void
+dns_cache_bump_epoch (dns_main_t *dm)
+{
+  clib_atomic_fetch_add_rel (&dm->cache_epoch, 1);
+}
+
 extern int dns_resolve_name (u8 *name, dns_cache_entry_t **ep,
 			     dns_pending_request_t *t0,
 			     dns_resolve_name_t *rn);
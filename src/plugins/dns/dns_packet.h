@@ -133,7 +133,8 @@ _(NAMESERVER, 2) /**< a nameserver */           \
 _(CNAME, 5)      /**< a CNAME (alias) */	\
 _(MAIL_EXCHANGE, 15) /**< a mail exchange  */	\
 _(PTR, 12)      /**< a PTR (pointer) record */	\
-_(HINFO, 13)	/**< Host info */
+_(HINFO, 13)	/**< Host info */                \
+_(SOA, 6)	/**< start of authority */
 
 typedef enum
 {
@@ -17,6 +17,8 @@
 
 #include <vlib/vlib.h>
 #include <vnet/vnet.h>
+#include <vnet/udp/udp_local.h>
+#include <ctype.h>
 
 vlib_node_registration_t dns46_request_node;
 
@@ -55,6 +57,155 @@ typedef enum
   DNS46_REQUEST_N_NEXT,
 } dns46_request_next_t;
 
+static void
+dns_per_thread_flush (dns_per_thread_data_t *ptd)
+{
+  dns_answer_t *a;
+
+  pool_foreach (a, ptd->answers)
+    {
+      vec_free (a->key);
+      vec_free (a->labels);
+    }
+  pool_free (ptd->answers);
+  hash_free (ptd->answer_by_key);
+}
+
+static void
+dns_per_thread_del (dns_per_thread_data_t *ptd, dns_answer_t *a)
+{
+  hash_unset_mem (ptd->answer_by_key, a->key);
+  vec_free (a->key);
+  vec_free (a->labels);
+  pool_put (ptd->answers, a);
+}
+
+/*
+ * Copy the question labels into the key, lower-cased, followed by the
+ * request type. Returns a pointer past the question, or 0 if the
+ * question is malformed.
+ */
+static_always_inline u8 *
+dns_question_to_key (u8 *label, u8 *end, u8 **keyp, u32 *request_typep)
+{
+  u8 *key = *keyp;
+  u8 *last_label = 0;
+  u8 len, i;
+
+  vec_reset_length (key);
+
+  while (label < end && (len = *label) != 0)
+    {
+      /* No compression in the question, nothing to point back to */
+      if ((len & 0xC0) || label + len + 1 >= end)
+	return 0;
+      last_label = label;
+      vec_add1 (key, len);
+      for (i = 1; i <= len; i++)
+	vec_add1 (key, tolower (label[i]));
+      label += len + 1;
+    }
+
+  if (label + 1 + sizeof (dns_query_t) > end || last_label == 0)
+    return 0;
+
+  /* Both ip4 and ip6 reverse requests end with ".arpa" */
+  if (last_label[0] == 4 && !memcmp (key + vec_len (key) - 4, "arpa", 4))
+    *request_typep = DNS_PEER_PENDING_IP_TO_NAME;
+  else
+    *request_typep = DNS_PEER_PENDING_NAME_TO_IP;
+
+  vec_add1 (key, *request_typep);
+  *keyp = key;
+
+  return label + 1 + sizeof (dns_query_t);
+}
+
+/*
+ * Turn the request into the reply: keep the question, append the answer,
+ * swap addresses and ports. Returns non-zero if the reply doesn't fit.
+ */
+static_always_inline int
+dns4_reply_in_place (vlib_main_t *vm, vlib_buffer_t *b, ip4_header_t *ip,
+		     udp_header_t *udp, dns_header_t *d, u8 *qend,
+		     dns_answer_t *a, f64 now)
+{
+  ip4_address_t tmp;
+  dns_rr_t *rr;
+  u16 rdlength = 0;
+  u32 dns_len, ttl;
+
+  dns_len = qend - (u8 *) d;
+  if (a->rcode == DNS_RCODE_NO_ERROR)
+    {
+      rdlength = a->labels ? vec_len (a->labels) : sizeof (ip4_address_t);
+      dns_len += 2 + sizeof (dns_rr_t) + rdlength;
+    }
+
+  if (b->current_data + dns_len > vlib_buffer_get_default_data_size (vm))
+    return -1;
+
+  if (b->flags & VLIB_BUFFER_NEXT_PRESENT)
+    {
+      vlib_buffer_free_one (vm, b->next_buffer);
+      b->flags &= ~VLIB_BUFFER_NEXT_PRESENT;
+      b->total_length_not_including_first_buffer = 0;
+    }
+
+  ttl = a->expiration_time == 0 ? a->ttl : a->expiration_time - now;
+
+  /* Announce that we did a recursive lookup */
+  d->flags = clib_host_to_net_u16 (DNS_AA | DNS_RA | DNS_RD |
+				   DNS_OPCODE_QUERY | DNS_QR | a->rcode);
+  d->anscount = 0;
+  d->nscount = 0;
+  d->arcount = 0;
+
+  if (a->rcode == DNS_RCODE_NO_ERROR)
+    {
+      d->anscount = clib_host_to_net_u16 (1);
+
+      /* Name pointer to the question (0xC00C), then a single RR */
+      qend[0] = 0xC0;
+      qend[1] = 0x0C;
+      rr = (dns_rr_t *) (qend + 2);
+      rr->class = clib_host_to_net_u16 (DNS_CLASS_IN);
+      rr->ttl = clib_host_to_net_u32 (ttl);
+      rr->rdlength = clib_host_to_net_u16 (rdlength);
+      if (a->labels)
+	{
+	  rr->type = clib_host_to_net_u16 (DNS_TYPE_PTR);
+	  clib_memcpy_fast (rr->rdata, a->labels, rdlength);
+	}
+      else
+	{
+	  rr->type = clib_host_to_net_u16 (DNS_TYPE_A);
+	  clib_memcpy_fast (rr->rdata, &a->address, rdlength);
+	}
+    }
+
+  udp->dst_port = udp->src_port;
+  udp->src_port = clib_host_to_net_u16 (UDP_DST_PORT_dns);
+  udp->length = clib_host_to_net_u16 (sizeof (*udp) + dns_len);
+  udp->checksum = 0;
+
+  tmp.as_u32 = ip->src_address.as_u32;
+  ip->src_address.as_u32 = ip->dst_address.as_u32;
+  ip->dst_address.as_u32 = tmp.as_u32;
+  ip->length = clib_host_to_net_u16 (sizeof (*ip) + sizeof (*udp) + dns_len);
+  ip->ttl = 255;
+  ip->flags_and_fragment_offset = 0;
+  ip->checksum = ip4_header_checksum (ip);
+
+  b->current_data = (u8 *) ip - b->data;
+  b->current_length = sizeof (*ip) + sizeof (*udp) + dns_len;
+  b->flags |= VNET_BUFFER_F_LOCALLY_ORIGINATED;
+  /* Reply in the FIB the request arrived in */
+  vnet_buffer (b)->sw_if_index[VLIB_TX] = ~0;
+
+  return 0;
+}
+
 static uword
 dns46_request_inline (vlib_main_t * vm,
 		      vlib_node_runtime_t * node, vlib_frame_t * frame,
@@ -63,11 +214,30 @@ dns46_request_inline (vlib_main_t * vm,
   u32 n_left_from, *from, *to_next;
   dns46_request_next_t next_index;
   dns_main_t *dm = &dns_main;
+  dns_per_thread_data_t *ptd;
+  u32 n_hits = 0, n_misses = 0, n_negative_hits = 0;
+  u32 epoch;
+  f64 now;
 
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;
   next_index = node->cached_next_index;
 
+  if (PREDICT_FALSE (dm->is_enabled == 0))
+    ptd = 0;
+  else
+    {
+      /* Drop the answers copied before the cache was last changed */
+      ptd = vec_elt_at_index (dm->per_thread_data, vm->thread_index);
+      epoch = clib_atomic_load_acq_n (&dm->cache_epoch);
+      if (PREDICT_FALSE (ptd->epoch != epoch))
+	{
+	  dns_per_thread_flush (ptd);
+	  ptd->epoch = epoch;
+	}
+    }
+  now = vlib_time_now (vm);
+
   while (n_left_from > 0)
     {
       u32 n_left_to_next;
@@ -150,10 +320,15 @@ dns46_request_inline (vlib_main_t * vm,
 	  ip6_header_t *ip60 = 0;
 	  dns_cache_entry_t *ep0;
 	  dns_pending_request_t _t0, *t0 = &_t0;
+	  dns_answer_t _a0, *a0;
 	  u16 flags0;
 	  u32 pool_index0 = ~0;
+	  u32 request_type0;
 	  u8 *name0;
 	  u8 *label0;
+	  u8 *qend0;
+	  uword *p0;
+	  int rv0;
 
 	  /* speculatively enqueue b0 to the current next frame */
 	  bi0 = from[0];
@@ -167,7 +342,7 @@ dns46_request_inline (vlib_main_t * vm,
 	  d0 = vlib_buffer_get_current (b0);
 	  u0 = (udp_header_t *) ((u8 *) d0 - sizeof (*u0));
 
-	  if (PREDICT_FALSE (dm->is_enabled == 0))
+	  if (PREDICT_FALSE (ptd == 0))
 	    {
 	      next0 = DNS46_REQUEST_NEXT_PUNT;
 	      goto done0;
@@ -207,6 +382,26 @@ dns46_request_inline (vlib_main_t * vm,
 	    }
 
 	  label0 = (u8 *) (d0 + 1);
+	  qend0 = dns_question_to_key (label0, vlib_buffer_get_tail (b0),
+				       &ptd->key, &request_type0);
+	  if (qend0 == 0)
+	    {
+	      error0 = DNS46_REQUEST_ERROR_BAD_REQUEST;
+	      goto done0;
+	    }
+
+	  /* Most requests are answered from this thread's cache */
+	  p0 = hash_get_mem (ptd->answer_by_key, ptd->key);
+	  if (p0)
+	    {
+	      a0 = pool_elt_at_index (ptd->answers, p0[0]);
+	      if (a0->expiration_time == 0 || now < a0->expiration_time)
+		{
+		  n_hits++;
+		  goto reply0;
+		}
+	      dns_per_thread_del (ptd, a0);
+	    }
 
 	  /*
 	   * vnet_dns_labels_to_name produces a non NULL terminated vector
@@ -216,20 +411,7 @@ dns46_request_inline (vlib_main_t * vm,
 	  vec_add1 (name0, 0);
 	  vec_dec_len (name0, 1);
 
-	  t0->request_type = DNS_PEER_PENDING_NAME_TO_IP;
-
-	  /*
-	   * See if this is a reverse lookup. Both ip4 and ip6 reverse
-	   * requests end with ".arpa"
-	   */
-	  if (PREDICT_TRUE (vec_len (name0) > 5))
-	    {
-	      u8 *aptr0 = name0 + vec_len (name0) - 5;
-
-	      if (!memcmp (aptr0, ".arpa", 5))
-		t0->request_type = DNS_PEER_PENDING_IP_TO_NAME;
-	    }
-
+	  t0->request_type = request_type0;
 	  t0->client_index = ~0;
 	  t0->is_ip6 = is_ip6;
 	  t0->dst_port = u0->src_port;
@@ -242,21 +424,52 @@ dns46_request_inline (vlib_main_t * vm,
 	    clib_memcpy_fast (t0->dst_address, ip40->src_address.as_u8,
 			      sizeof (ip4_address_t));
 
-	  vnet_dns_resolve_name (vm, dm, name0, t0, &ep0);
-
+	  /* Copy the answer out while the entry can't go away */
+	  clib_memset (&_a0, 0, sizeof (_a0));
+	  dns_cache_lock (dm, 13);
+	  rv0 = vnet_dns_resolve_name_nolock (vm, dm, name0, t0, &ep0);
 	  if (ep0)
+	    rv0 = vnet_dns_entry_to_answer_nolock (dm, name0, request_type0,
+						   &_a0);
+	  dns_cache_unlock (dm);
+	  n_misses++;
+
+	  if (ep0 == 0)
 	    {
-	      if (is_ip6)
-		vnet_send_dns6_reply (vm, dm, t0, ep0, b0);
-	      else
-		vnet_send_dns4_reply (vm, dm, t0, ep0, b0);
-	      next0 = DNS46_REQUEST_NEXT_IP_LOOKUP;
+	      /* The pending request owns the name, unless it failed */
+	      if (rv0)
+		vec_free (name0);
+	      error0 = DNS46_REQUEST_ERROR_RESOLUTION_REQUIRED;
+	      goto done0;
 	    }
-	  else
+	  vec_free (name0);
+	  if (rv0)
 	    {
 	      error0 = DNS46_REQUEST_ERROR_RESOLUTION_REQUIRED;
+	      goto done0;
 	    }
 
+	  if (pool_elts (ptd->answers) >= dm->name_cache_size)
+	    dns_per_thread_flush (ptd);
+	  if (ptd->answer_by_key == 0)
+	    ptd->answer_by_key = hash_create_vec (0, sizeof (u8),
+						  sizeof (uword));
+	  pool_get (ptd->answers, a0);
+	  *a0 = _a0;
+	  a0->key = vec_dup (ptd->key);
+	  hash_set_mem (ptd->answer_by_key, a0->key, a0 - ptd->answers);
+
+	reply0:
+	  if (a0->rcode != DNS_RCODE_NO_ERROR)
+	    n_negative_hits++;
+	  if (dns4_reply_in_place (vm, b0, ip40, u0, d0, qend0, a0, now))
+	    {
+	      error0 = DNS46_REQUEST_ERROR_NO_BUFFER_SPACE;
+	      goto done0;
+	    }
+	  pool_index0 = a0 - ptd->answers;
+	  next0 = DNS46_REQUEST_NEXT_IP_LOOKUP;
+
 	done0:
 	  b0->error = node->errors[error0];
 
@@ -278,6 +491,14 @@ dns46_request_inline (vlib_main_t * vm,
       vlib_put_next_frame (vm, node, next_index, n_left_to_next);
     }
 
+  vlib_node_increment_counter (vm, node->node_index,
+			       DNS46_REQUEST_ERROR_CACHE_HIT, n_hits);
+  vlib_node_increment_counter (vm, node->node_index,
+			       DNS46_REQUEST_ERROR_CACHE_MISS, n_misses);
+  vlib_node_increment_counter (vm, node->node_index,
+			       DNS46_REQUEST_ERROR_NEGATIVE_HIT,
+			       n_negative_hits);
+
   return frame->n_vectors;
 }
 
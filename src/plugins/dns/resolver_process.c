@@ -42,7 +42,7 @@ resolve_event (vlib_main_t * vm, dns_main_t * dm, f64 now, u8 * reply)
   dns_header_t *d;
   u32 pool_index;
   dns_cache_entry_t *ep;
-  u32 min_ttl;
+  u32 min_ttl, negative_ttl;
   u16 flags;
   u16 rcode;
   int i;
@@ -71,6 +71,10 @@ resolve_event (vlib_main_t * vm, dns_main_t * dm, f64 now, u8 * reply)
 
   ep = pool_elt_at_index (dm->entries, pool_index);
 
+  /* Threads may hold answers copied from the response being replaced */
+  if (ep->flags & DNS_CACHE_ENTRY_FLAG_VALID)
+    dns_cache_bump_epoch (dm);
+
   if (ep->dns_response)
     vec_free (ep->dns_response);
 
@@ -142,10 +146,14 @@ reply:
   ep->dns_response = reply;
 
   /*
-   * Pick a sensible default cache entry expiration time.
-   * We don't play the 10-second timeout game.
+   * Cache for the smallest answer TTL, or pick a sensible default
+   * expiration time. We don't play the 10-second timeout game.
    */
-  ep->expiration_time = now + 600.0;
+  min_ttl = ~0;
+  negative_ttl = ~0;
+  vnet_dns_response_ttls (reply, &min_ttl, &negative_ttl);
+  if (min_ttl == ~0)
+    min_ttl = 600;
 
   if (0)
     clib_warning ("resolving '%s', was %s valid",
@@ -164,7 +172,10 @@ reply:
   entry_was_valid = (ep->flags & DNS_CACHE_ENTRY_FLAG_VALID) ? 1 : 0;
 
   if (vec_len (ep->dns_response))
-    ep->flags |= DNS_CACHE_ENTRY_FLAG_VALID;
+    {
+      ep->flags |= DNS_CACHE_ENTRY_FLAG_VALID;
+      vnet_dns_entry_set_expiry_nolock (dm, ep, now, min_ttl);
+    }
 
   /* Most likely, send 1 message */
   for (i = 0; i < vec_len (ep->pending_requests); i++)
@@ -187,10 +198,7 @@ reply:
 	      clib_host_to_net_u16 (VL_API_DNS_RESOLVE_NAME_REPLY
 				    + dm->msg_id_base);
 	    rmp->context = pr->client_context;
-	    min_ttl = ~0;
-	    rv = vnet_dns_response_to_reply (ep->dns_response, rmp, &min_ttl);
-	    if (min_ttl != ~0)
-	      ep->expiration_time = now + min_ttl;
+	    rv = vnet_dns_response_to_reply (ep->dns_response, rmp, 0);
 	    rmp->retval = clib_host_to_net_u32 (rv);
 	    vl_api_send_msg (regp, (u8 *) rmp);
 	  }
@@ -209,10 +217,7 @@ reply:
 	      clib_host_to_net_u16 (VL_API_DNS_RESOLVE_IP_REPLY
 				    + dm->msg_id_base);
 	    rmp->context = pr->client_context;
-	    min_ttl = ~0;
-	    rv = vnet_dns_response_to_name (ep->dns_response, rmp, &min_ttl);
-	    if (min_ttl != ~0)
-	      ep->expiration_time = now + min_ttl;
+	    rv = vnet_dns_response_to_name (ep->dns_response, rmp, 0);
 	    rmp->retval = clib_host_to_net_u32 (rv);
 	    vl_api_send_msg (regp, (u8 *) rmp);
 	  }
@@ -272,11 +277,25 @@ reply:
 		      format_ip6_address,
 		      dm->ip6_name_servers + ep->server_rotor, ep->name);
       /* FALLTHROUGH */
-    case DNS_RCODE_NAME_ERROR:
     case DNS_RCODE_FORMAT_ERROR:
       /* remove trash from the cache... */
       vnet_dns_delete_entry_by_index_nolock (dm, ep - dm->entries);
       break;
+
+    case DNS_RCODE_NAME_ERROR:
+      /*
+       * Remember that the name doesn't exist, for as long as the SOA
+       * record says (RFC 2308). No SOA, no negative caching.
+       */
+      if (negative_ttl == ~0 || dm->negative_ttl_in_seconds == 0)
+	{
+	  vnet_dns_delete_entry_by_index_nolock (dm, ep - dm->entries);
+	  break;
+	}
+      ep->flags |= DNS_CACHE_ENTRY_FLAG_NEGATIVE;
+      vnet_dns_entry_set_expiry_nolock (
+	dm, ep, now, clib_min (negative_ttl, dm->negative_ttl_in_seconds));
+      break;
     }
 
 
@@ -301,6 +320,57 @@ retry_scan (vlib_main_t * vm, dns_main_t * dm, f64 now)
     }
 }
 
+static void
+expire_scan (vlib_main_t *vm, dns_main_t *dm, f64 now)
+{
+  dns_cache_entry_t *ep;
+  u32 *indices_to_delete = 0;
+  u32 *handle;
+  uword *p;
+  int i;
+
+  if (dm->cache_entry_by_name == 0)
+    return;
+
+  dns_cache_lock (dm, 12);
+
+  vec_reset_length (dm->expired_entries);
+  dm->expired_entries = tw_timer_expire_timers_vec_2t_2w_512sl (
+    &dm->expiry_wheel, now, dm->expired_entries);
+
+  /* Expired timers are gone, forget their handles before any deletion */
+  vec_foreach (handle, dm->expired_entries)
+    {
+      /* timer id 0, the handle is the pool index */
+      ep = pool_elt_at_index (dm->entries, handle[0]);
+      ep->expiry_timer_handle = ~0;
+    }
+
+  /* Take out the rest of each resolution chain, as lookups do */
+  vec_foreach (handle, dm->expired_entries)
+    {
+      if (pool_is_free_index (dm->entries, handle[0]))
+	continue;
+      ep = pool_elt_at_index (dm->entries, handle[0]);
+      while (1)
+	{
+	  vec_add1 (indices_to_delete, ep - dm->entries);
+	  if (!(ep->flags & DNS_CACHE_ENTRY_FLAG_CNAME))
+	    break;
+	  p = hash_get_mem (dm->cache_entry_by_name, ep->cname);
+	  if (!p)
+	    break;
+	  ep = pool_elt_at_index (dm->entries, p[0]);
+	}
+      for (i = 0; i < vec_len (indices_to_delete); i++)
+	vnet_dns_delete_entry_by_index_nolock (dm, indices_to_delete[i]);
+      vec_reset_length (indices_to_delete);
+    }
+
+  dns_cache_unlock (dm);
+  vec_free (indices_to_delete);
+}
+
 static uword
 dns_resolver_process (vlib_main_t * vm,
 		      vlib_node_runtime_t * rt, vlib_frame_t * f)
@@ -308,13 +378,18 @@ dns_resolver_process (vlib_main_t * vm,
   dns_main_t *dm = &dns_main;
   f64 now;
   f64 timeout = 1000.0;
+  f64 retry_time = 0.0;
   uword *event_data = 0;
   uword event_type;
   int i;
 
   while (1)
     {
-      vlib_process_wait_for_event_or_clock (vm, timeout);
+      /* Tick the expiration timers once a second, while there are any */
+      if (pool_elts (dm->entries))
+	vlib_process_wait_for_event_or_clock (vm, clib_min (timeout, 1.0));
+      else
+	vlib_process_wait_for_event_or_clock (vm, timeout);
 
       now = vlib_time_now (vm);
 
@@ -325,6 +400,7 @@ dns_resolver_process (vlib_main_t * vm,
 	  /* Send one of these when a resolution is pending */
 	case DNS_RESOLVER_EVENT_PENDING:
 	  timeout = 2.0;
+	  retry_time = now + timeout;
 	  break;
 
 	case DNS_RESOLVER_EVENT_RESOLVED:
@@ -333,11 +409,17 @@ dns_resolver_process (vlib_main_t * vm,
 	  break;
 
 	case ~0:		/* timeout */
-	  retry_scan (vm, dm, now);
+	  if (now >= retry_time)
+	    {
+	      retry_scan (vm, dm, now);
+	      retry_time = now + timeout;
+	    }
 	  break;
 	}
       vec_reset_length (event_data);
 
+      expire_scan (vm, dm, now);
+
       /* No work? Back to slow timeout mode... */
       if (vec_len (dm->unresolved_entries) == 0)
 	timeout = 1000.0;
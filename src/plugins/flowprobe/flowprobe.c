@@ -28,6 +28,7 @@
 #include <vnet/plugin/plugin.h>
 #include <vnet/udp/udp_local.h>
 #include <flowprobe/flowprobe.h>
+#include <vppinfra/bihash_template.c>
 
 #include <vlibapi/api.h>
 #include <vlibmemory/api.h>
@@ -244,7 +245,6 @@ flowprobe_template_rewrite_inline (ipfix_exporter_t *exp, flow_report_t *fr,
   ip4_ipfix_template_packet_t *tp;
   u32 field_count = 0;
   flow_report_stream_t *stream;
-  flowprobe_main_t *fm = &flowprobe_main;
   flowprobe_record_t flags = fr->opaque.as_uword;
   bool collect_ip4 = false, collect_ip6 = false;
 
@@ -317,8 +317,6 @@ flowprobe_template_rewrite_inline (ipfix_exporter_t *exp, flow_report_t *fr,
   /* Field count in this template */
   t->id_count = ipfix_id_count (fr->template_id, f - first_field);
 
-  fm->template_size[flags] = (u8 *) f - (u8 *) s;
-
   /* set length in octets */
   s->set_id_length =
     ipfix_set_id_length (2 /* set_id */ , (u8 *) f - (u8 *) s);
@@ -382,60 +380,27 @@ flowprobe_template_rewrite_l2_ip6 (ipfix_exporter_t *exp, flow_report_t *fr,
 					    FLOW_VARIANT_L2_IP6);
 }
 
-/**
- * @brief Flush accumulated data
- * @param frm flow_report_main_t *
- * @param fr flow_report_t *
- * @param f vlib_frame_t *
- *
- * <em>Notes:</em>
- * This function must simply return the incoming frame, or no template packets
- * will be sent.
- */
-vlib_frame_t *
-flowprobe_data_callback_ip4 (flow_report_main_t *frm, ipfix_exporter_t *exp,
-			     flow_report_t *fr, vlib_frame_t *f, u32 *to_next,
-			     u32 node_index)
-{
-  flowprobe_flush_callback_ip4 ();
-  return f;
-}
-
-vlib_frame_t *
-flowprobe_data_callback_ip6 (flow_report_main_t *frm, ipfix_exporter_t *exp,
-			     flow_report_t *fr, vlib_frame_t *f, u32 *to_next,
-			     u32 node_index)
-{
-  flowprobe_flush_callback_ip6 ();
-  return f;
-}
-
-vlib_frame_t *
-flowprobe_data_callback_l2 (flow_report_main_t *frm, ipfix_exporter_t *exp,
-			    flow_report_t *fr, vlib_frame_t *f, u32 *to_next,
-			    u32 node_index)
-{
-  flowprobe_flush_callback_l2 ();
-  return f;
-}
-
 static int
 flowprobe_template_add_del (u32 domain_id, u16 src_port,
 			    flowprobe_record_t flags,
-			    vnet_flow_data_callback_t * flow_data_callback,
-			    vnet_flow_rewrite_callback_t * rewrite_callback,
-			    bool is_add, u16 * template_id)
+			    vnet_flow_rewrite_callback_t *rewrite_callback,
+			    bool is_add, u16 *template_id, u32 *report_index)
 {
   ipfix_exporter_t *exp = &flow_report_main.exporters[0];
   vnet_flow_report_add_del_args_t a = {
     .rewrite_callback = rewrite_callback,
-    .flow_data_callback = flow_data_callback,
     .is_add = is_add,
     .domain_id = domain_id,
     .src_port = src_port,
     .opaque.as_uword = flags,
+    .flow_report_index = ~0,
   };
-  return vnet_flow_report_add_del (exp, &a, template_id);
+  int rv;
+
+  /* records are added from the data path, no data callback */
+  rv = vnet_flow_report_add_del (exp, &a, template_id);
+  *report_index = is_add ? a.flow_report_index : ~0;
+  return rv;
 }
 
 static void
@@ -470,8 +435,8 @@ flowprobe_create_state_tables (u32 active_timer)
   /* Hash table per worker */
   fm->ht_log2len = FLOWPROBE_LOG2_HASHSIZE;
 
-  /* Init per worker flow state and timer wheels */
-  if (active_timer)
+  /* Init per worker flow state and timer wheels, once */
+  if (active_timer && !fm->timers_per_worker)
     {
       vec_validate (fm->timers_per_worker, num_threads - 1);
       vec_validate (fm->expired_passive_per_worker, num_threads - 1);
@@ -480,11 +445,10 @@ flowprobe_create_state_tables (u32 active_timer)
 
       for (i = 0; i < num_threads; i++)
 	{
-	  int j;
+	  u8 *name = format (0, "flowprobe flows thread %u%c", i, 0);
 	  pool_alloc (fm->pool_per_worker[i], 1 << fm->ht_log2len);
-	  vec_resize (fm->hash_per_worker[i], 1 << fm->ht_log2len);
-	  for (j = 0; j < (1 << fm->ht_log2len); j++)
-	    fm->hash_per_worker[i][j] = ~0;
+	  clib_bihash_init_64_8 (&fm->hash_per_worker[i], (char *) name,
+				 1 << fm->ht_log2len, 0);
 	  fm->timers_per_worker[i] =
 	    clib_mem_alloc (sizeof (TWT (tw_timer_wheel)));
 	  tw_timer_wheel_init_2t_1w_2048sl (fm->timers_per_worker[i],
@@ -493,7 +457,7 @@ flowprobe_create_state_tables (u32 active_timer)
 	}
       fm->disabled = true;
     }
-  else
+  else if (!active_timer && !fm->stateless_entry)
     {
       f64 now = vlib_time_now (vm);
       vec_validate (fm->stateless_entry, num_threads - 1);
@@ -552,24 +516,23 @@ flowprobe_interface_add_del_feature (flowprobe_main_t *fm, u32 sw_if_index,
 	{
 	  if (fm->record & FLOW_RECORD_L2)
 	    {
-	      rv = flowprobe_template_add_del (1, UDP_DST_PORT_ipfix, flags,
-					       flowprobe_data_callback_l2,
-					       flowprobe_template_rewrite_l2,
-					       is_add, &template_id);
+	      rv = flowprobe_template_add_del (
+		1, UDP_DST_PORT_ipfix, flags, flowprobe_template_rewrite_l2,
+		is_add, &template_id,
+		&fm->context[FLOW_VARIANT_L2].report_index);
 	    }
 	  if (fm->record & FLOW_RECORD_L3 || fm->record & FLOW_RECORD_L4)
 	    {
-	      rv = flowprobe_template_add_del (1, UDP_DST_PORT_ipfix, flags,
-					       flowprobe_data_callback_l2,
-					       flowprobe_template_rewrite_l2_ip4,
-					       is_add, &template_id);
+	      rv = flowprobe_template_add_del (
+		1, UDP_DST_PORT_ipfix, flags,
+		flowprobe_template_rewrite_l2_ip4, is_add, &template_id,
+		&fm->context[FLOW_VARIANT_L2_IP4].report_index);
 	      fm->template_reports[flags | FLOW_RECORD_L2_IP4] =
 		(is_add) ? template_id : 0;
-	      rv =
-		flowprobe_template_add_del (1, UDP_DST_PORT_ipfix, flags,
-					    flowprobe_data_callback_l2,
-					    flowprobe_template_rewrite_l2_ip6,
-					    is_add, &template_id);
+	      rv = flowprobe_template_add_del (
+		1, UDP_DST_PORT_ipfix, flags,
+		flowprobe_template_rewrite_l2_ip6, is_add, &template_id,
+		&fm->context[FLOW_VARIANT_L2_IP6].report_index);
 	      fm->template_reports[flags | FLOW_RECORD_L2_IP6] =
 		(is_add) ? template_id : 0;
 
@@ -583,15 +546,13 @@ flowprobe_interface_add_del_feature (flowprobe_main_t *fm, u32 sw_if_index,
 	    }
 	}
       else if (which == FLOW_VARIANT_IP4)
-	rv = flowprobe_template_add_del (1, UDP_DST_PORT_ipfix, flags,
-					 flowprobe_data_callback_ip4,
-					 flowprobe_template_rewrite_ip4,
-					 is_add, &template_id);
+	rv = flowprobe_template_add_del (
+	  1, UDP_DST_PORT_ipfix, flags, flowprobe_template_rewrite_ip4, is_add,
+	  &template_id, &fm->context[FLOW_VARIANT_IP4].report_index);
       else if (which == FLOW_VARIANT_IP6)
-	rv = flowprobe_template_add_del (1, UDP_DST_PORT_ipfix, flags,
-					 flowprobe_data_callback_ip6,
-					 flowprobe_template_rewrite_ip6,
-					 is_add, &template_id);
+	rv = flowprobe_template_add_del (
+	  1, UDP_DST_PORT_ipfix, flags, flowprobe_template_rewrite_ip6, is_add,
+	  &template_id, &fm->context[FLOW_VARIANT_IP6].report_index);
     }
   if (rv && rv != VNET_API_ERROR_VALUE_EXIST)
     {
@@ -639,12 +600,13 @@ flowprobe_interface_add_del_feature (flowprobe_main_t *fm, u32 sw_if_index,
 				     sw_if_index, is_add, 0, 0);
     }
 
-  /* Stateful flow collection */
-  if (is_add && !fm->initialized)
+  /* Stateful or stateless flow collection, as per the current params */
+  if (is_add)
     {
-      flowprobe_create_state_tables (fm->active_timer);
-      if (fm->active_timer)
+      /* the walker also sends aged export buffers, stateless or not */
+      if (!fm->initialized)
 	vlib_process_signal_event (vm, flowprobe_timer_node.index, 1, 0);
+      flowprobe_create_state_tables (fm->active_timer);
     }
 
   return 0;
@@ -1027,6 +989,8 @@ format_flowprobe_params (u8 * s, va_list * args)
   flowprobe_record_t flags = va_arg (*args, flowprobe_record_t);
   u32 active_timer = va_arg (*args, u32);
   u32 passive_timer = va_arg (*args, u32);
+  u32 sampling_interval = va_arg (*args, u32);
+  int sampling_random = va_arg (*args, int);
 
   if (flags & FLOW_RECORD_L2)
     s = format (s, " l2");
@@ -1041,6 +1005,10 @@ format_flowprobe_params (u8 * s, va_list * args)
   if (passive_timer != (u32) ~ 0)
     s = format (s, " passive: %d", passive_timer);
 
+  if (sampling_interval > 1)
+    s = format (s, " sampling: 1 in %u%s", sampling_interval,
+		sampling_random ? " random" : "");
+
   return s;
 }
 
@@ -1078,13 +1046,16 @@ flowprobe_show_stats_fn (vlib_main_t * vm,
 
   vlib_cli_output (vm, "IPFIX table statistics");
   vlib_cli_output (vm, "Flow entry size: %d\n", sizeof (flowprobe_entry_t));
-  vlib_cli_output (vm, "Flow pool size per thread: %d\n",
+  vlib_cli_output (vm, "Flow table buckets per thread: %d\n",
 		   0x1 << FLOWPROBE_LOG2_HASHSIZE);
 
   for (i = 0; i < vec_len (fm->pool_per_worker); i++)
-    vlib_cli_output (vm, "Pool utilisation thread %d is %d%%\n", i,
-		     (100 * pool_elts (fm->pool_per_worker[i])) /
-		     (0x1 << FLOWPROBE_LOG2_HASHSIZE));
+    {
+      vlib_cli_output (vm, "Thread %d: %d flows", i,
+		       pool_elts (fm->pool_per_worker[i]));
+      vlib_cli_output (vm, "%U", format_bihash_64_8, &fm->hash_per_worker[i],
+		       0 /* verbose */);
+    }
   return 0;
 }
 
@@ -1247,7 +1218,39 @@ flowprobe_show_params_command_fn (vlib_main_t * vm,
   u32 passive_timer = fm->passive_timer;
 
   vlib_cli_output (vm, "%U", format_flowprobe_params, flags, active_timer,
-		   passive_timer);
+		   passive_timer, fm->sampling_interval,
+		   (int) fm->sampling_random);
+  return 0;
+}
+
+static clib_error_t *
+flowprobe_sampling_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			       vlib_cli_command_t *cmd)
+{
+  flowprobe_main_t *fm = &flowprobe_main;
+  u32 interval = ~0, i;
+  bool random = false;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "%u", &interval))
+	;
+      else if (unformat (input, "random"))
+	random = true;
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, input);
+    }
+
+  if (interval == ~0)
+    return clib_error_return (0, "Please specify the sampling interval...");
+
+  /* workers pick the new settings up on their next frame */
+  fm->sampling_random = random;
+  for (i = 0; i < vec_len (fm->sampler_per_worker); i++)
+    fm->sampler_per_worker[i].countdown = 0;
+  fm->sampling_interval = interval;
+
   return 0;
 }
 
@@ -1279,6 +1282,12 @@ VLIB_CLI_COMMAND (flowprobe_params_command, static) = {
   .function = flowprobe_params_command_fn,
 };
 
+VLIB_CLI_COMMAND (flowprobe_sampling_command, static) = {
+  .path = "flowprobe sampling",
+  .short_help = "flowprobe sampling <1-in-n> [random]",
+  .function = flowprobe_sampling_command_fn,
+};
+
 VLIB_CLI_COMMAND (flowprobe_show_feature_command, static) = {
     .path = "show flowprobe feature",
     .short_help =
@@ -1304,15 +1313,15 @@ VLIB_CLI_COMMAND (flowprobe_show_stats_command, static) = {
 /* *INDENT-ON* */
 
 /*
- * Main-core process, sending an interrupt to the per worker input
- * process that spins the per worker timer wheel.
+ * Main-core process, sending a periodic interrupt to the per worker input
+ * process that spins the per worker timer wheel. A worker left with
+ * expired entries after its time budget re-arms its own walker.
  */
 static uword
 timer_process (vlib_main_t * vm, vlib_node_runtime_t * rt, vlib_frame_t * f)
 {
   uword *event_data = 0;
   vlib_main_t **worker_vms = 0, *worker_vm;
-  flowprobe_main_t *fm = &flowprobe_main;
 
   /* Wait for Godot... */
   vlib_process_wait_for_event_or_clock (vm, 1e9);
@@ -1333,24 +1342,18 @@ timer_process (vlib_main_t * vm, vlib_node_runtime_t * rt, vlib_frame_t * f)
 	    vec_add1 (worker_vms, worker_vm);
 	}
     }
-  f64 sleep_duration = 0.1;
 
   while (1)
     {
       /* Send an interrupt to each timer input node */
-      sleep_duration = 0.1;
       for (i = 0; i < vec_len (worker_vms); i++)
 	{
 	  worker_vm = worker_vms[i];
 	  if (worker_vm)
-	    {
-	      vlib_node_set_interrupt_pending (worker_vm,
-					       flowprobe_walker_node.index);
-	      sleep_duration =
-		(fm->expired_passive_per_worker[i] > 0) ? 1e-4 : 0.1;
-	    }
+	    vlib_node_set_interrupt_pending (worker_vm,
+					     flowprobe_walker_node.index);
 	}
-      vlib_process_suspend (vm, sleep_duration);
+      vlib_process_suspend (vm, 0.1);
     }
   return 0;			/* or not */
 }
@@ -1389,20 +1392,18 @@ flowprobe_init (vlib_main_t * vm)
   fm->nanosecond_time_0 = unix_time_now_nsec ();
 
   clib_memset (fm->template_reports, 0, sizeof (fm->template_reports));
-  clib_memset (fm->template_size, 0, sizeof (fm->template_size));
   clib_memset (fm->template_per_flow, 0, sizeof (fm->template_per_flow));
 
   /* Decide how many worker threads we have */
   num_threads = 1 /* main thread */  + tm->n_threads;
 
-  /* Allocate per worker thread vectors per flavour */
   for (i = 0; i < FLOW_N_VARIANTS; i++)
-    {
-      vec_validate (fm->context[i].buffers_per_worker, num_threads - 1);
-      vec_validate (fm->context[i].frames_per_worker, num_threads - 1);
-      vec_validate (fm->context[i].next_record_offset_per_worker,
-		    num_threads - 1);
-    }
+    fm->context[i].report_index = ~0;
+
+  vec_validate_aligned (fm->sampler_per_worker, num_threads - 1,
+			CLIB_CACHE_LINE_BYTES);
+  for (i = 0; i < num_threads; i++)
+    fm->sampler_per_worker[i].seed = 0xdeadbeef + i;
 
   fm->active_timer = FLOWPROBE_TIMER_ACTIVE;
   fm->passive_timer = FLOWPROBE_TIMER_PASSIVE;
@@ -26,11 +26,14 @@
 #include <vnet/ipfix-export/flow_report.h>
 #include <vnet/ipfix-export/flow_report_classify.h>
 #include <vppinfra/tw_timer_2t_1w_2048sl.h>
+#include <vppinfra/bihash_64_8.h>
 
 /* Default timers in seconds */
 #define FLOWPROBE_TIMER_ACTIVE   (15)
 #define FLOWPROBE_TIMER_PASSIVE  120	// XXXX: FOR TESTING (30*60)
 #define FLOWPROBE_LOG2_HASHSIZE  (18)
+/* Partially filled export buffers are sent after this many seconds */
+#define FLOWPROBE_EXPORT_MAX_DELAY (1.0)
 
 typedef enum
 {
@@ -71,12 +74,8 @@ typedef struct
 {
   /* what to collect per variant */
   flowprobe_record_t flags;
-  /** ipfix buffers under construction, per-worker thread */
-  vlib_buffer_t **buffers_per_worker;
-  /** frames containing ipfix buffers, per-worker thread */
-  vlib_frame_t **frames_per_worker;
-  /** next record offset, per worker thread */
-  u16 *next_record_offset_per_worker;
+  /** flow report on exporter 0 the records are added to, ~0 if none */
+  u32 report_index;
 } flowprobe_protocol_context_t;
 
 /* *INDENT-OFF* */
@@ -96,6 +95,11 @@ typedef struct __attribute__ ((aligned (8))) {
 } flowprobe_key_t;
 /* *INDENT-ON* */
 
+/* the key is used as is in the per worker flow table */
+STATIC_ASSERT (sizeof (flowprobe_key_t) ==
+		 STRUCT_SIZE_OF (clib_bihash_kv_64_8_t, key),
+	       "flowprobe_key_t must match the flow table key size");
+
 typedef struct
 {
   u32 sec;
@@ -121,6 +125,15 @@ typedef struct
   } prot;
 } flowprobe_entry_t;
 
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  /** packets to skip before the next sample */
+  u32 countdown;
+  /** random sampling seed */
+  u32 seed;
+} flowprobe_sampler_t;
+
 /**
  * @file
  * @brief flow-per-packet plugin header file
@@ -132,15 +145,14 @@ typedef struct
 
   flowprobe_protocol_context_t context[FLOW_N_VARIANTS];
   u16 template_reports[FLOW_N_RECORDS];
-  u16 template_size[FLOW_N_RECORDS];
 
   /** Time reference pair */
   u64 nanosecond_time_0;
   f64 vlib_time_0;
 
   /** Per CPU flow-state */
-  u8 ht_log2len;		/* Hash table size is 2^log2len */
-  u32 **hash_per_worker;
+  u8 ht_log2len;		/* Hash table has 2^log2len buckets */
+  clib_bihash_64_8_t *hash_per_worker;
   flowprobe_entry_t **pool_per_worker;
   /* *INDENT-OFF* */
   TWT (tw_timer_wheel) ** timers_per_worker;
@@ -152,6 +164,11 @@ typedef struct
   u32 passive_timer;
   flowprobe_entry_t *stateless_entry;
 
+  /** 1-in-N packet sampling, 0 or 1 to look at every packet */
+  u32 sampling_interval;
+  bool sampling_random;
+  flowprobe_sampler_t *sampler_per_worker;
+
   bool initialized;
   bool disabled;
 
@@ -168,9 +185,6 @@ typedef struct
 extern flowprobe_main_t flowprobe_main;
 extern vlib_node_registration_t flowprobe_walker_node;
 
-void flowprobe_flush_callback_ip4 (void);
-void flowprobe_flush_callback_ip6 (void);
-void flowprobe_flush_callback_l2 (void);
 u8 *format_flowprobe_entry (u8 * s, va_list * args);
 
 #endif
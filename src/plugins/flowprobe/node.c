@@ -106,11 +106,9 @@ vlib_node_registration_t flowprobe_output_ip4_node;
 vlib_node_registration_t flowprobe_output_ip6_node;
 vlib_node_registration_t flowprobe_output_l2_node;
 
-/* No counters at the moment */
 #define foreach_flowprobe_error			\
-_(COLLISION, "Hash table collisions")		\
+_(SAMPLED_OUT, "Packets skipped by sampling")	\
 _(BUFFER, "Buffer allocation error")		\
-_(EXPORTED_PACKETS, "Exported packets")		\
 _(INPATH, "Exported packets in path")
 
 typedef enum
@@ -156,205 +154,158 @@ flowprobe_get_variant (flowprobe_variant_t which,
 #define NTP_TIMESTAMP 2208988800LU
 
 static inline u32
-flowprobe_common_add (vlib_buffer_t * to_b, flowprobe_entry_t * e, u16 offset)
+flowprobe_common_add (u8 *to, flowprobe_entry_t *e, u16 offset)
 {
   u16 start = offset;
 
   /* Ingress interface */
   u32 rx_if = clib_host_to_net_u32 (e->key.rx_sw_if_index);
-  clib_memcpy_fast (to_b->data + offset, &rx_if, sizeof (rx_if));
+  clib_memcpy_fast (to + offset, &rx_if, sizeof (rx_if));
   offset += sizeof (rx_if);
 
   /* Egress interface */
   u32 tx_if = clib_host_to_net_u32 (e->key.tx_sw_if_index);
-  clib_memcpy_fast (to_b->data + offset, &tx_if, sizeof (tx_if));
+  clib_memcpy_fast (to + offset, &tx_if, sizeof (tx_if));
   offset += sizeof (tx_if);
 
   /* Flow direction
      0x00: ingress flow
      0x01: egress flow */
-  to_b->data[offset++] = (e->key.direction == FLOW_DIRECTION_TX);
+  to[offset++] = (e->key.direction == FLOW_DIRECTION_TX);
 
   /* packet delta count */
   u64 packetdelta = clib_host_to_net_u64 (e->packetcount);
-  clib_memcpy_fast (to_b->data + offset, &packetdelta, sizeof (u64));
+  clib_memcpy_fast (to + offset, &packetdelta, sizeof (u64));
   offset += sizeof (u64);
 
   /* flowStartNanoseconds */
   u32 t = clib_host_to_net_u32 (e->flow_start.sec + NTP_TIMESTAMP);
-  clib_memcpy_fast (to_b->data + offset, &t, sizeof (u32));
+  clib_memcpy_fast (to + offset, &t, sizeof (u32));
   offset += sizeof (u32);
   t = clib_host_to_net_u32 (e->flow_start.nsec);
-  clib_memcpy_fast (to_b->data + offset, &t, sizeof (u32));
+  clib_memcpy_fast (to + offset, &t, sizeof (u32));
   offset += sizeof (u32);
 
   /* flowEndNanoseconds */
   t = clib_host_to_net_u32 (e->flow_end.sec + NTP_TIMESTAMP);
-  clib_memcpy_fast (to_b->data + offset, &t, sizeof (u32));
+  clib_memcpy_fast (to + offset, &t, sizeof (u32));
   offset += sizeof (u32);
   t = clib_host_to_net_u32 (e->flow_end.nsec);
-  clib_memcpy_fast (to_b->data + offset, &t, sizeof (u32));
+  clib_memcpy_fast (to + offset, &t, sizeof (u32));
   offset += sizeof (u32);
 
   return offset - start;
 }
 
 static inline u32
-flowprobe_l2_add (vlib_buffer_t * to_b, flowprobe_entry_t * e, u16 offset)
+flowprobe_l2_add (u8 *to, flowprobe_entry_t *e, u16 offset)
 {
   u16 start = offset;
 
   /* src mac address */
-  clib_memcpy_fast (to_b->data + offset, &e->key.src_mac, 6);
+  clib_memcpy_fast (to + offset, &e->key.src_mac, 6);
   offset += 6;
 
   /* dst mac address */
-  clib_memcpy_fast (to_b->data + offset, &e->key.dst_mac, 6);
+  clib_memcpy_fast (to + offset, &e->key.dst_mac, 6);
   offset += 6;
 
   /* ethertype */
-  clib_memcpy_fast (to_b->data + offset, &e->key.ethertype, 2);
+  clib_memcpy_fast (to + offset, &e->key.ethertype, 2);
   offset += 2;
 
   return offset - start;
 }
 
 static inline u32
-flowprobe_l3_ip6_add (vlib_buffer_t * to_b, flowprobe_entry_t * e, u16 offset)
+flowprobe_l3_ip6_add (u8 *to, flowprobe_entry_t *e, u16 offset)
 {
   u16 start = offset;
 
   /* ip6 src address */
-  clib_memcpy_fast (to_b->data + offset, &e->key.src_address,
+  clib_memcpy_fast (to + offset, &e->key.src_address,
 		    sizeof (ip6_address_t));
   offset += sizeof (ip6_address_t);
 
   /* ip6 dst address */
-  clib_memcpy_fast (to_b->data + offset, &e->key.dst_address,
+  clib_memcpy_fast (to + offset, &e->key.dst_address,
 		    sizeof (ip6_address_t));
   offset += sizeof (ip6_address_t);
 
   /* Protocol */
-  to_b->data[offset++] = e->key.protocol;
+  to[offset++] = e->key.protocol;
 
   /* octetDeltaCount */
   u64 octetdelta = clib_host_to_net_u64 (e->octetcount);
-  clib_memcpy_fast (to_b->data + offset, &octetdelta, sizeof (u64));
+  clib_memcpy_fast (to + offset, &octetdelta, sizeof (u64));
   offset += sizeof (u64);
 
   return offset - start;
 }
 
 static inline u32
-flowprobe_l3_ip4_add (vlib_buffer_t * to_b, flowprobe_entry_t * e, u16 offset)
+flowprobe_l3_ip4_add (u8 *to, flowprobe_entry_t *e, u16 offset)
 {
   u16 start = offset;
 
   /* ip4 src address */
-  clib_memcpy_fast (to_b->data + offset, &e->key.src_address.ip4,
+  clib_memcpy_fast (to + offset, &e->key.src_address.ip4,
 		    sizeof (ip4_address_t));
   offset += sizeof (ip4_address_t);
 
   /* ip4 dst address */
-  clib_memcpy_fast (to_b->data + offset, &e->key.dst_address.ip4,
+  clib_memcpy_fast (to + offset, &e->key.dst_address.ip4,
 		    sizeof (ip4_address_t));
   offset += sizeof (ip4_address_t);
 
   /* Protocol */
-  to_b->data[offset++] = e->key.protocol;
+  to[offset++] = e->key.protocol;
 
   /* octetDeltaCount */
   u64 octetdelta = clib_host_to_net_u64 (e->octetcount);
-  clib_memcpy_fast (to_b->data + offset, &octetdelta, sizeof (u64));
+  clib_memcpy_fast (to + offset, &octetdelta, sizeof (u64));
   offset += sizeof (u64);
 
   return offset - start;
 }
 
 static inline u32
-flowprobe_l4_add (vlib_buffer_t * to_b, flowprobe_entry_t * e, u16 offset)
+flowprobe_l4_add (u8 *to, flowprobe_entry_t *e, u16 offset)
 {
   u16 start = offset;
 
   /* src port */
-  clib_memcpy_fast (to_b->data + offset, &e->key.src_port, 2);
+  clib_memcpy_fast (to + offset, &e->key.src_port, 2);
   offset += 2;
 
   /* dst port */
-  clib_memcpy_fast (to_b->data + offset, &e->key.dst_port, 2);
+  clib_memcpy_fast (to + offset, &e->key.dst_port, 2);
   offset += 2;
 
   /* tcp control bits */
   u16 control_bits = htons (e->prot.tcp.flags);
-  clib_memcpy_fast (to_b->data + offset, &control_bits, 2);
+  clib_memcpy_fast (to + offset, &control_bits, 2);
   offset += 2;
 
   return offset - start;
 }
 
-static inline u32
-flowprobe_hash (flowprobe_key_t * k)
-{
-  flowprobe_main_t *fm = &flowprobe_main;
-  u32 h = 0;
-
-#ifdef clib_crc32c_uses_intrinsics
-  h = clib_crc32c ((u8 *) k, sizeof (*k));
-#else
-  int i;
-  u64 tmp = 0;
-  for (i = 0; i < sizeof (*k) / 8; i++)
-    tmp ^= ((u64 *) k)[i];
-
-  h = clib_xxhash (tmp);
-#endif
-
-  return h >> (32 - fm->ht_log2len);
-}
-
-flowprobe_entry_t *
-flowprobe_lookup (u32 my_cpu_number, flowprobe_key_t * k, u32 * poolindex,
-		  bool * collision)
+static flowprobe_entry_t *
+flowprobe_create (u32 my_cpu_number, clib_bihash_kv_64_8_t *kv, u64 hash,
+		  u32 *poolindex)
 {
   flowprobe_main_t *fm = &flowprobe_main;
   flowprobe_entry_t *e;
-  u32 h;
-
-  h = (fm->active_timer) ? flowprobe_hash (k) : 0;
-
-  /* Lookup in the flow state pool */
-  *poolindex = fm->hash_per_worker[my_cpu_number][h];
-  if (*poolindex != ~0)
-    {
-      e = pool_elt_at_index (fm->pool_per_worker[my_cpu_number], *poolindex);
-      if (e)
-	{
-	  /* Verify key or report collision */
-	  if (memcmp (k, &e->key, sizeof (flowprobe_key_t)))
-	    *collision = true;
-	  return e;
-	}
-    }
-
-  return 0;
-}
-
-flowprobe_entry_t *
-flowprobe_create (u32 my_cpu_number, flowprobe_key_t * k, u32 * poolindex)
-{
-  flowprobe_main_t *fm = &flowprobe_main;
-  u32 h;
-
-  flowprobe_entry_t *e;
-
-  /* Get my index */
-  h = (fm->active_timer) ? flowprobe_hash (k) : 0;
 
   pool_get (fm->pool_per_worker[my_cpu_number], e);
   *poolindex = e - fm->pool_per_worker[my_cpu_number];
-  fm->hash_per_worker[my_cpu_number][h] = *poolindex;
 
-  e->key = *k;
+  clib_memset (e, 0, sizeof (*e));
+  clib_memcpy_fast (&e->key, kv->key, sizeof (e->key));
+
+  kv->value = *poolindex;
+  clib_bihash_add_del_with_hash_64_8 (&fm->hash_per_worker[my_cpu_number], kv,
+				      hash, 1 /* is_add */);
 
   if (fm->passive_timer > 0)
     {
@@ -365,36 +316,48 @@ flowprobe_create (u32 my_cpu_number, flowprobe_key_t * k, u32 * poolindex)
   return e;
 }
 
-static inline void
-add_to_flow_record_state (vlib_main_t *vm, vlib_node_runtime_t *node,
-			  flowprobe_main_t *fm, vlib_buffer_t *b,
-			  timestamp_nsec_t timestamp, u16 length,
-			  flowprobe_variant_t which,
-			  flowprobe_direction_t direction,
-			  flowprobe_trace_t *t)
+/* 1-in-N packet sampling, deterministic or random */
+static_always_inline bool
+flowprobe_sample (flowprobe_main_t *fm, u32 my_cpu_number)
 {
-  if (fm->disabled)
-    return;
+  flowprobe_sampler_t *s = vec_elt_at_index (fm->sampler_per_worker,
+					     my_cpu_number);
 
-  ASSERT (direction == FLOW_DIRECTION_RX || direction == FLOW_DIRECTION_TX);
+  /* low bits of the LCG are not random, scale by the high ones instead */
+  if (fm->sampling_random)
+    return ((u64) random_u32 (&s->seed) * fm->sampling_interval) >> 32 == 0;
 
-  u32 my_cpu_number = vm->thread_index;
-  u16 octets = 0;
+  if (s->countdown)
+    {
+      s->countdown--;
+      return false;
+    }
+  s->countdown = fm->sampling_interval - 1;
+  return true;
+}
 
+static_always_inline void
+flowprobe_build_key (flowprobe_main_t *fm, vlib_buffer_t *b,
+		     flowprobe_variant_t which,
+		     flowprobe_direction_t direction, flowprobe_key_t *k,
+		     u16 *octets, u8 *tcp_flags)
+{
   flowprobe_record_t flags = fm->context[which].flags;
   bool collect_ip4 = false, collect_ip6 = false;
-  ASSERT (b);
   ethernet_header_t *eth = ethernet_buffer_get_header (b);
   u16 ethertype = clib_net_to_host_u16 (eth->type);
   u16 l2_hdr_sz = sizeof (ethernet_header_t);
-  /* *INDENT-OFF* */
-  flowprobe_key_t k = {};
-  /* *INDENT-ON* */
   ip4_header_t *ip4 = 0;
   ip6_header_t *ip6 = 0;
   udp_header_t *udp = 0;
   tcp_header_t *tcp = 0;
-  u8 tcp_flags = 0;
+
+  ASSERT (direction == FLOW_DIRECTION_RX || direction == FLOW_DIRECTION_TX);
+
+  /* padding is part of the key */
+  clib_memset_u64 (k, 0, sizeof (*k) / sizeof (u64));
+  *octets = 0;
+  *tcp_flags = 0;
 
   if (flags & FLOW_RECORD_L3 || flags & FLOW_RECORD_L4)
     {
@@ -402,17 +365,17 @@ add_to_flow_record_state (vlib_main_t *vm, vlib_node_runtime_t *node,
       collect_ip6 = which == FLOW_VARIANT_L2_IP6 || which == FLOW_VARIANT_IP6;
     }
 
-  k.rx_sw_if_index = vnet_buffer (b)->sw_if_index[VLIB_RX];
-  k.tx_sw_if_index = vnet_buffer (b)->sw_if_index[VLIB_TX];
+  k->rx_sw_if_index = vnet_buffer (b)->sw_if_index[VLIB_RX];
+  k->tx_sw_if_index = vnet_buffer (b)->sw_if_index[VLIB_TX];
 
-  k.which = which;
-  k.direction = direction;
+  k->which = which;
+  k->direction = direction;
 
   if (flags & FLOW_RECORD_L2)
     {
-      clib_memcpy_fast (k.src_mac, eth->src_address, 6);
-      clib_memcpy_fast (k.dst_mac, eth->dst_address, 6);
-      k.ethertype = ethertype;
+      clib_memcpy_fast (k->src_mac, eth->src_address, 6);
+      clib_memcpy_fast (k->dst_mac, eth->dst_address, 6);
+      k->ethertype = ethertype;
     }
   if (ethertype == ETHERNET_TYPE_VLAN)
     {
@@ -425,25 +388,25 @@ add_to_flow_record_state (vlib_main_t *vm, vlib_node_runtime_t *node,
 	  ethv++;
 	  l2_hdr_sz += sizeof (ethernet_vlan_header_tv_t);
 	}
-      k.ethertype = ethertype = clib_net_to_host_u16 ((ethv)->type);
+      k->ethertype = ethertype = clib_net_to_host_u16 ((ethv)->type);
     }
   if (collect_ip6 && ethertype == ETHERNET_TYPE_IP6)
     {
       ip6 = (ip6_header_t *) (b->data + l2_hdr_sz);
       if (flags & FLOW_RECORD_L3)
 	{
-	  k.src_address.as_u64[0] = ip6->src_address.as_u64[0];
-	  k.src_address.as_u64[1] = ip6->src_address.as_u64[1];
-	  k.dst_address.as_u64[0] = ip6->dst_address.as_u64[0];
-	  k.dst_address.as_u64[1] = ip6->dst_address.as_u64[1];
+	  k->src_address.as_u64[0] = ip6->src_address.as_u64[0];
+	  k->src_address.as_u64[1] = ip6->src_address.as_u64[1];
+	  k->dst_address.as_u64[0] = ip6->dst_address.as_u64[0];
+	  k->dst_address.as_u64[1] = ip6->dst_address.as_u64[1];
 	}
-      k.protocol = ip6->protocol;
-      if (k.protocol == IP_PROTOCOL_UDP)
+      k->protocol = ip6->protocol;
+      if (k->protocol == IP_PROTOCOL_UDP)
 	udp = (udp_header_t *) (ip6 + 1);
-      else if (k.protocol == IP_PROTOCOL_TCP)
+      else if (k->protocol == IP_PROTOCOL_TCP)
 	tcp = (tcp_header_t *) (ip6 + 1);
 
-      octets = clib_net_to_host_u16 (ip6->payload_length)
+      *octets = clib_net_to_host_u16 (ip6->payload_length)
 	+ sizeof (ip6_header_t);
     }
   if (collect_ip4 && ethertype == ETHERNET_TYPE_IP4)
@@ -451,268 +414,81 @@ add_to_flow_record_state (vlib_main_t *vm, vlib_node_runtime_t *node,
       ip4 = (ip4_header_t *) (b->data + l2_hdr_sz);
       if (flags & FLOW_RECORD_L3)
 	{
-	  k.src_address.ip4.as_u32 = ip4->src_address.as_u32;
-	  k.dst_address.ip4.as_u32 = ip4->dst_address.as_u32;
+	  k->src_address.ip4.as_u32 = ip4->src_address.as_u32;
+	  k->dst_address.ip4.as_u32 = ip4->dst_address.as_u32;
 	}
-      k.protocol = ip4->protocol;
-      if ((flags & FLOW_RECORD_L4) && k.protocol == IP_PROTOCOL_UDP)
+      k->protocol = ip4->protocol;
+      if ((flags & FLOW_RECORD_L4) && k->protocol == IP_PROTOCOL_UDP)
 	udp = (udp_header_t *) (ip4 + 1);
-      else if ((flags & FLOW_RECORD_L4) && k.protocol == IP_PROTOCOL_TCP)
+      else if ((flags & FLOW_RECORD_L4) && k->protocol == IP_PROTOCOL_TCP)
 	tcp = (tcp_header_t *) (ip4 + 1);
 
-      octets = clib_net_to_host_u16 (ip4->length);
+      *octets = clib_net_to_host_u16 (ip4->length);
     }
 
   if (udp)
     {
-      k.src_port = udp->src_port;
-      k.dst_port = udp->dst_port;
+      k->src_port = udp->src_port;
+      k->dst_port = udp->dst_port;
     }
   else if (tcp)
     {
-      k.src_port = tcp->src_port;
-      k.dst_port = tcp->dst_port;
-      tcp_flags = tcp->flags;
-    }
-
-  if (t)
-    {
-      t->rx_sw_if_index = k.rx_sw_if_index;
-      t->tx_sw_if_index = k.tx_sw_if_index;
-      clib_memcpy_fast (t->src_mac, k.src_mac, 6);
-      clib_memcpy_fast (t->dst_mac, k.dst_mac, 6);
-      t->ethertype = k.ethertype;
-      t->src_address.ip4.as_u32 = k.src_address.ip4.as_u32;
-      t->dst_address.ip4.as_u32 = k.dst_address.ip4.as_u32;
-      t->protocol = k.protocol;
-      t->src_port = k.src_port;
-      t->dst_port = k.dst_port;
-      t->which = k.which;
-    }
-
-  flowprobe_entry_t *e = 0;
-  f64 now = vlib_time_now (vm);
-  if (fm->active_timer > 0)
-    {
-      u32 poolindex = ~0;
-      bool collision = false;
-
-      e = flowprobe_lookup (my_cpu_number, &k, &poolindex, &collision);
-      if (collision)
-	{
-	  /* Flush data and clean up entry for reuse. */
-	  if (e->packetcount)
-	    flowprobe_export_entry (vm, e);
-	  e->key = k;
-	  e->flow_start = timestamp;
-	  vlib_node_increment_counter (vm, node->node_index,
-				       FLOWPROBE_ERROR_COLLISION, 1);
-	}
-      if (!e)			/* Create new entry */
-	{
-	  e = flowprobe_create (my_cpu_number, &k, &poolindex);
-	  e->last_exported = now;
-	  e->flow_start = timestamp;
-	}
-    }
-  else
-    {
-      e = &fm->stateless_entry[my_cpu_number];
-      e->key = k;
-    }
-
-  if (e)
-    {
-      /* Updating entry */
-      e->packetcount++;
-      e->octetcount += octets;
-      e->last_updated = now;
-      e->flow_end = timestamp;
-      e->prot.tcp.flags |= tcp_flags;
-      if (fm->active_timer == 0
-	  || (now > e->last_exported + fm->active_timer))
-	flowprobe_export_entry (vm, e);
+      k->src_port = tcp->src_port;
+      k->dst_port = tcp->dst_port;
+      *tcp_flags = tcp->flags;
     }
 }
 
-static u16
-flowprobe_get_headersize (void)
+static_always_inline void
+flowprobe_trace_key (flowprobe_trace_t *t, flowprobe_key_t *k)
 {
-  return sizeof (ip4_header_t) + sizeof (udp_header_t) +
-    sizeof (ipfix_message_header_t) + sizeof (ipfix_set_header_t);
+  t->rx_sw_if_index = k->rx_sw_if_index;
+  t->tx_sw_if_index = k->tx_sw_if_index;
+  clib_memcpy_fast (t->src_mac, k->src_mac, 6);
+  clib_memcpy_fast (t->dst_mac, k->dst_mac, 6);
+  t->ethertype = k->ethertype;
+  t->src_address.ip4.as_u32 = k->src_address.ip4.as_u32;
+  t->dst_address.ip4.as_u32 = k->dst_address.ip4.as_u32;
+  t->protocol = k->protocol;
+  t->src_port = k->src_port;
+  t->dst_port = k->dst_port;
+  t->which = k->which;
 }
 
-static void
-flowprobe_export_send (vlib_main_t * vm, vlib_buffer_t * b0,
-		       flowprobe_variant_t which)
+static_always_inline void
+flowprobe_update_entry (vlib_main_t *vm, flowprobe_main_t *fm,
+			flowprobe_entry_t *e, timestamp_nsec_t timestamp,
+			u16 octets, u8 tcp_flags, f64 now)
 {
-  flowprobe_main_t *fm = &flowprobe_main;
-  flow_report_main_t *frm = &flow_report_main;
-  ipfix_exporter_t *exp = pool_elt_at_index (frm->exporters, 0);
-  vlib_frame_t *f;
-  ip4_ipfix_template_packet_t *tp;
-  ipfix_set_header_t *s;
-  ipfix_message_header_t *h;
-  ip4_header_t *ip;
-  udp_header_t *udp;
-  flowprobe_record_t flags = fm->context[which].flags;
-  u32 my_cpu_number = vm->thread_index;
-
-  /* Fill in header */
-  flow_report_stream_t *stream;
-
-  /* Nothing to send */
-  if (fm->context[which].next_record_offset_per_worker[my_cpu_number] <=
-      flowprobe_get_headersize ())
-    return;
-
-  u32 i, index = vec_len (exp->streams);
-  for (i = 0; i < index; i++)
-    if (exp->streams[i].domain_id == 1)
-      {
-	index = i;
-	break;
-      }
-  if (i == vec_len (exp->streams))
-    {
-      vec_validate (exp->streams, index);
-      exp->streams[index].domain_id = 1;
-    }
-  stream = &exp->streams[index];
-
-  tp = vlib_buffer_get_current (b0);
-  ip = (ip4_header_t *) & tp->ip4;
-  udp = (udp_header_t *) (ip + 1);
-  h = (ipfix_message_header_t *) (udp + 1);
-  s = (ipfix_set_header_t *) (h + 1);
-
-  ip->ip_version_and_header_length = 0x45;
-  ip->ttl = 254;
-  ip->protocol = IP_PROTOCOL_UDP;
-  ip->flags_and_fragment_offset = 0;
-  ip->src_address.as_u32 = exp->src_address.ip.ip4.as_u32;
-  ip->dst_address.as_u32 = exp->ipfix_collector.ip.ip4.as_u32;
-  udp->src_port = clib_host_to_net_u16 (stream->src_port);
-  udp->dst_port = clib_host_to_net_u16 (exp->collector_port);
-  udp->checksum = 0;
-
-  /* FIXUP: message header export_time */
-  h->export_time = (u32)
-    (((f64) frm->unix_time_0) +
-     (vlib_time_now (frm->vlib_main) - frm->vlib_time_0));
-  h->export_time = clib_host_to_net_u32 (h->export_time);
-  h->domain_id = clib_host_to_net_u32 (stream->domain_id);
-
-  /* FIXUP: message header sequence_number */
-  h->sequence_number = stream->sequence_number++;
-  h->sequence_number = clib_host_to_net_u32 (h->sequence_number);
-
-  s->set_id_length = ipfix_set_id_length (fm->template_reports[flags],
-					  b0->current_length -
-					  (sizeof (*ip) + sizeof (*udp) +
-					   sizeof (*h)));
-  h->version_length = version_length (b0->current_length -
-				      (sizeof (*ip) + sizeof (*udp)));
-
-  ip->length = clib_host_to_net_u16 (b0->current_length);
-
-  ip->checksum = ip4_header_checksum (ip);
-  udp->length = clib_host_to_net_u16 (b0->current_length - sizeof (*ip));
-
-  if (exp->udp_checksum)
-    {
-      /* RFC 7011 section 10.3.2. */
-      udp->checksum = ip4_tcp_udp_compute_checksum (vm, b0, ip);
-      if (udp->checksum == 0)
-	udp->checksum = 0xffff;
-    }
-
-  ASSERT (ip4_header_checksum_is_valid (ip));
-
-  /* Find or allocate a frame */
-  f = fm->context[which].frames_per_worker[my_cpu_number];
-  if (PREDICT_FALSE (f == 0))
-    {
-      u32 *to_next;
-      f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
-      fm->context[which].frames_per_worker[my_cpu_number] = f;
-      u32 bi0 = vlib_get_buffer_index (vm, b0);
-
-      /* Enqueue the buffer */
-      to_next = vlib_frame_vector_args (f);
-      to_next[0] = bi0;
-      f->n_vectors = 1;
-    }
-
-  vlib_put_frame_to_node (vm, ip4_lookup_node.index, f);
-  vlib_node_increment_counter (vm, flowprobe_output_l2_node.index,
-			       FLOWPROBE_ERROR_EXPORTED_PACKETS, 1);
-
-  fm->context[which].frames_per_worker[my_cpu_number] = 0;
-  fm->context[which].buffers_per_worker[my_cpu_number] = 0;
-  fm->context[which].next_record_offset_per_worker[my_cpu_number] =
-    flowprobe_get_headersize ();
+  e->packetcount++;
+  e->octetcount += octets;
+  e->last_updated = now;
+  e->flow_end = timestamp;
+  e->prot.tcp.flags |= tcp_flags;
+  if (fm->active_timer == 0
+      || (now > e->last_exported + fm->active_timer))
+    flowprobe_export_entry (vm, e);
 }
 
-static vlib_buffer_t *
-flowprobe_get_buffer (vlib_main_t * vm, flowprobe_variant_t which)
-{
-  flowprobe_main_t *fm = &flowprobe_main;
-  ipfix_exporter_t *exp = pool_elt_at_index (flow_report_main.exporters, 0);
-  vlib_buffer_t *b0;
-  u32 bi0;
-  u32 my_cpu_number = vm->thread_index;
-
-  /* Find or allocate a buffer */
-  b0 = fm->context[which].buffers_per_worker[my_cpu_number];
-
-  /* Need to allocate a buffer? */
-  if (PREDICT_FALSE (b0 == 0))
-    {
-      if (vlib_buffer_alloc (vm, &bi0, 1) != 1)
-	{
-	  vlib_node_increment_counter (vm, flowprobe_output_l2_node.index,
-				       FLOWPROBE_ERROR_BUFFER, 1);
-	  return 0;
-	}
-
-      /* Initialize the buffer */
-      b0 = fm->context[which].buffers_per_worker[my_cpu_number] =
-	vlib_get_buffer (vm, bi0);
-
-      b0->current_data = 0;
-      b0->current_length = flowprobe_get_headersize ();
-      b0->flags |=
-	(VLIB_BUFFER_TOTAL_LENGTH_VALID | VNET_BUFFER_F_FLOW_REPORT);
-      vnet_buffer (b0)->sw_if_index[VLIB_RX] = 0;
-      vnet_buffer (b0)->sw_if_index[VLIB_TX] = exp->fib_index;
-      fm->context[which].next_record_offset_per_worker[my_cpu_number] =
-	b0->current_length;
-    }
-
-  return b0;
-}
+/* common + l2 + l3 ip6 + l4 */
+#define FLOWPROBE_RECORD_MAX_SIZE 128
 
 static void
 flowprobe_export_entry (vlib_main_t * vm, flowprobe_entry_t * e)
 {
-  u32 my_cpu_number = vm->thread_index;
   flowprobe_main_t *fm = &flowprobe_main;
   ipfix_exporter_t *exp = pool_elt_at_index (flow_report_main.exporters, 0);
-  vlib_buffer_t *b0;
   bool collect_ip4 = false, collect_ip6 = false;
   flowprobe_variant_t which = e->key.which;
   flowprobe_record_t flags = fm->context[which].flags;
-  u16 offset =
-    fm->context[which].next_record_offset_per_worker[my_cpu_number];
-
-  if (offset < flowprobe_get_headersize ())
-    offset = flowprobe_get_headersize ();
+  u8 record[FLOWPROBE_RECORD_MAX_SIZE];
+  flow_report_t *fr;
+  u16 offset = 0;
 
-  b0 = flowprobe_get_buffer (vm, which);
-  /* No available buffer, what to do... */
-  if (b0 == 0)
+  /* No template for this variant */
+  if (fm->context[which].report_index == ~0)
     return;
+  fr = pool_elt_at_index (exp->reports, fm->context[which].report_index);
 
   if (flags & FLOW_RECORD_L3)
     {
@@ -720,28 +496,29 @@ flowprobe_export_entry (vlib_main_t * vm, flowprobe_entry_t * e)
       collect_ip6 = which == FLOW_VARIANT_L2_IP6 || which == FLOW_VARIANT_IP6;
     }
 
-  offset += flowprobe_common_add (b0, e, offset);
+  offset += flowprobe_common_add (record, e, offset);
 
   if (flags & FLOW_RECORD_L2)
-    offset += flowprobe_l2_add (b0, e, offset);
+    offset += flowprobe_l2_add (record, e, offset);
   if (collect_ip6)
-    offset += flowprobe_l3_ip6_add (b0, e, offset);
+    offset += flowprobe_l3_ip6_add (record, e, offset);
   if (collect_ip4)
-    offset += flowprobe_l3_ip4_add (b0, e, offset);
+    offset += flowprobe_l3_ip4_add (record, e, offset);
   if (flags & FLOW_RECORD_L4)
-    offset += flowprobe_l4_add (b0, e, offset);
+    offset += flowprobe_l4_add (record, e, offset);
+
+  /* No available buffer, keep counting into the next export */
+  if (vnet_ipfix_exp_add_record (vm, exp, fr, record, offset))
+    {
+      vlib_node_increment_counter (vm, flowprobe_output_l2_node.index,
+				   FLOWPROBE_ERROR_BUFFER, 1);
+      return;
+    }
 
   /* Reset per flow-export counters */
   e->packetcount = 0;
   e->octetcount = 0;
   e->last_exported = vlib_time_now (vm);
-
-  b0->current_length = offset;
-
-  fm->context[which].next_record_offset_per_worker[my_cpu_number] = offset;
-  /* Time to flush the buffer? */
-  if (offset + fm->template_size[flags] > exp->path_mtu)
-    flowprobe_export_send (vm, b0, which);
 }
 
 uword
@@ -749,132 +526,123 @@ flowprobe_node_fn (vlib_main_t *vm, vlib_node_runtime_t *node,
 		   vlib_frame_t *frame, flowprobe_variant_t which,
 		   flowprobe_direction_t direction)
 {
-  u32 n_left_from, *from, *to_next;
-  flowprobe_next_t next_index;
   flowprobe_main_t *fm = &flowprobe_main;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u16 nexts[VLIB_FRAME_SIZE], *next = nexts;
+  clib_bihash_kv_64_8_t kvs[VLIB_FRAME_SIZE];
+  u64 hashes[VLIB_FRAME_SIZE];
+  u16 octets[VLIB_FRAME_SIZE];
+  u8 tcp_flags[VLIB_FRAME_SIZE];
+  u32 my_cpu_number = vm->thread_index;
+  u32 n_left, n_keys = 0, n_sampled_out = 0, i;
+  bool sampling = fm->sampling_interval > 1;
   timestamp_nsec_t timestamp;
+  clib_bihash_64_8_t *h;
+  flowprobe_entry_t *e;
+  u32 *from;
+  f64 now;
 
   unix_time_now_nsec_fraction (&timestamp.sec, &timestamp.nsec);
+  now = vlib_time_now (vm);
 
   from = vlib_frame_vector_args (frame);
-  n_left_from = frame->n_vectors;
-  next_index = node->cached_next_index;
+  n_left = frame->n_vectors;
+  vlib_get_buffers (vm, from, bufs, n_left);
 
-  while (n_left_from > 0)
+  /* Build the flow keys of the whole frame first */
+  while (n_left > 0)
     {
-      u32 n_left_to_next;
+      if (n_left >= 5)
+	{
+	  vlib_prefetch_buffer_header (b[4], LOAD);
+	  clib_prefetch_load (b[4]->data);
+	}
 
-      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
+      vnet_feature_next_u16 (next, b[0]);
 
-      while (n_left_from >= 4 && n_left_to_next >= 2)
+      if (PREDICT_FALSE (fm->disabled ||
+			 (b[0]->flags & VNET_BUFFER_F_FLOW_REPORT)))
+	goto next;
+
+      if (sampling && !flowprobe_sample (fm, my_cpu_number))
 	{
-	  u32 next0 = FLOWPROBE_NEXT_DROP;
-	  u32 next1 = FLOWPROBE_NEXT_DROP;
-	  u16 len0, len1;
-	  u32 bi0, bi1;
-	  vlib_buffer_t *b0, *b1;
-
-	  /* Prefetch next iteration. */
-	  {
-	    vlib_buffer_t *p2, *p3;
-
-	    p2 = vlib_get_buffer (vm, from[2]);
-	    p3 = vlib_get_buffer (vm, from[3]);
-
-	    vlib_prefetch_buffer_header (p2, LOAD);
-	    vlib_prefetch_buffer_header (p3, LOAD);
-
-	    clib_prefetch_store (p2->data);
-	    clib_prefetch_store (p3->data);
-	  }
-
-	  /* speculatively enqueue b0 and b1 to the current next frame */
-	  to_next[0] = bi0 = from[0];
-	  to_next[1] = bi1 = from[1];
-	  from += 2;
-	  to_next += 2;
-	  n_left_from -= 2;
-	  n_left_to_next -= 2;
-
-	  b0 = vlib_get_buffer (vm, bi0);
-	  b1 = vlib_get_buffer (vm, bi1);
-
-	  vnet_feature_next (&next0, b0);
-	  vnet_feature_next (&next1, b1);
-
-	  len0 = vlib_buffer_length_in_chain (vm, b0);
-	  ethernet_header_t *eh0 = vlib_buffer_get_current (b0);
-	  u16 ethertype0 = clib_net_to_host_u16 (eh0->type);
-
-	  if (PREDICT_TRUE ((b0->flags & VNET_BUFFER_F_FLOW_REPORT) == 0))
-	    add_to_flow_record_state (
-	      vm, node, fm, b0, timestamp, len0,
-	      flowprobe_get_variant (which, fm->context[which].flags,
-				     ethertype0),
-	      direction, 0);
-
-	  len1 = vlib_buffer_length_in_chain (vm, b1);
-	  ethernet_header_t *eh1 = vlib_buffer_get_current (b1);
-	  u16 ethertype1 = clib_net_to_host_u16 (eh1->type);
-
-	  if (PREDICT_TRUE ((b1->flags & VNET_BUFFER_F_FLOW_REPORT) == 0))
-	    add_to_flow_record_state (
-	      vm, node, fm, b1, timestamp, len1,
-	      flowprobe_get_variant (which, fm->context[which].flags,
-				     ethertype1),
-	      direction, 0);
-
-	  /* verify speculative enqueues, maybe switch current next frame */
-	  vlib_validate_buffer_enqueue_x2 (vm, node, next_index,
-					   to_next, n_left_to_next,
-					   bi0, bi1, next0, next1);
+	  n_sampled_out++;
+	  goto next;
 	}
 
-      while (n_left_from > 0 && n_left_to_next > 0)
+      flowprobe_build_key (
+	fm, b[0],
+	flowprobe_get_variant (
+	  which, fm->context[which].flags,
+	  clib_net_to_host_u16 (
+	    ((ethernet_header_t *) vlib_buffer_get_current (b[0]))->type)),
+	direction, (flowprobe_key_t *) kvs[n_keys].key, octets + n_keys,
+	tcp_flags + n_keys);
+
+      if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE) &&
+			 (b[0]->flags & VLIB_BUFFER_IS_TRACED)))
 	{
-	  u32 bi0;
-	  vlib_buffer_t *b0;
-	  u32 next0 = FLOWPROBE_NEXT_DROP;
-	  u16 len0;
-
-	  /* speculatively enqueue b0 to the current next frame */
-	  bi0 = from[0];
-	  to_next[0] = bi0;
-	  from += 1;
-	  to_next += 1;
-	  n_left_from -= 1;
-	  n_left_to_next -= 1;
-
-	  b0 = vlib_get_buffer (vm, bi0);
-
-	  vnet_feature_next (&next0, b0);
-
-	  len0 = vlib_buffer_length_in_chain (vm, b0);
-	  ethernet_header_t *eh0 = vlib_buffer_get_current (b0);
-	  u16 ethertype0 = clib_net_to_host_u16 (eh0->type);
-
-	  if (PREDICT_TRUE ((b0->flags & VNET_BUFFER_F_FLOW_REPORT) == 0))
-	    {
-	      flowprobe_trace_t *t = 0;
-	      if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
-				 && (b0->flags & VLIB_BUFFER_IS_TRACED)))
-		t = vlib_add_trace (vm, node, b0, sizeof (*t));
-
-	      add_to_flow_record_state (
-		vm, node, fm, b0, timestamp, len0,
-		flowprobe_get_variant (which, fm->context[which].flags,
-				       ethertype0),
-		direction, t);
-	    }
-
-	  /* verify speculative enqueue, maybe switch current next frame */
-	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-					   to_next, n_left_to_next,
-					   bi0, next0);
+	  flowprobe_trace_t *t = vlib_add_trace (vm, node, b[0], sizeof (*t));
+	  flowprobe_trace_key (t, (flowprobe_key_t *) kvs[n_keys].key);
 	}
+      n_keys++;
+
+    next:
+      b += 1;
+      next += 1;
+      n_left -= 1;
+    }
 
-      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+  if (fm->active_timer == 0)
+    {
+      /* Stateless, every packet is exported */
+      e = &fm->stateless_entry[my_cpu_number];
+      for (i = 0; i < n_keys; i++)
+	{
+	  clib_memcpy_fast (&e->key, kvs[i].key, sizeof (e->key));
+	  flowprobe_update_entry (vm, fm, e, timestamp, octets[i],
+				  tcp_flags[i], now);
+	}
+      goto done;
     }
+
+  /* Hash all keys and look them up with the buckets prefetched ahead */
+  h = &fm->hash_per_worker[my_cpu_number];
+  for (i = 0; i < n_keys; i++)
+    hashes[i] = clib_bihash_hash_64_8 (kvs + i);
+
+  for (i = 0; i < clib_min (n_keys, 8); i++)
+    clib_bihash_prefetch_bucket_64_8 (h, hashes[i]);
+
+  for (i = 0; i < n_keys; i++)
+    {
+      clib_bihash_kv_64_8_t kv;
+      u32 poolindex;
+
+      if (i + 8 < n_keys)
+	clib_bihash_prefetch_bucket_64_8 (h, hashes[i + 8]);
+
+      if (clib_bihash_search_inline_2_with_hash_64_8 (h, hashes[i], kvs + i,
+						      &kv) == 0)
+	e = pool_elt_at_index (fm->pool_per_worker[my_cpu_number], kv.value);
+      else
+	{
+	  e = flowprobe_create (my_cpu_number, kvs + i, hashes[i],
+				&poolindex);
+	  e->last_exported = now;
+	  e->flow_start = timestamp;
+	}
+
+      flowprobe_update_entry (vm, fm, e, timestamp, octets[i], tcp_flags[i],
+			      now);
+    }
+
+done:
+  if (n_sampled_out)
+    vlib_node_increment_counter (vm, node->node_index,
+				 FLOWPROBE_ERROR_SAMPLED_OUT, n_sampled_out);
+
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
   return frame->n_vectors;
 }
 
@@ -926,54 +694,41 @@ flowprobe_output_l2_node_fn (vlib_main_t *vm, vlib_node_runtime_t *node,
 			    FLOW_DIRECTION_TX);
 }
 
-static inline void
-flush_record (flowprobe_variant_t which)
-{
-  vlib_main_t *vm = vlib_get_main ();
-  vlib_buffer_t *b = flowprobe_get_buffer (vm, which);
-  if (b)
-    flowprobe_export_send (vm, b, which);
-}
-
-void
-flowprobe_flush_callback_ip4 (void)
-{
-  flush_record (FLOW_VARIANT_IP4);
-}
-
-void
-flowprobe_flush_callback_ip6 (void)
-{
-  flush_record (FLOW_VARIANT_IP6);
-}
-
-void
-flowprobe_flush_callback_l2 (void)
-{
-  flush_record (FLOW_VARIANT_L2);
-  flush_record (FLOW_VARIANT_L2_IP4);
-  flush_record (FLOW_VARIANT_L2_IP6);
-}
-
-
 static void
 flowprobe_delete_by_index (u32 my_cpu_number, u32 poolindex)
 {
   flowprobe_main_t *fm = &flowprobe_main;
+  clib_bihash_kv_64_8_t kv;
   flowprobe_entry_t *e;
-  u32 h;
 
   e = pool_elt_at_index (fm->pool_per_worker[my_cpu_number], poolindex);
 
-  /* Get my index */
-  h = flowprobe_hash (&e->key);
-
-  /* Reset hash */
-  fm->hash_per_worker[my_cpu_number][h] = ~0;
+  clib_memcpy_fast (kv.key, &e->key, sizeof (e->key));
+  clib_bihash_add_del_64_8 (&fm->hash_per_worker[my_cpu_number], &kv,
+			    0 /* is_add */);
 
   pool_put_index (fm->pool_per_worker[my_cpu_number], poolindex);
 }
 
+/*
+ * Send this thread's partially filled export buffers once their
+ * oldest record is older than FLOWPROBE_EXPORT_MAX_DELAY, so that
+ * workers do not wait for the exporter's periodic flush
+ */
+static void
+flowprobe_flush_aged_buffers (vlib_main_t *vm)
+{
+  flowprobe_main_t *fm = &flowprobe_main;
+  ipfix_exporter_t *exp = pool_elt_at_index (flow_report_main.exporters, 0);
+  flowprobe_variant_t which;
+
+  for (which = 0; which < FLOW_N_VARIANTS; which++)
+    if (fm->context[which].report_index != ~0)
+      vnet_ipfix_exp_flush (
+	vm, exp,
+	pool_elt_at_index (exp->reports, fm->context[which].report_index),
+	FLOWPROBE_EXPORT_MAX_DELAY);
+}
 
 /* Per worker process processing the active/passive expired entries */
 static uword
@@ -996,7 +751,13 @@ flowprobe_walker_process (vlib_main_t * vm,
     }
   fm->disabled = false;
 
+  flowprobe_flush_aged_buffers (vm);
+
   u32 cpu_index = os_get_thread_index ();
+
+  /* Stateless, nothing else to do */
+  if (cpu_index >= vec_len (fm->timers_per_worker))
+    return 0;
   u32 *to_be_removed = 0, *i;
 
   /*
@@ -1050,6 +811,10 @@ flowprobe_walker_process (vlib_main_t * vm,
   if (count)
     vec_delete (fm->expired_passive_per_worker[cpu_index], count, 0);
 
+  /* Out of time with expired entries left, come back on the next loop */
+  if (vec_len (fm->expired_passive_per_worker[cpu_index]))
+    vlib_node_set_interrupt_pending (vm, rt->node_index);
+
   vec_foreach (i, to_be_removed) flowprobe_delete_by_index (cpu_index, *i);
   vec_free (to_be_removed);
 
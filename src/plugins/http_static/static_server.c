@@ -134,6 +134,14 @@ hss_session_send_data (hss_url_handler_args_t *args)
 
   hs = hss_session_get (args->sh.thread_index, args->sh.session_index);
 
+  /* Session closed while an async handler was building the reply */
+  if (!hs)
+    {
+      if (args->free_vec_data)
+	vec_free (args->data);
+      return;
+    }
+
   if (hs->data && hs->free_data)
     vec_free (hs->data);
 
@@ -150,6 +158,7 @@ try_url_handler (hss_main_t *hsm, hss_session_t *hs, http_req_method_t rt,
   http_status_code_t sc = HTTP_STATUS_OK;
   hss_url_handler_args_t args = {};
   uword *p, *url_table;
+  u8 *query;
   int rv;
 
   if (!hsm->enable_url_handlers || !request)
@@ -159,7 +168,13 @@ try_url_handler (hss_main_t *hsm, hss_session_t *hs, http_req_method_t rt,
   url_table =
     (rt == HTTP_REQ_GET) ? hsm->get_url_handlers : hsm->post_url_handlers;
 
+  /* Handlers are registered by path, the query is left to the handler */
+  query = memchr (request, '?', vec_len (request));
+  if (query)
+    *query = 0;
   p = hash_get_mem (url_table, request);
+  if (query)
+    *query = '?';
   if (!p)
     return -1;
 
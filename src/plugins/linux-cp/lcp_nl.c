@@ -30,6 +30,7 @@
 
 #include <vlib/vlib.h>
 #include <vlib/unix/unix.h>
+#include <vlib/stats/stats.h>
 #include <vppinfra/error.h>
 #include <vppinfra/linux/netns.h>
 
@@ -66,12 +67,50 @@ typedef enum nl_event_type_t_
 {
   NL_EVENT_READ,
   NL_EVENT_ERR,
+  NL_EVENT_OVERRUN,
 } nl_event_type_t;
 
+/* Identity of a kernel route, used to find superseded messages in a batch */
+typedef struct nl_route_key_t_
+{
+  u32 table;
+  u32 priority;
+  u8 family;
+  u8 dst_len;
+  u8 tos;
+  u8 protocol;
+  u8 dst[16];
+} nl_route_key_t;
+
+typedef struct nl_stats_t_
+{
+  u64 n_msgs_rcvd;
+  u64 n_msgs_processed;
+  u64 n_msgs_coalesced;
+  u64 n_batches;
+  u64 n_overruns;
+  u64 n_syncs;
+  u32 queue_len_max;
+
+  /* time a message spent queued before it was applied */
+  f64 lag_last;
+  f64 lag_max;
+  f64 lag_sum;
+
+  /* time the worker barrier was held for a batch */
+  f64 barrier_time_max;
+  f64 barrier_time_sum;
+  u64 n_barriers;
+
+  f64 sync_time_last;
+} nl_stats_t;
+
 typedef struct nl_main
 {
 
   nl_status_t nl_status;
+  /* the current synchronization was triggered by a receive overrun */
+  u8 sync_is_overrun;
 
   struct nl_sock *sk_route;
   struct nl_sock *sk_route_sync[NL_SOCK_TYPES_N];
@@ -90,6 +129,24 @@ typedef struct nl_main
   u32 sync_batch_delay_ms;
   u32 sync_attempt_delay_ms;
 
+  /* receive buffer size granted by the kernel */
+  u32 rx_buf_size_eff;
+
+  /* drop route messages superseded by a later one in the same batch */
+  u8 coalesce;
+  nl_route_key_t *coalesce_keys;
+
+  /* a batch is being applied, non mp-safe callbacks share one barrier */
+  u8 in_batch;
+  u8 batch_barrier;
+  f64 batch_barrier_start;
+
+  nl_stats_t stats;
+  u32 stats_queue_len_index;
+  u32 stats_lag_index;
+  u32 stats_coalesced_index;
+  u32 stats_overruns_index;
+
 } nl_main_t;
 
 #define NL_RX_BUF_SIZE_DEF    (1 << 27) /* 128 MB */
@@ -109,6 +166,7 @@ static nl_main_t nl_main = {
   .sync_batch_limit = NL_SYNC_BATCH_LIMIT_DEF,
   .sync_batch_delay_ms = NL_SYNC_BATCH_DELAY_MS_DEF,
   .sync_attempt_delay_ms = NL_SYNC_ATTEMPT_DELAY_MS_DEF,
+  .coalesce = 1,
 };
 
 /* #define foreach_nl_nft_proto  \ */
@@ -122,6 +180,66 @@ static nl_main_t nl_main = {
 /* #undef _ */
 /* } nl_nft_proto_t; */
 
+/* While a batch is applied the barrier is taken by the first callback that
+ * is not mp-safe and held until the end of the batch, instead of being taken
+ * and released for every message.
+ */
+static void
+nl_barrier_sync (void)
+{
+  nl_main_t *nm = &nl_main;
+  vlib_main_t *vm = vlib_get_main ();
+
+  if (nm->in_batch)
+    {
+      if (nm->batch_barrier)
+	return;
+      nm->batch_barrier = 1;
+      nm->batch_barrier_start = vlib_time_now (vm);
+    }
+
+  vlib_worker_thread_barrier_sync (vm);
+}
+
+static void
+nl_barrier_release (void)
+{
+  nl_main_t *nm = &nl_main;
+
+  if (!nm->in_batch)
+    vlib_worker_thread_barrier_release (vlib_get_main ());
+}
+
+static void
+nl_batch_begin (void)
+{
+  nl_main_t *nm = &nl_main;
+
+  nm->in_batch = 1;
+}
+
+static void
+nl_batch_end (void)
+{
+  nl_main_t *nm = &nl_main;
+  vlib_main_t *vm = vlib_get_main ();
+  f64 t;
+
+  nm->in_batch = 0;
+
+  if (!nm->batch_barrier)
+    return;
+
+  vlib_worker_thread_barrier_release (vm);
+  nm->batch_barrier = 0;
+
+  t = vlib_time_now (vm) - nm->batch_barrier_start;
+  nm->stats.n_barriers++;
+  nm->stats.barrier_time_sum += t;
+  if (t > nm->stats.barrier_time_max)
+    nm->stats.barrier_time_max = t;
+}
+
 #define FOREACH_VFT(__func, __arg)                                            \
   {                                                                           \
     nl_main_t *nm = &nl_main;                                                 \
@@ -132,12 +250,12 @@ static nl_main_t nl_main = {
 	  continue;                                                           \
                                                                               \
 	if (!__nv->__func.is_mp_safe)                                         \
-	  vlib_worker_thread_barrier_sync (vlib_get_main ());                 \
+	  nl_barrier_sync ();                                                 \
                                                                               \
 	__nv->__func.cb (__arg);                                              \
                                                                               \
 	if (!__nv->__func.is_mp_safe)                                         \
-	  vlib_worker_thread_barrier_release (vlib_get_main ());              \
+	  nl_barrier_release ();                                              \
       }                                                                       \
   }
 
@@ -170,12 +288,12 @@ static nl_main_t nl_main = {
 	  continue;                                                           \
                                                                               \
 	if (!__nv->__func.is_mp_safe)                                         \
-	  vlib_worker_thread_barrier_sync (vlib_get_main ());                 \
+	  nl_barrier_sync ();                                                 \
                                                                               \
 	__nv->__func.cb (__arg, __ctx);                                       \
                                                                               \
 	if (!__nv->__func.is_mp_safe)                                         \
-	  vlib_worker_thread_barrier_release (vlib_get_main ());              \
+	  nl_barrier_release ();                                              \
       }                                                                       \
   }
 
@@ -331,29 +449,152 @@ nl_route_dispatch (struct nl_object *obj, void *arg)
     }
 }
 
+static int
+nl_route_key_get (struct nl_msg *msg, nl_route_key_t *key, int *is_add)
+{
+  struct nlmsghdr *nlh = nlmsg_hdr (msg);
+  struct nlattr *tb[RTA_MAX + 1];
+  struct rtmsg *rtm;
+  int len;
+
+  if (nlh->nlmsg_type != RTM_NEWROUTE && nlh->nlmsg_type != RTM_DELROUTE)
+    return 0;
+
+  if (nlmsg_parse (nlh, sizeof (*rtm), tb, RTA_MAX, NULL) < 0)
+    return 0;
+
+  rtm = nlmsg_data (nlh);
+
+  /* only unicast routes that are programmed with a table lock per entry */
+  if ((rtm->rtm_family != AF_INET && rtm->rtm_family != AF_INET6) ||
+      rtm->rtm_type != RTN_UNICAST || rtm->rtm_protocol == RTPROT_KERNEL)
+    return 0;
+
+  clib_memset (key, 0, sizeof (*key));
+  key->family = rtm->rtm_family;
+  key->dst_len = rtm->rtm_dst_len;
+  key->tos = rtm->rtm_tos;
+  key->protocol = rtm->rtm_protocol;
+  key->table = tb[RTA_TABLE] ? nla_get_u32 (tb[RTA_TABLE]) : rtm->rtm_table;
+  key->priority = tb[RTA_PRIORITY] ? nla_get_u32 (tb[RTA_PRIORITY]) : 0;
+
+  if (tb[RTA_DST])
+    {
+      len = nla_len (tb[RTA_DST]);
+      if (len > sizeof (key->dst))
+	return 0;
+      clib_memcpy (key->dst, nla_data (tb[RTA_DST]), len);
+    }
+
+  /* IPv6 link-local and multicast routes are never programmed */
+  if (key->family == AF_INET6 &&
+      (key->dst[0] == 0xff ||
+       (key->dst[0] == 0xfe && (key->dst[1] & 0xc0) == 0x80)))
+    return 0;
+
+  *is_add = (nlh->nlmsg_type == RTM_NEWROUTE);
+
+  return 1;
+}
+
+/* Drop route messages of a batch whose effect is overwritten by a later
+ * message for the same route. IPv4 routes are added with replace semantics,
+ * so an add supersedes everything before it. IPv6 routes are added path by
+ * path and a delete removes the whole entry, so there a delete supersedes
+ * everything before it. Walk the batch backwards remembering the routes for
+ * which such a message has been seen.
+ */
+static u32
+nl_route_coalesce_msgs (u32 n_msgs)
+{
+  nl_main_t *nm = &nl_main;
+  nl_msg_info_t *msg_info;
+  nl_route_key_t *key;
+  uword *seen;
+  u32 i, n_coalesced = 0;
+  int is_add;
+
+  /* keys are stored by reference in the hash, size the vector up front */
+  vec_validate (nm->coalesce_keys, n_msgs - 1);
+  seen = hash_create_mem (0, sizeof (nl_route_key_t), 0);
+
+  for (i = n_msgs; i-- > 0;)
+    {
+      msg_info = vec_elt_at_index (nm->nl_msg_queue, i);
+      key = vec_elt_at_index (nm->coalesce_keys, i);
+
+      if (!nl_route_key_get (msg_info->msg, key, &is_add))
+	continue;
+
+      if (hash_get_mem (seen, key))
+	{
+	  nlmsg_free (msg_info->msg);
+	  msg_info->msg = NULL;
+	  n_coalesced++;
+	}
+      else if (is_add == (key->family == AF_INET))
+	hash_set_mem (seen, key, 1);
+    }
+
+  hash_free (seen);
+
+  return n_coalesced;
+}
+
 static int
 nl_route_process_msgs (void)
 {
   nl_main_t *nm = &nl_main;
+  vlib_main_t *vm = vlib_get_main ();
+  nl_stats_t *st = &nm->stats;
   nl_msg_info_t *msg_info;
-  int err, n_msgs = 0;
+  int err, i, n_msgs;
+  u32 n_coalesced = 0;
+  f64 lag;
 
-  /* process a batch of messages. break if we hit our limit */
-  vec_foreach (msg_info, nm->nl_msg_queue)
+  /* process a batch of messages, up to our limit */
+  n_msgs = clib_min (vec_len (nm->nl_msg_queue), nm->batch_size);
+  if (n_msgs == 0)
+    return 0;
+
+  if (nm->coalesce)
+    n_coalesced = nl_route_coalesce_msgs (n_msgs);
+
+  nl_batch_begin ();
+
+  for (i = 0; i < n_msgs; i++)
     {
+      msg_info = vec_elt_at_index (nm->nl_msg_queue, i);
+      if (!msg_info->msg)
+	continue;
+
       if ((err = nl_msg_parse (msg_info->msg, nl_route_dispatch, msg_info)) <
 	  0)
 	NL_ERROR ("Unable to parse object: %s", nl_geterror (err));
       nlmsg_free (msg_info->msg);
-      if (++n_msgs >= nm->batch_size)
-	break;
+
+      lag = vlib_time_now (vm) - msg_info->ts;
+      st->lag_last = lag;
+      st->lag_sum += lag;
+      if (lag > st->lag_max)
+	st->lag_max = lag;
     }
 
+  nl_batch_end ();
+
   /* remove the messages we processed from the head of the queue */
-  if (n_msgs)
-    vec_delete (nm->nl_msg_queue, n_msgs, 0);
+  vec_delete (nm->nl_msg_queue, n_msgs, 0);
+
+  st->n_batches++;
+  st->n_msgs_processed += n_msgs - n_coalesced;
+  st->n_msgs_coalesced += n_coalesced;
+
+  vlib_stats_set_gauge (nm->stats_queue_len_index, vec_len (nm->nl_msg_queue));
+  vlib_stats_set_gauge (nm->stats_lag_index, st->lag_last * 1e6);
+  vlib_stats_set_gauge (nm->stats_coalesced_index, st->n_msgs_coalesced);
 
-  NL_INFO ("Processed %u messages", n_msgs);
+  NL_INFO ("Processed %u messages, %u coalesced", n_msgs - n_coalesced,
+	   n_coalesced);
 
   return n_msgs;
 }
@@ -532,6 +773,7 @@ nl_route_process (vlib_main_t *vm, vlib_node_runtime_t *node,
   uword event_type;
   uword *event_data = 0;
   f64 wait_time = DAY_F64;
+  f64 sync_start, batch_start;
   int n_msgs;
   int is_done;
 
@@ -554,9 +796,15 @@ nl_route_process (vlib_main_t *vm, vlib_node_runtime_t *node,
 	     */
 	    case ~0:
 	    case NL_EVENT_READ:
+	      batch_start = vlib_time_now (vm);
 	      nl_route_process_msgs ();
+	      /* Yield for as long as the batch took, at most the batch delay.
+	       * A backlog gets half of the main thread instead of a fixed
+	       * number of batches per second
+	       */
 	      wait_time = (vec_len (nm->nl_msg_queue) != 0) ?
-			    nm->batch_delay_ms * 1e-3 :
+			    clib_min (nm->batch_delay_ms * 1e-3,
+				      vlib_time_now (vm) - batch_start) :
 			    DAY_F64;
 	      break;
 
@@ -565,6 +813,16 @@ nl_route_process (vlib_main_t *vm, vlib_node_runtime_t *node,
 	     */
 	    case NL_EVENT_ERR:
 	      nm->nl_status = NL_STATUS_SYNC;
+	      nm->sync_is_overrun = 0;
+	      break;
+
+	    /* The kernel dropped notifications because the receive buffer
+	     * was full. The socket itself is fine, resynchronize without
+	     * closing it
+	     */
+	    case NL_EVENT_OVERRUN:
+	      nm->nl_status = NL_STATUS_SYNC;
+	      nm->sync_is_overrun = 1;
 	      break;
 
 	    default:
@@ -573,19 +831,37 @@ nl_route_process (vlib_main_t *vm, vlib_node_runtime_t *node,
 	}
       else if (nm->nl_status == NL_STATUS_SYNC)
 	{
-	  /* Stop processing notifications - close the notification socket and
-	   * discard all messages that are currently in the queue
-	   */
-	  lcp_nl_close_socket ();
-	  lcp_nl_route_discard_msgs ();
+	  sync_start = vlib_time_now (vm);
+	  nm->stats.n_syncs++;
 
-	  /* Wait some time before next synchronization attempt. Allows to
-	   * reduce the number of failed attempts that stall the main thread by
-	   * waiting out the notification storm
-	   */
-	  NL_INFO ("Wait before next synchronization attempt for %ums",
-		   nm->sync_attempt_delay_ms);
-	  vlib_process_suspend (vm, nm->sync_attempt_delay_ms * 1e-3);
+	  if (nm->sync_is_overrun)
+	    {
+	      /* Netlink cannot replay the lost notifications. Keep the
+	       * notification socket open so that nothing sent after the dump
+	       * request is lost, and discard what is queued, the dump
+	       * replies supersede it. Mark and sweep only touches the entries
+	       * that differ. The first attempt is made right away, if it
+	       * fails the full cycle below applies
+	       */
+	      NL_INFO ("Receive overrun, resynchronizing");
+	      lcp_nl_route_discard_msgs ();
+	    }
+	  else
+	    {
+	      /* Stop processing notifications - close the notification socket
+	       * and discard all messages that are currently in the queue
+	       */
+	      lcp_nl_close_socket ();
+	      lcp_nl_route_discard_msgs ();
+
+	      /* Wait some time before next synchronization attempt. Allows to
+	       * reduce the number of failed attempts that stall the main thread
+	       * by waiting out the notification storm
+	       */
+	      NL_INFO ("Wait before next synchronization attempt for %ums",
+		       nm->sync_attempt_delay_ms);
+	      vlib_process_suspend (vm, nm->sync_attempt_delay_ms * 1e-3);
+	    }
 
 	  /* Open netlink synchronization socket, one for every data type of
 	   * interest: link, address, neighbor, and route. That is needed to
@@ -603,7 +879,8 @@ nl_route_process (vlib_main_t *vm, vlib_node_runtime_t *node,
 	   * the moment. Once all the dump replies are processed, the
 	   * notifications will be processed
 	   */
-	  lcp_nl_open_socket ();
+	  if (!nm->sync_is_overrun)
+	    lcp_nl_open_socket ();
 
 	  /* Request the current entry set from the kernel for every data type
 	   * of interest. Thus requesting a snapshot of the current routing
@@ -619,8 +896,10 @@ nl_route_process (vlib_main_t *vm, vlib_node_runtime_t *node,
   is_done = 0;                                                                \
   do                                                                          \
     {                                                                         \
+      nl_batch_begin ();                                                      \
       n_msgs =                                                                \
 	lcp_nl_recv_dump_replies (stype, nm->sync_batch_limit, &is_done);     \
+      nl_batch_end ();                                                        \
       if (n_msgs < 0)                                                         \
 	{                                                                     \
 	  NL_ERROR ("Error receiving dump replies of type " tname             \
@@ -651,7 +930,7 @@ nl_route_process (vlib_main_t *vm, vlib_node_runtime_t *node,
       /* If error event received, stop synchronization and repeat an          \
        * attempt later                                                        \
        */                                                                     \
-      if (event_type == NL_EVENT_ERR)                                         \
+      if (event_type == NL_EVENT_ERR || event_type == NL_EVENT_OVERRUN)      \
 	goto sync_later;                                                      \
     }                                                                         \
   while (!is_done);                                                           \
@@ -668,7 +947,13 @@ nl_route_process (vlib_main_t *vm, vlib_node_runtime_t *node,
 	   */
 	  wait_time = (vec_len (nm->nl_msg_queue) != 0) ? 1e-3 : DAY_F64;
 
+	  nm->stats.sync_time_last = vlib_time_now (vm) - sync_start;
+	  NL_INFO ("Synchronization done in %.3fs", nm->stats.sync_time_last);
+
 	sync_later:
+	  /* A failed attempt falls back to closing the notification socket */
+	  nm->sync_is_overrun = 0;
+
 	  /* Close netlink synchronization sockets */
 #define _(stype, mtype, tname, fn) lcp_nl_close_sync_socket (stype);
 	  foreach_sock_type
@@ -701,6 +986,10 @@ nl_route_cb (struct nl_msg *msg, void *arg)
   msg_info->msg = msg;
   nlmsg_get (msg);
 
+  nm->stats.n_msgs_rcvd++;
+  if (vec_len (nm->nl_msg_queue) > nm->stats.queue_len_max)
+    nm->stats.queue_len_max = vec_len (nm->nl_msg_queue);
+
   return 0;
 }
 
@@ -714,8 +1003,17 @@ lcp_nl_drain_messages (void)
   while ((err = nl_recvmsgs_default (nm->sk_route)) > -1)
     ;
 
-  /* If there was an error other then EAGAIN, signal process node */
-  if (err != -NLE_AGAIN)
+  /* ENOBUFS, the kernel dropped notifications since the receive buffer
+   * was full. Any other error than EAGAIN is a socket failure
+   */
+  if (err == -NLE_NOMEM)
+    {
+      nm->stats.n_overruns++;
+      vlib_stats_set_gauge (nm->stats_overruns_index, nm->stats.n_overruns);
+      vlib_process_signal_event (vlib_get_main (), nl_route_process_node.index,
+				 NL_EVENT_OVERRUN, 0);
+    }
+  else if (err != -NLE_AGAIN)
     vlib_process_signal_event (vlib_get_main (), nl_route_process_node.index,
 			       NL_EVENT_ERR, 0);
   else
@@ -742,7 +1040,7 @@ nl_route_read_cb (clib_file_t *f)
 {
   int err;
   err = lcp_nl_drain_messages ();
-  if (err < 0 && err != -NLE_AGAIN)
+  if (err < 0 && err != -NLE_AGAIN && err != -NLE_NOMEM)
     NL_ERROR ("Error reading netlink socket (fd %d): %s (%d)",
 	      f->file_descriptor, nl_geterror (err), err);
 
@@ -752,6 +1050,25 @@ nl_route_read_cb (clib_file_t *f)
 static clib_error_t *
 nl_route_error_cb (clib_file_t *f)
 {
+  nl_main_t *nm = &nl_main;
+  socklen_t len = sizeof (int);
+  int so_err = 0;
+
+  /* A receive buffer overrun is reported as a pending socket error. Reading
+   * it clears it, the socket remains usable
+   */
+  getsockopt (f->file_descriptor, SOL_SOCKET, SO_ERROR, &so_err, &len);
+  if (so_err == ENOBUFS)
+    {
+      NL_INFO ("Receive overrun on netlink socket (fd %d)",
+	       f->file_descriptor);
+      nm->stats.n_overruns++;
+      vlib_stats_set_gauge (nm->stats_overruns_index, nm->stats.n_overruns);
+      vlib_process_signal_event (vlib_get_main (), nl_route_process_node.index,
+				 NL_EVENT_OVERRUN, 0);
+      return 0;
+    }
+
   NL_ERROR ("Error polling netlink socket (fd %d)", f->file_descriptor);
 
   /* notify process node */
@@ -770,6 +1087,31 @@ lcp_nl_get_cache (lcp_nl_obj_t t)
   return nm->nl_caches[t];
 }
 
+static void
+lcp_nl_socket_set_buffer_size (struct nl_sock *sk)
+{
+  nl_main_t *nm = &nl_main;
+  int fd = nl_socket_get_fd (sk);
+  int size = nm->rx_buf_size;
+  socklen_t len = sizeof (size);
+
+  nl_socket_set_buffer_size (sk, nm->rx_buf_size, nm->tx_buf_size);
+
+  /* SO_RCVBUF is capped by net.core.rmem_max, usually far below what a full
+   * table load needs. SO_RCVBUFFORCE is not, given CAP_NET_ADMIN
+   */
+  if (setsockopt (fd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof (size)) < 0)
+    NL_DBG ("SO_RCVBUFFORCE failed: %s", strerror (errno));
+
+  /* the kernel reports twice the size, which includes its overhead */
+  if (getsockopt (fd, SOL_SOCKET, SO_RCVBUF, &size, &len) == 0)
+    nm->rx_buf_size_eff = size / 2;
+
+  if (nm->rx_buf_size_eff < nm->rx_buf_size)
+    NL_INFO ("Netlink receive buffer is %u bytes, %u requested",
+	     nm->rx_buf_size_eff, nm->rx_buf_size);
+}
+
 /* Set the RX buffer size to be used on the netlink socket */
 void
 lcp_nl_set_buffer_size (u32 buf_size)
@@ -779,7 +1121,7 @@ lcp_nl_set_buffer_size (u32 buf_size)
   nm->rx_buf_size = buf_size;
 
   if (nm->sk_route)
-    nl_socket_set_buffer_size (nm->sk_route, nm->rx_buf_size, nm->tx_buf_size);
+    lcp_nl_socket_set_buffer_size (nm->sk_route);
 }
 
 /* Set the batch size - maximum netlink messages to process at one time */
@@ -813,6 +1155,8 @@ lcp_itf_pair_config (vlib_main_t *vm, unformat_input_t *input)
 	lcp_nl_set_batch_size (batch_size);
       else if (unformat (input, "nl-batch-delay-ms %u", &batch_delay_ms))
 	lcp_nl_set_batch_delay (batch_delay_ms);
+      else if (unformat (input, "nl-no-coalesce"))
+	nl_main.coalesce = 0;
       else
 	return clib_error_return (0, "invalid netlink option: %U",
 				  format_unformat_error, input);
@@ -894,7 +1238,7 @@ lcp_nl_open_socket (void)
 
   /* Set socket in nonblocking mode and increase buffer sizes */
   nl_socket_set_nonblocking (nm->sk_route);
-  nl_socket_set_buffer_size (nm->sk_route, nm->rx_buf_size, nm->tx_buf_size);
+  lcp_nl_socket_set_buffer_size (nm->sk_route);
 
   if (nm->clib_file_index == ~0)
     {
@@ -982,6 +1326,66 @@ lcp_nl_close_sync_socket (nl_sock_type_t sock_type)
     }
 }
 
+static clib_error_t *
+lcp_nl_show_cmd (vlib_main_t *vm, unformat_input_t *input,
+		 vlib_cli_command_t *cmd)
+{
+  nl_main_t *nm = &nl_main;
+  nl_stats_t *st = &nm->stats;
+  u64 n_applied = st->n_msgs_processed;
+
+  vlib_cli_output (vm, "status: %s, socket fd %d",
+		   nm->nl_status == NL_STATUS_SYNC ? "synchronizing" :
+							"processing",
+		   nm->sk_route ? nl_socket_get_fd (nm->sk_route) : -1);
+  vlib_cli_output (vm, "rx buffer: %u bytes (%u requested)",
+		   nm->rx_buf_size_eff, nm->rx_buf_size);
+  vlib_cli_output (vm, "batch: size %u, delay %ums, coalesce %s",
+		   nm->batch_size, nm->batch_delay_ms,
+		   nm->coalesce ? "on" : "off");
+  vlib_cli_output (vm, "queue: %u messages, max %u", vec_len (nm->nl_msg_queue),
+		   st->queue_len_max);
+  vlib_cli_output (vm, "messages: %lu received, %lu applied, %lu coalesced",
+		   st->n_msgs_rcvd, n_applied, st->n_msgs_coalesced);
+  vlib_cli_output (vm, "lag: last %.3fms, avg %.3fms, max %.3fms",
+		   st->lag_last * 1e3,
+		   n_applied ? st->lag_sum * 1e3 / n_applied : 0.0,
+		   st->lag_max * 1e3);
+  vlib_cli_output (vm, "batches: %lu, barrier held %lu times, avg %.3fms, "
+		   "max %.3fms",
+		   st->n_batches, st->n_barriers,
+		   st->n_barriers ? st->barrier_time_sum * 1e3 / st->n_barriers :
+				    0.0,
+		   st->barrier_time_max * 1e3);
+  vlib_cli_output (vm, "overruns: %lu, synchronizations: %lu, last %.3fs",
+		   st->n_overruns, st->n_syncs, st->sync_time_last);
+
+  return NULL;
+}
+
+VLIB_CLI_COMMAND (lcp_nl_show_cmd_node, static) = {
+  .path = "show lcp netlink",
+  .function = lcp_nl_show_cmd,
+  .short_help = "show lcp netlink",
+};
+
+static clib_error_t *
+lcp_nl_clear_cmd (vlib_main_t *vm, unformat_input_t *input,
+		  vlib_cli_command_t *cmd)
+{
+  nl_main_t *nm = &nl_main;
+
+  clib_memset (&nm->stats, 0, sizeof (nm->stats));
+
+  return NULL;
+}
+
+VLIB_CLI_COMMAND (lcp_nl_clear_cmd_node, static) = {
+  .path = "clear lcp netlink",
+  .function = lcp_nl_clear_cmd,
+  .short_help = "clear lcp netlink",
+};
+
 #include <vnet/plugin/plugin.h>
 clib_error_t *
 lcp_nl_init (vlib_main_t *vm)
@@ -995,6 +1399,14 @@ lcp_nl_init (vlib_main_t *vm)
   nm->clib_file_index = ~0;
   nm->nl_logger = vlib_log_register_class ("nl", "nl");
 
+  nm->stats_queue_len_index =
+    vlib_stats_add_gauge ("/linux-cp/netlink/queue-length");
+  nm->stats_lag_index = vlib_stats_add_gauge ("/linux-cp/netlink/lag-us");
+  nm->stats_coalesced_index =
+    vlib_stats_add_gauge ("/linux-cp/netlink/coalesced");
+  nm->stats_overruns_index =
+    vlib_stats_add_gauge ("/linux-cp/netlink/overruns");
+
   lcp_nl_open_socket ();
   lcp_itf_pair_register_vft (&nl_itf_pair_vft);
 
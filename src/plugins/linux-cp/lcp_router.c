@@ -1101,6 +1101,40 @@ lcp_router_route_mk_entry_flags (uint8_t rtype, int table_id, uint8_t rproto)
   return (fef);
 }
 
+/*
+ * A table lock is held for every unicast entry that the plugin sources, not
+ * for every netlink message. A route replace is announced by the kernel as
+ * just another NEWROUTE, so counting messages leaks locks, and it would not
+ * allow the netlink layer to coalesce superseded messages for a prefix.
+ * Routes that are never programmed (kernel protocol, IPv6 link-local and
+ * multicast) and multicast routes keep holding a lock per message.
+ */
+static int
+lcp_router_route_is_counted (uint8_t rtype, uint8_t rproto,
+			     const fib_prefix_t *pfx)
+{
+  if (rtype == RTN_MULTICAST || rproto == RTPROT_KERNEL)
+    return 0;
+
+  if (FIB_PROTOCOL_IP6 == pfx->fp_proto &&
+      (ip6_address_is_multicast (&pfx->fp_addr.ip6) ||
+       ip6_address_is_link_local_unicast (&pfx->fp_addr.ip6)))
+    return 0;
+
+  return 1;
+}
+
+static int
+lcp_router_route_is_sourced (const lcp_router_table_t *nlt,
+			     const fib_prefix_t *pfx, fib_source_t fib_src)
+{
+  fib_node_index_t fei;
+
+  fei = fib_table_lookup_exact_match (nlt->nlt_fib_index, pfx);
+
+  return (FIB_NODE_INDEX_INVALID != fei && fib_entry_is_sourced (fei, fib_src));
+}
+
 static void
 lcp_router_route_del (struct rtnl_route *rr)
 {
@@ -1137,12 +1171,15 @@ lcp_router_route_del (struct rtnl_route *rr)
   rtnl_route_foreach_nexthop (rr, lcp_router_route_path_parse, &np);
   lcp_router_route_path_add_special (rr, &np);
 
-  if (0 != vec_len (np.paths))
-    {
-      fib_source_t fib_src;
+  fib_source_t fib_src = lcp_router_proto_fib_source (rproto);
+  int is_counted = lcp_router_route_is_counted (rtype, rproto, &pfx);
+  int was_sourced = 0;
 
-      fib_src = lcp_router_proto_fib_source (rproto);
+  if (is_counted)
+    was_sourced = lcp_router_route_is_sourced (nlt, &pfx, fib_src);
 
+  if (0 != vec_len (np.paths))
+    {
       if (pfx.fp_proto == FIB_PROTOCOL_IP6)
 	fib_table_entry_delete (nlt->nlt_fib_index, &pfx, fib_src);
       else
@@ -1152,7 +1189,10 @@ lcp_router_route_del (struct rtnl_route *rr)
 
   vec_free (np.paths);
 
-  lcp_router_table_unlock (nlt);
+  /* release the entry's lock only once the last path has gone */
+  if (!is_counted ||
+      (was_sourced && !lcp_router_route_is_sourced (nlt, &pfx, fib_src)))
+    lcp_router_table_unlock (nlt);
 }
 
 static void
@@ -1163,6 +1203,7 @@ lcp_router_route_add (struct rtnl_route *rr)
   fib_prefix_t pfx;
   lcp_router_table_t *nlt;
   uint8_t rtype, rproto;
+  int is_counted, keep_lock = 1;
 
   rtype = rtnl_route_get_type (rr);
   table_id = rtnl_route_get_table (rr);
@@ -1174,6 +1215,7 @@ lcp_router_route_add (struct rtnl_route *rr)
 
   lcp_router_route_mk_prefix (rr, &pfx);
   entry_flags = lcp_router_route_mk_entry_flags (rtype, table_id, rproto);
+  is_counted = lcp_router_route_is_counted (rtype, rproto, &pfx);
 
   nlt = lcp_router_table_add_or_lock (table_id, pfx.fp_proto);
   /* Skip any kernel routes and IPv6 LL or multicast routes */
@@ -1223,8 +1265,10 @@ lcp_router_route_add (struct rtnl_route *rr)
 	  else
 	    {
 	      fib_source_t fib_src;
+	      int was_sourced;
 
 	      fib_src = lcp_router_proto_fib_source (rproto);
+	      was_sourced = lcp_router_route_is_sourced (nlt, &pfx, fib_src);
 
 	      if (pfx.fp_proto == FIB_PROTOCOL_IP6)
 		fib_table_entry_path_add2 (nlt->nlt_fib_index, &pfx, fib_src,
@@ -1232,14 +1276,24 @@ lcp_router_route_add (struct rtnl_route *rr)
 	      else
 		fib_table_entry_update (nlt->nlt_fib_index, &pfx, fib_src,
 					entry_flags, np.paths);
+
+	      /* an entry that already existed holds its lock already */
+	      keep_lock =
+		!was_sourced && lcp_router_route_is_sourced (nlt, &pfx, fib_src);
 	    }
 	}
       else
-	LCP_ROUTER_DBG ("no paths for route add: %d:%U %U",
-			rtnl_route_get_table (rr), format_fib_prefix, &pfx,
-			format_fib_entry_flags, entry_flags);
+	{
+	  LCP_ROUTER_DBG ("no paths for route add: %d:%U %U",
+			  rtnl_route_get_table (rr), format_fib_prefix, &pfx,
+			  format_fib_entry_flags, entry_flags);
+	  keep_lock = !is_counted;
+	}
       vec_free (np.paths);
     }
+
+  if (!keep_lock)
+    lcp_router_table_unlock (nlt);
 }
 
 static void
@@ -156,6 +156,9 @@ ip4_map (vlib_main_t * vm, vlib_node_runtime_t * node, vlib_frame_t * frame)
   vlib_combined_counter_main_t *cm = mm->domain_counters;
   u32 thread_index = vm->thread_index;
   u32 *buffer0 = 0;
+  u32 map_domain_indices[VLIB_FRAME_SIZE], *mdi = map_domain_indices;
+
+  ip4_map_get_domain_indices (vm, from, n_left_from, map_domain_indices);
 
   while (n_left_from > 0)
     {
@@ -170,25 +173,24 @@ ip4_map (vlib_main_t * vm, vlib_node_runtime_t * node, vlib_frame_t * frame)
 	  u16 port0 = 0;
 	  ip6_header_t *ip6h0;
 	  u32 next0 = IP4_MAP_NEXT_IP6_LOOKUP;
-	  u32 map_domain_index0 = ~0;
+	  u32 map_domain_index0 = mdi[0];
 	  bool free_original_buffer0 = false;
 	  u32 *frag_from0, frag_left0;
 
 	  pi0 = to_next[0] = from[0];
 	  from += 1;
 	  n_left_from -= 1;
+	  mdi += 1;
 
 	  p0 = vlib_get_buffer (vm, pi0);
 	  ip40 = vlib_buffer_get_current (p0);
 
-	  d0 =
-	    ip4_map_get_domain (&ip40->dst_address, &map_domain_index0,
-				&error0);
-	  if (!d0)
+	  if (map_domain_index0 == ~0)
 	    {			/* Guess it wasn't for us */
 	      vnet_feature_next (&next0, p0);
 	      goto exit;
 	    }
+	  d0 = pool_elt_at_index (mm->domains, map_domain_index0);
 
 	  /*
 	   * Shared IPv4 address
@@ -552,6 +552,9 @@ ip4_map_t (vlib_main_t * vm, vlib_node_runtime_t * node, vlib_frame_t * frame)
   next_index = node->cached_next_index;
   vlib_combined_counter_main_t *cm = map_main.domain_counters;
   u32 thread_index = vm->thread_index;
+  u32 map_domain_indices[VLIB_FRAME_SIZE], *mdi = map_domain_indices;
+
+  ip4_map_get_domain_indices (vm, from, n_left_from, map_domain_indices);
 
   while (n_left_from > 0)
     {
@@ -577,6 +580,8 @@ ip4_map_t (vlib_main_t * vm, vlib_node_runtime_t * node, vlib_frame_t * frame)
 	  error0 = MAP_ERROR_NONE;
 
 	  p0 = vlib_get_buffer (vm, pi0);
+	  vnet_buffer (p0)->map_t.map_domain_index = mdi[0];
+	  mdi += 1;
 
 	  u16 l4_dst_port = vnet_buffer (p0)->ip.reass.l4_dst_port;
 
@@ -588,15 +593,13 @@ ip4_map_t (vlib_main_t * vm, vlib_node_runtime_t * node, vlib_frame_t * frame)
 	      error0 = MAP_ERROR_UNKNOWN;
 	    }
 
-	  d0 = ip4_map_get_domain (&ip40->dst_address,
-				   &vnet_buffer (p0)->map_t.map_domain_index,
-				   &error0);
-
-	  if (!d0)
+	  if (vnet_buffer (p0)->map_t.map_domain_index == ~0)
 	    {			/* Guess it wasn't for us */
 	      vnet_feature_next (&next0, p0);
 	      goto exit;
 	    }
+	  d0 = pool_elt_at_index (map_main.domains,
+				  vnet_buffer (p0)->map_t.map_domain_index);
 
 	  dst_port0 = -1;
 
@@ -54,6 +54,31 @@ lpm_32_add (lpm_t *lpm, void *addr_v, u8 pfxlen,
   }
   hash = hash_set(hash, key, value);
   lpm->hash[pfxlen] = hash;
+  ip4_mtrie_16_route_add (lpm->mtrie, addr, pfxlen, value + 1);
+}
+
+/*
+ * Longest prefix shorter than pfxlen covering the address, which the
+ * mtrie falls back to once the prefix is gone.
+ */
+static void
+lpm_32_find_cover (lpm_t *lpm, ip4_address_t *addr, u8 pfxlen,
+		   u32 *cover_len, u32 *cover_value)
+{
+  uword *result;
+  i32 mask_len;
+
+  for (mask_len = pfxlen - 1; mask_len >= 0; mask_len--) {
+    result = hash_get (lpm->hash[mask_len],
+		       masked_address32(addr->data_u32, mask_len));
+    if (result) {
+      *cover_len = mask_len;
+      *cover_value = result[0];
+      return;
+    }
+  }
+  *cover_len = 0;
+  *cover_value = ~0;
 }
 
 static void
@@ -65,8 +90,13 @@ lpm_32_delete (lpm_t *lpm, void *addr_v, u8 pfxlen)
   key = masked_address32(addr->data_u32, pfxlen);
   hash = lpm->hash[pfxlen];
   result = hash_get (hash, key);
-  if (result)
+  if (result) {
+    u32 value = result[0], cover_len, cover_value;
     hash_unset(hash, key);
+    lpm_32_find_cover (lpm, addr, pfxlen, &cover_len, &cover_value);
+    ip4_mtrie_16_route_del (lpm->mtrie, addr, pfxlen, value + 1, cover_len,
+			    cover_value + 1);
+  }
   lpm->hash[pfxlen] = hash;
 }
 
@@ -77,6 +107,8 @@ lpm_32_lookup (lpm_t *lpm, void *addr_v, u8 pfxlen)
   i32 mask_len;
   u32 key;
   ip4_address_t *addr = addr_v;
+  if (pfxlen == 32)
+    return lpm_32_lookup_inline (lpm, addr);
   for (mask_len = pfxlen; mask_len >= 0; mask_len--) {
     hash = lpm->hash[mask_len];
     if (hash) {
@@ -113,7 +145,8 @@ lpm_128_lookup (lpm_t *lpm, void *addr_v, u8 pfxlen)
   u32 value;
   clib_bitmap_foreach (i, lpm->prefix_lengths_bitmap)
      {
-      rv = lpm_128_lookup_core(lpm, addr, i, &value);
+      /* bits are set at 128 - pfxlen, so the longest prefix comes first */
+      rv = lpm_128_lookup_core(lpm, addr, 128 - i, &value);
       if (rv == 0)
 	return value;
     }
@@ -164,6 +197,9 @@ lpm_table_init (enum lpm_type_e lpm_type)
     lpm->add = lpm_32_add;
     lpm->delete = lpm_32_delete;
     lpm->lookup = lpm_32_lookup;
+    lpm->mtrie = clib_mem_alloc_aligned (sizeof (*lpm->mtrie),
+					 CLIB_CACHE_LINE_BYTES);
+    ip4_mtrie_16_init (lpm->mtrie);
     break;
   case LPM_TYPE_KEY128:
     lpm->add = lpm_128_add;
@@ -15,6 +15,7 @@
 
 #include <vppinfra/types.h>
 #include <vppinfra/bihash_24_8.h>
+#include <vnet/ip/ip4_mtrie.h>
 
 enum lpm_type_e {
   LPM_TYPE_KEY32,
@@ -26,8 +27,10 @@ typedef struct lpm_ {
   void (*delete) (struct lpm_ *lpm, void *addr_v, u8 pfxlen);
   u32 (*lookup) (struct lpm_ *lpm, void *addr_v, u8 pfxlen);
 
-  /* IPv4 LPM */
+  /* IPv4 LPM, the mtrie is searched by the data plane, the hashes by
+     the control plane to find the cover of a deleted prefix */
   uword *hash[33];
+  ip4_mtrie_16_t *mtrie;
 
   /* IPv6 LPM */
   BVT (clib_bihash) bihash;
@@ -36,3 +39,56 @@ typedef struct lpm_ {
 } lpm_t;
 
 lpm_t *lpm_table_init (enum lpm_type_e lpm_type);
+
+/*
+ * Values are stored in the mtrie off by one, as the empty leaf holds zero,
+ * so a miss comes out as ~0 like from the lookup function.
+ */
+static_always_inline u32
+lpm_32_leaf_value (ip4_mtrie_leaf_t leaf)
+{
+  return ip4_mtrie_leaf_get_adj_index (leaf) - 1;
+}
+
+static_always_inline u32
+lpm_32_lookup_inline (lpm_t *lpm, const ip4_address_t *addr)
+{
+  ip4_mtrie_leaf_t leaf;
+
+  leaf = ip4_mtrie_16_lookup_step_one (lpm->mtrie, addr);
+  leaf = ip4_mtrie_16_lookup_step (leaf, addr, 2);
+  leaf = ip4_mtrie_16_lookup_step (leaf, addr, 3);
+  return lpm_32_leaf_value (leaf);
+}
+
+/*
+ * Look up four addresses at once, interleaving the plies so that their
+ * cache misses overlap.
+ */
+static_always_inline void
+lpm_32_lookup_x4 (lpm_t *lpm, const ip4_address_t *a0,
+		  const ip4_address_t *a1, const ip4_address_t *a2,
+		  const ip4_address_t *a3, u32 *values)
+{
+  ip4_mtrie_leaf_t l0, l1, l2, l3;
+
+  l0 = ip4_mtrie_16_lookup_step_one (lpm->mtrie, a0);
+  l1 = ip4_mtrie_16_lookup_step_one (lpm->mtrie, a1);
+  l2 = ip4_mtrie_16_lookup_step_one (lpm->mtrie, a2);
+  l3 = ip4_mtrie_16_lookup_step_one (lpm->mtrie, a3);
+
+  l0 = ip4_mtrie_16_lookup_step (l0, a0, 2);
+  l1 = ip4_mtrie_16_lookup_step (l1, a1, 2);
+  l2 = ip4_mtrie_16_lookup_step (l2, a2, 2);
+  l3 = ip4_mtrie_16_lookup_step (l3, a3, 2);
+
+  l0 = ip4_mtrie_16_lookup_step (l0, a0, 3);
+  l1 = ip4_mtrie_16_lookup_step (l1, a1, 3);
+  l2 = ip4_mtrie_16_lookup_step (l2, a2, 3);
+  l3 = ip4_mtrie_16_lookup_step (l3, a3, 3);
+
+  values[0] = lpm_32_leaf_value (l0);
+  values[1] = lpm_32_leaf_value (l1);
+  values[2] = lpm_32_leaf_value (l2);
+  values[3] = lpm_32_leaf_value (l3);
+}
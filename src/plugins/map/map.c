@@ -1077,6 +1077,8 @@ show_map_stats_command_fn (vlib_main_t * vm, unformat_input_t * input,
   vlib_cli_output (vm, "MAP domains: %d (%d bytes)\n", domaincount, domains);
   vlib_cli_output (vm, "MAP rules: %d (%d bytes)\n", rulecount, rules);
   vlib_cli_output (vm, "Total: %d bytes)\n", rules + domains);
+  vlib_cli_output (vm, "MAP IPv4 lookup table: %U\n", format_memory_size,
+		   ip4_mtrie_16_memory_usage (mm->ip4_prefix_tbl->mtrie));
 
 #if MAP_SKIP_IP6_LOOKUP
   vlib_cli_output (vm,
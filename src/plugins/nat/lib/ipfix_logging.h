@@ -40,43 +40,6 @@ typedef enum {
   MAX_ENTRIES_PER_USER = 3,
 } quota_exceed_event_t;
 
-typedef struct {
-
-  /** ipfix buffers under construction */
-  vlib_buffer_t *nat44_session_buffer;
-  vlib_buffer_t *addr_exhausted_buffer;
-  vlib_buffer_t *max_entries_per_user_buffer;
-  vlib_buffer_t *max_sessions_buffer;
-  vlib_buffer_t *max_bibs_buffer;
-  vlib_buffer_t *max_frags_ip4_buffer;
-  vlib_buffer_t *max_frags_ip6_buffer;
-  vlib_buffer_t *nat64_bib_buffer;
-  vlib_buffer_t *nat64_ses_buffer;
-
-  /** frames containing ipfix buffers */
-  vlib_frame_t *nat44_session_frame;
-  vlib_frame_t *addr_exhausted_frame;
-  vlib_frame_t *max_entries_per_user_frame;
-  vlib_frame_t *max_sessions_frame;
-  vlib_frame_t *max_bibs_frame;
-  vlib_frame_t *max_frags_ip4_frame;
-  vlib_frame_t *max_frags_ip6_frame;
-  vlib_frame_t *nat64_bib_frame;
-  vlib_frame_t *nat64_ses_frame;
-
-  /** next record offset */
-  u32 nat44_session_next_record_offset;
-  u32 addr_exhausted_next_record_offset;
-  u32 max_entries_per_user_next_record_offset;
-  u32 max_sessions_next_record_offset;
-  u32 max_bibs_next_record_offset;
-  u32 max_frags_ip4_next_record_offset;
-  u32 max_frags_ip6_next_record_offset;
-  u32 nat64_bib_next_record_offset;
-  u32 nat64_ses_next_record_offset;
-
-} nat_ipfix_per_thread_data_t;
-
 typedef struct {
   /** NAT plugin IPFIX logging enabled */
   u8 enabled;
@@ -85,28 +48,14 @@ typedef struct {
   u64 milisecond_time_0;
   f64 vlib_time_0;
 
-  /* Per thread data */
-  nat_ipfix_per_thread_data_t *per_thread_data;
-
-  /** template IDs */
-  u16 nat44_session_template_id;
-  u16 addr_exhausted_template_id;
-  u16 max_entries_per_user_template_id;
-  u16 max_sessions_template_id;
-  u16 max_bibs_template_id;
-  u16 max_frags_ip4_template_id;
-  u16 max_frags_ip6_template_id;
-  u16 nat64_bib_template_id;
-  u16 nat64_ses_template_id;
-
-  /** stream index */
-  u32 stream_index;
-
-  /** vector of worker vlib mains */
-  vlib_main_t **worker_vms;
-
-  /** nat data callbacks call counter */
-  u16 call_counter;
+  /** flow report indices on exporter 0, ~0 while disabled */
+  u32 nat44_session_report_index;
+  u32 addr_exhausted_report_index;
+  u32 max_entries_per_user_report_index;
+  u32 max_sessions_report_index;
+  u32 max_bibs_report_index;
+  u32 nat64_bib_report_index;
+  u32 nat64_ses_report_index;
 
 } nat_ipfix_logging_main_t;
 
@@ -435,6 +435,10 @@ show_perfmon_stats_command_fn (vlib_main_t *vm, unformat_input_t *input,
   if (b->footer)
     vlib_cli_output (vm, "\n%s\n", b->footer);
 
+  if (b->active_type == PERFMON_BUNDLE_TYPE_NODE && pm->sample_interval)
+    vlib_cli_output (vm, "\nsampled 1 in %u dispatches per node\n",
+		     pm->sample_interval);
+
 done:
   vec_free (readings);
   vec_free (s);
@@ -471,6 +475,7 @@ perfmon_start_command_fn (vlib_main_t *vm, unformat_input_t *input,
   unformat_input_t _line_input, *line_input = &_line_input;
   perfmon_bundle_t *b = 0;
   perfmon_bundle_type_t bundle_type = PERFMON_BUNDLE_TYPE_UNKNOWN;
+  u32 sample_interval = 0;
 
   if (pm->is_running)
     return clib_error_return (0, "please stop first");
@@ -485,6 +490,8 @@ perfmon_start_command_fn (vlib_main_t *vm, unformat_input_t *input,
       else if (unformat (line_input, "type %U", unformat_perfmon_active_type,
 			 b, &bundle_type))
 	;
+      else if (unformat (line_input, "sample-interval %u", &sample_interval))
+	;
       else
 	return clib_error_return (0, "unknown input '%U'",
 				  format_unformat_error, line_input);
@@ -510,14 +517,19 @@ perfmon_start_command_fn (vlib_main_t *vm, unformat_input_t *input,
 	(perfmon_bundle_type_t) count_trailing_zeros (b->type_flags);
     }
 
+  if (sample_interval > 1 && bundle_type != PERFMON_BUNDLE_TYPE_NODE)
+    return clib_error_return (0, "sample-interval applies to node bundles");
+
   b->active_type = bundle_type;
+  pm->sample_interval = sample_interval > 1 ? sample_interval : 0;
 
   return perfmon_start (vm, b);
 }
 
 VLIB_CLI_COMMAND (perfmon_start_command, static) = {
   .path = "perfmon start",
-  .short_help = "perfmon start bundle [<bundle-name>] type [<node|thread>]",
+  .short_help = "perfmon start bundle [<bundle-name>] type [<node|thread>] "
+		"[sample-interval <n>]",
   .function = perfmon_start_command_fn,
   .is_mp_safe = 1,
 };
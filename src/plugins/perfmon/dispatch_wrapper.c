@@ -34,7 +34,8 @@ perfmon_read_pmcs (u64 *counters, u32 *indexes, u8 n_counters)
 
 static_always_inline uword
 perfmon_dispatch_wrapper_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
-				 vlib_frame_t *frame, u8 n_events)
+				 vlib_frame_t *frame, u8 n_events,
+				 int is_sampled)
 {
   perfmon_main_t *pm = &perfmon_main;
   perfmon_thread_runtime_t *rt =
@@ -50,6 +51,18 @@ perfmon_dispatch_wrapper_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 
   clib_prefetch_load (s);
 
+  /* in sampling mode only every nth dispatch of a node is measured, so the
+   * counters are read rarely enough to be left on in production */
+  if (is_sampled)
+    {
+      if (PREDICT_TRUE (s->n_until_sample))
+	{
+	  s->n_until_sample--;
+	  return node->function (vm, node, frame);
+	}
+      s->n_until_sample = rt->sample_interval - 1;
+    }
+
   perfmon_read_pmcs (&samples.t[0][0], &rt->indexes[0], n_events);
   rv = node->function (vm, node, frame);
   perfmon_read_pmcs (&samples.t[1][0], &rt->indexes[0], n_events);
@@ -83,7 +96,12 @@ perfmon_dispatch_wrapper_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
   static uword perfmon_dispatch_wrapper##x (                                  \
     vlib_main_t *vm, vlib_node_runtime_t *node, vlib_frame_t *frame)          \
   {                                                                           \
-    return perfmon_dispatch_wrapper_inline (vm, node, frame, x);              \
+    return perfmon_dispatch_wrapper_inline (vm, node, frame, x, 0);           \
+  }                                                                           \
+  static uword perfmon_sampled_dispatch_wrapper##x (                          \
+    vlib_main_t *vm, vlib_node_runtime_t *node, vlib_frame_t *frame)          \
+  {                                                                           \
+    return perfmon_dispatch_wrapper_inline (vm, node, frame, x, 1);           \
   }
 
 foreach_n_events
@@ -94,3 +112,10 @@ foreach_n_events
     foreach_n_events
 #undef _
   };
+
+  vlib_node_function_t
+    *perfmon_sampled_dispatch_wrappers[PERF_MAX_EVENTS + 1] = {
+#define _(x) [x] = &perfmon_sampled_dispatch_wrapper##x,
+      foreach_n_events
+#undef _
+    };
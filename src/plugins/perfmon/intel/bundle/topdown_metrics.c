@@ -179,6 +179,14 @@ format_topdown_lvl2 (u8 *s, va_list *args)
   return s;
 }
 
+static f64
+topdown_lvl2_metric (void *ps, u32 row, perfmon_bundle_type_t type)
+{
+  if (type == PERFMON_BUNDLE_TYPE_NODE)
+    return topdown_lvl2_rdpmc_metric (ps, (topdown_e_t) row);
+  return topdown_lvl2_perf_reading (ps, (topdown_e_t) row);
+}
+
 static perfmon_cpu_supports_t topdown_lvl2_cpu_supports[] = {
   /* Intel SPR supports papi/thread or rdpmc/node */
   { clib_cpu_supports_avx512_fp16, PERFMON_BUNDLE_TYPE_NODE_OR_THREAD }
@@ -206,6 +214,13 @@ PERFMON_REGISTER_BUNDLE (topdown_lvl2_metric) = {
 				     "% RT.LO", "% BS.BM", "% BS.MC",
 				     "% FE.FL", "% FE.FB", "% BE.MB",
 				     "% BE.CB"),
+  .metric_fn = topdown_lvl2_metric,
+  .metric_names = PERFMON_STRINGS (
+    "topdown/retiring", "topdown/bad-speculation", "topdown/frontend-bound",
+    "topdown/backend-bound", "topdown/heavy-operations",
+    "topdown/light-operations", "topdown/branch-mispredict",
+    "topdown/machine-clears", "topdown/fetch-latency",
+    "topdown/fetch-bandwidth", "topdown/memory-bound", "topdown/core-bound"),
   .footer = "Retiring (RT), Bad Speculation (BS),\n"
 	    " FrontEnd bound (1FE), BackEnd bound (BE),\n"
 	    " Light Operations (LO), Heavy Operations (HO),\n"
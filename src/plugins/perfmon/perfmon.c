@@ -22,6 +22,7 @@
 #include <linux/limits.h>
 #include <sys/ioctl.h>
 
+#include <vlib/stats/stats.h>
 #include <perfmon/perfmon.h>
 
 perfmon_main_t perfmon_main;
@@ -41,6 +42,115 @@ VLIB_REGISTER_LOG_CLASS (if_default_log, static) = {
   vlib_log_warn (if_default_log.class, fmt, __VA_ARGS__)
 #define log_err(fmt, ...) vlib_log_err (if_default_log.class, fmt, __VA_ARGS__)
 
+static void
+perfmon_stats_remove (void)
+{
+  perfmon_main_t *pm = &perfmon_main;
+
+  if (pm->calls_stats_index == ~0)
+    return;
+
+  vlib_stats_remove_entry (pm->calls_stats_index);
+  vlib_stats_remove_entry (pm->packets_stats_index);
+  for (int i = 0; i < vec_len (pm->event_stats_indices); i++)
+    vlib_stats_remove_entry (pm->event_stats_indices[i]);
+  for (int i = 0; i < vec_len (pm->metric_stats_indices); i++)
+    vlib_stats_remove_entry (pm->metric_stats_indices[i]);
+  vec_free (pm->event_stats_indices);
+  vec_free (pm->metric_stats_indices);
+  pm->calls_stats_index = pm->packets_stats_index = ~0;
+}
+
+/* per node counters are exported as [thread][node] vectors, indexed like
+ * /sys/node/calls, so they can be joined with /sys/node/names */
+static void
+perfmon_stats_add (perfmon_bundle_t *b, u32 n_threads, u32 n_nodes)
+{
+  perfmon_main_t *pm = &perfmon_main;
+  u32 *indices = 0;
+
+  perfmon_stats_remove ();
+
+  pm->calls_stats_index =
+    vlib_stats_add_counter_vector ("/perfmon/nodes/calls");
+  vec_add1 (indices, pm->calls_stats_index);
+  pm->packets_stats_index =
+    vlib_stats_add_counter_vector ("/perfmon/nodes/packets");
+  vec_add1 (indices, pm->packets_stats_index);
+
+  /* preserved samples only hold the counters around the last call, they are
+   * left to the bundle metrics */
+  for (int i = 0; i < b->n_events; i++)
+    if ((b->preserve_samples & 1 << i) == 0)
+      {
+	perfmon_event_t *e = b->src->events + b->events[i];
+	u32 index = vlib_stats_add_counter_vector ("/perfmon/nodes/%s", e->name);
+	vec_add1 (pm->event_stats_indices, index);
+	vec_add1 (indices, index);
+      }
+
+  if (b->metric_fn)
+    for (char **name = b->metric_names; name && name[0]; name++)
+      {
+	u32 index = vlib_stats_add_counter_vector ("/perfmon/nodes/%s", name[0]);
+	vec_add1 (pm->metric_stats_indices, index);
+	vec_add1 (indices, index);
+      }
+
+  for (int i = 0; i < vec_len (indices); i++)
+    vlib_stats_validate (indices[i], n_threads - 1, n_nodes - 1);
+  vec_free (indices);
+}
+
+static void
+perfmon_stats_collector_fn (vlib_stats_collector_data_t *d)
+{
+  perfmon_main_t *pm = &perfmon_main;
+  perfmon_bundle_t *b = pm->active_bundle;
+  counter_t **calls, **packets, **c;
+
+  d->entry->value = pm->sample_interval;
+
+  if (pm->calls_stats_index == ~0 || b == 0)
+    return;
+
+  calls = vlib_stats_get_entry_data_pointer (pm->calls_stats_index);
+  packets = vlib_stats_get_entry_data_pointer (pm->packets_stats_index);
+
+  for (int i = 0; i < vec_len (pm->thread_runtimes); i++)
+    {
+      perfmon_thread_runtime_t *tr = vec_elt_at_index (pm->thread_runtimes, i);
+
+      for (int j = 0; j < tr->n_nodes; j++)
+	{
+	  perfmon_node_stats_t ns;
+	  int k = 0;
+
+	  clib_memcpy_fast (&ns, tr->node_stats + j, sizeof (ns));
+	  calls[i][j] = ns.n_calls;
+	  packets[i][j] = ns.n_packets;
+
+	  for (int e = 0; e < b->n_events; e++)
+	    if ((b->preserve_samples & 1 << e) == 0)
+	      {
+		c = vlib_stats_get_entry_data_pointer (
+		  pm->event_stats_indices[k++]);
+		c[i][j] = ns.value[e];
+	      }
+
+	  /* metrics are derived here rather than in the dispatch path, as
+	   * fixed point with two decimal places */
+	  for (int m = 0; m < vec_len (pm->metric_stats_indices); m++)
+	    {
+	      f64 v = ns.n_calls ? b->metric_fn (&ns, m, b->active_type) : 0;
+	      c = vlib_stats_get_entry_data_pointer (
+		pm->metric_stats_indices[m]);
+	      c[i][j] = v > 0 ? (u64) (v * 100 + 0.5) : 0;
+	    }
+	}
+    }
+}
+
 void
 perfmon_reset (vlib_main_t *vm)
 {
@@ -73,6 +183,7 @@ perfmon_reset (vlib_main_t *vm)
 	  munmap (tr->mmap_pages[j], page_size);
     }
   vec_free (pm->thread_runtimes);
+  perfmon_stats_remove ();
 
   pm->is_running = 0;
   pm->active_instance_type = 0;
@@ -197,6 +308,7 @@ perfmon_set (vlib_main_t *vm, perfmon_bundle_t *b)
 	  rt->n_events = b->n_events;
 	  rt->n_nodes = n_nodes;
 	  rt->preserve_samples = b->preserve_samples;
+	  rt->sample_interval = pm->sample_interval;
 	  vec_validate_aligned (rt->node_stats, n_nodes - 1,
 				CLIB_CACHE_LINE_BYTES);
 	}
@@ -204,6 +316,9 @@ perfmon_set (vlib_main_t *vm, perfmon_bundle_t *b)
 
   pm->active_bundle = b;
 
+  if (is_node)
+    perfmon_stats_add (b, vec_len (pm->thread_runtimes), n_nodes);
+
 error:
   if (err)
     {
@@ -284,9 +399,13 @@ perfmon_start (vlib_main_t *vm, perfmon_bundle_t *b)
 	    }
 	}
 
+      vlib_node_function_t **wrappers = pm->sample_interval > 1 ?
+					  perfmon_sampled_dispatch_wrappers :
+					  perfmon_dispatch_wrappers;
+
       for (int i = 0; i < vlib_get_n_threads (); i++)
-	vlib_node_set_dispatch_wrapper (
-	  vlib_get_main_by_index (i), perfmon_dispatch_wrappers[b->n_events]);
+	vlib_node_set_dispatch_wrapper (vlib_get_main_by_index (i),
+					wrappers[b->n_events]);
     }
   pm->sample_time = vlib_time_now (vm);
   pm->is_running = 1;
@@ -377,6 +496,14 @@ perfmon_init (vlib_main_t *vm)
   perfmon_main_t *pm = &perfmon_main;
   perfmon_source_t *s = pm->sources;
   perfmon_bundle_t *b = pm->bundles;
+  vlib_stats_collector_reg_t reg = {};
+
+  pm->calls_stats_index = pm->packets_stats_index = ~0;
+  pm->sample_interval_stats_index =
+    vlib_stats_add_gauge ("/perfmon/sample-interval");
+  reg.entry_index = pm->sample_interval_stats_index;
+  reg.collect_fn = perfmon_stats_collector_fn;
+  vlib_stats_register_collector_fn (&reg);
 
   pm->source_by_name = hash_create_string (0, sizeof (uword));
   while (s)
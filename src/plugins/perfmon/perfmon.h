@@ -87,6 +87,8 @@ typedef struct
 
 struct perfmon_source;
 extern vlib_node_function_t *perfmon_dispatch_wrappers[PERF_MAX_EVENTS + 1];
+extern vlib_node_function_t
+  *perfmon_sampled_dispatch_wrappers[PERF_MAX_EVENTS + 1];
 
 typedef clib_error_t *(perfmon_source_init_fn_t) (vlib_main_t *vm,
 						  struct perfmon_source *);
@@ -109,6 +111,8 @@ struct perfmon_bundle;
 
 typedef clib_error_t *(perfmon_bundle_init_fn_t) (vlib_main_t *vm,
 						  struct perfmon_bundle *);
+typedef f64 (perfmon_bundle_metric_fn_t) (void *ps, u32 row,
+					  perfmon_bundle_type_t type);
 
 typedef struct
 {
@@ -143,6 +147,11 @@ typedef struct perfmon_bundle
   char **column_headers;
   format_function_t *format_fn;
 
+  /* optional, metrics derived from node stats when exported to the stats
+   * segment, one per name */
+  char **metric_names;
+  perfmon_bundle_metric_fn_t *metric_fn;
+
   /* do not set manually */
   perfmon_source_t *src;
   struct perfmon_bundle *next;
@@ -161,6 +170,7 @@ typedef struct
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   u64 n_calls;
   u64 n_packets;
+  u32 n_until_sample;
   union
   {
     struct
@@ -179,6 +189,7 @@ typedef struct
   perfmon_bundle_t *bundle;
   u32 indexes[PERF_MAX_EVENTS];
   u16 preserve_samples;
+  u32 sample_interval;
   struct perf_event_mmap_page *mmap_pages[PERF_MAX_EVENTS];
 } perfmon_thread_runtime_t;
 
@@ -196,6 +207,16 @@ typedef struct
   int *fds_to_close;
   perfmon_instance_type_t *default_instance_type;
   perfmon_instance_type_t *active_instance_type;
+
+  /* read counters on every nth dispatch of a node, 0 to read on all */
+  u32 sample_interval;
+
+  /* stats segment, [thread][node] */
+  u32 sample_interval_stats_index;
+  u32 calls_stats_index;
+  u32 packets_stats_index;
+  u32 *event_stats_indices;
+  u32 *metric_stats_indices;
 } perfmon_main_t;
 
 extern perfmon_main_t perfmon_main;
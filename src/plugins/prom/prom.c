@@ -22,184 +22,612 @@
 
 static prom_main_t prom_main;
 
+/* Max time a scrape runs on the main thread before yielding */
+#define PROM_SCRAPE_SLICE_TIME 1e-3
+/* Scrapes restart if the stats directory changes between slices. After
+ * this many restarts the scrape completes without yielding */
+#define PROM_SCRAPE_MAX_RESTARTS 5
+
 static u8 *
-make_stat_name (char *name)
+make_stat_name (u8 *s, char *name)
 {
   prom_main_t *pm = &prom_main;
-  char *p = name;
+  u32 i;
+
+  i = vec_len (s) + vec_len (pm->stat_name_prefix);
+  s = format (s, "%v%s", pm->stat_name_prefix, name);
+  for (; i < vec_len (s); i++)
+    if (!isalnum (s[i]))
+      s[i] = '_';
+  return s;
+}
+
+static u8 *
+stat_entry_name (prom_main_t *pm, u32 index, char *dir_name)
+{
+  prom_stat_entry_t *e;
+  u32 len;
+
+  vec_validate (pm->entries, index);
+  e = vec_elt_at_index (pm->entries, index);
+  len = strnlen (dir_name, VLIB_STATS_MAX_NAME_SZ);
+
+  /* Directory indices are reused once entries are removed */
+  if (e->name && vec_len (e->dir_name) == len &&
+      !memcmp (e->dir_name, dir_name, len))
+    return e->name;
+
+  vec_reset_length (e->dir_name);
+  vec_add (e->dir_name, dir_name, len);
+  vec_reset_length (e->name);
+  e->name = make_stat_name (e->name, dir_name);
+  return e->name;
+}
+
+static void
+stat_entries_free (prom_main_t *pm)
+{
+  prom_stat_entry_t *e;
 
-  while (*p)
+  vec_foreach (e, pm->entries)
     {
-      if (!isalnum (*p))
-	*p = '_';
-      p++;
+      vec_free (e->dir_name);
+      vec_free (e->name);
     }
+  vec_free (pm->entries);
+}
+
+/* Label values escape backslash, double quote and line feed */
+static u8 *
+add_label_value (u8 *s, u8 *value)
+{
+  u32 i;
 
-  /* Reuse vector, instead of always allocating, when building a name. */
-  vec_reset_length (pm->name_scratch_pad);
-  pm->name_scratch_pad =
-    format (pm->name_scratch_pad, "%v%s", pm->stat_name_prefix, name);
-  return pm->name_scratch_pad;
+  for (i = 0; i < vec_len (value) && value[i]; i++)
+    {
+      if (value[i] == '\\' || value[i] == '"')
+	vec_add1 (s, '\\');
+      else if (value[i] == '\n')
+	{
+	  vec_add (s, "\\n", 2);
+	  continue;
+	}
+      vec_add1 (s, value[i]);
+    }
+  return s;
+}
+
+/* Keep the interface labels in sync with /if/names */
+static void
+if_labels_update (prom_main_t *pm, stat_client_main_t *scm)
+{
+  vlib_stats_entry_t *ep;
+  u8 **names, *name;
+  u32 index, i, len;
+
+  index = vlib_stats_find_entry_index ("/if/names");
+  if (index == STAT_SEGMENT_INDEX_INVALID)
+    return;
+
+  ep = vec_elt_at_index (scm->directory_vector, index);
+  names = stat_segment_adjust (scm, ep->data);
+
+  for (i = 0; i < vec_len (names); i++)
+    {
+      vec_validate (pm->if_names, i);
+      vec_validate (pm->if_labels, i);
+      name = names[i] ? stat_segment_adjust (scm, names[i]) : 0;
+      if (!name)
+	{
+	  vec_free (pm->if_names[i]);
+	  vec_free (pm->if_labels[i]);
+	  continue;
+	}
+      len = vec_len (name);
+      if (vec_len (pm->if_names[i]) == len &&
+	  !memcmp (pm->if_names[i], name, len))
+	continue;
+      vec_reset_length (pm->if_names[i]);
+      vec_add (pm->if_names[i], name, len);
+      vec_reset_length (pm->if_labels[i]);
+      vec_add (pm->if_labels[i], "interface=\"", 11);
+      pm->if_labels[i] = add_label_value (pm->if_labels[i], pm->if_names[i]);
+      vec_add1 (pm->if_labels[i], '"');
+    }
 }
 
 static u8 *
-dump_counter_vector_simple (stat_segment_data_t *res, u8 *s, u8 used_only)
+index_label (prom_main_t *pm, u8 is_if, u32 index)
 {
-  u8 need_header = 1;
+  if (is_if && index < vec_len (pm->if_labels) && pm->if_labels[index])
+    return pm->if_labels[index];
+
+  vec_validate (pm->index_labels, index);
+  if (!pm->index_labels[index])
+    pm->index_labels[index] = format (0, "index=\"%u\"", index);
+  return pm->index_labels[index];
+}
+
+static u8 *
+thread_label (prom_main_t *pm, u32 thread_index)
+{
+  vec_validate (pm->thread_labels, thread_index);
+  if (!pm->thread_labels[thread_index])
+    pm->thread_labels[thread_index] =
+      format (0, "thread=\"%u\"", thread_index);
+  return pm->thread_labels[thread_index];
+}
+
+static u8 *
+add_string (u8 *s, char *str)
+{
+  vec_add (s, str, strlen (str));
+  return s;
+}
+
+static u8 *
+add_u64 (u8 *s, u64 value)
+{
+  u8 buf[20], *p = buf + sizeof (buf);
+
+  do
+    *--p = '0' + value % 10;
+  while (value /= 10);
+
+  vec_add (s, p, buf + sizeof (buf) - p);
+  return s;
+}
+
+static u8 *
+add_type (u8 *s, u8 *name, char *suffix)
+{
+  s = add_string (s, "# TYPE ");
+  vec_append (s, name);
+  s = add_string (s, suffix);
+  return add_string (s, " counter\n");
+}
+
+/* Samples are built from cached strings, avoiding format () per line */
+static u8 *
+add_sample (u8 *s, u8 *name, char *suffix, u8 *thread, u8 *label, u64 value)
+{
+  vec_append (s, name);
+  s = add_string (s, suffix);
+  if (thread || label)
+    {
+      vec_add1 (s, '{');
+      if (thread)
+	vec_append (s, thread);
+      if (thread && label)
+	vec_add1 (s, ',');
+      if (label)
+	vec_append (s, label);
+      vec_add1 (s, '}');
+    }
+  vec_add1 (s, ' ');
+  s = add_u64 (s, value);
+  vec_add1 (s, '\n');
+  return s;
+}
+
+static u8 *
+dump_counter_vector_simple (prom_main_t *pm, stat_client_main_t *scm,
+			    vlib_stats_entry_t *ep, u8 *name, u8 *s)
+{
+  u8 need_header = 1, is_if;
+  counter_t **counters, *cb;
   int j, k;
-  u8 *name;
 
-  name = make_stat_name (res->name);
+  counters = stat_segment_adjust (scm, ep->data);
+  is_if = !strncmp (ep->name, "/if/", 4);
 
-  for (k = 0; k < vec_len (res->simple_counter_vec); k++)
-    for (j = 0; j < vec_len (res->simple_counter_vec[k]); j++)
-      {
-	if (used_only && !res->simple_counter_vec[k][j])
-	  continue;
-	if (need_header)
-	  {
-	    s = format (s, "# TYPE %v counter\n", name);
-	    need_header = 0;
-	  }
-	s = format (s, "%v{thread=\"%d\",interface=\"%d\"} %lld\n", name, k, j,
-		    res->simple_counter_vec[k][j]);
-      }
+  if (pm->per_thread)
+    {
+      for (k = 0; k < vec_len (counters); k++)
+	{
+	  cb = stat_segment_adjust (scm, counters[k]);
+	  for (j = 0; j < vec_len (cb); j++)
+	    {
+	      if (pm->used_only && !cb[j])
+		continue;
+	      if (need_header)
+		{
+		  s = add_type (s, name, "");
+		  need_header = 0;
+		}
+	      s = add_sample (s, name, "", thread_label (pm, k),
+			      index_label (pm, is_if, j), cb[j]);
+	    }
+	}
+      return s;
+    }
+
+  /* Sum across threads, walking each thread's counters in order */
+  vec_reset_length (pm->simple_sums);
+  for (k = 0; k < vec_len (counters); k++)
+    {
+      cb = stat_segment_adjust (scm, counters[k]);
+      if (vec_len (cb) > vec_len (pm->simple_sums))
+	vec_validate_init_empty (pm->simple_sums, vec_len (cb) - 1, 0);
+      for (j = 0; j < vec_len (cb); j++)
+	pm->simple_sums[j] += cb[j];
+    }
+
+  for (j = 0; j < vec_len (pm->simple_sums); j++)
+    {
+      if (pm->used_only && !pm->simple_sums[j])
+	continue;
+      if (need_header)
+	{
+	  s = add_type (s, name, "");
+	  need_header = 0;
+	}
+      s = add_sample (s, name, "", 0, index_label (pm, is_if, j),
+		      pm->simple_sums[j]);
+    }
 
   return s;
 }
 
 static u8 *
-dump_counter_vector_combined (stat_segment_data_t *res, u8 *s, u8 used_only)
+dump_counter_vector_combined (prom_main_t *pm, stat_client_main_t *scm,
+			      vlib_stats_entry_t *ep, u8 *name, u8 *s)
 {
-  u8 need_header = 1;
+  vlib_counter_t **counters, *cb, *sums;
+  u8 need_header = 1, is_if;
+  u8 *label;
   int j, k;
-  u8 *name;
 
-  name = make_stat_name (res->name);
+  counters = stat_segment_adjust (scm, ep->data);
+  is_if = !strncmp (ep->name, "/if/", 4);
 
-  for (k = 0; k < vec_len (res->simple_counter_vec); k++)
-    for (j = 0; j < vec_len (res->combined_counter_vec[k]); j++)
-      {
-	if (used_only && !res->combined_counter_vec[k][j].packets)
-	  continue;
-	if (need_header)
-	  {
-	    s = format (s, "# TYPE %v_packets counter\n", name);
-	    s = format (s, "# TYPE %v_bytes counter\n", name);
-	    need_header = 0;
-	  }
-	s = format (s, "%v_packets{thread=\"%d\",interface=\"%d\"} %lld\n",
-		    name, k, j, res->combined_counter_vec[k][j].packets);
-	s = format (s, "%v_bytes{thread=\"%d\",interface=\"%d\"} %lld\n", name,
-		    k, j, res->combined_counter_vec[k][j].bytes);
-      }
+  if (pm->per_thread)
+    {
+      for (k = 0; k < vec_len (counters); k++)
+	{
+	  cb = stat_segment_adjust (scm, counters[k]);
+	  for (j = 0; j < vec_len (cb); j++)
+	    {
+	      if (pm->used_only && !cb[j].packets)
+		continue;
+	      if (need_header)
+		{
+		  s = add_type (s, name, "_packets");
+		  s = add_type (s, name, "_bytes");
+		  need_header = 0;
+		}
+	      label = index_label (pm, is_if, j);
+	      s = add_sample (s, name, "_packets", thread_label (pm, k), label,
+			      cb[j].packets);
+	      s = add_sample (s, name, "_bytes", thread_label (pm, k), label,
+			      cb[j].bytes);
+	    }
+	}
+      return s;
+    }
+
+  vec_reset_length (pm->combined_sums);
+  for (k = 0; k < vec_len (counters); k++)
+    {
+      cb = stat_segment_adjust (scm, counters[k]);
+      if (vec_len (cb) > vec_len (pm->combined_sums))
+	{
+	  vlib_counter_t zero = {};
+	  vec_validate_init_empty (pm->combined_sums, vec_len (cb) - 1, zero);
+	}
+      for (j = 0; j < vec_len (cb); j++)
+	{
+	  pm->combined_sums[j].packets += cb[j].packets;
+	  pm->combined_sums[j].bytes += cb[j].bytes;
+	}
+    }
+
+  sums = pm->combined_sums;
+  for (j = 0; j < vec_len (sums); j++)
+    {
+      if (pm->used_only && !sums[j].packets)
+	continue;
+      if (need_header)
+	{
+	  s = add_type (s, name, "_packets");
+	  s = add_type (s, name, "_bytes");
+	  need_header = 0;
+	}
+      label = index_label (pm, is_if, j);
+      s = add_sample (s, name, "_packets", 0, label, sums[j].packets);
+      s = add_sample (s, name, "_bytes", 0, label, sums[j].bytes);
+    }
 
   return s;
 }
 
+/* Symlinks point at one column of a counter vector, e.g.
+ * /interfaces/<name>/rx is /if/rx[sw_if_index] */
 static u8 *
-dump_scalar_index (stat_segment_data_t *res, u8 *s, u8 used_only)
+dump_symlink (prom_main_t *pm, stat_client_main_t *scm,
+	      vlib_stats_entry_t *ep, u8 *name, u8 *s)
 {
-  u8 *name;
+  vlib_counter_t **combined, *ccb, csum = {};
+  counter_t **simple, *scb, ssum = 0;
+  vlib_stats_entry_t *ep2;
+  u32 j = ep->index2;
+  u8 *thread;
+  int k;
 
-  if (used_only && !res->scalar_value)
-    return s;
+  ep2 = vec_elt_at_index (scm->directory_vector, ep->index1);
+
+  switch (ep2->type)
+    {
+    case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
+      simple = stat_segment_adjust (scm, ep2->data);
+      for (k = 0; k < vec_len (simple); k++)
+	{
+	  scb = stat_segment_adjust (scm, simple[k]);
+	  ssum += j < vec_len (scb) ? scb[j] : 0;
+	}
+      if (pm->used_only && !ssum)
+	break;
+      s = add_type (s, name, "");
+      if (!pm->per_thread)
+	{
+	  s = add_sample (s, name, "", 0, 0, ssum);
+	  break;
+	}
+      for (k = 0; k < vec_len (simple); k++)
+	{
+	  scb = stat_segment_adjust (scm, simple[k]);
+	  thread = thread_label (pm, k);
+	  s = add_sample (s, name, "", thread, 0,
+			  j < vec_len (scb) ? scb[j] : 0);
+	}
+      break;
 
-  name = make_stat_name (res->name);
+    case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
+      combined = stat_segment_adjust (scm, ep2->data);
+      for (k = 0; k < vec_len (combined); k++)
+	{
+	  ccb = stat_segment_adjust (scm, combined[k]);
+	  if (j >= vec_len (ccb))
+	    continue;
+	  csum.packets += ccb[j].packets;
+	  csum.bytes += ccb[j].bytes;
+	}
+      if (pm->used_only && !csum.packets)
+	break;
+      s = add_type (s, name, "_packets");
+      s = add_type (s, name, "_bytes");
+      if (!pm->per_thread)
+	{
+	  s = add_sample (s, name, "_packets", 0, 0, csum.packets);
+	  s = add_sample (s, name, "_bytes", 0, 0, csum.bytes);
+	  break;
+	}
+      for (k = 0; k < vec_len (combined); k++)
+	{
+	  ccb = stat_segment_adjust (scm, combined[k]);
+	  thread = thread_label (pm, k);
+	  s = add_sample (s, name, "_packets", thread, 0,
+			  j < vec_len (ccb) ? ccb[j].packets : 0);
+	  s = add_sample (s, name, "_bytes", thread, 0,
+			  j < vec_len (ccb) ? ccb[j].bytes : 0);
+	}
+      break;
 
-  s = format (s, "# TYPE %v counter\n", name);
-  s = format (s, "%v %.2f\n", name, res->scalar_value);
+    default:
+      break;
+    }
 
   return s;
 }
 
 static u8 *
-dump_name_vector (stat_segment_data_t *res, u8 *s, u8 used_only)
+dump_scalar_index (prom_main_t *pm, vlib_stats_entry_t *ep, u8 *name, u8 *s)
 {
-  u8 *name;
+  if (pm->used_only && !ep->value)
+    return s;
+
+  s = add_type (s, name, "");
+  s = format (s, "%v %.2f\n", name, (f64) ep->value);
+
+  return s;
+}
+
+static u8 *
+dump_name_vector (prom_main_t *pm, stat_client_main_t *scm,
+		  vlib_stats_entry_t *ep, u8 *name, u8 *s)
+{
+  u8 **names, *n;
   int k;
 
-  name = make_stat_name (res->name);
+  names = stat_segment_adjust (scm, ep->data);
 
   s = format (s, "# TYPE %v_info gauge\n", name);
-  for (k = 0; k < vec_len (res->name_vector); k++)
-    s = format (s, "%v_info{index=\"%d\",name=\"%s\"} 1\n", name, k,
-		res->name_vector[k]);
+  for (k = 0; k < vec_len (names); k++)
+    {
+      n = names[k] ? stat_segment_adjust (scm, names[k]) : 0;
+      if (!n)
+	continue;
+      s = format (s, "%v_info{index=\"%d\",name=\"%s\"} 1\n", name, k, n);
+    }
 
   return s;
 }
 
 static u8 *
-scrape_stats_segment (u8 *s, u8 **patterns, u8 used_only)
+dump_stat_entry (prom_main_t *pm, stat_client_main_t *scm, u32 index, u8 *s)
 {
-  stat_segment_data_t *res;
-  static u32 *stats = 0;
-  int i;
+  vlib_stats_entry_t *ep;
+  u8 *name;
 
-  stats = stat_segment_ls (patterns);
+  ep = vec_elt_at_index (scm->directory_vector, index);
+  if (ep->type == STAT_DIR_TYPE_EMPTY)
+    return s;
 
-retry:
-  res = stat_segment_dump (stats);
-  if (res == 0)
-    { /* Memory layout has changed */
-      if (stats)
-	vec_free (stats);
-      stats = stat_segment_ls (patterns);
-      goto retry;
-    }
+  name = stat_entry_name (pm, index, ep->name);
 
-  for (i = 0; i < vec_len (res); i++)
+  switch (ep->type)
     {
-      switch (res[i].type)
-	{
-	case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
-	  s = dump_counter_vector_simple (&res[i], s, used_only);
-	  break;
+    case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
+      return dump_counter_vector_simple (pm, scm, ep, name, s);
 
-	case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
-	  s = dump_counter_vector_combined (&res[i], s, used_only);
-	  break;
+    case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
+      return dump_counter_vector_combined (pm, scm, ep, name, s);
 
-	case STAT_DIR_TYPE_SCALAR_INDEX:
-	  s = dump_scalar_index (&res[i], s, used_only);
-	  break;
+    case STAT_DIR_TYPE_SYMLINK:
+      return dump_symlink (pm, scm, ep, name, s);
 
-	case STAT_DIR_TYPE_NAME_VECTOR:
-	  s = dump_name_vector (&res[i], s, used_only);
-	  break;
+    case STAT_DIR_TYPE_SCALAR_INDEX:
+      return dump_scalar_index (pm, ep, name, s);
 
-	case STAT_DIR_TYPE_EMPTY:
-	  break;
+    case STAT_DIR_TYPE_NAME_VECTOR:
+      return dump_name_vector (pm, scm, ep, name, s);
 
-	default:
-	  clib_warning ("Unknown value %d\n", res[i].type);
-	  ;
-	}
+    default:
+      clib_warning ("Unknown value %d\n", ep->type);
     }
-  stat_segment_data_free (res);
 
   return s;
 }
 
-static void
-send_data_to_hss (hss_session_handle_t sh)
+/*
+ * Formats the entries matching the patterns, reading counters in place
+ * from the stats segment. The main thread is yielded every slice, if the
+ * stats directory changes meanwhile the scrape restarts.
+ */
+static u8 *
+scrape_stats_segment (vlib_main_t *vm, u8 *s, u8 **patterns)
 {
-  hss_url_handler_args_t args = {};
+  stat_client_main_t *scm = &stat_client_main;
   prom_main_t *pm = &prom_main;
+  f64 start, slice_start, slice_time, max_slice_time = 0;
+  u32 *stats, i, len = vec_len (s), n_restarts = 0;
+  u8 can_yield;
+  stat_segment_access_t sa;
+
+  start = vlib_time_now (vm);
+
+restart:
+  if (s)
+    vec_set_len (s, len);
+  can_yield = n_restarts < PROM_SCRAPE_MAX_RESTARTS;
+  stats = stat_segment_ls (patterns);
+  if (!stats && scm->current_epoch != scm->shared_header->epoch &&
+      can_yield)
+    goto retry;
+
+  i = 0;
+  while (i < vec_len (stats))
+    {
+      slice_start = vlib_time_now (vm);
+      if (stat_segment_access_start (&sa, scm) ||
+	  sa.epoch != scm->current_epoch)
+	goto retry;
+
+      if (i == 0)
+	if_labels_update (pm, scm);
+
+      do
+	s = dump_stat_entry (pm, scm, stats[i++], s);
+      while (i < vec_len (stats) &&
+	     (!can_yield ||
+	      vlib_time_now (vm) - slice_start < PROM_SCRAPE_SLICE_TIME));
 
-  args.sh = sh;
-  args.data = vec_dup (pm->stats);
-  args.data_len = vec_len (pm->stats);
-  args.sc = HTTP_STATUS_OK;
-  args.free_vec_data = 1;
+      if (!stat_segment_access_end (&sa, scm))
+	goto retry;
 
-  pm->send_data (&args);
+      slice_time = vlib_time_now (vm) - slice_start;
+      max_slice_time = clib_max (max_slice_time, slice_time);
+
+      if (i < vec_len (stats))
+	vlib_process_suspend (vm, 2e-5);
+    }
+
+  vec_free (stats);
+
+  pm->n_scrapes++;
+  pm->last_scrape_time = vlib_time_now (vm) - start;
+  pm->last_max_slice_time = max_slice_time;
+  pm->max_slice_time = clib_max (pm->max_slice_time, max_slice_time);
+  pm->last_scrape_bytes = vec_len (s) - len;
+
+  return s;
+
+retry:
+  vec_free (stats);
+  n_restarts++;
+  pm->n_restarts++;
+  goto restart;
 }
 
 static void
 send_data_to_hss_rpc (void *rpc_args)
 {
-  send_data_to_hss (*(hss_session_handle_t *) rpc_args);
+  hss_url_handler_args_t *args = rpc_args;
+
+  prom_main.send_data (args);
+  clib_mem_free (args);
+}
+
+static void
+send_data_to_hss (hss_session_handle_t sh, u8 *data)
+{
+  hss_url_handler_args_t *args;
+
+  args = clib_mem_alloc (sizeof (*args));
+  clib_memset (args, 0, sizeof (*args));
+  args->sh = sh;
+  args->data = data;
+  args->data_len = vec_len (data);
+  args->sc = HTTP_STATUS_OK;
+  args->free_vec_data = 1;
+
+  session_send_rpc_evt_to_thread_force (sh.thread_index, send_data_to_hss_rpc,
+					args);
+}
+
+static void
+prom_scrape_req_free (prom_scrape_req_t *req)
+{
+  u8 **pattern;
+
+  vec_foreach (pattern, req->patterns)
+    vec_free (*pattern);
+  vec_free (req->patterns);
+}
+
+static void
+prom_handle_scrape_reqs (vlib_main_t *vm)
+{
+  prom_main_t *pm = &prom_main;
+  prom_scrape_req_t *reqs, *req;
+  u8 *data;
+
+  /* Requests queued while scraping are handled on the next event */
+  reqs = pm->pending_reqs;
+  pm->pending_reqs = 0;
+
+  vec_foreach (req, reqs)
+    {
+      /* Filtered scrapes are not cached */
+      if (req->patterns)
+	{
+	  data = scrape_stats_segment (vm, 0, req->patterns);
+	  send_data_to_hss (req->sh, data);
+	  prom_scrape_req_free (req);
+	  continue;
+	}
+
+      /* If we've recently scraped stats, return data */
+      if ((vlib_time_now (vm) - pm->last_scrape) >= pm->min_scrape_interval)
+	{
+	  vec_reset_length (pm->stats);
+	  pm->stats = scrape_stats_segment (vm, pm->stats, pm->stats_patterns);
+	  pm->last_scrape = vlib_time_now (vm);
+	}
+      send_data_to_hss (req->sh, vec_dup (pm->stats));
+    }
+
+  vec_free (reqs);
 }
 
 static uword
@@ -207,8 +635,6 @@ prom_scraper_process (vlib_main_t *vm, vlib_node_runtime_t *rt,
 		      vlib_frame_t *f)
 {
   uword *event_data = 0, event_type;
-  prom_main_t *pm = &prom_main;
-  hss_session_handle_t sh;
   f64 timeout = 10000.0;
 
   while (1)
@@ -221,13 +647,7 @@ prom_scraper_process (vlib_main_t *vm, vlib_node_runtime_t *rt,
 	  /* timeout, do nothing */
 	  break;
 	case PROM_SCRAPER_EVT_RUN:
-	  sh.as_u64 = event_data[0];
-	  vec_reset_length (pm->stats);
-	  pm->stats = scrape_stats_segment (pm->stats, pm->stats_patterns,
-					    pm->used_only);
-	  session_send_rpc_evt_to_thread_force (sh.thread_index,
-						send_data_to_hss_rpc, &sh);
-	  pm->last_scrape = vlib_time_now (vm);
+	  prom_handle_scrape_reqs (vm);
 	  break;
 	default:
 	  clib_warning ("unexpected event %u", event_type);
@@ -244,6 +664,7 @@ VLIB_REGISTER_NODE (prom_scraper_process_node) = {
   .type = VLIB_NODE_TYPE_PROCESS,
   .name = "prom-scraper-process",
   .state = VLIB_NODE_STATE_DISABLED,
+  .process_log2_n_stack_bytes = 18,
 };
 
 static void
@@ -261,33 +682,82 @@ prom_scraper_process_enable (vlib_main_t *vm)
 }
 
 static void
-signal_run_to_scraper (uword *args)
+signal_run_to_scraper (prom_scrape_req_t *req)
 {
   prom_main_t *pm = &prom_main;
   ASSERT (vlib_get_thread_index () == 0);
+  vec_add1 (pm->pending_reqs, *req);
   vlib_process_signal_event (pm->vm, pm->scraper_node_index,
-			     PROM_SCRAPER_EVT_RUN, *args);
+			     PROM_SCRAPER_EVT_RUN, 0);
 }
 
-hss_url_handler_rc_t
-prom_stats_dump (hss_url_handler_args_t *args)
+static u8
+hex_value (u8 c)
 {
-  vlib_main_t *vm = vlib_get_main ();
-  f64 now = vlib_time_now (vm);
-  prom_main_t *pm = &prom_main;
+  return isdigit (c) ? c - '0' : (tolower (c) - 'a' + 10);
+}
+
+/*
+ * Collects the filter=<regex> parameters of the request query string,
+ * e.g. stats.prom?filter=%5E%2Fif%2F&filter=%5E%2Fsys%2F
+ */
+static u8 **
+query_to_patterns (u8 *request)
+{
+  u8 **patterns = 0, *pattern, *p, *end;
+  u8 c;
 
-  /* If we've recently scraped stats, return data */
-  if ((now - pm->last_scrape) < pm->min_scrape_interval)
+  end = request + vec_len (request);
+  p = request ? memchr (request, '?', vec_len (request)) : 0;
+  if (!p)
+    return 0;
+
+  for (p++; p < end; p++)
     {
-      send_data_to_hss (args->sh);
-      return HSS_URL_HANDLER_ASYNC;
+      if (end - p < 7 || memcmp (p, "filter=", 7))
+	{
+	  /* not a filter, skip it */
+	  while (p < end && *p != '&')
+	    p++;
+	  continue;
+	}
+
+      pattern = 0;
+      for (p += 7; p < end && *p != '&'; p++)
+	{
+	  c = *p;
+	  if (c == '+')
+	    c = ' ';
+	  else if (c == '%' && end - p > 2 && isxdigit (p[1]) &&
+		   isxdigit (p[2]))
+	    {
+	      c = hex_value (p[1]) << 4 | hex_value (p[2]);
+	      p += 2;
+	    }
+	  vec_add1 (pattern, c);
+	}
+      vec_add1 (pattern, 0);
+      vec_add1 (patterns, pattern);
     }
 
-  if (vm->thread_index != 0)
-    vl_api_rpc_call_main_thread (signal_run_to_scraper, (u8 *) &args->sh,
-				 sizeof (args->sh));
+  return patterns;
+}
+
+hss_url_handler_rc_t
+prom_stats_dump (hss_url_handler_args_t *args)
+{
+  prom_scrape_req_t req = {};
+
+  /* Scrapes always run on the main thread, the request vector is only
+   * valid for the duration of this call */
+  req.sh = args->sh;
+  req.patterns = query_to_patterns (args->request);
+
+  if (vlib_get_thread_index () != 0)
+    vl_api_rpc_call_main_thread (signal_run_to_scraper, (u8 *) &req,
+				 sizeof (req));
   else
-    signal_run_to_scraper (&args->sh.as_u64);
+    signal_run_to_scraper (&req);
 
   return HSS_URL_HANDLER_ASYNC;
 }
@@ -351,6 +821,9 @@ prom_stat_name_prefix_set (u8 *prefix)
 
   vec_free (pm->stat_name_prefix);
   pm->stat_name_prefix = prefix;
+
+  /* cached names embed the prefix */
+  stat_entries_free (pm);
 }
 
 void
@@ -361,6 +834,14 @@ prom_report_used_only (u8 used_only)
   pm->used_only = used_only;
 }
 
+void
+prom_report_per_thread (u8 per_thread)
+{
+  prom_main_t *pm = &prom_main;
+
+  pm->per_thread = per_thread;
+}
+
 static void
 prom_stat_segment_client_init (void)
 {
@@ -403,6 +884,7 @@ prom_init (vlib_main_t *vm)
   pm->is_enabled = 0;
   pm->min_scrape_interval = 1;
   pm->used_only = 0;
+  pm->per_thread = 0;
   pm->stat_name_prefix = 0;
 
   return 0;
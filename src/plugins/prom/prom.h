@@ -19,6 +19,23 @@
 #include <vnet/session/session.h>
 #include <http_static/http_static.h>
 
+/** Metric name cached per stats directory entry */
+typedef struct prom_stat_entry_
+{
+  /** Directory entry name the metric name was built from */
+  u8 *dir_name;
+  /** Prefixed metric name with invalid characters replaced */
+  u8 *name;
+} prom_stat_entry_t;
+
+/** Scrape request queued to the scraper process */
+typedef struct prom_scrape_req_
+{
+  hss_session_handle_t sh;
+  /** Patterns from the request query string, if any */
+  u8 **patterns;
+} prom_scrape_req_t;
+
 typedef struct prom_main_
 {
   u8 *stats;
@@ -27,9 +44,36 @@ typedef struct prom_main_
   hss_session_send_fn send_data;
   u32 scraper_node_index;
   u8 is_enabled;
-  u8 *name_scratch_pad;
   vlib_main_t *vm;
 
+  /** Requests waiting for the scraper process, main thread only */
+  prom_scrape_req_t *pending_reqs;
+
+  /*
+   * Formatting caches, only used by the scraper process
+   */
+  prom_stat_entry_t *entries;
+  /** Per interface label and the /if/names value it was built from */
+  u8 **if_labels;
+  u8 **if_names;
+  /** Per index label for non interface counters */
+  u8 **index_labels;
+  /** Per thread labels, used when not aggregating */
+  u8 **thread_labels;
+  /** Scratch counter sums */
+  counter_t *simple_sums;
+  vlib_counter_t *combined_sums;
+
+  /*
+   * Scrape statistics
+   */
+  u64 n_scrapes;
+  u64 n_restarts;
+  f64 last_scrape_time;
+  f64 last_max_slice_time;
+  f64 max_slice_time;
+  uword last_scrape_bytes;
+
   /*
    * Configs
    */
@@ -37,6 +81,7 @@ typedef struct prom_main_
   u8 *stat_name_prefix;
   f64 min_scrape_interval;
   u8 used_only;
+  u8 per_thread;
 } prom_main_t;
 
 typedef enum prom_process_evt_codes_
@@ -54,6 +99,7 @@ void prom_stat_patterns_free (void);
 
 void prom_stat_name_prefix_set (u8 *prefix);
 void prom_report_used_only (u8 used_only);
+void prom_report_per_thread (u8 per_thread);
 
 #endif /* SRC_PLUGINS_PROM_PROM_H_ */
 
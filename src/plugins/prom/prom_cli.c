@@ -109,6 +109,10 @@ prom_command_fn (vlib_main_t *vm, unformat_input_t *input,
 	prom_report_used_only (1 /* used only */);
       else if (unformat (line_input, "all-stats"))
 	prom_report_used_only (0 /* used only */);
+      else if (unformat (line_input, "per-thread"))
+	prom_report_per_thread (1 /* per thread */);
+      else if (unformat (line_input, "aggregate"))
+	prom_report_per_thread (0 /* per thread */);
       else if (unformat (line_input, "stat-name-prefix %_%v%_",
 			 &stat_name_prefix))
 	prom_stat_name_prefix_set (stat_name_prefix);
@@ -139,11 +143,40 @@ no_input:
 VLIB_CLI_COMMAND (prom_enable_command, static) = {
   .path = "prom",
   .short_help = "prom [enable] [min-scrape-interval <n>] [used-only] "
-		"[all-stats] [stat-name-prefix <prefix>] "
-		"[stat-patterns <patterns>...]",
+		"[all-stats] [per-thread] [aggregate] "
+		"[stat-name-prefix <prefix>] [stat-patterns <patterns>...]",
   .function = prom_command_fn,
 };
 
+static clib_error_t *
+show_prom_command_fn (vlib_main_t *vm, unformat_input_t *input,
+		      vlib_cli_command_t *cmd)
+{
+  prom_main_t *pm = prom_get_main ();
+
+  if (!pm->is_enabled)
+    return clib_error_return (0, "prom not enabled");
+
+  vlib_cli_output (vm, "prom: %s, %s, min-scrape-interval %.2fs",
+		   pm->used_only ? "used-only" : "all-stats",
+		   pm->per_thread ? "per-thread" : "aggregate",
+		   pm->min_scrape_interval);
+  vlib_cli_output (vm, "  scrapes %lu restarts %lu", pm->n_scrapes,
+		   pm->n_restarts);
+  vlib_cli_output (vm, "  last scrape %.3fms, %U", pm->last_scrape_time * 1e3,
+		   format_memory_size, pm->last_scrape_bytes);
+  vlib_cli_output (vm, "  main thread slice last %.3fms max %.3fms",
+		   pm->last_max_slice_time * 1e3, pm->max_slice_time * 1e3);
+
+  return 0;
+}
+
+VLIB_CLI_COMMAND (show_prom_command, static) = {
+  .path = "show prom",
+  .short_help = "show prom",
+  .function = show_prom_command_fn,
+};
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
@@ -16,6 +16,24 @@ format_snort_instance (u8 *s, va_list *args)
   return s;
 }
 
+static u8 *
+format_snort_qpair (u8 *s, va_list *args)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  snort_qpair_t *qp = va_arg (*args, snort_qpair_t *);
+  f64 us_per_clock = vm->clib_time.seconds_per_clock * 1e6;
+  u32 n_in_flight = vec_len (qp->buffer_indices) - vec_len (qp->freelist);
+
+  s = format (s, "in-flight %u max %u enqueued %lu verdicts %lu", n_in_flight,
+	      qp->max_in_flight, qp->n_enq, qp->n_verdicts);
+  if (qp->n_verdicts)
+    s = format (s, " latency avg %.2fus max %.2fus",
+		(f64) qp->verdict_clocks_sum / qp->n_verdicts * us_per_clock,
+		qp->verdict_clocks_max * us_per_clock);
+
+  return s;
+}
+
 static clib_error_t *
 snort_create_instance_command_fn (vlib_main_t *vm, unformat_input_t *input,
 				  vlib_cli_command_t *cmd)
@@ -24,7 +42,9 @@ snort_create_instance_command_fn (vlib_main_t *vm, unformat_input_t *input,
   clib_error_t *err = 0;
   u8 *name = 0;
   u32 queue_size = 1024;
+  u32 queue_threshold = 0;
   u8 drop_on_diconnect = 1;
+  u8 pass_on_queue_full = 0;
 
   /* Get a line of input. */
   if (!unformat_user (input, unformat_line_input, line_input))
@@ -38,6 +58,12 @@ snort_create_instance_command_fn (vlib_main_t *vm, unformat_input_t *input,
 	drop_on_diconnect = 1;
       else if (unformat (line_input, "on-disconnect pass"))
 	drop_on_diconnect = 0;
+      else if (unformat (line_input, "queue-threshold %u", &queue_threshold))
+	;
+      else if (unformat (line_input, "on-queue-full drop"))
+	pass_on_queue_full = 0;
+      else if (unformat (line_input, "on-queue-full pass"))
+	pass_on_queue_full = 1;
       else if (unformat (line_input, "name %s", &name))
 	;
       else
@@ -61,7 +87,8 @@ snort_create_instance_command_fn (vlib_main_t *vm, unformat_input_t *input,
     }
 
   err = snort_instance_create (vm, (char *) name, min_log2 (queue_size),
-			       drop_on_diconnect);
+			       drop_on_diconnect, pass_on_queue_full,
+			       queue_threshold);
 
 done:
   vec_free (name);
@@ -72,7 +99,8 @@ done:
 VLIB_CLI_COMMAND (snort_create_instance_command, static) = {
   .path = "snort create-instance",
   .short_help = "snort create-instaince name <name> [queue-size <size>] "
-		"[on-disconnect drop|pass]",
+		"[on-disconnect drop|pass] [queue-threshold <n>] "
+		"[on-queue-full drop|pass]",
   .function = snort_create_instance_command_fn,
 };
 
@@ -191,9 +219,20 @@ snort_show_instances_command_fn (vlib_main_t *vm, unformat_input_t *input,
 {
   snort_main_t *sm = &snort_main;
   snort_instance_t *si;
+  snort_qpair_t *qp;
 
   pool_foreach (si, sm->instances)
-    vlib_cli_output (vm, "%U", format_snort_instance, si);
+    {
+      vlib_cli_output (vm, "%U", format_snort_instance, si);
+      vlib_cli_output (vm,
+		       "  on-disconnect %s queue-threshold %u on-queue-full %s",
+		       si->drop_on_disconnect ? "drop" : "pass",
+		       si->queue_threshold,
+		       si->pass_on_queue_full ? "pass" : "drop");
+      vec_foreach (qp, si->qpairs)
+	vlib_cli_output (vm, "  qpair %u: %U", qp - si->qpairs,
+			 format_snort_qpair, qp);
+    }
 
   return 0;
 }
@@ -247,6 +286,77 @@ VLIB_CLI_COMMAND (snort_show_clients_command, static) = {
   .function = snort_show_clients_command_fn,
 };
 
+static int
+snort_trusted_flow_count (clib_bihash_kv_16_8_t *kv, void *arg)
+{
+  u32 *count = arg;
+  count[0]++;
+  return BIHASH_WALK_CONTINUE;
+}
+
+static clib_error_t *
+snort_show_trusted_flows_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				     vlib_cli_command_t *cmd)
+{
+  snort_main_t *sm = &snort_main;
+  u32 count = 0;
+
+  clib_bihash_foreach_key_value_pair_16_8 (&sm->trusted_flows,
+					   snort_trusted_flow_count, &count);
+  vlib_cli_output (vm, "trusted flows: %u, timeout %us", count,
+		   sm->trusted_flow_timeout);
+  if (unformat (input, "verbose"))
+    vlib_cli_output (vm, "%U", format_bihash_16_8, &sm->trusted_flows,
+		     0 /* verbose */);
+  return 0;
+}
+
+VLIB_CLI_COMMAND (snort_show_trusted_flows_command, static) = {
+  .path = "show snort trusted-flows",
+  .short_help = "show snort trusted-flows [verbose]",
+  .function = snort_show_trusted_flows_command_fn,
+};
+
+static clib_error_t *
+snort_trusted_flows_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				vlib_cli_command_t *cmd)
+{
+  snort_main_t *sm = &snort_main;
+  u32 timeout;
+
+  if (unformat (input, "timeout %u", &timeout))
+    {
+      sm->trusted_flow_timeout = timeout;
+      if (timeout == 0)
+	snort_trusted_flows_clear ();
+    }
+  else
+    return clib_error_return (0, "unknown input `%U'", format_unformat_error,
+			      input);
+  return 0;
+}
+
+VLIB_CLI_COMMAND (snort_trusted_flows_command, static) = {
+  .path = "snort trusted-flows",
+  .short_help = "snort trusted-flows timeout <seconds>",
+  .function = snort_trusted_flows_command_fn,
+};
+
+static clib_error_t *
+snort_clear_trusted_flows_command_fn (vlib_main_t *vm,
+				      unformat_input_t *input,
+				      vlib_cli_command_t *cmd)
+{
+  snort_trusted_flows_clear ();
+  return 0;
+}
+
+VLIB_CLI_COMMAND (snort_clear_trusted_flows_command, static) = {
+  .path = "clear snort trusted-flows",
+  .short_help = "clear snort trusted-flows",
+  .function = snort_clear_trusted_flows_command_fn,
+};
+
 static clib_error_t *
 snort_mode_polling_command_fn (vlib_main_t *vm, unformat_input_t *input,
 			       vlib_cli_command_t *cmd)
@@ -0,0 +1,393 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+/*
+ * Minimal DAQ client speaking the snort plugin socket and shared memory
+ * protocol, used to exercise and benchmark the plugin without snort.
+ */
+
+#define _GNU_SOURCE
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <errno.h>
+#include <getopt.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+
+#include "daq_vpp.h"
+
+typedef struct
+{
+  uint32_t queue_size;
+  daq_vpp_desc_t *descs;
+  uint32_t *enq_ring;
+  uint32_t *deq_ring;
+  volatile uint32_t *enq_head;
+  volatile uint32_t *deq_head;
+  uint32_t next_desc;
+  int enq_fd;
+  int deq_fd;
+} test_qpair_t;
+
+typedef struct
+{
+  /* config */
+  const char *socket_name;
+  const char *instance;
+  int polling;
+  uint32_t batch;
+  uint32_t delay_us;
+  uint32_t trust_every;
+  uint32_t drop_every;
+  uint32_t duration;
+
+  /* state */
+  int sock_fd;
+  int epoll_fd;
+  uint8_t *shm_base;
+  uint32_t shm_size;
+  uint8_t num_qpairs;
+  test_qpair_t *qpairs;
+  uint8_t num_bpools;
+  uint8_t **bpool_base;
+
+  /* stats */
+  uint64_t n_packets;
+  uint64_t n_bytes;
+  uint64_t n_forward;
+  uint64_t n_trust;
+  uint64_t n_drop;
+  uint64_t n_signals;
+  uint64_t n_wakeups;
+  uint64_t data_xor;
+} test_main_t;
+
+static test_main_t test_main;
+static volatile int interrupted;
+
+static void
+test_sigint (int signum)
+{
+  interrupted = 1;
+}
+
+static int
+test_recvmsg (int fd, daq_vpp_msg_t *msg, int n_fds, int *fds)
+{
+  const int ctl_sz =
+    CMSG_SPACE (sizeof (int) * n_fds) + CMSG_SPACE (sizeof (struct ucred));
+  char ctl[ctl_sz];
+  struct msghdr mh = {};
+  struct iovec iov[1];
+  struct cmsghdr *cmsg;
+
+  iov[0].iov_base = (void *) msg;
+  iov[0].iov_len = sizeof (daq_vpp_msg_t);
+  mh.msg_iov = iov;
+  mh.msg_iovlen = 1;
+  mh.msg_control = ctl;
+  mh.msg_controllen = ctl_sz;
+
+  memset (ctl, 0, ctl_sz);
+
+  if (recvmsg (fd, &mh, 0) != sizeof (daq_vpp_msg_t))
+    return -1;
+
+  for (cmsg = CMSG_FIRSTHDR (&mh); cmsg; cmsg = CMSG_NXTHDR (&mh, cmsg))
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+      memcpy (fds, CMSG_DATA (cmsg), n_fds * sizeof (int));
+
+  return 0;
+}
+
+static int
+test_connect (test_main_t *tm)
+{
+  struct sockaddr_un sun = { .sun_family = AF_UNIX };
+  daq_vpp_msg_t msg = {};
+  int shm_fd = -1;
+
+  if ((tm->sock_fd = socket (AF_UNIX, SOCK_SEQPACKET, 0)) < 0)
+    return fprintf (stderr, "socket: %s\n", strerror (errno)), -1;
+
+  strncpy (sun.sun_path, tm->socket_name, sizeof (sun.sun_path) - 1);
+  if (connect (tm->sock_fd, (struct sockaddr *) &sun, sizeof (sun)) != 0)
+    return fprintf (stderr, "connect '%s': %s\n", tm->socket_name,
+		    strerror (errno)),
+	   -1;
+
+  msg.type = DAQ_VPP_MSG_TYPE_HELLO;
+  snprintf (msg.hello.inst_name, DAQ_VPP_INST_NAME_LEN - 1, "%s",
+	    tm->instance);
+  if (send (tm->sock_fd, &msg, sizeof (msg), 0) != sizeof (msg))
+    return fprintf (stderr, "send hello failed\n"), -1;
+
+  if (test_recvmsg (tm->sock_fd, &msg, 1, &shm_fd) ||
+      msg.type != DAQ_VPP_MSG_TYPE_CONFIG || shm_fd == -1)
+    return fprintf (stderr, "no config message, unknown instance?\n"), -1;
+
+  tm->num_bpools = msg.config.num_bpools;
+  tm->num_qpairs = msg.config.num_qpairs;
+  tm->shm_size = msg.config.shm_size;
+  tm->shm_base = mmap (0, tm->shm_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+		       shm_fd, 0);
+  if (tm->shm_base == MAP_FAILED)
+    return fprintf (stderr, "mmap shm: %s\n", strerror (errno)), -1;
+
+  tm->bpool_base = calloc (tm->num_bpools, sizeof (uint8_t *));
+  for (int i = 0; i < tm->num_bpools; i++)
+    {
+      int fd = -1;
+      if (test_recvmsg (tm->sock_fd, &msg, 1, &fd) ||
+	  msg.type != DAQ_VPP_MSG_TYPE_BPOOL || fd == -1)
+	return fprintf (stderr, "no buffer pool message\n"), -1;
+      tm->bpool_base[i] =
+	mmap (0, msg.bpool.size, PROT_READ, MAP_SHARED, fd, 0);
+      if (tm->bpool_base[i] == MAP_FAILED)
+	return fprintf (stderr, "mmap buffer pool: %s\n", strerror (errno)),
+	       -1;
+    }
+
+  if ((tm->epoll_fd = epoll_create (1)) == -1)
+    return fprintf (stderr, "epoll_create: %s\n", strerror (errno)), -1;
+
+  tm->qpairs = calloc (tm->num_qpairs, sizeof (test_qpair_t));
+  for (int i = 0; i < tm->num_qpairs; i++)
+    {
+      struct epoll_event ev = { .events = EPOLLIN, .data.u32 = i };
+      test_qpair_t *qp = tm->qpairs + i;
+      int fds[2] = { -1, -1 };
+
+      if (test_recvmsg (tm->sock_fd, &msg, 2, fds) ||
+	  msg.type != DAQ_VPP_MSG_TYPE_QPAIR || fds[0] == -1 || fds[1] == -1)
+	return fprintf (stderr, "no queue pair message\n"), -1;
+
+      qp->queue_size = 1 << msg.qpair.log2_queue_size;
+      qp->descs =
+	(daq_vpp_desc_t *) (tm->shm_base + msg.qpair.desc_table_offset);
+      qp->enq_ring = (uint32_t *) (tm->shm_base + msg.qpair.enq_ring_offset);
+      qp->deq_ring = (uint32_t *) (tm->shm_base + msg.qpair.deq_ring_offset);
+      qp->enq_head = (uint32_t *) (tm->shm_base + msg.qpair.enq_head_offset);
+      qp->deq_head = (uint32_t *) (tm->shm_base + msg.qpair.deq_head_offset);
+      qp->next_desc = *qp->enq_head;
+      qp->enq_fd = fds[0];
+      qp->deq_fd = fds[1];
+
+      if (epoll_ctl (tm->epoll_fd, EPOLL_CTL_ADD, qp->enq_fd, &ev) == -1)
+	return fprintf (stderr, "epoll_ctl: %s\n", strerror (errno)), -1;
+    }
+
+  printf ("connected to instance '%s': %u qpairs of %u, %u buffer pools\n",
+	  tm->instance, tm->num_qpairs,
+	  tm->num_qpairs ? tm->qpairs[0].queue_size : 0, tm->num_bpools);
+  return 0;
+}
+
+/* take up to batch descriptors, look at the packet and hand back all
+ * verdicts with a single head update and at most one signal */
+static uint32_t
+test_qpair_serve (test_main_t *tm, test_qpair_t *qp)
+{
+  uint32_t mask = qp->queue_size - 1;
+  uint32_t head, next, deq_head, n;
+  uint64_t ctr;
+
+  head = __atomic_load_n (qp->enq_head, __ATOMIC_ACQUIRE);
+  next = qp->next_desc;
+  n = head - next;
+  if (n == 0)
+    return 0;
+  if (n > tm->batch)
+    n = tm->batch;
+
+  deq_head = *qp->deq_head;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint32_t desc_index = qp->enq_ring[next & mask];
+      daq_vpp_desc_t *d = qp->descs + desc_index;
+      uint8_t *data = tm->bpool_base[d->buffer_pool] + d->offset;
+      uint64_t pkt = tm->n_packets++;
+
+      /* touch the headers as an inspection engine would */
+      tm->data_xor ^= *(uint64_t *) data ^ *(uint64_t *) (data + 12);
+      tm->n_bytes += d->length;
+
+      if (tm->drop_every && pkt % tm->drop_every == 0)
+	{
+	  d->action = DAQ_VPP_ACTION_DROP;
+	  tm->n_drop++;
+	}
+      else if (tm->trust_every && pkt % tm->trust_every == 0)
+	{
+	  d->action = DAQ_VPP_ACTION_TRUST;
+	  tm->n_trust++;
+	}
+      else
+	{
+	  d->action = DAQ_VPP_ACTION_FORWARD;
+	  tm->n_forward++;
+	}
+
+      qp->deq_ring[deq_head++ & mask] = desc_index;
+      next++;
+    }
+
+  qp->next_desc = next;
+  __atomic_store_n (qp->deq_head, deq_head, __ATOMIC_RELEASE);
+
+  if (!tm->polling)
+    {
+      ctr = n;
+      if (write (qp->deq_fd, &ctr, sizeof (ctr)) == sizeof (ctr))
+	tm->n_signals++;
+    }
+
+  return n;
+}
+
+static double
+test_time_now (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void
+test_report (test_main_t *tm, double t, uint64_t n_packets)
+{
+  printf ("%.1fs: %lu packets %.3f Mpps, forward %lu trust %lu drop %lu, "
+	  "%lu signals %lu wakeups\n",
+	  t, tm->n_packets, t > 0 ? n_packets / t * 1e-6 : 0, tm->n_forward,
+	  tm->n_trust, tm->n_drop, tm->n_signals, tm->n_wakeups);
+  fflush (stdout);
+}
+
+static void
+test_run (test_main_t *tm)
+{
+  struct epoll_event events[256];
+  double start = test_time_now (), last = start, now;
+  uint64_t last_packets = 0;
+
+  while (!interrupted)
+    {
+      uint32_t n = 0;
+
+      for (int i = 0; i < tm->num_qpairs; i++)
+	n += test_qpair_serve (tm, tm->qpairs + i);
+
+      if (n && tm->delay_us)
+	usleep (tm->delay_us);
+
+      if (n == 0 && !tm->polling)
+	{
+	  int n_events = epoll_wait (tm->epoll_fd, events,
+				     tm->num_qpairs < 256 ? tm->num_qpairs :
+							    256,
+				     100);
+	  for (int i = 0; i < n_events; i++)
+	    {
+	      uint64_t ctr;
+	      test_qpair_t *qp = tm->qpairs + events[i].data.u32;
+	      ssize_t __attribute__ ((unused)) rv =
+		read (qp->enq_fd, &ctr, sizeof (ctr));
+	    }
+	  if (n_events > 0)
+	    tm->n_wakeups++;
+	}
+
+      now = test_time_now ();
+      if (now - last >= 1.0)
+	{
+	  test_report (tm, now - last, tm->n_packets - last_packets);
+	  last = now;
+	  last_packets = tm->n_packets;
+	}
+      if (tm->duration && now - start >= tm->duration)
+	break;
+    }
+
+  now = test_time_now ();
+  printf ("total: ");
+  test_report (tm, now - start, tm->n_packets);
+}
+
+static void
+test_usage (char *prog)
+{
+  fprintf (stderr,
+	   "usage: %s [-s <socket>] [-i <instance>] [-p] [-b <batch>] "
+	   "[-d <usec>] [-t <n>] [-x <n>] [-c <seconds>]\n"
+	   "  -s  snort plugin socket (default " DAQ_VPP_DEFAULT_SOCKET_PATH
+	   ")\n"
+	   "  -i  instance name (default snort1)\n"
+	   "  -p  busy poll instead of waiting for enqueue events\n"
+	   "  -b  max verdicts returned per qpair at once (default 256)\n"
+	   "  -d  sleep after each non-empty batch, to emulate a slow snort\n"
+	   "  -t  give every n-th packet a trust verdict\n"
+	   "  -x  drop every n-th packet\n"
+	   "  -c  exit after this many seconds\n",
+	   prog);
+}
+
+int
+main (int argc, char **argv)
+{
+  test_main_t *tm = &test_main;
+  int c;
+
+  tm->socket_name = DAQ_VPP_DEFAULT_SOCKET_PATH;
+  tm->instance = "snort1";
+  tm->batch = 256;
+
+  while ((c = getopt (argc, argv, "s:i:pb:d:t:x:c:h")) != -1)
+    switch (c)
+      {
+      case 's':
+	tm->socket_name = optarg;
+	break;
+      case 'i':
+	tm->instance = optarg;
+	break;
+      case 'p':
+	tm->polling = 1;
+	break;
+      case 'b':
+	tm->batch = atoi (optarg);
+	break;
+      case 'd':
+	tm->delay_us = atoi (optarg);
+	break;
+      case 't':
+	tm->trust_every = atoi (optarg);
+	break;
+      case 'x':
+	tm->drop_every = atoi (optarg);
+	break;
+      case 'c':
+	tm->duration = atoi (optarg);
+	break;
+      default:
+	test_usage (argv[0]);
+	return 1;
+      }
+
+  if (tm->batch == 0)
+    tm->batch = 1;
+
+  signal (SIGINT, test_sigint);
+  signal (SIGTERM, test_sigint);
+
+  if (test_connect (tm))
+    return 1;
+
+  test_run (tm);
+  return 0;
+}
@@ -21,6 +21,10 @@
 
 #define DAQ_VPP_VERSION 1
 
+/* in interrupt mode, verdicts are published immediately but VPP is only
+ * signalled once per this many verdicts or before the next receive */
+#define DAQ_VPP_VERDICT_BATCH 64
+
 #if __x86_64__
 #define VPP_DAQ_PAUSE() __builtin_ia32_pause ()
 #elif defined(__aarch64__) || defined(__arm__)
@@ -71,6 +75,7 @@ typedef struct _vpp_qpair
   int enq_fd;
   int deq_fd;
   VPPDescData *desc_data;
+  uint32_t n_unsignalled;
   volatile int lock;
 } VPPQueuePair;
 
@@ -515,6 +520,35 @@ vpp_daq_get_datalink_type (void *handle)
   return DLT_IPV4;
 }
 
+static inline int
+vpp_daq_signal_verdicts (VPPQueuePair *qp)
+{
+  uint64_t counter_increment = qp->n_unsignalled;
+
+  qp->n_unsignalled = 0;
+  if (write (qp->deq_fd, &counter_increment, sizeof (counter_increment)) !=
+      sizeof (counter_increment))
+    return DAQ_ERROR;
+  return DAQ_SUCCESS;
+}
+
+static void
+vpp_daq_flush_verdicts (VPP_Context_t *vc)
+{
+  for (int i = 0; i < vc->num_qpairs; i++)
+    {
+      VPPQueuePair *qp = vc->qpairs + i;
+
+      if (__atomic_load_n (&qp->n_unsignalled, __ATOMIC_RELAXED) == 0)
+	continue;
+
+      vpp_daq_qpair_lock (qp);
+      if (qp->n_unsignalled)
+	vpp_daq_signal_verdicts (qp);
+      vpp_daq_qpair_unlock (qp);
+    }
+}
+
 static inline uint32_t
 vpp_daq_msg_receive_one (VPP_Context_t *vc, VPPQueuePair *qp,
 			 const DAQ_Msg_t *msgs[], unsigned max_recv)
@@ -573,6 +607,10 @@ vpp_daq_msg_receive (void *handle, const unsigned max_recv,
       return 0;
     }
 
+  /* let VPP pick up verdicts from the previous batch */
+  if (vc->input_mode == DAQ_VPP_INPUT_MODE_INTERRUPT)
+    vpp_daq_flush_verdicts (vc);
+
   /* first, we visit all qpairs. If we find any work there then we can give
    * it back immediatelly. To avoid bias towards qpair 0 we remeber what
    * next qpair */
@@ -643,29 +681,34 @@ vpp_daq_msg_finalize (void *handle, const DAQ_Msg_t *msg, DAQ_Verdict verdict)
   VPPQueuePair *qp = vc->qpairs + dd->qpair_index;
   daq_vpp_desc_t *d;
   uint32_t mask, head;
-  uint64_t counter_increment = 1;
-  int rv, retv = DAQ_SUCCESS;
+  int retv = DAQ_SUCCESS;
 
   vpp_daq_qpair_lock (qp);
   mask = qp->queue_size - 1;
   head = *qp->deq_head;
   d = qp->descs + dd->index;
-  if (verdict == DAQ_VERDICT_PASS)
-    d->action = DAQ_VPP_ACTION_FORWARD;
-  else
-    d->action = DAQ_VPP_ACTION_DROP;
+  switch (verdict)
+    {
+    case DAQ_VERDICT_PASS:
+    case DAQ_VERDICT_REPLACE:
+      d->action = DAQ_VPP_ACTION_FORWARD;
+      break;
+    case DAQ_VERDICT_WHITELIST:
+    case DAQ_VERDICT_IGNORE:
+      d->action = DAQ_VPP_ACTION_TRUST;
+      break;
+    default:
+      d->action = DAQ_VPP_ACTION_DROP;
+      break;
+    }
 
   qp->deq_ring[head & mask] = dd->index;
   head = head + 1;
   __atomic_store_n (qp->deq_head, head, __ATOMIC_RELEASE);
 
-  if (vc->input_mode == DAQ_VPP_INPUT_MODE_INTERRUPT)
-    {
-      rv = write (qp->deq_fd, &counter_increment, sizeof (counter_increment));
-
-      if (rv != sizeof (counter_increment))
-	retv = DAQ_ERROR;
-    }
+  if (vc->input_mode == DAQ_VPP_INPUT_MODE_INTERRUPT &&
+      ++qp->n_unsignalled >= DAQ_VPP_VERDICT_BATCH)
+    retv = vpp_daq_signal_verdicts (qp);
 
   vpp_daq_qpair_unlock (qp);
   return retv;
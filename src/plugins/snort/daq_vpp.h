@@ -63,6 +63,8 @@ typedef enum
 {
   DAQ_VPP_ACTION_DROP,
   DAQ_VPP_ACTION_FORWARD,
+  /* forward, and bypass inspection for the rest of the flow */
+  DAQ_VPP_ACTION_TRUST,
 } daq_vpp_action_t;
 
 typedef struct
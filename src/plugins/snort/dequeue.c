@@ -43,6 +43,51 @@ static char *snort_deq_error_strings[] = {
 #undef _
 };
 
+static int
+snort_trusted_flow_is_stale (clib_bihash_kv_16_8_t *kv, void *arg)
+{
+  snort_main_t *sm = arg;
+  u32 now = (u32) vlib_time_now (vlib_get_main ());
+
+  return now - (u32) kv->value > sm->trusted_flow_timeout;
+}
+
+static_always_inline u16
+snort_deq_verdict (vlib_main_t *vm, snort_qpair_t *qp, u32 instance_index,
+		   u32 desc_index, u64 now)
+{
+  snort_main_t *sm = &snort_main;
+  daq_vpp_desc_t *d = qp->descriptors + desc_index;
+  u64 clocks = now - qp->enq_time[desc_index];
+
+  qp->verdict_clocks_sum += clocks;
+  if (clocks > qp->verdict_clocks_max)
+    qp->verdict_clocks_max = clocks;
+
+  if (d->action == DAQ_VPP_ACTION_FORWARD)
+    return qp->next_indices[desc_index];
+
+  if (d->action == DAQ_VPP_ACTION_TRUST)
+    {
+      if (sm->trusted_flow_timeout)
+	{
+	  clib_bihash_kv_16_8_t kv;
+	  ip4_header_t *ip =
+	    (ip4_header_t *) (sm->buffer_pool_base_addrs[d->buffer_pool] +
+			      d->offset);
+
+	  snort_trusted_flow_key (&kv, ip, instance_index);
+	  kv.value = (u32) vlib_time_now (vm);
+	  clib_bihash_add_or_overwrite_stale_16_8 (
+	    &sm->trusted_flows, &kv, snort_trusted_flow_is_stale, sm);
+	  sm->trusted_flows_active = 1;
+	}
+      return qp->next_indices[desc_index];
+    }
+
+  return SNORT_ENQ_NEXT_DROP;
+}
+
 static_always_inline uword
 snort_deq_instance (vlib_main_t *vm, u32 instance_index, snort_qpair_t *qp,
 		    u32 *buffer_indices, u16 *nexts, u32 max_recv)
@@ -52,6 +97,7 @@ snort_deq_instance (vlib_main_t *vm, u32 instance_index, snort_qpair_t *qp,
     vec_elt_at_index (sm->per_thread_data, vm->thread_index);
   u32 mask = pow2_mask (qp->log2_queue_size);
   u32 head, next, n_recv = 0, n_left;
+  u64 now;
 
   head = __atomic_load_n (qp->deq_head, __ATOMIC_ACQUIRE);
   next = qp->next_desc;
@@ -61,6 +107,8 @@ snort_deq_instance (vlib_main_t *vm, u32 instance_index, snort_qpair_t *qp,
   if (n_left == 0)
     return 0;
 
+  now = clib_cpu_time_now ();
+
   if (n_left > max_recv)
     {
       n_left = max_recv;
@@ -71,7 +119,6 @@ snort_deq_instance (vlib_main_t *vm, u32 instance_index, snort_qpair_t *qp,
   while (n_left)
     {
       u32 desc_index, bi;
-      daq_vpp_desc_t *d;
 
       /* check if descriptor index taken from dequqe ring is valid */
       if ((desc_index = qp->deq_ring[next & mask]) & ~mask)
@@ -92,12 +139,8 @@ snort_deq_instance (vlib_main_t *vm, u32 instance_index, snort_qpair_t *qp,
 
       /* put descriptor back to freelist */
       vec_add1 (qp->freelist, desc_index);
-      d = qp->descriptors + desc_index;
       buffer_indices++[0] = bi;
-      if (d->action == DAQ_VPP_ACTION_FORWARD)
-	nexts[0] = qp->next_indices[desc_index];
-      else
-	nexts[0] = SNORT_ENQ_NEXT_DROP;
+      nexts[0] = snort_deq_verdict (vm, qp, instance_index, desc_index, now);
       qp->buffer_indices[desc_index] = ~0;
       nexts++;
       n_recv++;
@@ -109,6 +152,7 @@ snort_deq_instance (vlib_main_t *vm, u32 instance_index, snort_qpair_t *qp,
     }
 
   qp->next_desc = next;
+  qp->n_verdicts += n_recv;
 
   return n_recv;
 }
@@ -217,11 +261,13 @@ enq:
 }
 
 static_always_inline uword
-snort_deq_instance_poll (vlib_main_t *vm, snort_qpair_t *qp,
-			 u32 *buffer_indices, u16 *nexts, u32 max_recv)
+snort_deq_instance_poll (vlib_main_t *vm, u32 instance_index,
+			 snort_qpair_t *qp, u32 *buffer_indices, u16 *nexts,
+			 u32 max_recv)
 {
   u32 mask = pow2_mask (qp->log2_queue_size);
   u32 head, next, n_recv = 0, n_left;
+  u64 now;
 
   head = __atomic_load_n (qp->deq_head, __ATOMIC_ACQUIRE);
   next = qp->next_desc;
@@ -231,13 +277,14 @@ snort_deq_instance_poll (vlib_main_t *vm, snort_qpair_t *qp,
   if (n_left == 0)
     return 0;
 
+  now = clib_cpu_time_now ();
+
   if (n_left > max_recv)
     n_left = max_recv;
 
   while (n_left)
     {
       u32 desc_index, bi;
-      daq_vpp_desc_t *d;
 
       /* check if descriptor index taken from dequqe ring is valid */
       if ((desc_index = qp->deq_ring[next & mask]) & ~mask)
@@ -258,12 +305,8 @@ snort_deq_instance_poll (vlib_main_t *vm, snort_qpair_t *qp,
 
       /* put descriptor back to freelist */
       vec_add1 (qp->freelist, desc_index);
-      d = qp->descriptors + desc_index;
       buffer_indices++[0] = bi;
-      if (d->action == DAQ_VPP_ACTION_FORWARD)
-	nexts[0] = qp->next_indices[desc_index];
-      else
-	nexts[0] = SNORT_ENQ_NEXT_DROP;
+      nexts[0] = snort_deq_verdict (vm, qp, instance_index, desc_index, now);
       qp->buffer_indices[desc_index] = ~0;
       nexts++;
       n_recv++;
@@ -275,6 +318,7 @@ snort_deq_instance_poll (vlib_main_t *vm, snort_qpair_t *qp,
     }
 
   qp->next_desc = next;
+  qp->n_verdicts += n_recv;
 
   return n_recv;
 }
@@ -315,7 +359,7 @@ snort_deq_node_polling (vlib_main_t *vm, vlib_node_runtime_t *node,
 	n = snort_deq_instance_all_poll (vm, qp, bi, nexts, n_left,
 					 si->drop_on_disconnect);
       else
-	n = snort_deq_instance_poll (vm, qp, bi, nexts, n_left);
+	n = snort_deq_instance_poll (vm, si->index, qp, bi, nexts, n_left);
 
       n_left -= n;
       bi += n;
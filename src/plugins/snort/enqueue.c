@@ -40,7 +40,9 @@ format_snort_enq_trace (u8 *s, va_list *args)
 #define foreach_snort_enq_error                                               \
   _ (SOCKET_ERROR, "write socket error")                                      \
   _ (NO_INSTANCE, "no snort instance")                                        \
-  _ (NO_ENQ_SLOTS, "no enqueue slots (packet dropped)")
+  _ (NO_ENQ_SLOTS, "no enqueue slots (packet dropped)")                      \
+  _ (QUEUE_FULL_PASS, "no enqueue slots (packet passed)")                     \
+  _ (TRUSTED, "trusted flow (not inspected)")
 
 typedef enum
 {
@@ -56,6 +58,29 @@ static char *snort_enq_error_strings[] = {
 #undef _
 };
 
+static_always_inline int
+snort_enq_is_trusted (snort_main_t *sm, vlib_buffer_t *b, u32 l3_offset,
+		      u32 instance_index, u32 now)
+{
+  clib_bihash_kv_16_8_t kv;
+  ip4_header_t *ip = (ip4_header_t *) (vlib_buffer_get_current (b) + l3_offset);
+
+  snort_trusted_flow_key (&kv, ip, instance_index);
+  if (clib_bihash_search_inline_16_8 (&sm->trusted_flows, &kv))
+    return 0;
+
+  if (now - (u32) kv.value > sm->trusted_flow_timeout)
+    return 0;
+
+  /* refresh at most once a second */
+  if ((u32) kv.value != now)
+    {
+      kv.value = now;
+      clib_bihash_add_del_16_8 (&sm->trusted_flows, &kv, 1);
+    }
+  return 1;
+}
+
 static_always_inline uword
 snort_enq_node_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 		       vlib_frame_t *frame, int with_trace)
@@ -66,10 +91,13 @@ snort_enq_node_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
   u32 thread_index = vm->thread_index;
   u32 n_left = frame->n_vectors;
   u32 n_trace = 0;
-  u32 total_enq = 0, n_processed = 0;
+  u32 total_enq = 0, n_processed = 0, n_no_client = 0, n_trusted = 0;
   u32 *from = vlib_frame_vector_args (frame);
   vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u32 bypass_bufs[VLIB_FRAME_SIZE];
   u16 nexts[VLIB_FRAME_SIZE], *next = nexts;
+  u32 now = (u32) vlib_time_now (vm);
+  u64 enq_time;
 
   vlib_get_buffers (vm, from, bufs, n_left);
 
@@ -95,7 +123,16 @@ snort_enq_node_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	  else
 	    next[0] = next_index;
 	  next++;
-	  n_processed++;
+	  bypass_bufs[n_processed++] = from[0];
+	  n_no_client++;
+	}
+      else if (sm->trusted_flows_active &&
+	       snort_enq_is_trusted (sm, b[0], l3_offset, instance_index, now))
+	{
+	  next[0] = next_index;
+	  next++;
+	  bypass_bufs[n_processed++] = from[0];
+	  n_trusted++;
 	}
       else
 	{
@@ -127,15 +164,20 @@ snort_enq_node_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 
   if (n_processed)
     {
-      vlib_node_increment_counter (vm, snort_enq_node.index,
-				   SNORT_ENQ_ERROR_NO_INSTANCE, n_processed);
-      vlib_buffer_enqueue_to_next (vm, node, vlib_frame_vector_args (frame),
-				   nexts, n_processed);
+      if (n_no_client)
+	vlib_node_increment_counter (vm, snort_enq_node.index,
+				     SNORT_ENQ_ERROR_NO_INSTANCE, n_no_client);
+      if (n_trusted)
+	vlib_node_increment_counter (vm, snort_enq_node.index,
+				     SNORT_ENQ_ERROR_TRUSTED, n_trusted);
+      vlib_buffer_enqueue_to_next (vm, node, bypass_bufs, nexts, n_processed);
     }
 
+  enq_time = clib_cpu_time_now ();
+
   vec_foreach (si, sm->instances)
     {
-      u32 head, freelist_len, n_pending, n_enq, mask;
+      u32 head, freelist_len, n_pending, n_enq, n_avail, n_in_flight, mask;
       u64 ctr = 1;
       qp = vec_elt_at_index (si->qpairs, thread_index);
       mask = pow2_mask (qp->log2_queue_size);
@@ -146,15 +188,33 @@ snort_enq_node_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	continue;
 
       freelist_len = vec_len (qp->freelist);
+      n_in_flight = vec_len (qp->buffer_indices) - freelist_len;
+      n_avail = si->queue_threshold > n_in_flight ?
+		  si->queue_threshold - n_in_flight :
+		  0;
+      n_avail = clib_min (n_avail, freelist_len);
 
-      if (freelist_len < n_pending)
+      if (n_avail < n_pending)
 	{
-	  n_enq = freelist_len;
-	  vlib_buffer_free (vm, qp->pending_buffers + n_enq,
-			    n_pending - n_enq);
-	  vlib_node_increment_counter (vm, snort_enq_node.index,
-				       SNORT_ENQ_ERROR_NO_ENQ_SLOTS,
-				       n_pending - n_enq);
+	  n_enq = n_avail;
+	  if (si->pass_on_queue_full)
+	    {
+	      vlib_buffer_enqueue_to_next (vm, node,
+					   qp->pending_buffers + n_enq,
+					   qp->pending_nexts + n_enq,
+					   n_pending - n_enq);
+	      vlib_node_increment_counter (vm, snort_enq_node.index,
+					   SNORT_ENQ_ERROR_QUEUE_FULL_PASS,
+					   n_pending - n_enq);
+	    }
+	  else
+	    {
+	      vlib_buffer_free (vm, qp->pending_buffers + n_enq,
+				n_pending - n_enq);
+	      vlib_node_increment_counter (vm, snort_enq_node.index,
+					   SNORT_ENQ_ERROR_NO_ENQ_SLOTS,
+					   n_pending - n_enq);
+	    }
 	}
       else
 	n_enq = n_pending;
@@ -163,6 +223,10 @@ snort_enq_node_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	continue;
 
       total_enq += n_enq;
+      qp->n_enq += n_enq;
+      n_in_flight += n_enq;
+      if (n_in_flight > qp->max_in_flight)
+	qp->max_in_flight = n_in_flight;
       head = *qp->enq_head;
 
       for (u32 i = 0; i < n_enq; i++)
@@ -171,6 +235,7 @@ snort_enq_node_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	  qp->next_indices[desc_index] = qp->pending_nexts[i];
 	  ASSERT (qp->buffer_indices[desc_index] == ~0);
 	  qp->buffer_indices[desc_index] = qp->pending_buffers[i];
+	  qp->enq_time[desc_index] = enq_time;
 	  clib_memcpy_fast (qp->descriptors + desc_index,
 			    qp->pending_descs + i, sizeof (daq_vpp_desc_t));
 	  qp->enq_ring[head & mask] = desc_index;
@@ -9,6 +9,8 @@
 
 #include <sys/eventfd.h>
 
+#include <vppinfra/bihash_template.c>
+
 snort_main_t snort_main;
 
 VLIB_REGISTER_LOG_CLASS (snort_log, static) = {
@@ -281,7 +283,8 @@ snort_listener_init (vlib_main_t *vm)
 
 clib_error_t *
 snort_instance_create (vlib_main_t *vm, char *name, u8 log2_queue_sz,
-		       u8 drop_on_disconnect)
+		       u8 drop_on_disconnect, u8 pass_on_queue_full,
+		       u32 queue_threshold)
 {
   vlib_thread_main_t *tm = vlib_get_thread_main ();
   snort_main_t *sm = &snort_main;
@@ -298,6 +301,9 @@ snort_instance_create (vlib_main_t *vm, char *name, u8 log2_queue_sz,
   if (snort_get_instance_by_name (name))
     return clib_error_return (0, "instance already exists");
 
+  if (queue_threshold == 0 || queue_threshold > qsz)
+    queue_threshold = qsz;
+
   /* descriptor table */
   qpair_mem_sz += round_pow2 (qsz * sizeof (daq_vpp_desc_t), align);
 
@@ -341,6 +347,8 @@ snort_instance_create (vlib_main_t *vm, char *name, u8 log2_queue_sz,
   si->shm_size = size;
   si->name = format (0, "%s%c", name, 0);
   si->drop_on_disconnect = drop_on_disconnect;
+  si->pass_on_queue_full = pass_on_queue_full;
+  si->queue_threshold = queue_threshold;
   index = si - sm->instances;
   hash_set_mem (sm->instance_by_name, si->name, index);
 
@@ -374,6 +382,7 @@ snort_instance_create (vlib_main_t *vm, char *name, u8 log2_queue_sz,
       vec_validate_aligned (qp->buffer_indices, qsz - 1,
 			    CLIB_CACHE_LINE_BYTES);
       vec_validate_aligned (qp->next_indices, qsz - 1, CLIB_CACHE_LINE_BYTES);
+      vec_validate_aligned (qp->enq_time, qsz - 1, CLIB_CACHE_LINE_BYTES);
       clib_memset_u32 (qp->buffer_indices, ~0, qsz);
 
       /* pre-populate freelist */
@@ -502,6 +511,28 @@ snort_set_node_mode (vlib_main_t *vm, u32 mode)
   return 0;
 }
 
+static int
+snort_trusted_flow_collect (clib_bihash_kv_16_8_t *kv, void *arg)
+{
+  clib_bihash_kv_16_8_t **kvs = arg;
+  vec_add1 (*kvs, *kv);
+  return BIHASH_WALK_CONTINUE;
+}
+
+void
+snort_trusted_flows_clear (void)
+{
+  snort_main_t *sm = &snort_main;
+  clib_bihash_kv_16_8_t *kvs = 0, *kv;
+
+  clib_bihash_foreach_key_value_pair_16_8 (
+    &sm->trusted_flows, snort_trusted_flow_collect, &kvs);
+  vec_foreach (kv, kvs)
+    clib_bihash_add_del_16_8 (&sm->trusted_flows, kv, 0);
+  vec_free (kvs);
+  sm->trusted_flows_active = 0;
+}
+
 static void
 snort_set_default_socket (snort_main_t *sm, u8 *socket_name)
 {
@@ -524,6 +555,10 @@ snort_init (vlib_main_t *vm)
   sm->instance_by_name = hash_create_string (0, sizeof (uword));
   vlib_buffer_pool_t *bp;
 
+  sm->trusted_flow_timeout = SNORT_DEFAULT_TRUSTED_FLOW_TIMEOUT;
+  clib_bihash_init_16_8 (&sm->trusted_flows, "snort trusted flows", 1 << 16,
+			 64 << 20);
+
   vec_foreach (bp, vm->buffer_main->buffer_pools)
     {
       vlib_physmem_map_t *pm =
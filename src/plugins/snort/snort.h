@@ -7,7 +7,9 @@
 
 #include <vppinfra/error.h>
 #include <vppinfra/socket.h>
+#include <vppinfra/bihash_16_8.h>
 #include <vlib/vlib.h>
+#include <vnet/ip/ip4_packet.h>
 #include <snort/daq_vpp.h>
 
 typedef struct
@@ -27,6 +29,14 @@ typedef struct
   u32 *freelist;
   u32 ready;
 
+  /* statistics, updated by the owning thread only */
+  u64 *enq_time;
+  u64 n_enq;
+  u64 n_verdicts;
+  u64 verdict_clocks_sum;
+  u64 verdict_clocks_max;
+  u32 max_in_flight;
+
   /* temporary storeage used by enqueue node */
   u32 n_pending;
   u16 pending_nexts[VLIB_FRAME_SIZE];
@@ -44,6 +54,10 @@ typedef struct
   snort_qpair_t *qpairs;
   u8 *name;
   u8 drop_on_disconnect;
+  /* pass instead of drop packets which don't fit below queue_threshold */
+  u8 pass_on_queue_full;
+  /* max descriptors in flight per qpair */
+  u32 queue_threshold;
 } snort_instance_t;
 
 typedef struct
@@ -78,6 +92,11 @@ typedef struct
   snort_per_thread_data_t *per_thread_data;
   u32 input_mode;
   u8 *socket_name;
+
+  /* flows given a trust verdict, not sent to snort until idle */
+  clib_bihash_16_8_t trusted_flows;
+  u32 trusted_flow_timeout;
+  u8 trusted_flows_active;
 } snort_main_t;
 
 extern snort_main_t snort_main;
@@ -97,6 +116,8 @@ typedef enum
   SNORT_INOUT = 3
 } snort_attach_dir_t;
 
+#define SNORT_DEFAULT_TRUSTED_FLOW_TIMEOUT 30
+
 #define SNORT_ENQ_NEXT_NODES                                                  \
   {                                                                           \
     [SNORT_ENQ_NEXT_DROP] = "error-drop",                                     \
@@ -104,12 +125,15 @@ typedef enum
 
 /* functions */
 clib_error_t *snort_instance_create (vlib_main_t *vm, char *name,
-				     u8 log2_queue_sz, u8 drop_on_disconnect);
+				     u8 log2_queue_sz, u8 drop_on_disconnect,
+				     u8 pass_on_queue_full,
+				     u32 queue_threshold);
 clib_error_t *snort_interface_enable_disable (vlib_main_t *vm,
 					      char *instance_name,
 					      u32 sw_if_index, int is_enable,
 					      snort_attach_dir_t dir);
 clib_error_t *snort_set_node_mode (vlib_main_t *vm, u32 mode);
+void snort_trusted_flows_clear (void);
 
 always_inline void
 snort_freelist_init (u32 *fl)
@@ -118,4 +142,34 @@ snort_freelist_init (u32 *fl)
     fl[j] = j;
 }
 
+/* both directions of a flow map to the same key */
+always_inline void
+snort_trusted_flow_key (clib_bihash_kv_16_8_t *kv, ip4_header_t *ip,
+			u32 instance_index)
+{
+  u64 a, b, t;
+  u16 sport = 0, dport = 0;
+
+  if ((ip->protocol == IP_PROTOCOL_TCP || ip->protocol == IP_PROTOCOL_UDP) &&
+      ip4_get_fragment_offset (ip) == 0)
+    {
+      u16 *ports = (u16 *) ip4_next_header (ip);
+      sport = ports[0];
+      dport = ports[1];
+    }
+
+  a = (u64) ip->src_address.as_u32 << 16 | sport;
+  b = (u64) ip->dst_address.as_u32 << 16 | dport;
+  if (a > b)
+    {
+      t = a;
+      a = b;
+      b = t;
+    }
+
+  kv->key[0] = (a >> 16) << 32 | (b >> 16);
+  kv->key[1] = (u64) instance_index << 40 | (u64) ip->protocol << 32 |
+	       (a & 0xffff) << 16 | (b & 0xffff);
+}
+
 #endif /* __snort_snort_h__ */
@@ -241,6 +241,119 @@ test_bihash_threads (bihash_test_main_t * tm)
   return 0;
 }
 
+/*
+ * Random order lookups in a table living on the given heap, in clocks
+ * per lookup. Big tables on small pages are dominated by TLB misses.
+ */
+static clib_error_t *
+test_bihash_tlb_lookups (bihash_test_main_t *tm, clib_mem_heap_t *heap,
+			 u32 *order, f64 *clocks_per_lookup)
+{
+  BVT (clib_bihash_init2_args) _a = {}, *a = &_a;
+  BVT (clib_bihash) h = {};
+  BVT (clib_bihash_kv) kv;
+  clib_error_t *err = 0;
+  clib_mem_heap_t *oldheap;
+  u64 t0, clocks = 0;
+  u32 i, j;
+
+  /* all table memory comes from the heap current at instantiation */
+  oldheap = clib_mem_set_heap (heap);
+
+  a->h = &h;
+  a->name = "tlb test";
+  a->nbuckets = tm->nbuckets;
+  a->instantiate_immediately = 1;
+  a->dont_add_to_all_bihash_list = 1;
+  BV (clib_bihash_init2) (a);
+
+  for (i = 0; i < tm->nitems; i++)
+    {
+      kv.key = tm->keys[i];
+      kv.value = i;
+      BV (clib_bihash_add_del) (&h, &kv, 1 /* is_add */);
+    }
+
+  for (j = 0; j < tm->search_iter; j++)
+    {
+      t0 = clib_cpu_time_now ();
+      for (i = 0; i < tm->nitems; i++)
+	{
+	  kv.key = tm->keys[order[i]];
+	  if (BV (clib_bihash_search) (&h, &kv, &kv) < 0 ||
+	      kv.value != order[i])
+	    {
+	      err = clib_error_return (0, "search for key %llu failed",
+				       tm->keys[order[i]]);
+	      goto done;
+	    }
+	}
+      clocks += clib_cpu_time_now () - t0;
+    }
+
+  *clocks_per_lookup = (f64) clocks / ((f64) tm->nitems * tm->search_iter);
+
+done:
+  BV (clib_bihash_free) (&h);
+  clib_mem_set_heap (oldheap);
+  return err;
+}
+
+static clib_error_t *
+test_bihash_tlb (bihash_test_main_t *tm)
+{
+  vlib_main_t *vm = tm->vlib_main;
+  clib_mem_heap_t *small, *large, *heaps[2];
+  clib_error_t *err = 0;
+  u32 i, *order = 0;
+  f64 clocks[2];
+
+  large = clib_mem_get_large_heap (os_get_numa_index ());
+  if (large == 0)
+    return clib_error_return (0, "no large heap, see "
+				 "'memory { large-alloc-threshold }'");
+
+  small = clib_mem_create_heap (0, tm->hash_memory_size, 1 /* locked */,
+				"bihash tlb test");
+  if (small == 0)
+    return clib_error_return (0, "failed to create %U test heap",
+			      format_memory_size, tm->hash_memory_size);
+
+  for (i = 0; i < tm->nitems; i++)
+    {
+      vec_add1 (tm->keys, random_u64 (&tm->seed));
+      vec_add1 (order, i);
+    }
+
+  /* shuffle the lookup order, so each lookup hits a random page */
+  for (i = tm->nitems - 1; i > 0; i--)
+    {
+      u32 k = random_u64 (&tm->seed) % (i + 1), tmp = order[i];
+      order[i] = order[k];
+      order[k] = tmp;
+    }
+
+  heaps[0] = small;
+  heaps[1] = large;
+  for (i = 0; i < ARRAY_LEN (heaps); i++)
+    if ((err = test_bihash_tlb_lookups (tm, heaps[i], order, clocks + i)))
+      goto done;
+
+  vlib_cli_output (vm, "%u items, %u buckets, %u random lookup rounds",
+		   tm->nitems, tm->nbuckets, tm->search_iter);
+  for (i = 0; i < ARRAY_LEN (heaps); i++)
+    vlib_cli_output (vm, "  %-24s page size %-6U%8.2f clocks/lookup",
+		     heaps[i]->name, format_log2_page_size,
+		     heaps[i]->log2_page_sz, clocks[i]);
+
+done:
+  clib_mem_destroy_heap (small);
+  vec_free (order);
+  vec_free (tm->keys);
+  hash_free (tm->key_hash);
+  return err;
+}
+
 /*
  * Callback to blow up spectacularly if anything remains in the table
  */
@@ -508,6 +621,8 @@ test_bihash_command_fn (vlib_main_t * vm,
 	which = 1;
       else if (unformat (input, "threads %u", &tm->nthreads))
 	which = 2;
+      else if (unformat (input, "tlb"))
+	which = 3;
       else if (unformat (input, "verbose"))
 	tm->verbose = 1;
       else
@@ -534,6 +649,10 @@ test_bihash_command_fn (vlib_main_t * vm,
       error = test_bihash_threads (tm);
       break;
 
+    case 3:
+      error = test_bihash_tlb (tm);
+      break;
+
     default:
       return clib_error_return (0, "no such test?");
     }
@@ -545,7 +664,8 @@ test_bihash_command_fn (vlib_main_t * vm,
 VLIB_CLI_COMMAND (test_bihash_command, static) =
 {
   .path = "test bihash",
-  .short_help = "test bihash",
+  .short_help = "test bihash [tlb][nitems <n>][nbuckets <n>][search <n>]"
+		"[memory-size <size>]",
   .function = test_bihash_command_fn,
 };
 /* *INDENT-ON* */
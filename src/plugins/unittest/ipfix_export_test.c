@@ -0,0 +1,110 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include <vlib/vlib.h>
+#include <vnet/ipfix-export/flow_report.h>
+#include <vnet/udp/udp_local.h>
+
+static clib_error_t *
+ipfix_export_test (vlib_main_t *vm, unformat_input_t *input,
+		   vlib_cli_command_t *cmd_arg)
+{
+  flow_report_main_t *frm = &flow_report_main;
+  u32 n_records = 1000000, size = 32, i;
+  ipfix_report_element_t elts[1];
+  vnet_flow_report_add_del_args_t a;
+  ipfix_exporter_per_thread_t *eptd;
+  u64 n_packets, n_dropped, t0, clocks;
+  ipfix_exporter_t *exp;
+  flow_report_t *fr;
+  clib_error_t *err = 0;
+  u8 *record = 0;
+  f64 t;
+  int rv;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "records %u", &n_records))
+	;
+      else if (unformat (input, "size %u", &size))
+	;
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, input);
+    }
+
+  if (n_records == 0 || size == 0 || size > 256)
+    return clib_error_return (0, "records must be non-zero and size "
+				 "between 1 and 256 bytes");
+
+  exp = pool_elt_at_index (frm->exporters, 0);
+  if (ip_address_is_zero (&exp->ipfix_collector))
+    return clib_error_return (0, "ipfix exporter is not configured");
+
+  /* one padding field of the requested size, the content is not checked */
+  elts[0].info_element = paddingOctets;
+  elts[0].size = size;
+
+  clib_memset (&a, 0, sizeof (a));
+  a.is_add = 1;
+  a.rewrite_callback = vnet_flow_rewrite_generic_callback;
+  a.report_elements = elts;
+  a.n_report_elements = ARRAY_LEN (elts);
+  a.domain_id = 0x1f0e;
+  a.src_port = UDP_DST_PORT_ipfix;
+  a.flow_report_index = ~0;
+
+  rv = vnet_flow_report_add_del (exp, &a, NULL);
+  if (rv)
+    return clib_error_return (0, "vnet_flow_report_add_del returned %d", rv);
+
+  fr = pool_elt_at_index (exp->reports, a.flow_report_index);
+  eptd = vec_elt_at_index (exp->per_thread_data, vm->thread_index);
+  n_packets = eptd->n_packets;
+  n_dropped = eptd->n_records_dropped;
+
+  vec_validate_init_empty (record, size - 1, 0x5a);
+
+  clocks = 0;
+  t0 = clib_cpu_time_now ();
+  for (i = 0; i < n_records; i++)
+    {
+      record[0] = i;
+      vnet_ipfix_exp_add_record (vm, exp, fr, record, size);
+
+      /* let the graph free the sent packets, not counted */
+      if ((i & 0xffff) == 0xffff)
+	{
+	  vnet_ipfix_exp_flush (vm, exp, fr, 1e9);
+	  clocks += clib_cpu_time_now () - t0;
+	  vlib_process_suspend (vm, 1e-3);
+	  t0 = clib_cpu_time_now ();
+	}
+    }
+  vnet_ipfix_exp_flush (vm, exp, fr, 0);
+  clocks += clib_cpu_time_now () - t0;
+  t = clocks * vm->clib_time.seconds_per_clock;
+
+  n_packets = eptd->n_packets - n_packets;
+  n_dropped = eptd->n_records_dropped - n_dropped;
+
+  vlib_cli_output (vm, "%u x %u byte records, path-mtu %u:", n_records, size,
+		   exp->path_mtu);
+  vlib_cli_output (vm, "  %lu packets, %lu records dropped", n_packets,
+		   n_dropped);
+  vlib_cli_output (vm, "  %.2f clocks/record, %.2f Mrecords/s",
+		   (f64) clocks / n_records, (f64) n_records / t * 1e-6);
+
+  a.is_add = 0;
+  rv = vnet_flow_report_add_del (exp, &a, NULL);
+  if (rv)
+    err = clib_error_return (0, "vnet_flow_report_add_del returned %d", rv);
+
+  vec_free (record);
+  return err;
+}
+
+VLIB_CLI_COMMAND (ipfix_export_test_command, static) = {
+  .path = "test ipfix-export",
+  .short_help = "test ipfix-export [records <n>] [size <bytes>]",
+  .function = ipfix_export_test,
+};
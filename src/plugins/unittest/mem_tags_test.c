@@ -0,0 +1,197 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include <pthread.h>
+#include <vppinfra/mem.h>
+#include <vlib/vlib.h>
+
+#define MT_TEST(_cond, _comment, _args...)                                    \
+  {                                                                           \
+    if (!(_cond))                                                             \
+      {                                                                       \
+	vlib_cli_output (vm, "FAIL:%d: " _comment, __LINE__, ##_args);        \
+	rv = 1;                                                               \
+	goto done;                                                            \
+      }                                                                       \
+  }
+
+typedef struct
+{
+  clib_mem_heap_t *heap;
+  void **objs;
+} mem_tags_test_free_args_t;
+
+static void *
+mem_tags_test_free_thread (void *arg)
+{
+  mem_tags_test_free_args_t *a = arg;
+  for (u32 i = 0; i < vec_len (a->objs); i++)
+    clib_mem_heap_free (a->heap, a->objs[i]);
+  return 0;
+}
+
+static int
+mem_tags_test_accounting (vlib_main_t *vm, clib_mem_heap_t *h, u32 tag,
+			  u32 n_objects)
+{
+  mem_tags_test_free_args_t a;
+  clib_mem_tag_counters_t _t, *t = &_t;
+  pthread_t thread;
+  void **objs = 0;
+  uword n_bytes = 0;
+  u32 old_tag, i;
+  int rv = 0;
+
+  vec_validate (objs, n_objects - 1);
+
+  old_tag = clib_mem_set_tag (tag);
+  for (i = 0; i < n_objects; i++)
+    {
+      objs[i] = clib_mem_heap_alloc (h, 1 + (i % 200));
+      n_bytes += clib_mem_size (objs[i]);
+    }
+  clib_mem_set_tag (old_tag);
+
+  clib_mem_tag_get_counters (tag, t);
+  MT_TEST (t->n_objects == n_objects, "%lu objects, expected %u",
+	   t->n_objects, n_objects);
+  MT_TEST (t->n_bytes == n_bytes, "%lu bytes, expected %lu", t->n_bytes,
+	   n_bytes);
+
+  /* the whole usable size belongs to the caller, the tag must survive */
+  for (i = 0; i < n_objects; i++)
+    clib_memset (objs[i], 0xfe, clib_mem_size (objs[i]));
+
+  /* objects keep their tag when they grow, whatever the current tag is */
+  n_bytes = 0;
+  for (i = 0; i < n_objects; i++)
+    {
+      objs[i] = clib_mem_heap_realloc (h, objs[i], 64 + (i % 1000));
+      clib_memset (objs[i], 0xfe, clib_mem_size (objs[i]));
+      n_bytes += clib_mem_size (objs[i]);
+    }
+
+  clib_mem_tag_get_counters (tag, t);
+  MT_TEST (t->n_objects == n_objects, "%lu objects after realloc, "
+				      "expected %u",
+	   t->n_objects, n_objects);
+  MT_TEST (t->n_bytes == n_bytes, "%lu bytes after realloc, expected %lu",
+	   t->n_bytes, n_bytes);
+
+  /* the second half is freed by another thread, counters are per thread
+     but must still add up */
+  a.heap = h;
+  a.objs = 0;
+  vec_add (a.objs, objs + n_objects / 2, n_objects - n_objects / 2);
+  MT_TEST (pthread_create (&thread, 0, mem_tags_test_free_thread, &a) == 0,
+	   "pthread_create failed");
+  pthread_join (thread, 0);
+  vec_free (a.objs);
+  for (i = 0; i < n_objects / 2; i++)
+    clib_mem_heap_free (h, objs[i]);
+
+  clib_mem_tag_get_counters (tag, t);
+  MT_TEST (t->n_objects == 0, "%lu objects left", t->n_objects);
+  MT_TEST (t->n_bytes == 0, "%lu bytes left", t->n_bytes);
+
+done:
+  vec_free (objs);
+  return rv;
+}
+
+static f64
+mem_tags_test_perf (clib_mem_heap_t *h, u32 tag, u32 n_objects, u32 size,
+		    u32 n_rounds)
+{
+  void **objs = 0;
+  u32 old_tag, i, j;
+  u64 t0, clocks = 0;
+
+  vec_validate (objs, n_objects - 1);
+  old_tag = clib_mem_set_tag (tag);
+
+  for (j = 0; j < n_rounds; j++)
+    {
+      t0 = clib_cpu_time_now ();
+      for (i = 0; i < n_objects; i++)
+	objs[i] = clib_mem_heap_alloc (h, size);
+      for (i = 0; i < n_objects; i++)
+	clib_mem_heap_free (h, objs[i]);
+      clocks += clib_cpu_time_now () - t0;
+    }
+
+  clib_mem_set_tag (old_tag);
+  vec_free (objs);
+  return (f64) clocks / ((f64) n_objects * n_rounds);
+}
+
+static clib_error_t *
+mem_tags_test (vlib_main_t *vm, unformat_input_t *input,
+	       vlib_cli_command_t *cmd_arg)
+{
+  u32 n_objects = 10000, size = 64, n_rounds = 100;
+  clib_mem_heap_t *plain, *tagged;
+  f64 untagged_heap, tag_none, tag_set;
+  clib_error_t *err = 0;
+  u32 tag;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "objects %u", &n_objects))
+	;
+      else if (unformat (input, "size %u", &size))
+	;
+      else if (unformat (input, "rounds %u", &n_rounds))
+	;
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, input);
+    }
+
+  if (n_objects == 0 || size == 0 || n_rounds == 0)
+    return clib_error_return (0, "objects, size and rounds must be non-zero");
+
+  tag = clib_mem_tag_get_or_create ("unittest-mem-tags");
+  if (tag == CLIB_MEM_TAG_NONE)
+    return clib_error_return (0, "no free memory tag");
+
+  plain = clib_mem_create_heap (0, 256 << 20, 1, "mem tags test plain");
+  tagged = clib_mem_create_heap (0, 256 << 20, 1, "mem tags test tagged");
+  if (!plain || !tagged)
+    {
+      err = clib_error_return (0, "failed to create test heaps");
+      goto done;
+    }
+  clib_mem_heap_enable_tags (tagged);
+
+  if (mem_tags_test_accounting (vm, tagged, tag, n_objects))
+    {
+      err = clib_error_return (0, "mem tags accounting test failed");
+      goto done;
+    }
+
+  untagged_heap = mem_tags_test_perf (plain, tag, n_objects, size, n_rounds);
+  tag_none = mem_tags_test_perf (tagged, CLIB_MEM_TAG_NONE, n_objects, size,
+				 n_rounds);
+  tag_set = mem_tags_test_perf (tagged, tag, n_objects, size, n_rounds);
+
+  vlib_cli_output (vm, "%u x %u byte alloc + free, %u rounds, clocks per "
+		       "object:",
+		   n_objects, size, n_rounds);
+  vlib_cli_output (vm, "  %-28s%8.2f", "tags disabled", untagged_heap);
+  vlib_cli_output (vm, "  %-28s%8.2f", "tags enabled, no tag set", tag_none);
+  vlib_cli_output (vm, "  %-28s%8.2f (%+.1f%%)", "tags enabled, tag set",
+		   tag_set, 100 * (tag_set - untagged_heap) / untagged_heap);
+
+done:
+  if (plain)
+    clib_mem_destroy_heap (plain);
+  if (tagged)
+    clib_mem_destroy_heap (tagged);
+  return err;
+}
+
+VLIB_CLI_COMMAND (mem_tags_test_command, static) = {
+  .path = "test mem-tags",
+  .short_help = "test mem-tags [objects <n>] [size <bytes>] [rounds <n>]",
+  .function = mem_tags_test,
+};
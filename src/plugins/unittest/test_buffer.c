@@ -13,6 +13,7 @@
  * limitations under the License.
  */
 
+#include <pthread.h>
 #include <vlib/vlib.h>
 #include <vlib/buffer_funcs.h>
 
@@ -318,6 +319,141 @@ VLIB_CLI_COMMAND (test_linearize_speed_command, static) = {
   .function = test_linearize_speed_fn,
 };
 
+typedef struct
+{
+  vlib_buffer_pool_t *bp;
+  volatile int locked;
+} buffer_pool_lock_holder_t;
+
+static void *
+buffer_pool_lock_holder (void *arg)
+{
+  buffer_pool_lock_holder_t *h = arg;
+
+  clib_spinlock_lock (&h->bp->lock);
+  h->locked = 1;
+  usleep (10000);
+  clib_spinlock_unlock (&h->bp->lock);
+  return 0;
+}
+
+static int
+buffer_pool_cache_test (vlib_main_t *vm)
+{
+  const u32 cache_sz = VLIB_BUFFER_POOL_PER_THREAD_CACHE_SZ;
+  const u32 n_half = cache_sz / 2;
+  const u32 n_buffers = 2 * cache_sz;
+  vlib_buffer_main_t *bm = vm->buffer_main;
+  vlib_buffer_pool_t *bp, *obp;
+  vlib_buffer_pool_thread_t *bpt, *obpt;
+  buffer_pool_lock_holder_t holder;
+  pthread_t thread;
+  u32 *buffers = 0, *b, *end, bi;
+  u32 n_alloc, n_free, n_cached;
+  u64 n_lock, n;
+  int rv = 0;
+
+  bp = vlib_get_buffer_pool (
+    vm, vlib_buffer_pool_get_default_for_numa (vm, vm->numa_node));
+  bpt = vec_elt_at_index (bp->threads, vm->thread_index);
+
+  vec_validate (buffers, n_buffers - 1);
+  n_alloc = vlib_buffer_alloc_from_pool (vm, buffers, n_buffers, bp->index);
+  b = buffers;
+  end = buffers + n_alloc;
+  TEST (n_alloc == n_buffers, "allocated %u of %u buffers", n_alloc,
+	n_buffers);
+
+  /* filling the cache takes no lock */
+  n_lock = bpt->n_lock;
+  n_free = cache_sz - bpt->n_cached;
+  vlib_buffer_free (vm, b, n_free);
+  b += n_free;
+  TEST (bpt->n_cached == cache_sz && bpt->n_lock == n_lock,
+	"full cache: %u cached, %llu locks", bpt->n_cached,
+	bpt->n_lock - n_lock);
+
+  /* one more buffer returns half of the cache under one lock */
+  vlib_buffer_free (vm, b++, 1);
+  TEST (bpt->n_cached == n_half && bpt->n_lock == n_lock + 1,
+	"overflow: %u cached, %llu locks", bpt->n_cached,
+	bpt->n_lock - n_lock);
+
+  /* so the frees that follow are served from the cache */
+  vlib_buffer_free (vm, b, n_half);
+  b += n_half;
+  TEST (bpt->n_cached == cache_sz && bpt->n_lock == n_lock + 1,
+	"after overflow: %u cached, %llu locks", bpt->n_cached,
+	bpt->n_lock - n_lock);
+
+  /* the pool lock held by another thread is counted as contention */
+  holder.bp = bp;
+  holder.locked = 0;
+  TEST (pthread_create (&thread, 0, buffer_pool_lock_holder, &holder) == 0,
+	"pthread_create");
+  while (!holder.locked)
+    CLIB_PAUSE ();
+  n = bpt->n_lock_contended;
+  vlib_buffer_free (vm, b++, 1);
+  pthread_join (thread, 0);
+  TEST (bpt->n_lock_contended == n + 1, "%llu contended locks",
+	bpt->n_lock_contended - n);
+
+  /* buffers freed by a worker go to the worker's cache */
+  if (vlib_get_n_threads () > 1)
+    {
+      obpt = vec_elt_at_index (bp->threads, 1);
+      n_cached = bpt->n_cached;
+      vlib_worker_thread_barrier_sync (vm);
+      n = obpt->n_cached;
+      n_free = clib_min (cache_sz - n, end - b);
+      vlib_buffer_free (vlib_get_main_by_index (1), b, n_free);
+      b += n_free;
+      vlib_worker_thread_barrier_release (vm);
+      TEST (obpt->n_cached == n + n_free && bpt->n_cached == n_cached,
+	    "worker free: worker %u cached, main %u cached", obpt->n_cached,
+	    bpt->n_cached);
+    }
+
+  /* buffers of another numa node's pool are counted as remote frees */
+  vec_foreach (obp, bm->buffer_pools)
+    {
+      if (obp->numa_node == vm->numa_node)
+	continue;
+      obpt = vec_elt_at_index (obp->threads, vm->thread_index);
+      if (vlib_buffer_alloc_from_pool (vm, &bi, 1, obp->index) != 1)
+	continue;
+      n = obpt->n_remote_free;
+      vlib_buffer_free_one (vm, bi);
+      TEST (obpt->n_remote_free == n + 1, "pool %s: %llu remote frees",
+	    obp->name, obpt->n_remote_free - n);
+    }
+
+  rv = 1;
+
+err:
+  if (b < end)
+    vlib_buffer_free (vm, b, end - b);
+  vec_free (buffers);
+  return rv;
+}
+
+static clib_error_t *
+test_buffer_pool_cache_fn (vlib_main_t *vm, unformat_input_t *input,
+			   vlib_cli_command_t *cmd)
+{
+  if (!buffer_pool_cache_test (vm))
+    return clib_error_return (0, "buffer pool cache test failed");
+
+  return 0;
+}
+
+VLIB_CLI_COMMAND (test_buffer_pool_cache_command, static) = {
+  .path = "test buffer-pool-cache",
+  .short_help = "test buffer-pool-cache",
+  .function = test_buffer_pool_cache_fn,
+};
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
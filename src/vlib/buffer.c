@@ -619,21 +619,49 @@ format_vlib_buffer_pool_all (u8 *s, va_list *va)
   return s;
 }
 
+static u8 *
+format_vlib_buffer_pool_threads (u8 *s, va_list *va)
+{
+  vlib_buffer_pool_t *bp = va_arg (*va, vlib_buffer_pool_t *);
+  vlib_buffer_pool_thread_t *bpt;
+
+  s = format (s, "%s:\n  %=8s%=8s%=14s%=14s%=14s", bp->name, "Thread",
+	      "Cached", "Pool-locks", "Contended", "Remote-frees");
+
+  vec_foreach (bpt, bp->threads)
+    s = format (s, "\n  %=8u%=8u%=14llu%=14llu%=14llu", bpt - bp->threads,
+		bpt->n_cached, bpt->n_lock, bpt->n_lock_contended,
+		bpt->n_remote_free);
+
+  return s;
+}
+
 static clib_error_t *
 show_buffers (vlib_main_t *vm, unformat_input_t *input,
 	      vlib_cli_command_t *cmd)
 {
+  vlib_buffer_main_t *bm = vm->buffer_main;
+  vlib_buffer_pool_t *bp;
+
   vlib_cli_output (vm, "%U", format_vlib_buffer_pool_all, vm);
+
+  if (unformat (input, "verbose"))
+    vec_foreach (bp, bm->buffer_pools)
+      vlib_cli_output (vm, "%U", format_vlib_buffer_pool_threads, bp);
+
   return 0;
 }
 
-/* *INDENT-OFF* */
+/*?
+ * Show the buffer pools. 'verbose' adds, per thread, the buffers in
+ * its cache, how often it took the pool lock and found it held, and
+ * how many buffers it freed to a pool on another numa node.
+?*/
 VLIB_CLI_COMMAND (show_buffers_command, static) = {
   .path = "show buffers",
-  .short_help = "Show packet buffer allocation",
+  .short_help = "show buffers [verbose]",
   .function = show_buffers,
 };
-/* *INDENT-ON* */
 
 clib_error_t *
 vlib_buffer_num_workers_change (vlib_main_t *vm)
@@ -780,6 +808,28 @@ buffer_get_by_index (vlib_buffer_main_t * bm, u32 index)
   return bp;
 }
 
+#define foreach_buffer_pool_thread_counter                                    \
+  _ (lock, "pool-locks")                                                      \
+  _ (lock_contended, "pool-lock-contended")                                   \
+  _ (remote_free, "remote-frees")
+
+#define _(n, s)                                                               \
+  static void buffer_gauges_collect_##n##_fn (vlib_stats_collector_data_t *d) \
+  {                                                                           \
+    vlib_main_t *vm = vlib_get_main ();                                       \
+    vlib_buffer_pool_t *bp =                                                  \
+      buffer_get_by_index (vm->buffer_main, d->private_data);                 \
+    vlib_buffer_pool_thread_t *bpt;                                           \
+    u64 sum = 0;                                                              \
+    if (!bp)                                                                  \
+      return;                                                                 \
+    vec_foreach (bpt, bp->threads)                                            \
+      sum += bpt->n_##n;                                                      \
+    d->entry->value = sum;                                                    \
+  }
+foreach_buffer_pool_thread_counter
+#undef _
+
 static void
 buffer_gauges_collect_used_fn (vlib_stats_collector_data_t *d)
 {
@@ -904,6 +954,13 @@ vlib_buffer_main_init (struct vlib_main_t * vm)
       vlib_stats_add_gauge ("/buffer-pools/%s/available", bp->name);
     reg.collect_fn = buffer_gauges_collect_available_fn;
     vlib_stats_register_collector_fn (&reg);
+
+#define _(n, s)                                                               \
+  reg.entry_index = vlib_stats_add_gauge ("/buffer-pools/%s/" s, bp->name);   \
+  reg.collect_fn = buffer_gauges_collect_##n##_fn;                            \
+  vlib_stats_register_collector_fn (&reg);
+    foreach_buffer_pool_thread_counter
+#undef _
   }
 
 done:
@@ -445,6 +445,12 @@ typedef struct
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   u32 cached_buffers[VLIB_BUFFER_POOL_PER_THREAD_CACHE_SZ];
   u32 n_cached;
+
+  /* pool lock statistics */
+  u64 n_lock;
+  u64 n_lock_contended;
+  /* buffers freed by a thread on another numa node than the pool's */
+  u64 n_remote_free;
 } vlib_buffer_pool_thread_t;
 
 typedef struct
@@ -495,6 +495,20 @@ vlib_get_buffer_pool (vlib_main_t * vm, u8 buffer_pool_index)
   return vec_elt_at_index (bm->buffer_pools, buffer_pool_index);
 }
 
+static_always_inline void
+vlib_buffer_pool_lock (vlib_main_t *vm, vlib_buffer_pool_t *bp)
+{
+  vlib_buffer_pool_thread_t *bpt =
+    vec_elt_at_index (bp->threads, vm->thread_index);
+
+  bpt->n_lock++;
+  if (PREDICT_FALSE (!clib_spinlock_trylock (&bp->lock)))
+    {
+      bpt->n_lock_contended++;
+      clib_spinlock_lock (&bp->lock);
+    }
+}
+
 static_always_inline __clib_warn_unused_result uword
 vlib_buffer_pool_get (vlib_main_t * vm, u8 buffer_pool_index, u32 * buffers,
 		      u32 n_buffers)
@@ -504,7 +518,7 @@ vlib_buffer_pool_get (vlib_main_t * vm, u8 buffer_pool_index, u32 * buffers,
 
   ASSERT (bp->buffers);
 
-  clib_spinlock_lock (&bp->lock);
+  vlib_buffer_pool_lock (vm, bp);
   len = bp->n_avail;
   if (PREDICT_TRUE (n_buffers < len))
     {
@@ -586,7 +600,9 @@ vlib_buffer_alloc_from_pool (vlib_main_t * vm, u32 * buffers, u32 n_buffers,
       n_left -= len;
     }
 
-  len = round_pow2 (n_left, 32);
+  /* refill at least half of the cache, to take the pool lock less often */
+  len = clib_max (round_pow2 (n_left, 32),
+		  VLIB_BUFFER_POOL_PER_THREAD_CACHE_SZ / 2);
   len = vlib_buffer_pool_get (vm, buffer_pool_index, bpt->cached_buffers,
 			      len);
   bpt->n_cached = len;
@@ -714,6 +730,7 @@ vlib_buffer_pool_put (vlib_main_t * vm, u8 buffer_pool_index,
   vlib_buffer_pool_t *bp = vlib_get_buffer_pool (vm, buffer_pool_index);
   vlib_buffer_pool_thread_t *bpt = vec_elt_at_index (bp->threads,
 						     vm->thread_index);
+  const u32 n_half = VLIB_BUFFER_POOL_PER_THREAD_CACHE_SZ / 2;
   u32 n_cached, n_empty;
 
   if (CLIB_DEBUG > 0)
@@ -722,6 +739,9 @@ vlib_buffer_pool_put (vlib_main_t * vm, u8 buffer_pool_index,
   if (PREDICT_FALSE (bm->free_callback_fn != 0))
     bm->free_callback_fn (vm, buffer_pool_index, buffers, n_buffers);
 
+  if (PREDICT_FALSE (bp->numa_node != vm->numa_node))
+    bpt->n_remote_free += n_buffers;
+
   n_cached = bpt->n_cached;
   n_empty = VLIB_BUFFER_POOL_PER_THREAD_CACHE_SZ - n_cached;
   if (n_buffers <= n_empty)
@@ -734,13 +754,24 @@ vlib_buffer_pool_put (vlib_main_t * vm, u8 buffer_pool_index,
 
   vlib_buffer_copy_indices (bpt->cached_buffers + n_cached,
 			    buffers + n_buffers - n_empty, n_empty);
-  bpt->n_cached = VLIB_BUFFER_POOL_PER_THREAD_CACHE_SZ;
 
-  clib_spinlock_lock (&bp->lock);
+  /*
+   * The cache is full. Return the rest together with half of the cache,
+   * so the frees that follow, e.g. of buffers handed off from another
+   * numa node, are cached rather than each taking the pool lock.
+   */
+  vlib_buffer_pool_lock (vm, bp);
   vlib_buffer_copy_indices (bp->buffers + bp->n_avail, buffers,
 			    n_buffers - n_empty);
   bp->n_avail += n_buffers - n_empty;
+  vlib_buffer_copy_indices (bp->buffers + bp->n_avail, bpt->cached_buffers,
+			    n_half);
+  bp->n_avail += n_half;
   clib_spinlock_unlock (&bp->lock);
+
+  vlib_buffer_copy_indices (bpt->cached_buffers,
+			    bpt->cached_buffers + n_half, n_half);
+  bpt->n_cached = n_half;
 }
 
 static_always_inline void
@@ -819,7 +819,7 @@ show_memory_usage (vlib_main_t * vm,
   clib_mem_main_t *mm = &clib_mem_main;
   int verbose __attribute__ ((unused)) = 0;
   int api_segment = 0, stats_segment = 0, main_heap = 0, numa_heaps = 0;
-  int map = 0;
+  int map = 0, tags = 0, large_heaps = 0;
   clib_error_t *error;
   u32 index = 0;
   int i;
@@ -839,8 +839,12 @@ show_memory_usage (vlib_main_t * vm,
 	main_heap = 1;
       else if (unformat (input, "numa-heaps"))
 	numa_heaps = 1;
+      else if (unformat (input, "large-heaps"))
+	large_heaps = 1;
       else if (unformat (input, "map"))
 	map = 1;
+      else if (unformat (input, "tags"))
+	tags = 1;
       else
 	{
 	  error = clib_error_return (0, "unknown input `%U'",
@@ -849,10 +853,11 @@ show_memory_usage (vlib_main_t * vm,
 	}
     }
 
-  if ((api_segment + stats_segment + main_heap + numa_heaps + map) == 0)
-    return clib_error_return
-      (0, "Need one of api-segment, stats-segment, main-heap, numa-heaps "
-       "or map");
+  if ((api_segment + stats_segment + main_heap + numa_heaps + large_heaps +
+       map + tags) == 0)
+    return clib_error_return (0, "Need one of api-segment, stats-segment, "
+				 "main-heap, numa-heaps, large-heaps, map "
+				 "or tags");
 
   if (api_segment)
     {
@@ -931,6 +936,26 @@ show_memory_usage (vlib_main_t * vm,
 			     mm->per_numa_mheaps[index], verbose);
 	  }
       }
+    if (large_heaps)
+      {
+	if (mm->large_alloc_threshold == 0)
+	  vlib_cli_output (vm, "large allocations are not enabled, see "
+			       "'memory { large-alloc-threshold }'");
+	else
+	  vlib_cli_output (vm, "Large allocation threshold %U",
+			   format_memory_size, mm->large_alloc_threshold);
+
+	for (i = 0; i < ARRAY_LEN (mm->large_heaps); i++)
+	  {
+	    if (mm->large_heaps[i] == 0)
+	      continue;
+	    was_enabled = clib_mem_trace_enable_disable (0);
+	    vlib_cli_output (vm, "Numa %d:", i);
+	    vlib_cli_output (vm, "  %U\n", format_clib_mem_heap,
+			     mm->large_heaps[i], verbose);
+	    clib_mem_trace_enable_disable (was_enabled);
+	  }
+      }
     if (map)
       {
 	clib_mem_page_stats_t stats = { };
@@ -973,6 +998,16 @@ show_memory_usage (vlib_main_t * vm,
 	  }
 	vec_free (s);
       }
+    if (tags)
+      {
+	clib_mem_heap_t *h = clib_mem_get_per_cpu_heap ();
+
+	if (!(h->flags & CLIB_MEM_HEAP_F_TAGGED))
+	  vlib_cli_output (vm, "allocation tags are not enabled on the "
+			       "main heap, see 'memory { tags }'");
+	else
+	  vlib_cli_output (vm, "%U", format_clib_mem_tags, verbose);
+      }
   }
   return 0;
 }
@@ -981,7 +1016,7 @@ show_memory_usage (vlib_main_t * vm,
 VLIB_CLI_COMMAND (show_memory_usage_command, static) = {
   .path = "show memory",
   .short_help = "show memory [api-segment][stats-segment][verbose]\n"
-  "            [numa-heaps][map]",
+  "            [numa-heaps][large-heaps][map][tags]",
   .function = show_memory_usage,
 };
 /* *INDENT-ON* */
@@ -38,6 +38,7 @@
  */
 
 #include <vlib/vlib.h>
+#include <vlib/unix/plugin.h>
 #include <vppinfra/ptclosure.h>
 
 /**
@@ -337,6 +338,7 @@ call_init_exit_functions_internal (vlib_main_t *vm,
   vlib_global_main_t *vgm = vlib_get_global_main ();
   clib_error_t *error = 0;
   _vlib_init_function_list_elt_t *i;
+  u32 old_tag;
 
   if (do_sort && (error = vlib_sort_init_exit_functions (headp)))
     return (error);
@@ -360,7 +362,9 @@ call_init_exit_functions_internal (vlib_main_t *vm,
 	      else
 		hash_set1 (vm->worker_init_functions_called, i->f);
 	    }
+	  old_tag = clib_mem_set_tag (vlib_mem_tag_for_address (i->f));
 	  error = i->f (vm);
+	  clib_mem_set_tag (old_tag);
 	  if (error)
 	    return error;
 	}
@@ -428,6 +432,7 @@ vlib_call_all_config_functions (vlib_main_t * vm,
   vlib_config_function_runtime_t *c, **all;
   uword *hash = 0, *p;
   uword i;
+  u32 old_tag;
 
   hash = hash_create_string (0, sizeof (uword));
   all = 0;
@@ -473,7 +478,9 @@ vlib_call_all_config_functions (vlib_main_t * vm,
 	continue;
       hash_set1 (vgm->init_functions_called, c->function);
 
+      old_tag = clib_mem_set_tag (vlib_mem_tag_for_address (c->function));
       error = c->function (vm, &c->input);
+      clib_mem_set_tag (old_tag);
       if (error)
 	goto done;
     }
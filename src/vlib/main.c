@@ -305,6 +305,12 @@ vlib_next_frame_change_ownership (vlib_main_t * vm,
 		      next_frame - vm->node_main.next_frames;
 		  }
 	      }
+	      vec_foreach (p, nm->deferred_frames)
+		{
+		  if (p->frame == next_frame->frame)
+		    p->next_frame_index =
+		      next_frame - vm->node_main.next_frames;
+		}
 	    }
 	}
     }
@@ -1186,6 +1192,106 @@ dispatch_pending_node (vlib_main_t * vm, uword pending_frame_index,
   return last_time_stamp;
 }
 
+static_always_inline void
+vlib_node_coalesce_release (vlib_node_coalesce_t *c, u32 n_vectors, u64 now)
+{
+  u64 dt = now - c->first_deferral_time;
+
+  c->n_coalesced_calls++;
+  c->n_coalesced_vectors += n_vectors;
+  c->n_deferrals += c->n_pending_deferrals;
+  c->deferral_clocks += dt;
+  c->max_deferral_clocks = clib_max (c->max_deferral_clocks, dt);
+  c->n_pending_deferrals = 0;
+}
+
+/*
+ * Returns 1 if the pending frame is held back until a later main loop so
+ * more vectors can be added to it. Only frames which are still the open
+ * next frame of their feeding node are held back, so that later enqueues
+ * land in them without adding a new pending frame.
+ */
+static_always_inline int
+vlib_pending_frame_coalesce (vlib_main_t *vm, uword pending_frame_index,
+			     u64 now)
+{
+  vlib_node_main_t *nm = &vm->node_main;
+  vlib_pending_frame_t *p = nm->pending_frames + pending_frame_index;
+  vlib_node_runtime_t *n;
+  vlib_node_coalesce_t *c;
+  vlib_next_frame_t *nf;
+  vlib_frame_t *f;
+
+  n = vec_elt_at_index (nm->nodes_by_type[VLIB_NODE_TYPE_INTERNAL],
+			p->node_runtime_index);
+  if (!(n->flags & VLIB_NODE_FLAG_PREFERS_BATCHING))
+    return 0;
+
+  vec_validate (nm->coalesce, p->node_runtime_index);
+  c = vec_elt_at_index (nm->coalesce, p->node_runtime_index);
+  f = vlib_get_frame (vm, p->frame);
+
+  if (f->n_vectors < nm->coalesce_target_vectors &&
+      p->next_frame_index != VLIB_PENDING_FRAME_NO_NEXT_FRAME &&
+      !(f->frame_flags & VLIB_FRAME_NO_APPEND))
+    {
+      nf = vec_elt_at_index (nm->next_frames, p->next_frame_index);
+      if (nf->frame == p->frame)
+	{
+	  if (c->n_pending_deferrals == 0)
+	    c->first_deferral_time = now;
+
+	  if (c->n_pending_deferrals < nm->coalesce_max_loops &&
+	      now - c->first_deferral_time < nm->coalesce_max_clocks)
+	    {
+	      c->n_pending_deferrals++;
+	      vec_add1 (nm->deferred_frames, p[0]);
+	      return 1;
+	    }
+	}
+    }
+
+  if (c->n_pending_deferrals)
+    vlib_node_coalesce_release (c, f->n_vectors, now);
+
+  return 0;
+}
+
+/* Dispatch all frames held back */
+static u64
+dispatch_deferred_frames (vlib_main_t *vm, u64 last_time_stamp)
+{
+  vlib_node_main_t *nm = &vm->node_main;
+  vlib_pending_frame_t *p;
+  vlib_node_coalesce_t *c;
+  uword i;
+
+  vec_append (nm->pending_frames, nm->deferred_frames);
+  vec_set_len (nm->deferred_frames, 0);
+
+  vec_foreach (p, nm->pending_frames)
+    {
+      c = vec_elt_at_index (nm->coalesce, p->node_runtime_index);
+      if (c->n_pending_deferrals)
+	vlib_node_coalesce_release (c, vlib_get_frame (vm, p->frame)->n_vectors,
+				    last_time_stamp);
+    }
+
+  for (i = 0; i < _vec_len (nm->pending_frames); i++)
+    last_time_stamp = dispatch_pending_node (vm, i, last_time_stamp);
+  vec_set_len (nm->pending_frames, 0);
+
+  return last_time_stamp;
+}
+
+/* Frames must not be held back across a node graph refork, a worker
+   dispatches them before it parks at the barrier */
+void
+vlib_worker_flush_deferred_frames (vlib_main_t *vm)
+{
+  dispatch_deferred_frames (vm, clib_cpu_time_now ());
+}
+
 always_inline uword
 vlib_process_stack_is_valid (vlib_process_t * p)
 {
@@ -1514,7 +1620,7 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
 	}
 
       if (!is_main)
-	vlib_worker_thread_barrier_check ();
+	vlib_worker_thread_barrier_check_inline (1 /* from_main_loop */);
 
       if (PREDICT_FALSE (vm->check_frame_queues + frame_queue_check_counter))
 	{
@@ -1585,8 +1691,23 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
       /* Input nodes may have added work to the pending vector.
          Process pending vector until there is nothing left.
          All pending vectors will be processed from input -> output. */
-      for (i = 0; i < _vec_len (nm->pending_frames); i++)
-	cpu_time_now = dispatch_pending_node (vm, i, cpu_time_now);
+      if (PREDICT_FALSE (nm->coalesce_target_vectors |
+			 vec_len (nm->deferred_frames)))
+	{
+	  /* frames held back on the previous loop go first */
+	  if (vec_len (nm->deferred_frames))
+	    {
+	      vec_insert_elts (nm->pending_frames, nm->deferred_frames,
+			       vec_len (nm->deferred_frames), 0);
+	      vec_set_len (nm->deferred_frames, 0);
+	    }
+	  for (i = 0; i < _vec_len (nm->pending_frames); i++)
+	    if (!vlib_pending_frame_coalesce (vm, i, cpu_time_now))
+	      cpu_time_now = dispatch_pending_node (vm, i, cpu_time_now);
+	}
+      else
+	for (i = 0; i < _vec_len (nm->pending_frames); i++)
+	  cpu_time_now = dispatch_pending_node (vm, i, cpu_time_now);
       /* Reset pending vector for next iteration. */
       vec_set_len (nm->pending_frames, 0);
 
@@ -1635,6 +1756,11 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
 	    {
 	      uword i;
 
+	      /* processes, e.g. the CLI, may run for long, frames held
+		 back must not wait for them */
+	      if (vec_len (nm->deferred_frames))
+		cpu_time_now = dispatch_deferred_frames (vm, cpu_time_now);
+
 	      for (i = 0; i < _vec_len (nm->data_from_advancing_timing_wheel);
 		   i++)
 		{
@@ -130,6 +130,12 @@ vlib_node_runtime_update (vlib_main_t * vm, u32 node_index, u32 next_index)
 	    && pf->next_frame_index >= i)
 	  pf->next_frame_index += n_insert;
       }
+      vec_foreach (pf, nm->deferred_frames)
+	{
+	  if (pf->next_frame_index != VLIB_PENDING_FRAME_NO_NEXT_FRAME &&
+	      pf->next_frame_index >= i)
+	    pf->next_frame_index += n_insert;
+	}
       /* *INDENT-OFF* */
       pool_foreach (pf, nm->suspended_process_frames)  {
 	  if (pf->next_frame_index != ~0 && pf->next_frame_index >= i)
@@ -893,6 +899,41 @@ vlib_node_set_march_variant (vlib_main_t *vm, u32 node_index,
     }
   return -1;
 }
+
+void
+vlib_node_set_coalesce (vlib_main_t *vm, u32 target_vectors, u32 max_loops,
+			u32 max_usec)
+{
+  u64 max_clocks = max_usec * 1e-6 * vm->clib_time.clocks_per_second;
+
+  for (int i = 0; i < vlib_get_n_threads (); i++)
+    {
+      vlib_node_main_t *nm = &vlib_get_main_by_index (i)->node_main;
+      nm->coalesce_target_vectors = clib_min (target_vectors, VLIB_FRAME_SIZE);
+      nm->coalesce_max_loops = max_loops;
+      nm->coalesce_max_usec = max_usec;
+      nm->coalesce_max_clocks = max_clocks;
+    }
+}
+
+void
+vlib_node_set_prefers_batching (vlib_main_t *vm, u32 node_index, int enable)
+{
+  for (int i = 0; i < vlib_get_n_threads (); i++)
+    {
+      vlib_main_t *ovm = vlib_get_main_by_index (i);
+      vlib_node_t *n = vlib_get_node (ovm, node_index);
+      vlib_node_runtime_t *nrt = vlib_node_get_runtime (ovm, node_index);
+
+      if (enable)
+	n->flags |= VLIB_NODE_FLAG_PREFERS_BATCHING;
+      else
+	n->flags &= ~VLIB_NODE_FLAG_PREFERS_BATCHING;
+      nrt->flags = (nrt->flags & ~VLIB_NODE_FLAG_PREFERS_BATCHING) |
+		   (n->flags & VLIB_NODE_FLAG_PREFERS_BATCHING);
+    }
+}
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
@@ -297,6 +297,10 @@ typedef struct vlib_node_t
 #define VLIB_NODE_FLAG_TRACE_SUPPORTED (1 << 8)
 #define VLIB_NODE_FLAG_ADAPTIVE_MODE			     (1 << 9)
 
+  /* Internal node which amortizes per-call costs over the frame, small
+     frames may be held back for a few main loops to let them fill up. */
+#define VLIB_NODE_FLAG_PREFERS_BATCHING (1 << 10)
+
   /* State for input nodes. */
   u8 state;
 
@@ -454,6 +458,27 @@ typedef struct
 #define VLIB_PENDING_FRAME_NO_NEXT_FRAME ((u32) ~0)
 } vlib_pending_frame_t;
 
+/* Per node frame coalescing state and accounting. */
+typedef struct
+{
+  /* CPU time when the frames currently held back were first deferred. */
+  u64 first_deferral_time;
+
+  /* Number of times frames have been held back since last dispatch. */
+  u32 n_pending_deferrals;
+
+  /* Dispatches of frames which were held back at least once. */
+  u64 n_coalesced_calls;
+  u64 n_coalesced_vectors;
+
+  /* Total times frames were held back. */
+  u64 n_deferrals;
+
+  /* Latency added by holding frames back, in clocks. */
+  u64 deferral_clocks;
+  u64 max_deferral_clocks;
+} vlib_node_coalesce_t;
+
 typedef struct vlib_node_runtime_t
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);	/**< cacheline mark */
@@ -701,6 +726,21 @@ typedef struct
   /* Vector of internal node's frames waiting to be called. */
   vlib_pending_frame_t *pending_frames;
 
+  /* Frame coalescing. Pending frames of nodes flagged
+     VLIB_NODE_FLAG_PREFERS_BATCHING holding fewer than target vectors
+     are held back for up to max loops or max clocks, whichever comes
+     first. Disabled when coalesce_target_vectors is zero. */
+  u16 coalesce_target_vectors;
+  u16 coalesce_max_loops;
+  u32 coalesce_max_usec;
+  u64 coalesce_max_clocks;
+
+  /* Frames held back, dispatched ahead of new work on next main loop. */
+  vlib_pending_frame_t *deferred_frames;
+
+  /* Coalescing state, indexed by internal node runtime index. */
+  vlib_node_coalesce_t *coalesce;
+
   /* Timing wheel for scheduling time-based node dispatch. */
   void *timing_wheel;
 
@@ -916,6 +916,200 @@ VLIB_CLI_COMMAND (set_node_fn_command, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+set_node_coalesce (vlib_main_t *vm, unformat_input_t *input,
+		   vlib_cli_command_t *cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vlib_node_main_t *nm = &vm->node_main;
+  u32 target_vectors = nm->coalesce_target_vectors;
+  u32 max_loops = nm->coalesce_max_loops ? nm->coalesce_max_loops : 4;
+  u32 max_usec = nm->coalesce_max_usec ? nm->coalesce_max_usec : 100;
+  u32 node_index = ~0;
+  int enable = 1;
+  clib_error_t *err = 0;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "target-vectors %u", &target_vectors))
+	;
+      else if (unformat (line_input, "max-loops %u", &max_loops))
+	;
+      else if (unformat (line_input, "max-usec %u", &max_usec))
+	;
+      else if (unformat (line_input, "disable"))
+	enable = 0;
+      else if (unformat (line_input, "%U", unformat_vlib_node, vm,
+			 &node_index))
+	;
+      else
+	{
+	  err = clib_error_return (0, "unknown input '%U'",
+				   format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (node_index != ~0)
+    {
+      if (vlib_get_node (vm, node_index)->type != VLIB_NODE_TYPE_INTERNAL)
+	{
+	  err = clib_error_return (0, "only internal nodes can be coalesced");
+	  goto done;
+	}
+      vlib_worker_thread_barrier_sync (vm);
+      vlib_node_set_prefers_batching (vm, node_index, enable);
+      vlib_worker_thread_barrier_release (vm);
+      goto done;
+    }
+
+  if (!enable)
+    target_vectors = 0;
+  else if (target_vectors == 0)
+    {
+      err = clib_error_return (0, "please specify target-vectors");
+      goto done;
+    }
+  else if (max_loops > 0xffff)
+    {
+      err = clib_error_return (0, "max-loops must be at most 65535");
+      goto done;
+    }
+
+  vlib_worker_thread_barrier_sync (vm);
+  vlib_node_set_coalesce (vm, target_vectors, max_loops, max_usec);
+  vlib_worker_thread_barrier_release (vm);
+
+done:
+  unformat_free (line_input);
+  return err;
+}
+
+/*?
+ * Hold back small frames of internal nodes which prefer batching, so
+ * that per call costs are spread over more packets when the vector rate
+ * is low. A frame is held back on each main loop while it has fewer
+ * than target-vectors packets, for at most max-loops (up to 65535) main
+ * loops and max-usec microseconds. The time is checked once per main
+ * loop, so max-usec is a best effort bound rather than a hard latency
+ * budget. With a node name, marks that node as preferring batching, or
+ * clears the mark with disable.
+ *
+ * @cliexpar
+ * @cliexcmd{set node coalesce target-vectors 64 max-loops 4 max-usec 50}
+ * @cliexcmd{set node coalesce ip4-lookup}
+ * @cliexcmd{set node coalesce disable}
+?*/
+VLIB_CLI_COMMAND (set_node_coalesce_command, static) = {
+  .path = "set node coalesce",
+  .short_help = "set node coalesce [target-vectors <n>] [max-loops <n>] "
+		"[max-usec <n>] [<node-name>] [disable]",
+  .function = set_node_coalesce,
+};
+
+static clib_error_t *
+show_node_coalesce (vlib_main_t *vm, unformat_input_t *input,
+		    vlib_cli_command_t *cmd)
+{
+  vlib_node_main_t *nm = &vm->node_main;
+  vlib_node_runtime_t *rt;
+  vlib_node_coalesce_t *c;
+  f64 us_per_clock = 1e6 * vm->clib_time.seconds_per_clock;
+
+  if (nm->coalesce_target_vectors)
+    vlib_cli_output (vm,
+		     "target %u vectors, held back at most %u loops "
+		     "or %u usec",
+		     nm->coalesce_target_vectors, nm->coalesce_max_loops,
+		     nm->coalesce_max_usec);
+  else
+    vlib_cli_output (vm, "frame coalescing disabled");
+
+  foreach_vlib_main ()
+    {
+      vlib_node_main_t *tnm = &this_vlib_main->node_main;
+      int header = 0;
+
+      vec_foreach (rt, tnm->nodes_by_type[VLIB_NODE_TYPE_INTERNAL])
+	{
+	  u32 ri = rt - tnm->nodes_by_type[VLIB_NODE_TYPE_INTERNAL];
+
+	  if (!(rt->flags & VLIB_NODE_FLAG_PREFERS_BATCHING))
+	    continue;
+
+	  if (!header)
+	    {
+	      vlib_cli_output (vm, "\nThread %u %U", this_vlib_main->thread_index,
+			       format_vlib_thread_name,
+			       this_vlib_main->thread_index);
+	      vlib_cli_output (vm, "%-30s%14s%14s%14s%14s%14s", "Name",
+			       "Coalesced", "Deferrals", "Vectors/Call",
+			       "Avg-usec", "Max-usec");
+	      header = 1;
+	    }
+
+	  c = ri < vec_len (tnm->coalesce) ? tnm->coalesce + ri : 0;
+	  if (!c || !c->n_coalesced_calls)
+	    {
+	      vlib_cli_output (vm, "%-30U%14u", format_vlib_node_name, vm,
+			       rt->node_index, 0);
+	      continue;
+	    }
+	  vlib_cli_output (
+	    vm, "%-30U%14llu%14llu%14.2f%14.2f%14.2f", format_vlib_node_name,
+	    vm, rt->node_index, c->n_coalesced_calls, c->n_deferrals,
+	    (f64) c->n_coalesced_vectors / c->n_coalesced_calls,
+	    c->deferral_clocks * us_per_clock / c->n_coalesced_calls,
+	    c->max_deferral_clocks * us_per_clock);
+	}
+    }
+
+  return 0;
+}
+
+/*?
+ * Show, per thread, the nodes which prefer batching, how often their
+ * frames were held back and the latency this added. Vectors/Call is
+ * the average frame size of dispatches that were held back first.
+?*/
+VLIB_CLI_COMMAND (show_node_coalesce_command, static) = {
+  .path = "show node coalesce",
+  .short_help = "show node coalesce",
+  .function = show_node_coalesce,
+  .is_mp_safe = 1,
+};
+
+static clib_error_t *
+clear_node_coalesce (vlib_main_t *vm, unformat_input_t *input,
+		     vlib_cli_command_t *cmd)
+{
+  vlib_node_coalesce_t *c;
+
+  vlib_worker_thread_barrier_sync (vm);
+  foreach_vlib_main ()
+    vec_foreach (c, this_vlib_main->node_main.coalesce)
+      {
+	u64 first_deferral_time = c->first_deferral_time;
+	u32 n_pending_deferrals = c->n_pending_deferrals;
+
+	clib_memset (c, 0, sizeof (c[0]));
+	c->first_deferral_time = first_deferral_time;
+	c->n_pending_deferrals = n_pending_deferrals;
+      }
+  vlib_worker_thread_barrier_release (vm);
+
+  return 0;
+}
+
+VLIB_CLI_COMMAND (clear_node_coalesce_command, static) = {
+  .path = "clear node coalesce",
+  .short_help = "clear node coalesce",
+  .function = clear_node_coalesce,
+};
+
 /* Dummy function to get us linked in. */
 void
 vlib_node_cli_reference (void)
@@ -1277,6 +1277,22 @@ vlib_node_function_t *
 vlib_node_get_preferred_node_fn_variant (vlib_main_t *vm,
 					 vlib_node_fn_registration_t *regs);
 
+/** \brief Set the frame coalescing policy on all threads
+    Frames of internal nodes flagged VLIB_NODE_FLAG_PREFERS_BATCHING
+    holding fewer than target_vectors are held back for up to max_loops
+    main loops or max_usec microseconds.
+    @param target_vectors frame size to coalesce towards, 0 disables
+    @warning call only on the main thread. Barrier sync required
+*/
+void vlib_node_set_coalesce (vlib_main_t *vm, u32 target_vectors,
+			     u32 max_loops, u32 max_usec);
+
+/** \brief Set or clear VLIB_NODE_FLAG_PREFERS_BATCHING on a node
+    @warning call only on the main thread. Barrier sync required
+*/
+void vlib_node_set_prefers_batching (vlib_main_t *vm, u32 node_index,
+				     int enable);
+
 /*
  * vlib_frame_bitmap functions
  */
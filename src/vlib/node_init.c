@@ -47,8 +47,10 @@ vlib_node_config (vlib_main_t *vm, unformat_input_t *input)
   clib_error_t *error = 0;
   unformat_input_t sub_input;
   u32 *march_variant_by_node = 0;
+  u32 *batching_nodes = 0;
   clib_march_variant_type_t march_variant;
   u32 node_index;
+  u32 target_vectors = 0, max_loops = 4, max_usec = 100;
   int i;
 
   /* specify prioritization defaults for all graph nodes */
@@ -72,6 +74,26 @@ vlib_node_config (vlib_main_t *vm, unformat_input_t *input)
 	      unformat_free (&sub_input);
 	    }
 	}
+      else if (unformat (input, "coalesce %U", unformat_vlib_cli_sub_input,
+			 &sub_input))
+	{
+	  while (unformat_check_input (&sub_input) != UNFORMAT_END_OF_INPUT)
+	    {
+	      if (unformat (&sub_input, "target-vectors %u", &target_vectors))
+		;
+	      else if (unformat (&sub_input, "max-loops %u", &max_loops))
+		;
+	      else if (unformat (&sub_input, "max-usec %u", &max_usec))
+		;
+	      else
+		return clib_error_return (0, "unknown input '%U'",
+					  format_unformat_error, &sub_input);
+	    }
+	  unformat_free (&sub_input);
+	  if (max_loops > 0xffff)
+	    return clib_error_return (0, "coalesce max-loops must be at most "
+					 "65535");
+	}
       else /* specify prioritization for an individual graph node */
 	if (unformat (input, "%U", unformat_vlib_node, vm, &node_index))
 	{
@@ -80,6 +102,11 @@ vlib_node_config (vlib_main_t *vm, unformat_input_t *input)
 	      while (unformat_check_input (&sub_input) !=
 		     UNFORMAT_END_OF_INPUT)
 		{
+		  if (unformat (&sub_input, "prefers-batching"))
+		    {
+		      vec_add1 (batching_nodes, node_index);
+		      continue;
+		    }
 		  if (!unformat (&sub_input, "variant %U",
 				 unformat_vlib_node_variant, &march_variant))
 		    return clib_error_return (0,
@@ -104,6 +131,14 @@ vlib_node_config (vlib_main_t *vm, unformat_input_t *input)
 	  vlib_node_set_march_variant (vm, i, march_variant_by_node[i]);
       vec_free (march_variant_by_node);
     }
+
+  vec_foreach_index (i, batching_nodes)
+    vlib_node_set_prefers_batching (vm, batching_nodes[i], 1);
+  vec_free (batching_nodes);
+
+  if (target_vectors)
+    vlib_node_set_coalesce (vm, target_vectors, max_loops, max_usec);
+
   unformat_free (input);
 
   return error;
@@ -17,22 +17,15 @@ enum
   STAT_MEM_TOTAL_ALLOC,
   STAT_MEM_FREE_CHUNKS,
   STAT_MEM_RELEASABLE,
+  STAT_MEM_PAGE_SIZE,
 } stat_mem_usage_e;
 
-/*
- * Called from the stats periodic process to update memory counters.
- */
 static void
-stat_provider_mem_usage_update_fn (vlib_stats_collector_data_t *d)
+stat_provider_mem_heap_usage (clib_mem_heap_t *heap, counter_t *cb)
 {
   clib_mem_usage_t usage;
-  clib_mem_heap_t *heap;
-  counter_t **counters = d->entry->data;
-  counter_t *cb;
 
-  heap = vec_elt (memory_heaps_vec, d->private_data);
   clib_mem_get_heap_usage (heap, &usage);
-  cb = counters[0];
   cb[STAT_MEM_TOTAL] = usage.bytes_total;
   cb[STAT_MEM_USED] = usage.bytes_used;
   cb[STAT_MEM_FREE] = usage.bytes_free;
@@ -40,28 +33,197 @@ stat_provider_mem_usage_update_fn (vlib_stats_collector_data_t *d)
   cb[STAT_MEM_TOTAL_ALLOC] = usage.bytes_max;
   cb[STAT_MEM_FREE_CHUNKS] = usage.bytes_free_reclaimed;
   cb[STAT_MEM_RELEASABLE] = usage.bytes_overhead;
+  cb[STAT_MEM_PAGE_SIZE] =
+    heap->log2_page_sz == CLIB_MEM_PAGE_SZ_UNKNOWN ?
+      0 :
+      clib_mem_page_bytes (heap->log2_page_sz);
+}
+
+static u32
+stat_provider_mem_heap_add_entry (clib_mem_heap_t *heap)
+{
+  u32 idx;
+
+  idx = vlib_stats_add_counter_vector ("/mem/%s", heap->name);
+  vlib_stats_validate (idx, 0, STAT_MEM_PAGE_SIZE);
+
+  /* Create symlink */
+  vlib_stats_add_symlink (idx, STAT_MEM_USED, "/mem/%s/used", heap->name);
+  vlib_stats_add_symlink (idx, STAT_MEM_TOTAL, "/mem/%s/total", heap->name);
+  vlib_stats_add_symlink (idx, STAT_MEM_FREE, "/mem/%s/free", heap->name);
+  vlib_stats_add_symlink (idx, STAT_MEM_PAGE_SIZE, "/mem/%s/page-size",
+			  heap->name);
+  return idx;
+}
+
+/*
+ * Called from the stats periodic process to update memory counters.
+ */
+static void
+stat_provider_mem_usage_update_fn (vlib_stats_collector_data_t *d)
+{
+  counter_t **counters = d->entry->data;
+
+  stat_provider_mem_heap_usage (vec_elt (memory_heaps_vec, d->private_data),
+				counters[0]);
+}
+
+/* stats entries of the per NUMA large allocation heaps, once created */
+static u32 mem_large_heap_entries[CLIB_MAX_NUMAS];
+
+/*
+ * Large heaps are created by the first large allocation on each NUMA
+ * node, so they are picked up here rather than registered up front.
+ */
+static void
+stat_provider_mem_large_heaps_update_fn (vlib_stats_collector_data_t *d)
+{
+  clib_mem_main_t *mm = &clib_mem_main;
+  clib_mem_heap_t *heap;
+  counter_t **counters;
+  int i;
+
+  for (i = 0; i < ARRAY_LEN (mm->large_heaps); i++)
+    {
+      if ((heap = clib_atomic_load_acq_n (&mm->large_heaps[i])) == 0)
+	continue;
+
+      if (mem_large_heap_entries[i] == ~0)
+	{
+	  vlib_stats_segment_lock ();
+	  mem_large_heap_entries[i] = stat_provider_mem_heap_add_entry (heap);
+	  vlib_stats_segment_unlock ();
+	}
+
+      counters = vlib_stats_get_entry_data_pointer (mem_large_heap_entries[i]);
+      stat_provider_mem_heap_usage (heap, counters[0]);
+    }
+}
+
+static void
+vlib_stats_register_mem_large_heaps (void)
+{
+  vlib_stats_collector_reg_t r = {};
+
+  clib_memset_u32 (mem_large_heap_entries, ~0,
+		   ARRAY_LEN (mem_large_heap_entries));
+
+  r.entry_index = vlib_stats_add_gauge ("/mem/large-alloc-threshold");
+  vlib_stats_set_gauge (r.entry_index, clib_mem_main.large_alloc_threshold);
+  r.collect_fn = stat_provider_mem_large_heaps_update_fn;
+  vlib_stats_register_collector_fn (&r);
+}
+
+enum
+{
+  STAT_MEM_TAG_BYTES = 0,
+  STAT_MEM_TAG_OBJECTS,
+  STAT_MEM_TAG_ALLOCS,
+  STAT_MEM_TAG_N_COUNTERS,
+};
+
+static struct
+{
+  u32 entry_index;
+  char *name;
+} mem_tag_counters[] = {
+  [STAT_MEM_TAG_BYTES] = { .name = "bytes" },
+  [STAT_MEM_TAG_OBJECTS] = { .name = "objects" },
+  [STAT_MEM_TAG_ALLOCS] = { .name = "allocs" },
+};
+
+/* number of tags the entries are sized for and symlinked */
+static u32 mem_tags_n_exported;
+
+/*
+ * Called from the stats periodic process to update allocation tag
+ * counters, tags are created at any time so new ones are added here.
+ */
+static void
+stat_provider_mem_tags_update_fn (vlib_stats_collector_data_t *d)
+{
+  clib_mem_main_t *mm = &clib_mem_main;
+  u32 n_tags = clib_atomic_load_acq_n (&mm->n_tags);
+  counter_t *c[STAT_MEM_TAG_N_COUNTERS];
+  counter_t **counters;
+  int i, j;
+
+  if (n_tags > mem_tags_n_exported)
+    {
+      vlib_stats_segment_lock ();
+      for (j = 0; j < STAT_MEM_TAG_N_COUNTERS; j++)
+	vlib_stats_validate (mem_tag_counters[j].entry_index, 0, n_tags - 1);
+
+      /* tag 0 collects nothing, untagged usage is in the heap counters */
+      for (i = clib_max (mem_tags_n_exported, 1); i < n_tags; i++)
+	for (j = 0; j < STAT_MEM_TAG_N_COUNTERS; j++)
+	  vlib_stats_add_symlink (mem_tag_counters[j].entry_index, i,
+				  "/mem/tags/%s/%s", mm->tags[i].name,
+				  mem_tag_counters[j].name);
+      vlib_stats_segment_unlock ();
+      mem_tags_n_exported = n_tags;
+    }
+
+  for (j = 0; j < STAT_MEM_TAG_N_COUNTERS; j++)
+    {
+      counters =
+	vlib_stats_get_entry_data_pointer (mem_tag_counters[j].entry_index);
+      c[j] = counters[0];
+    }
+
+  for (i = 1; i < n_tags; i++)
+    {
+      clib_mem_tag_counters_t tc;
+      clib_mem_tag_get_counters (i, &tc);
+      c[STAT_MEM_TAG_BYTES][i] = tc.n_bytes;
+      c[STAT_MEM_TAG_OBJECTS][i] = tc.n_objects;
+      c[STAT_MEM_TAG_ALLOCS][i] = tc.n_allocs;
+    }
+}
+
+static void
+vlib_stats_register_mem_tags (void)
+{
+  vlib_stats_collector_reg_t r = {};
+  int j;
+
+  for (j = 0; j < STAT_MEM_TAG_N_COUNTERS; j++)
+    mem_tag_counters[j].entry_index =
+      vlib_stats_add_counter_vector ("/mem/tags/%s", mem_tag_counters[j].name);
+
+  r.entry_index = mem_tag_counters[STAT_MEM_TAG_BYTES].entry_index;
+  r.collect_fn = stat_provider_mem_tags_update_fn;
+  vlib_stats_register_collector_fn (&r);
 }
 
 /*
  * Provide memory heap counters.
  * Two dimensional array of heap index and per-heap gauges.
+ * Allocation tag and large heap counters are provided once the first
+ * heap with tags or large allocations enabled is registered.
  */
 void
 vlib_stats_register_mem_heap (clib_mem_heap_t *heap)
 {
+  static int mem_tags_registered, mem_large_heaps_registered;
   vlib_stats_collector_reg_t r = {};
-  u32 idx;
 
-  vec_add1 (memory_heaps_vec, heap);
+  if ((heap->flags & CLIB_MEM_HEAP_F_TAGGED) && !mem_tags_registered)
+    {
+      vlib_stats_register_mem_tags ();
+      mem_tags_registered = 1;
+    }
 
-  r.entry_index = idx = vlib_stats_add_counter_vector ("/mem/%s", heap->name);
-  vlib_stats_validate (idx, 0, STAT_MEM_RELEASABLE);
+  if ((heap->flags & CLIB_MEM_HEAP_F_LARGE_ALLOC) &&
+      !mem_large_heaps_registered)
+    {
+      vlib_stats_register_mem_large_heaps ();
+      mem_large_heaps_registered = 1;
+    }
 
-  /* Create symlink */
-  vlib_stats_add_symlink (idx, STAT_MEM_USED, "/mem/%s/used", heap->name);
-  vlib_stats_add_symlink (idx, STAT_MEM_TOTAL, "/mem/%s/total", heap->name);
-  vlib_stats_add_symlink (idx, STAT_MEM_FREE, "/mem/%s/free", heap->name);
+  vec_add1 (memory_heaps_vec, heap);
 
+  r.entry_index = stat_provider_mem_heap_add_entry (heap);
   r.private_data = vec_len (memory_heaps_vec) - 1;
   r.collect_fn = stat_provider_mem_usage_update_fn;
   vlib_stats_register_collector_fn (&r);
@@ -529,6 +529,56 @@ vlib_stats_add_symlink (u32 entry_index, u32 vector_index, char *fmt, ...)
   return vector_index;
 }
 
+u32 *
+vlib_stats_add_histogram (u32 n_buckets, char *unit, char *fmt, ...)
+{
+  u32 *bucket_entries = 0;
+  va_list va;
+  u8 *name;
+  u32 i;
+
+  va_start (va, fmt);
+  name = va_format (0, fmt, &va);
+  va_end (va);
+
+  for (i = 0; i < n_buckets; i++)
+    if (i < n_buckets - 1)
+      vec_add1 (bucket_entries,
+		vlib_stats_add_counter_vector ("%v/lt-%llu%s", name, 1ULL << i,
+					       unit));
+    else
+      vec_add1 (bucket_entries,
+		vlib_stats_add_counter_vector ("%v/lt-inf", name));
+
+  vec_free (name);
+  return bucket_entries;
+}
+
+void
+vlib_stats_add_histogram_symlinks (u32 *bucket_entries, u32 vector_index,
+				   char *fmt, ...)
+{
+  vlib_stats_segment_t *sm = vlib_stats_get_segment ();
+  vlib_stats_entry_t *e;
+  va_list va;
+  u8 *name;
+  u32 *ei;
+
+  va_start (va, fmt);
+  name = va_format (0, fmt, &va);
+  va_end (va);
+
+  /* the symlinks take the bucket suffix of the entries they point to */
+  vec_foreach (ei, bucket_entries)
+    {
+      e = vlib_stats_get_entry (sm, ei[0]);
+      vlib_stats_add_symlink (ei[0], vector_index, "%v%s", name,
+			      strrchr (e->name, '/'));
+    }
+
+  vec_free (name);
+}
+
 void
 vlib_stats_rename_symlink (u64 entry_index, char *fmt, ...)
 {
@@ -150,6 +150,13 @@ void vlib_stats_free_string_vector (vlib_stats_string_vector_t *sv);
 u32 vlib_stats_add_symlink (u32 entry_index, u32 vector_index, char *fmt, ...);
 void vlib_stats_rename_symlink (u64 entry_index, char *fmt, ...);
 
+/* log2 histogram, one counter vector per bucket, <name>/lt-<2^n><unit>,
+ * indexed like the objects it describes; bucket n counts values below 2^n
+ * units and the last one, <name>/lt-inf, everything above */
+u32 *vlib_stats_add_histogram (u32 n_buckets, char *unit, char *fmt, ...);
+void vlib_stats_add_histogram_symlinks (u32 *bucket_entries, u32 vector_index,
+					char *fmt, ...);
+
 /* common to all types */
 void vlib_stats_validate (u32 entry_index, ...);
 int vlib_stats_validate_will_expand (u32 entry_index, ...);
@@ -663,6 +663,8 @@ start_workers (vlib_main_t * vm)
 	      nm_clone->pending_frames = 0;
 	      vec_validate (nm_clone->pending_frames, 10);
 	      vec_set_len (nm_clone->pending_frames, 0);
+	      nm_clone->deferred_frames = 0;
+	      nm_clone->coalesce = 0;
 
 	      /* fork nodes */
 	      nm_clone->nodes = 0;
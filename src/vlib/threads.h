@@ -184,6 +184,7 @@ void vlib_worker_thread_barrier_sync_int (vlib_main_t * vm,
 					  const char *func_name);
 void vlib_worker_thread_barrier_release (vlib_main_t * vm);
 u8 vlib_worker_thread_barrier_held (void);
+void vlib_worker_flush_deferred_frames (vlib_main_t *vm);
 void vlib_worker_thread_initial_barrier_sync_and_release (vlib_main_t * vm);
 void vlib_worker_thread_node_refork (void);
 /**
@@ -346,15 +347,26 @@ vlib_get_current_worker_index ()
   return vlib_get_thread_index () - 1;
 }
 
+/*
+ * from_main_loop is set when called between node dispatches, where the
+ * frames held back for coalescing can be dispatched before parking, so
+ * that they do not outlive a node graph refork.
+ */
 static inline void
-vlib_worker_thread_barrier_check (void)
+vlib_worker_thread_barrier_check_inline (int from_main_loop)
 {
   if (PREDICT_FALSE (*vlib_worker_threads->wait_at_barrier))
     {
       vlib_global_main_t *vgm = vlib_get_global_main ();
       vlib_main_t *vm = vlib_get_main ();
       u32 thread_index = vm->thread_index;
-      f64 t = vlib_time_now (vm);
+      f64 t;
+
+      if (from_main_loop &&
+	  PREDICT_FALSE (vec_len (vm->node_main.deferred_frames) != 0))
+	vlib_worker_flush_deferred_frames (vm);
+
+      t = vlib_time_now (vm);
 
       if (PREDICT_FALSE (vec_len (vm->barrier_perf_callbacks) != 0))
 	clib_call_callbacks (vm->barrier_perf_callbacks, vm,
@@ -463,6 +475,12 @@ vlib_worker_thread_barrier_check (void)
     }
 }
 
+static inline void
+vlib_worker_thread_barrier_check (void)
+{
+  vlib_worker_thread_barrier_check_inline (0 /* from_main_loop */);
+}
+
 always_inline vlib_main_t *
 vlib_get_worker_vlib_main (u32 worker_index)
 {
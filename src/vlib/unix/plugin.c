@@ -17,6 +17,7 @@
 
 #include <vlib/unix/plugin.h>
 #include <vppinfra/elf.h>
+#define __USE_GNU
 #include <dlfcn.h>
 #include <dirent.h>
 
@@ -48,6 +49,42 @@ vlib_get_plugin_symbol (char *plugin_name, char *symbol_name)
   return dlsym (pi->handle, symbol_name);
 }
 
+/*
+ * Allocation tag of a plugin or library, named after the shared object
+ * file without its version suffix, e.g. "acl_plugin.so" or "libvnet.so".
+ * Untagged unless the current heap has tags enabled.
+ */
+static u32
+vlib_mem_tag_for_file (const char *path)
+{
+  const char *name, *so;
+  uword len;
+
+  if (!(clib_mem_get_heap ()->flags & CLIB_MEM_HEAP_F_TAGGED) || !path)
+    return CLIB_MEM_TAG_NONE;
+
+  name = strrchr (path, '/');
+  name = name ? name + 1 : path;
+  so = strstr (name, ".so");
+  len = so ? so - name + 3 : strlen (name);
+
+  return clib_mem_tag_get_or_create ("%U", format_ascii_bytes, name, len);
+}
+
+u32
+vlib_mem_tag_for_address (void *addr)
+{
+  Dl_info info;
+
+  if (!(clib_mem_get_heap ()->flags & CLIB_MEM_HEAP_F_TAGGED))
+    return CLIB_MEM_TAG_NONE;
+
+  if (dladdr (addr, &info) == 0)
+    return CLIB_MEM_TAG_NONE;
+
+  return vlib_mem_tag_for_file (info.dli_fname);
+}
+
 static char *
 str_array_to_vec (char *array, int len)
 {
@@ -169,6 +206,7 @@ load_one_plugin (plugin_main_t * pm, plugin_info_t * pi, int from_early_init)
   vlib_plugin_r2_t *r2;
   plugin_config_t *pc = 0;
   uword *p;
+  u32 old_tag;
 
   if (elf_read_file (&em, (char *) pi->filename))
     return -1;
@@ -306,8 +344,11 @@ process_reg:
     }
   vec_free (version_required);
 
+  /* charge allocations made by the plugin's constructors to the plugin */
+  old_tag = clib_mem_set_tag (vlib_mem_tag_for_file ((char *) pi->filename));
   handle = dlopen ((char *) pi->filename,
 		   RTLD_LAZY | (reg->deep_bind ? RTLD_DEEPBIND : 0));
+  clib_mem_set_tag (old_tag);
 
   if (handle == 0)
     {
@@ -334,7 +375,9 @@ process_reg:
       if (h)
 	{
 	  ei = h;
+	  old_tag = clib_mem_set_tag (vlib_mem_tag_for_address (h));
 	  error = (*ei) (pm->vlib_main);
+	  clib_mem_set_tag (old_tag);
 	  if (error)
 	    {
 	      u8 *err = format (0, "%s: %U%c", pi->name,
@@ -72,6 +72,25 @@ typedef struct vl_api_registration_
   u8 *output_vector;		/**< Socket only: output vector */
   int *additional_fds_to_close;
 
+  /* socket server only: per-client counters */
+  f64 time_connected;		/**< Socket only: time of accept */
+  u64 n_rx_msgs;		/**< Socket only: messages received */
+  u64 n_tx_msgs;		/**< Socket only: messages sent */
+  u64 n_reads;			/**< Socket only: read system calls */
+  u64 n_writes;			/**< Socket only: write system calls */
+  f64 queue_delay_sum;		/**< Socket only: read to handler delay */
+  f64 queue_delay_max;		/**< Socket only: worst delay seen */
+  u64 n_turns;			/**< Socket only: turns at the handlers */
+
+  /* socket server only: messages waiting for the client's turn */
+  u8 *rx_pending;		/**< Socket only: unhandled messages */
+  u32 rx_pending_offset;	/**< Socket only: next one to handle */
+  f64 rx_pending_time;		/**< Socket only: when they were read */
+
+  /* socket server only: replies written from their own buffers */
+  u8 **tx_msgs;			/**< Socket only: replies to writev */
+  u32 tx_msgs_bytes;		/**< Socket only: bytes in tx_msgs */
+
   /* socket client only */
   u32 server_handle;		/**< Socket client only: server handle */
   u32 server_index;		/**< Socket client only: server index */
@@ -223,6 +242,20 @@ typedef struct
   char name[64];
 } api_version_t;
 
+#define VL_API_HANDLER_STATS_N_BUCKETS 32
+
+/** Handler profile of one message, times in cpu clocks */
+typedef struct
+{
+  u64 calls;
+  u64 clocks;
+  u64 max_clocks;
+  /** time the worker barrier was held, including the handler */
+  u64 barrier_clocks;
+  /** calls by handler time, bucket n counts times below 2^n clocks */
+  u32 hist[VL_API_HANDLER_STATS_N_BUCKETS];
+} vl_api_msg_handler_stats_t;
+
 typedef struct
 {
   /** Message handler vector  */
@@ -262,6 +295,12 @@ typedef struct
   u8 trace_enable : 1;	 /**< trace this message  */
   u8 replay_allowed : 1; /**< This message can be replayed  */
 
+  /** Handler profile, always collected */
+  vl_api_msg_handler_stats_t handler_stats;
+
+  /** Memory allocation tag of the registering module, set while the
+   * handler runs */
+  u32 mem_tag;
 } vl_api_msg_data_t;
 
 /** API main structure, used by both vpp and binary API clients */
@@ -415,6 +454,22 @@ vl_api_get_msg_data (api_main_t *am, u32 msg_id)
   return am->msg_data + msg_id;
 }
 
+always_inline void
+vl_msg_api_handler_stats_update (vl_api_msg_handler_stats_t *hs, u64 clocks,
+				 u64 barrier_clocks)
+{
+  u32 bucket;
+
+  bucket = clocks ? min_log2 (clocks) + 1 : 0;
+  bucket = clib_min (bucket, VL_API_HANDLER_STATS_N_BUCKETS - 1);
+
+  hs->calls++;
+  hs->clocks += clocks;
+  hs->max_clocks = clib_max (hs->max_clocks, clocks);
+  hs->barrier_clocks += barrier_clocks;
+  hs->hist[bucket]++;
+}
+
 always_inline void
 vlibapi_set_main (api_main_t * am)
 {
@@ -560,6 +560,11 @@ msg_handler_internal (api_main_t *am, void *the_msg, uword msg_len,
       if (do_it && calc_size <= msg_len)
 	{
 
+	  u64 t_sync, t_start, t_end;
+	  u32 old_tag;
+
+	  t_sync = clib_cpu_time_now ();
+
 	  if (!m->is_mp_safe)
 	    {
 	      vl_msg_api_barrier_trace_context (am->msg_names[id]);
@@ -573,7 +578,11 @@ msg_handler_internal (api_main_t *am, void *the_msg, uword msg_len,
 	    clib_call_callbacks (am->perf_counter_cbs, am, id,
 				 0 /* before */ );
 
+	  old_tag = clib_mem_set_tag (m->mem_tag);
+	  t_start = clib_cpu_time_now ();
 	  m->handler (the_msg);
+	  t_end = clib_cpu_time_now ();
+	  clib_mem_set_tag (old_tag);
 
 	  if (PREDICT_FALSE (vec_len (am->perf_counter_cbs) != 0))
 	    clib_call_callbacks (am->perf_counter_cbs, am, id,
@@ -581,6 +590,13 @@ msg_handler_internal (api_main_t *am, void *the_msg, uword msg_len,
 
 	  if (!m->is_mp_safe)
 	    vl_msg_api_barrier_release ();
+
+	  /* a handler may register messages, m may have moved */
+	  m = vl_api_get_msg_data (am, id);
+	  vl_msg_api_handler_stats_update (&m->handler_stats, t_end - t_start,
+					   m->is_mp_safe ?
+					     0 :
+					     clib_cpu_time_now () - t_sync);
 	}
     }
   else
@@ -774,6 +790,7 @@ vl_msg_api_config (vl_msg_api_msg_config_t * c)
   m->bounce = c->message_bounce;
   m->is_mp_safe = c->is_mp_safe;
   m->is_autoendian = c->is_autoendian;
+  m->mem_tag = clib_mem_get_tag ();
 
   m->trace_size = c->size;
   m->trace_enable = c->traced;
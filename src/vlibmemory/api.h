@@ -108,7 +108,11 @@ vl_api_send_fd_msg (vl_api_registration_t * reg, int fds[], int n_fds)
 {
   clib_file_t *cf = vl_api_registration_file (reg);
   if (cf)
-    return vl_sock_api_send_fd_msg (cf->file_descriptor, fds, n_fds);
+    {
+      /* messages queued before the fd must reach the client first */
+      vl_socket_api_flush (reg);
+      return vl_sock_api_send_fd_msg (cf->file_descriptor, fds, n_fds);
+    }
   return 0;
 }
 
@@ -405,6 +405,10 @@ vl_api_clnt_process (vlib_main_t *vm, vlib_node_runtime_t *node,
 	  vl_mem_api_handle_msg_private (vm, node, private_segment_rotor++);
 	}
 
+      /* socket clients with messages left get their next turn soon */
+      if (vec_len (socket_main.rx_pending_reg_indices))
+	sleep_time = 10e-6;
+
       vlib_process_wait_for_event_or_clock (vm, sleep_time);
       vec_reset_length (event_data);
       event_type = vlib_process_get_events (vm, &event_data);
@@ -420,18 +424,13 @@ vl_api_clnt_process (vlib_main_t *vm, vlib_node_runtime_t *node,
 	case SOCKET_READ_EVENT:
 	  for (i = 0; i < vec_len (event_data); i++)
 	    {
-	      vl_api_registration_t *regp;
+	      vl_socket_args_for_process_t args;
 
 	      a = pool_elt_at_index (socket_main.process_args, event_data[i]);
-	      regp = vl_socket_get_registration (a->reg_index);
-	      if (regp)
-		{
-		  vl_socket_process_api_msg (regp, (i8 *) a->data);
-		  a = pool_elt_at_index (socket_main.process_args,
-					 event_data[i]);
-		}
-	      vec_free (a->data);
+	      args = *a;
 	      pool_put (socket_main.process_args, a);
+
+	      vl_socket_api_rx_enqueue (&args);
 	    }
 	  break;
 
@@ -444,6 +443,9 @@ vl_api_clnt_process (vlib_main_t *vm, vlib_node_runtime_t *node,
 	  break;
 	}
 
+      /* one turn for each socket client with messages to handle */
+      vl_socket_api_rx_serve ();
+
       if (now > dead_client_scan_time)
 	{
 	  vl_mem_api_dead_client_scan (am, shm, now);
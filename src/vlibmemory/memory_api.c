@@ -773,6 +773,7 @@ vl_mem_api_handler_with_vm_node (api_main_t *am, svm_region_t *vlib_rp,
   u8 *(*print_fp) (void *, void *);
   svm_region_t *old_vlib_rp;
   void *save_shmem_hdr;
+  u64 t_sync, t_start, t_end;
   int is_mp_safe = 1;
 
   if (PREDICT_FALSE (am->elog_trace_api_messages))
@@ -814,6 +815,7 @@ vl_mem_api_handler_with_vm_node (api_main_t *am, svm_region_t *vlib_rp,
 	}
       is_mp_safe = am->msg_data[id].is_mp_safe;
 
+      t_sync = clib_cpu_time_now ();
       if (!is_mp_safe)
 	{
 	  vl_msg_api_barrier_trace_context (am->msg_data[id].name);
@@ -839,7 +841,9 @@ vl_mem_api_handler_with_vm_node (api_main_t *am, svm_region_t *vlib_rp,
       if (PREDICT_FALSE (vec_len (am->perf_counter_cbs) != 0))
 	clib_call_callbacks (am->perf_counter_cbs, am, id, 0 /* before */);
 
+      t_start = clib_cpu_time_now ();
       (*handler) (the_msg, vm, node);
+      t_end = clib_cpu_time_now ();
 
       if (PREDICT_FALSE (vec_len (am->perf_counter_cbs) != 0))
 	clib_call_callbacks (am->perf_counter_cbs, am, id, 1 /* after */);
@@ -850,6 +854,12 @@ vl_mem_api_handler_with_vm_node (api_main_t *am, svm_region_t *vlib_rp,
 	}
       if (!is_mp_safe)
 	vl_msg_api_barrier_release ();
+
+      /* a handler may register messages, m may have moved */
+      m = vl_api_get_msg_data (am, id);
+      vl_msg_api_handler_stats_update (
+	&m->handler_stats, t_end - t_start,
+	is_mp_safe ? 0 : clib_cpu_time_now () - t_sync);
     }
   else
     {
@@ -87,16 +87,26 @@ vl_sock_api_dump_clients (vlib_main_t * vm, api_main_t * am)
     return;
 
   vlib_cli_output (vm, "Socket clients");
-  vlib_cli_output (vm, "%20s %8s", "Name", "Fildesc");
-    /* *INDENT-OFF* */
-    pool_foreach (reg, sm->registration_pool)
-     {
-        if (reg->registration_type == REGISTRATION_TYPE_SOCKET_SERVER) {
-            f = vl_api_registration_file (reg);
-            vlib_cli_output (vm, "%20s %8d", reg->name, f->file_descriptor);
-        }
+  vlib_cli_output (vm, "%20s %8s %12s %12s %10s %10s %10s %10s %10s %10s",
+		   "Name", "Fildesc", "Rx-msgs", "Tx-msgs", "Rx-msg/s",
+		   "Reads", "Writes", "Turns", "Avg-q-us", "Max-q-us");
+  pool_foreach (reg, sm->registration_pool)
+    {
+      f64 age;
+
+      if (reg->registration_type != REGISTRATION_TYPE_SOCKET_SERVER)
+	continue;
+
+      f = vl_api_registration_file (reg);
+      age = vlib_time_now (vm) - reg->time_connected;
+      vlib_cli_output (
+	vm, "%20s %8d %12llu %12llu %10.0f %10llu %10llu %10llu %10.1f %10.1f",
+	reg->name, f ? f->file_descriptor : -1, reg->n_rx_msgs, reg->n_tx_msgs,
+	(age > 0 ? reg->n_rx_msgs / age : 0), reg->n_reads, reg->n_writes,
+	reg->n_turns,
+	(reg->n_turns ? reg->queue_delay_sum / reg->n_turns * 1e6 : 0),
+	reg->queue_delay_max * 1e6);
     }
-/* *INDENT-ON* */
 }
 
 vl_api_registration_t *
@@ -114,6 +124,24 @@ vl_socket_api_client_handle_to_registration (u32 handle)
   return pool_elt_at_index (sm->registration_pool, index);
 }
 
+/* bytes of replies not written to the socket yet */
+static_always_inline u32
+vl_socket_api_tx_pending (vl_api_registration_t *rp)
+{
+  return (vec_len (rp->output_vector) + rp->tx_msgs_bytes);
+}
+
+static void
+vl_socket_api_tx_msgs_free (vl_api_registration_t *rp)
+{
+  u8 **elem;
+
+  vec_foreach (elem, rp->tx_msgs)
+    vl_msg_api_free (*elem);
+  vec_reset_length (rp->tx_msgs);
+  rp->tx_msgs_bytes = 0;
+}
+
 void
 vl_socket_api_send (vl_api_registration_t * rp, u8 * elem)
 {
@@ -143,18 +171,44 @@ vl_socket_api_send (vl_api_registration_t * rp, u8 * elem)
 			       rp->vl_api_registration_pool_index);
   ASSERT (sock_rp);
 
-  /* Add the msgbuf_t to the output vector */
-  vec_add (sock_rp->output_vector, (u8 *) mb, sizeof (*mb));
+  sock_rp->n_tx_msgs++;
 
-  /* Try to send the message and save any error like
-   * we do in the input epoll loop */
-  vec_add (sock_rp->output_vector, elem, ntohl (mb->data_len));
-  error = clib_file_write (cf);
-  unix_save_error (&unix_main, error);
+  /*
+   * A local client reads its replies from the output vector, and data
+   * already waiting there for the socket must go first. Otherwise the
+   * reply is written later with writev from its own buffer, no copy.
+   */
+  if (!cf || vec_len (sock_rp->output_vector))
+    {
+      /* Add the msgbuf_t to the output vector */
+      vec_add (sock_rp->output_vector, (u8 *) mb, sizeof (*mb));
+      vec_add (sock_rp->output_vector, elem, ntohl (mb->data_len));
+    }
+  else
+    {
+      vec_add1 (sock_rp->tx_msgs, elem);
+      sock_rp->tx_msgs_bytes += sizeof (*mb) + ntohl (mb->data_len);
+      elem = 0;
+    }
 
-  /* If we didn't finish sending everything, wait for tx space */
-  if (vec_len (sock_rp->output_vector) > 0
-      && !(cf->flags & UNIX_FILE_DATA_AVAILABLE_TO_WRITE))
+  if (!cf)
+    goto done;
+
+  if (vl_socket_api_tx_pending (sock_rp) >= sm->tx_flush_size)
+    {
+      /* Try to send the messages and save any error like
+       * we do in the input epoll loop */
+      error = clib_file_write (cf);
+      unix_save_error (&unix_main, error);
+    }
+
+  /*
+   * If we didn't send everything, have the epoll loop write the rest;
+   * unless this is a reply within a batch, which is flushed at its end.
+   */
+  if (vl_socket_api_tx_pending (sock_rp) > 0 &&
+      sm->batch_reg_index != rp->vl_api_registration_pool_index &&
+      !(cf->flags & UNIX_FILE_DATA_AVAILABLE_TO_WRITE))
     {
       cf->flags |= UNIX_FILE_DATA_AVAILABLE_TO_WRITE;
       fm->file_update (cf, UNIX_FILE_UPDATE_MODIFY);
@@ -166,7 +220,38 @@ vl_socket_api_send (vl_api_registration_t * rp, u8 * elem)
 		cf->file_descriptor);
 #endif
 
-  vl_msg_api_free ((void *) elem);
+done:
+  if (elem)
+    vl_msg_api_free ((void *) elem);
+}
+
+/*
+ * A client inside vpp, e.g. a config loader: a socket registration
+ * with no socket, replies to it stay in its output vector.
+ * Returns the handle to put in the client_index of its messages.
+ */
+u32
+vl_socket_api_local_client_create (char *name)
+{
+  vl_api_registration_t *rp;
+
+  pool_get (socket_main.registration_pool, rp);
+  clib_memset (rp, 0, sizeof (*rp));
+
+  rp->registration_type = REGISTRATION_TYPE_SOCKET_SERVER;
+  rp->vl_api_registration_pool_index = rp - socket_main.registration_pool;
+  rp->clib_file_index = ~0;
+  rp->time_connected = vlib_time_now (vlib_get_main ());
+  rp->name = format (0, "%s%c", name, 0);
+
+  return sock_api_registration_handle (rp);
+}
+
+void
+vl_socket_api_local_client_delete (u32 handle)
+{
+  vl_socket_free_registration_index (
+    socket_api_registration_handle_to_index (handle));
 }
 
 void
@@ -194,6 +279,9 @@ vl_socket_free_registration_index (u32 pool_index)
   vec_free (rp->name);
   vec_free (rp->unprocessed_input);
   vec_free (rp->output_vector);
+  vec_free (rp->rx_pending);
+  vl_socket_api_tx_msgs_free (rp);
+  vec_free (rp->tx_msgs);
   rp->registration_type = REGISTRATION_TYPE_FREE;
   pool_put (socket_main.registration_pool, rp);
 }
@@ -209,6 +297,157 @@ vl_socket_process_api_msg (vl_api_registration_t * rp, i8 * input_v)
   socket_main.current_rp = 0;
 }
 
+/*
+ * Queue the messages of one read until the client gets its turn. The
+ * data is taken over, or freed.
+ */
+void
+vl_socket_api_rx_enqueue (vl_socket_args_for_process_t *a)
+{
+  socket_main_t *sm = &socket_main;
+  vl_api_registration_t *rp;
+
+  rp = vl_socket_get_registration (a->reg_index);
+  if (!rp || rp->is_being_removed)
+    {
+      vec_free (a->data);
+      return;
+    }
+
+  if (0 == vec_len (rp->rx_pending))
+    {
+      rp->rx_pending = a->data;
+      rp->rx_pending_offset = 0;
+      rp->rx_pending_time = a->time_read;
+      vec_add1 (sm->rx_pending_reg_indices, a->reg_index);
+    }
+  else
+    {
+      /* drop what was handled before it grows */
+      vec_delete (rp->rx_pending, rp->rx_pending_offset, 0);
+      rp->rx_pending_offset = 0;
+      vec_add (rp->rx_pending, a->data, vec_len (a->data));
+      vec_free (a->data);
+    }
+  a->data = 0;
+}
+
+/*
+ * One turn of a client: handle up to rx_msg_budget of its messages, then
+ * write all of the replies in one go. Returns non-zero if the client has
+ * messages left.
+ */
+static int
+vl_socket_api_rx_turn (u32 reg_index, f64 now)
+{
+  socket_main_t *sm = &socket_main;
+  vl_api_registration_t *rp;
+  u32 offset, n_msgs = 0;
+  msgbuf_t *mbp;
+  u8 *data;
+  f64 delay;
+
+  rp = vl_socket_get_registration (reg_index);
+  if (!rp || rp->is_being_removed || 0 == vec_len (rp->rx_pending))
+    return 0;
+
+  delay = now - rp->rx_pending_time;
+  rp->queue_delay_sum += delay;
+  rp->queue_delay_max = clib_max (rp->queue_delay_max, delay);
+  rp->n_turns++;
+
+  /* a handler may remove the client, keep the messages to ourselves */
+  data = rp->rx_pending;
+  offset = rp->rx_pending_offset;
+  rp->rx_pending = 0;
+
+  sm->batch_reg_index = reg_index;
+
+  while (offset < vec_len (data) && n_msgs++ < sm->rx_msg_budget)
+    {
+      /* a handler, e.g. sockclnt_delete, may remove the client */
+      rp = vl_socket_get_registration (reg_index);
+      if (!rp || rp->is_being_removed)
+	break;
+
+      mbp = (msgbuf_t *) (data + offset);
+      offset += sizeof (*mbp) + ntohl (mbp->data_len);
+
+      vl_socket_process_api_msg (rp, (i8 *) mbp);
+    }
+
+  sm->batch_reg_index = ~0;
+
+  rp = vl_socket_get_registration (reg_index);
+  if (!rp || rp->is_being_removed || offset >= vec_len (data))
+    {
+      vec_free (data);
+      if (rp && !rp->is_being_removed)
+	vl_socket_api_flush (rp);
+      return 0;
+    }
+
+  rp->rx_pending = data;
+  rp->rx_pending_offset = offset;
+  vl_socket_api_flush (rp);
+
+  return 1;
+}
+
+/*
+ * Give each client with messages queued one turn, those with more to
+ * do go to the back of the line. Returns non-zero if messages are left
+ * for another round.
+ */
+int
+vl_socket_api_rx_serve (void)
+{
+  socket_main_t *sm = &socket_main;
+  u32 i, n_clients, reg_index;
+  f64 now;
+
+  n_clients = vec_len (sm->rx_pending_reg_indices);
+  if (0 == n_clients)
+    return 0;
+
+  now = vlib_time_now (vlib_get_main ());
+
+  for (i = 0; i < n_clients; i++)
+    {
+      reg_index = sm->rx_pending_reg_indices[i];
+      if (vl_socket_api_rx_turn (reg_index, now))
+	vec_add1 (sm->rx_pending_reg_indices, reg_index);
+    }
+
+  vec_delete (sm->rx_pending_reg_indices, n_clients, 0);
+
+  return (vec_len (sm->rx_pending_reg_indices) > 0);
+}
+
+void
+vl_socket_api_flush (vl_api_registration_t *rp)
+{
+  clib_file_main_t *fm = &file_main;
+  clib_error_t *error;
+  clib_file_t *cf;
+
+  cf = vl_api_registration_file (rp);
+  if (!cf || 0 == vl_socket_api_tx_pending (rp))
+    return;
+
+  error = clib_file_write (cf);
+  unix_save_error (&unix_main, error);
+
+  /* If we didn't finish sending everything, wait for tx space */
+  rp = vl_socket_get_registration (cf->private_data);
+  if (rp && vl_socket_api_tx_pending (rp) > 0 &&
+      !(cf->flags & UNIX_FILE_DATA_AVAILABLE_TO_WRITE))
+    {
+      cf->flags |= UNIX_FILE_DATA_AVAILABLE_TO_WRITE;
+      fm->file_update (cf, UNIX_FILE_UPDATE_MODIFY);
+    }
+}
+
 int
 is_being_removed_reg_index (u32 reg_index)
 {
@@ -249,7 +488,7 @@ vl_socket_request_remove_reg_index (u32 reg_index)
  * Read function for API socket.
  *
  * Read data from socket, invoke SOCKET_READ_EVENT
- * for each fully read API message, return 0.
+ * once for all the fully read API messages, return 0.
  * Store incomplete data for next invocation to continue.
  *
  * On severe read error, the file is closed.
@@ -270,10 +509,9 @@ vl_socket_read_ready (clib_file_t * uf)
   int n;
   /* msg_buffer vector can point to input_buffer or unprocessed_input */
   i8 *msg_buffer = 0;
-  /* data_for_process is a vector containing one full message, incl msgbuf_t */
+  /* data_for_process is a vector of full messages, each incl msgbuf_t */
   u8 *data_for_process;
-  /* msgbuf_len is the size of one message, including sizeof (msgbuf_t) */
-  u32 msgbuf_len;
+  u32 msgbuf_len, offset = 0, n_msgs = 0;
   u32 save_input_buffer_length = vec_len (socket_main.input_buffer);
   vl_socket_args_for_process_t *a;
   u32 reg_index = uf->private_data;
@@ -298,6 +536,7 @@ vl_socket_read_ready (clib_file_t * uf)
       /* EAGAIN means we do not close the file, but no data to process anyway. */
       return 0;
     }
+  rp->n_reads++;
 
   /* Fake smaller length teporarily, so input_buffer can be used as msg_buffer. */
   vec_set_len (socket_main.input_buffer, n);
@@ -318,69 +557,131 @@ vl_socket_read_ready (clib_file_t * uf)
     {
       msg_buffer = socket_main.input_buffer;
     }
-  /* Loop to process any full messages. */
+  /*
+   * Find the full messages at the front of the buffer; they are handed
+   * to the API process as one batch, the remaining fragment is kept.
+   */
   ASSERT (vec_len (msg_buffer) > 0);
-  do
+  while (vec_len (msg_buffer) - offset > sizeof (msgbuf_t))
     {
-      /* Here, we are not sure how big a chunk of message we have left. */
-      /* Do we at least know how big the full message will be? */
-      if (vec_len (msg_buffer) <= sizeof (msgbuf_t))
-	/* No, so fragment is not a full message. */
-	goto save_and_split;
-
-      /* Now we know how big the full message will be. */
+      /* msgbuf_len is the size of one message, including sizeof (msgbuf_t) */
       msgbuf_len =
-	ntohl (((msgbuf_t *) msg_buffer)->data_len) + sizeof (msgbuf_t);
+	ntohl (((msgbuf_t *) (msg_buffer + offset))->data_len) +
+	sizeof (msgbuf_t);
 
       /* But do we have a full message? */
-      if (msgbuf_len > vec_len (msg_buffer))
-	{
-	save_and_split:
-	  /* We don't have the entire message yet. */
-	  /* If msg_buffer is unprocessed_input, nothing needs to be done. */
-	  if (msg_buffer == socket_main.input_buffer)
-	    /* But if we were using the input buffer, save the fragment. */
-	    {
-	      ASSERT (vec_len (rp->unprocessed_input) == 0);
-	      vec_validate (rp->unprocessed_input, vec_len (msg_buffer) - 1);
-	      clib_memcpy_fast (rp->unprocessed_input, msg_buffer,
-				vec_len (msg_buffer));
-	      vec_set_len (rp->unprocessed_input, vec_len (msg_buffer));
-	    }
-	  /* No more full messages, restore original input_buffer length. */
-	  vec_set_len (socket_main.input_buffer, save_input_buffer_length);
-	  return 0;
-	}
+      if (offset + msgbuf_len > vec_len (msg_buffer))
+	break;
+
+      offset += msgbuf_len;
+      n_msgs++;
+    }
+
+  if (n_msgs)
+    {
+      data_for_process = 0;
+      vec_add (data_for_process, msg_buffer, offset);
 
-      /*
-       * We have at least one full message.
-       * But msg_buffer can contain more data, so copy one message data
-       * so we can overwrite its length to what single message has.
-       */
-      data_for_process = (u8 *) vec_dup (msg_buffer);
-      vec_set_len (data_for_process, msgbuf_len);
       /* Everything is ready to signal the SOCKET_READ_EVENT. */
       pool_get (socket_main.process_args, a);
       a->reg_index = reg_index;
       a->data = data_for_process;
+      a->time_read = vlib_time_now (vm);
+      rp->n_rx_msgs += n_msgs;
 
       vlib_process_signal_event (vm, vl_api_clnt_node.index,
 				 SOCKET_READ_EVENT,
 				 a - socket_main.process_args);
-      if (vec_len (msg_buffer) > msgbuf_len)
-	/* There are some fragments left. Shrink the msg_buffer to simplify logic. */
-	vec_delete (msg_buffer, msgbuf_len, 0);
-      else
-	/* We are done with msg_buffer. */
-	vec_set_len (msg_buffer, 0);
     }
-  while (vec_len (msg_buffer) > 0);
+
+  if (msg_buffer == socket_main.input_buffer)
+    {
+      /* We were using the input buffer, save the fragment. */
+      ASSERT (vec_len (rp->unprocessed_input) == 0);
+      if (offset < vec_len (msg_buffer))
+	vec_add (rp->unprocessed_input, msg_buffer + offset,
+		 vec_len (msg_buffer) - offset);
+    }
+  else
+    /* msg_buffer is unprocessed_input, drop what was consumed */
+    vec_delete (rp->unprocessed_input, offset, 0);
 
   /* Restore input_buffer, it could have been msg_buffer. */
   vec_set_len (socket_main.input_buffer, save_input_buffer_length);
   return 0;
 }
 
+/*
+ * Write queued replies straight from their message buffers. What the
+ * socket does not take is copied to the output vector and the buffers
+ * are freed, so that none is held while a slow client catches up.
+ * Returns non-zero on a write error.
+ */
+static int
+vl_socket_api_writev (clib_file_t *uf, vl_api_registration_t *rp)
+{
+  socket_main_t *sm = &socket_main;
+  u32 i, first = 0, written = 0, len;
+  struct iovec *iov;
+  msgbuf_t *mb;
+  ssize_t n;
+
+  while (first < vec_len (rp->tx_msgs))
+    {
+      vec_reset_length (sm->tx_iovecs);
+      for (i = first; i < vec_len (rp->tx_msgs) &&
+		      vec_len (sm->tx_iovecs) < SOCKSVR_TX_MAX_IOVECS;
+	   i++)
+	{
+	  mb = (msgbuf_t *) (rp->tx_msgs[i] - offsetof (msgbuf_t, data));
+	  vec_add2 (sm->tx_iovecs, iov, 1);
+	  iov->iov_base = mb;
+	  iov->iov_len = sizeof (*mb) + ntohl (mb->data_len);
+	}
+
+      n = writev (uf->file_descriptor, sm->tx_iovecs,
+		  vec_len (sm->tx_iovecs));
+      if (n < 0)
+	{
+	  if (errno == EAGAIN || errno == EINTR)
+	    break;
+	  return (-1);
+	}
+      rp->n_writes++;
+
+      /* free the replies written in full */
+      vec_foreach (iov, sm->tx_iovecs)
+	{
+	  if (n < iov->iov_len)
+	    break;
+	  n -= iov->iov_len;
+	  vl_msg_api_free (rp->tx_msgs[first++]);
+	}
+
+      /* A short write means the socket is full, wait for the next event */
+      if (iov < vec_end (sm->tx_iovecs))
+	{
+	  written = n;
+	  break;
+	}
+    }
+
+  /* the rest waits in the output vector */
+  for (i = first; i < vec_len (rp->tx_msgs); i++)
+    {
+      mb = (msgbuf_t *) (rp->tx_msgs[i] - offsetof (msgbuf_t, data));
+      len = sizeof (*mb) + ntohl (mb->data_len);
+      vec_add (rp->output_vector, (u8 *) mb + written, len - written);
+      vl_msg_api_free (rp->tx_msgs[i]);
+      written = 0;
+    }
+
+  vec_reset_length (rp->tx_msgs);
+  rp->tx_msgs_bytes = 0;
+
+  return (0);
+}
+
 clib_error_t *
 vl_socket_write_ready (clib_file_t * uf)
 {
@@ -396,17 +697,16 @@ vl_socket_write_ready (clib_file_t * uf)
 
   rp = pool_elt_at_index (socket_main.registration_pool, reg_index);
 
-  /* Flush output vector. */
+  /* Flush output vector, as much as the socket takes in one write. */
   size_t total_bytes = vec_len (rp->output_vector);
-  size_t bytes_to_send, remaining_bytes = total_bytes;
+  size_t remaining_bytes = total_bytes;
   void *p = rp->output_vector;
   while (remaining_bytes > 0)
     {
-      bytes_to_send = remaining_bytes > 4096 ? 4096 : remaining_bytes;
-      n = write (uf->file_descriptor, p, bytes_to_send);
+      n = write (uf->file_descriptor, p, remaining_bytes);
       if (n < 0)
 	{
-	  if (errno == EAGAIN)
+	  if (errno == EAGAIN || errno == EINTR)
 	    {
 	      break;
 	    }
@@ -416,12 +716,25 @@ vl_socket_write_ready (clib_file_t * uf)
 	  vl_socket_request_remove_reg_index (reg_index);
 	  return 0;
 	}
-      remaining_bytes -= bytes_to_send;
-      p += bytes_to_send;
+      rp->n_writes++;
+      /* A short write means the socket is full, wait for the next event */
+      remaining_bytes -= n;
+      p += n;
+      if (n == 0 || remaining_bytes > 0)
+	break;
     }
 
   vec_delete (rp->output_vector, total_bytes - remaining_bytes, 0);
-  if (vec_len (rp->output_vector) <= 0
+
+  /* then the replies queued behind it */
+  if (0 == vec_len (rp->output_vector) && vec_len (rp->tx_msgs) &&
+      vl_socket_api_writev (uf, rp))
+    {
+      vl_socket_request_remove_reg_index (reg_index);
+      return 0;
+    }
+
+  if (vl_socket_api_tx_pending (rp) <= 0
       && (uf->flags & UNIX_FILE_DATA_AVAILABLE_TO_WRITE))
     {
       uf->flags &= ~UNIX_FILE_DATA_AVAILABLE_TO_WRITE;
@@ -457,6 +770,7 @@ socksvr_file_add (clib_file_main_t * fm, int fd)
 
   rp->registration_type = REGISTRATION_TYPE_SOCKET_SERVER;
   rp->vl_api_registration_pool_index = rp - socket_main.registration_pool;
+  rp->time_connected = vlib_time_now (vlib_get_main ());
   rp->clib_file_index = clib_file_add (fm, &template);
 }
 
@@ -742,10 +1056,11 @@ reply:
 
   /*
    * Note: The reply message needs to make it out the back door
-   * before we send the magic fd message. That's taken care of by
-   * the send function.
+   * before we send the magic fd message, flush it rather than leave
+   * it to the end of the batch.
    */
   vl_socket_api_send (regp, (u8 *) rmp);
+  vl_socket_api_flush (regp);
 
   if (rv != 0)
     return;
@@ -806,7 +1121,15 @@ vl_sock_api_init (vlib_main_t * vm)
   foreach_vlib_api_msg;
 #undef _
 
-  vec_resize (sm->input_buffer, 4096);
+  if (0 == sm->rx_buffer_size)
+    sm->rx_buffer_size = SOCKSVR_DEFAULT_RX_BUFFER_SIZE;
+  if (0 == sm->tx_flush_size)
+    sm->tx_flush_size = SOCKSVR_DEFAULT_TX_FLUSH_SIZE;
+  if (0 == sm->rx_msg_budget)
+    sm->rx_msg_budget = SOCKSVR_DEFAULT_RX_MSG_BUDGET;
+  sm->batch_reg_index = ~0;
+
+  vec_resize (sm->input_buffer, sm->rx_buffer_size);
 
   sock->config = (char *) sm->socket_name;
   sock->flags = CLIB_SOCKET_F_IS_SERVER | CLIB_SOCKET_F_ALLOW_GROUP_WRITE;
@@ -862,6 +1185,12 @@ socksvr_config (vlib_main_t * vm, unformat_input_t * input)
     {
       if (unformat (input, "socket-name %s", &sm->socket_name))
 	;
+      else if (unformat (input, "rx-buffer-size %u", &sm->rx_buffer_size))
+	;
+      else if (unformat (input, "tx-flush-size %u", &sm->tx_flush_size))
+	;
+      else if (unformat (input, "rx-msg-budget %u", &sm->rx_msg_budget))
+	;
       /* DEPRECATE: default keyword is ignored */
       else if (unformat (input, "default"))
 	;
@@ -21,16 +21,24 @@
 #include <vlibapi/api_common.h>
 #include <svm/ssvm.h>
 #include <vppinfra/file.h>
+#include <sys/uio.h>
 
 /* Deprecated */
 #define API_SOCKET_FILE "/run/vpp/api.sock"
 
 #define API_SOCKET_FILENAME "api.sock"
+#define SOCKSVR_DEFAULT_RX_BUFFER_SIZE (64 << 10)
+#define SOCKSVR_DEFAULT_TX_FLUSH_SIZE (64 << 10)
+#define SOCKSVR_DEFAULT_RX_MSG_BUDGET 64
+#define SOCKSVR_TX_MAX_IOVECS 256
 
 typedef struct
 {
   u32 reg_index;
+  /** one or more complete messages, each with its msgbuf_t header */
   u8 *data;
+  /** when the data was read, to measure queueing delay */
+  f64 time_read;
 } vl_socket_args_for_process_t;
 
 typedef struct
@@ -54,6 +62,27 @@ typedef struct
   vl_api_registration_t *current_rp;
   /* One input buffer, shared across all sockets */
   i8 *input_buffer;
+  /* read size, so a burst of requests is taken in one read */
+  u32 rx_buffer_size;
+
+  /*
+   * Replies are queued per client and written with one writev once a
+   * batch of requests is handled, or when this many bytes are pending,
+   * rather than with a write per message.
+   */
+  u32 tx_flush_size;
+  struct iovec *tx_iovecs;
+
+  /* registration whose batch of requests is being handled, or ~0 */
+  u32 batch_reg_index;
+
+  /*
+   * Clients with messages read but not handled, served round robin. Each
+   * turn handles at most rx_msg_budget messages of one client, so a busy
+   * client does not hold off the others.
+   */
+  u32 *rx_pending_reg_indices;
+  u32 rx_msg_budget;
 
   /* pool of process args for socket clients */
   vl_socket_args_for_process_t *process_args;
@@ -77,6 +106,9 @@ clib_error_t *vl_socket_read_ready (struct clib_file *uf);
 clib_error_t *vl_socket_write_ready (struct clib_file *uf);
 void vl_socket_api_send (vl_api_registration_t * rp, u8 * elem);
 void vl_socket_process_api_msg (vl_api_registration_t * rp, i8 * input_v);
+void vl_socket_api_rx_enqueue (vl_socket_args_for_process_t *a);
+int vl_socket_api_rx_serve (void);
+void vl_socket_api_flush (vl_api_registration_t *rp);
 void vl_sock_api_dump_clients (vlib_main_t * vm, api_main_t * am);
 clib_error_t *vl_sock_api_init (vlib_main_t * vm);
 clib_error_t *vl_sock_api_send_fd_msg (int socket_fd, int fds[], int n_fds);
@@ -84,6 +116,8 @@ clib_error_t *vl_sock_api_recv_fd_msg (int socket_fd, int fds[], int n_fds,
 				       u32 wait);
 
 vl_api_registration_t *vl_socket_api_client_handle_to_registration (u32 idx);
+u32 vl_socket_api_local_client_create (char *name);
+void vl_socket_api_local_client_delete (u32 handle);
 u8 vl_socket_api_registration_handle_is_valid (u32 reg_index);
 
 #endif /* SRC_VLIBMEMORY_SOCKET_API_H_ */
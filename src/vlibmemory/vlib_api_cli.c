@@ -22,6 +22,7 @@
 
 #include <vlibapi/api.h>
 #include <vlibmemory/api.h>
+#include <vlib/stats/stats.h>
 
 static clib_error_t *
 vl_api_show_histogram_command (vlib_main_t * vm,
@@ -273,6 +274,249 @@ VLIB_CLI_COMMAND (cli_show_api_message_table_command, static) =
 };
 /* *INDENT-ON* */
 
+static int
+handler_stats_compare (void *a1, void *a2)
+{
+  api_main_t *am = vlibapi_get_main ();
+  u32 *i1 = a1, *i2 = a2;
+  u64 c1 = am->msg_data[*i1].handler_stats.clocks;
+  u64 c2 = am->msg_data[*i2].handler_stats.clocks;
+
+  /* largest total first */
+  return (c1 < c2) - (c1 > c2);
+}
+
+static clib_error_t *
+vl_api_show_handler_stats_command (vlib_main_t *vm, unformat_input_t *input,
+				   vlib_cli_command_t *cli_cmd)
+{
+  api_main_t *am = vlibapi_get_main ();
+  f64 us_per_clock = vm->clib_time.seconds_per_clock * 1e6;
+  vl_api_msg_handler_stats_t *hs;
+  u32 *indices = 0, *i, j, max = ~0;
+  int verbose = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "verbose"))
+	verbose = 1;
+      else if (unformat (input, "max %u", &max))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  for (j = 1; j < vec_len (am->msg_data); j++)
+    if (am->msg_data[j].handler_stats.calls)
+      vec_add1 (indices, j);
+
+  if (0 == vec_len (indices))
+    {
+      vlib_cli_output (vm, "No API messages handled.");
+      return 0;
+    }
+
+  vec_sort_with_function (indices, handler_stats_compare);
+
+  vlib_cli_output (vm, "%-40s %10s %12s %10s %10s %12s", "Name", "Calls",
+		   "Total(us)", "Avg(us)", "Max(us)", "Barrier(us)");
+
+  vec_foreach (i, indices)
+    {
+      if (i - indices >= max)
+	break;
+
+      hs = &am->msg_data[*i].handler_stats;
+      vlib_cli_output (vm, "%-40s %10llu %12.1f %10.2f %10.2f %12.1f",
+		       am->msg_data[*i].name, hs->calls,
+		       hs->clocks * us_per_clock,
+		       (f64) hs->clocks / hs->calls * us_per_clock,
+		       hs->max_clocks * us_per_clock,
+		       hs->barrier_clocks * us_per_clock);
+
+      if (!verbose)
+	continue;
+
+      for (j = 0; j < VL_API_HANDLER_STATS_N_BUCKETS; j++)
+	if (hs->hist[j])
+	  vlib_cli_output (vm, "  < %10.2f us: %u",
+			   (f64) (1ULL << j) * us_per_clock, hs->hist[j]);
+    }
+
+  vec_free (indices);
+  return 0;
+}
+
+/*?
+ * Display the time spent in each API message handler, largest first.
+ * 'verbose' adds the distribution of handler times, 'max' limits the
+ * output to the top entries. The barrier time includes waiting for the
+ * workers to stop, i.e. it is the time forwarding was held off.
+ *
+ * @cliexpar
+ * @cliexstart{show api handler-stats max 2}
+ * Name                 Calls  Total(us)  Avg(us)  Max(us)  Barrier(us)
+ * ip_route_add_del     10000    21450.3     2.15    41.07      29874.2
+ * sw_interface_dump       12      310.2    25.85    81.90          0.0
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (cli_show_api_handler_stats_command, static) = {
+  .path = "show api handler-stats",
+  .short_help = "show api handler-stats [verbose] [max <n>]",
+  .function = vl_api_show_handler_stats_command,
+};
+
+static clib_error_t *
+vl_api_clear_handler_stats_command (vlib_main_t *vm, unformat_input_t *input,
+				    vlib_cli_command_t *cli_cmd)
+{
+  api_main_t *am = vlibapi_get_main ();
+  vl_api_msg_data_t *m;
+
+  vec_foreach (m, am->msg_data)
+    clib_memset (&m->handler_stats, 0, sizeof (m->handler_stats));
+
+  return 0;
+}
+
+/*?
+ * Clear the API message handler statistics
+?*/
+VLIB_CLI_COMMAND (cli_clear_api_handler_stats_command, static) = {
+  .path = "clear api handler-stats",
+  .short_help = "clear api handler-stats",
+  .function = vl_api_clear_handler_stats_command,
+};
+
+/*
+ * Handler stats in the stats segment: one counter vector per stat,
+ * indexed by message id, with /api/msg/<name>/<stat> symlinks. The
+ * handler time histogram is one /api/msg/handler-clocks/lt-<2^n>clocks
+ * vector per bucket, symlinked as /api/msg/<name>/handler-clocks/... once
+ * the message has been called, to keep the directory small.
+ */
+enum
+{
+  API_MSG_CALLS,
+  API_MSG_CLOCKS,
+  API_MSG_MAX_CLOCKS,
+  API_MSG_BARRIER_CLOCKS,
+  N_API_MSG_COUNTERS
+};
+
+static struct
+{
+  u32 entry_index;
+  char *name;
+} api_msg_counters[] = {
+  [API_MSG_CALLS] = { .name = "calls" },
+  [API_MSG_CLOCKS] = { .name = "clocks" },
+  [API_MSG_MAX_CLOCKS] = { .name = "max-clocks" },
+  [API_MSG_BARRIER_CLOCKS] = { .name = "barrier-clocks" },
+};
+
+/* number of messages the entries are sized for and symlinked */
+static u32 api_msg_counters_n_msgs;
+static u32 *api_msg_hist_entries;
+static uword *api_msg_hist_has_symlinks;
+
+static void
+api_msg_counters_collect (vlib_stats_collector_data_t *d)
+{
+  api_main_t *am = vlibapi_get_main ();
+  u32 n_msgs = vec_len (am->msg_data);
+  counter_t *c[N_API_MSG_COUNTERS];
+  vl_api_msg_data_t *m;
+  counter_t **counters;
+  int i, j;
+
+  if (n_msgs == 0)
+    return;
+
+  /* plugins may register messages after the entries are created */
+  if (n_msgs > api_msg_counters_n_msgs)
+    {
+      vlib_stats_segment_lock ();
+      for (j = 0; j < N_API_MSG_COUNTERS; j++)
+	vlib_stats_validate (api_msg_counters[j].entry_index, 0, n_msgs - 1);
+
+      for (i = api_msg_counters_n_msgs; i < n_msgs; i++)
+	{
+	  m = vl_api_get_msg_data (am, i);
+	  if (!m->handler || !m->name)
+	    continue;
+	  for (j = 0; j < N_API_MSG_COUNTERS; j++)
+	    vlib_stats_add_symlink (api_msg_counters[j].entry_index, i,
+				    "/api/msg/%s/%s", m->name,
+				    api_msg_counters[j].name);
+	}
+      for (j = 0; j < VL_API_HANDLER_STATS_N_BUCKETS; j++)
+	vlib_stats_validate (api_msg_hist_entries[j], 0, n_msgs - 1);
+      vlib_stats_segment_unlock ();
+      api_msg_counters_n_msgs = n_msgs;
+    }
+
+  for (i = 0; i < n_msgs; i++)
+    {
+      m = vl_api_get_msg_data (am, i);
+      if (!m->handler_stats.calls || !m->name ||
+	  clib_bitmap_get (api_msg_hist_has_symlinks, i))
+	continue;
+      vlib_stats_segment_lock ();
+      vlib_stats_add_histogram_symlinks (api_msg_hist_entries, i,
+					 "/api/msg/%s/handler-clocks", m->name);
+      vlib_stats_segment_unlock ();
+      api_msg_hist_has_symlinks =
+	clib_bitmap_set (api_msg_hist_has_symlinks, i, 1);
+    }
+
+  for (j = 0; j < N_API_MSG_COUNTERS; j++)
+    {
+      counters =
+	vlib_stats_get_entry_data_pointer (api_msg_counters[j].entry_index);
+      c[j] = counters[0];
+    }
+
+  for (i = 0; i < n_msgs; i++)
+    {
+      vl_api_msg_handler_stats_t *hs = &am->msg_data[i].handler_stats;
+
+      c[API_MSG_CALLS][i] = hs->calls;
+      c[API_MSG_CLOCKS][i] = hs->clocks;
+      c[API_MSG_MAX_CLOCKS][i] = hs->max_clocks;
+      c[API_MSG_BARRIER_CLOCKS][i] = hs->barrier_clocks;
+    }
+
+  for (j = 0; j < VL_API_HANDLER_STATS_N_BUCKETS; j++)
+    {
+      counters = vlib_stats_get_entry_data_pointer (api_msg_hist_entries[j]);
+      for (i = 0; i < n_msgs; i++)
+	counters[0][i] = am->msg_data[i].handler_stats.hist[j];
+    }
+}
+
+static clib_error_t *
+api_msg_counters_init (vlib_main_t *vm)
+{
+  vlib_stats_collector_reg_t reg = {};
+  int j;
+
+  for (j = 0; j < N_API_MSG_COUNTERS; j++)
+    api_msg_counters[j].entry_index =
+      vlib_stats_add_counter_vector ("/api/msg/%s", api_msg_counters[j].name);
+  api_msg_hist_entries = vlib_stats_add_histogram (
+    VL_API_HANDLER_STATS_N_BUCKETS, "clocks", "/api/msg/handler-clocks");
+
+  reg.entry_index = api_msg_counters[API_MSG_CALLS].entry_index;
+  reg.collect_fn = api_msg_counters_collect;
+  vlib_stats_register_collector_fn (&reg);
+
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (api_msg_counters_init);
+
 static int
 range_compare (vl_api_msg_range_t * a0, vl_api_msg_range_t * a1)
 {
@@ -955,6 +1199,299 @@ vl_msg_dump_file_json (vlib_main_t *vm, u8 *filename)
   vec_free (buf);
 }
 
+/*
+ * Bulk configuration: a JSON array of API messages, as written by
+ * "api trace save-json" or vat2, is validated as a whole and then
+ * applied in file order by one in-process client. The worker barrier
+ * is taken once per batch of messages rather than once per message.
+ */
+typedef struct
+{
+  u8 *msg;
+  u32 len;
+  u16 msg_id;
+} vl_api_config_msg_t;
+
+typedef struct
+{
+  u32 n_applied;
+  u32 n_failed;
+  u32 n_barriers;
+} vl_api_config_result_t;
+
+static vl_api_config_msg_t *
+vl_api_config_parse (vlib_main_t *vm, cJSON *o, clib_error_t **error)
+{
+  api_main_t *am = vlibapi_get_main ();
+  vl_api_config_msg_t *msgs = 0, *cm;
+  vl_api_msg_data_t *m;
+  cJSON *item;
+  u8 *name_crc;
+  char *name, *crc;
+  int len, i;
+
+  for (i = 0; i < cJSON_GetArraySize (o); i++)
+    {
+      item = cJSON_GetArrayItem (o, i);
+      name = cJSON_GetStringValue (cJSON_GetObjectItem (item, "_msgname"));
+      crc = cJSON_GetStringValue (cJSON_GetObjectItem (item, "_crc"));
+      if (!name || !crc)
+	{
+	  *error = clib_error_return (
+	    0, "message %d: missing '_msgname' or '_crc' element", i);
+	  goto fail;
+	}
+
+      /* unlike a trace replay, a different signature is an error */
+      name_crc = format (0, "%s_%s%c", name, crc, 0);
+      vec_add2 (msgs, cm, 1);
+      clib_memset (cm, 0, sizeof (*cm));
+      cm->msg_id = vl_msg_find_id_by_name_and_crc (vm, am, (char *) name_crc);
+      vec_free (name_crc);
+
+      m = vl_api_get_msg_data (am, cm->msg_id);
+      if (!m || !m->handler)
+	{
+	  *error = clib_error_return (0, "message %d: unknown message %s_%s",
+				      i, name, crc);
+	  goto fail;
+	}
+      if (!m->replay_allowed || !m->fromjson_handler)
+	{
+	  *error = clib_error_return (0, "message %d: %s cannot be loaded", i,
+				      name);
+	  goto fail;
+	}
+
+      cm->msg = m->fromjson_handler (item, &len);
+      if (!cm->msg)
+	{
+	  *error = clib_error_return (0, "message %d: bad %s", i, name);
+	  goto fail;
+	}
+      cm->len = len;
+
+      /* the converter leaves the message id unset */
+      *(u16 *) cm->msg = cm->msg_id;
+
+      /* to network order, as received from a client */
+      if (clib_arch_is_little_endian)
+	m->endian_handler (cm->msg);
+    }
+
+  return msgs;
+
+fail:
+  vec_foreach (cm, msgs)
+    if (cm->msg)
+      cJSON_free (cm->msg);
+  vec_free (msgs);
+  return 0;
+}
+
+/* u32 client_index follows the u16 message id in a request */
+#define VL_API_REQUEST_CLIENT_INDEX_OFFSET 2
+/* i32 retval follows the u16 message id and u32 context in a reply */
+#define VL_API_REPLY_RETVAL_OFFSET 6
+
+static int
+vl_api_config_msg_is_reply (vl_api_msg_data_t *m)
+{
+  uword len;
+
+  if (!m || !m->name)
+    return 0;
+
+  /* a reply is named <request>_reply */
+  len = strlen (m->name);
+  return (len > 6 && !strcmp (m->name + len - 6, "_reply"));
+}
+
+static void
+vl_api_config_check_replies (vlib_main_t *vm, vl_api_registration_t *rp,
+			     u32 index, vl_api_config_result_t *res)
+{
+  api_main_t *am = vlibapi_get_main ();
+  vl_api_msg_data_t *m;
+  msgbuf_t *mb;
+  u32 offset = 0;
+  i32 retval;
+
+  while (offset < vec_len (rp->output_vector))
+    {
+      mb = (msgbuf_t *) (rp->output_vector + offset);
+      offset += sizeof (*mb) + ntohl (mb->data_len);
+
+      m = vl_api_get_msg_data (am, clib_net_to_host_u16 (*(u16 *) mb->data));
+      if (!vl_api_config_msg_is_reply (m))
+	continue;
+
+      retval = clib_net_to_host_i32 (
+	*(i32 *) (mb->data + VL_API_REPLY_RETVAL_OFFSET));
+      if (retval)
+	{
+	  if (res->n_failed++ < 10)
+	    vlib_cli_output (vm, "message %u: %s: retval %d", index, m->name,
+			     retval);
+	}
+    }
+
+  vec_reset_length (rp->output_vector);
+}
+
+static clib_error_t *
+vl_api_config_load (vlib_main_t *vm, u8 *filename, u32 barrier_batch,
+		    int stop_on_error, vl_api_config_result_t *res)
+{
+  vl_api_config_msg_t *msgs = 0, *cm;
+  clib_error_t *error = 0;
+  vl_api_registration_t *rp;
+  u32 handle, n_held = 0;
+  char *buf;
+  cJSON *o;
+  FILE *f;
+
+  f = fopen ((char *) filename, "r");
+  if (!f)
+    return clib_error_return_unix (0, "failed to open %s", filename);
+
+  buf = vl_msg_read_file (f);
+  fclose (f);
+
+  o = cJSON_Parse (buf);
+  vec_free (buf);
+  if (!o)
+    return clib_error_return (0, "%s: failed parsing JSON input: %s",
+			      filename, cJSON_GetErrorPtr ());
+
+  if (!cJSON_IsArray (o))
+    {
+      cJSON_Delete (o);
+      return clib_error_return (0, "%s: expected an array of messages",
+				filename);
+    }
+
+  /* nothing is applied unless every message is valid */
+  msgs = vl_api_config_parse (vm, o, &error);
+  cJSON_Delete (o);
+  if (error)
+    return error;
+
+  handle = vl_socket_api_local_client_create ("api-config");
+  rp = vl_socket_api_client_handle_to_registration (handle);
+
+  vec_foreach (cm, msgs)
+    {
+      u32 n_failed = res->n_failed;
+
+      /* the loader is the client the replies go to */
+      *(u32 *) (cm->msg + VL_API_REQUEST_CLIENT_INDEX_OFFSET) =
+	clib_host_to_net_u32 (handle);
+
+      if (n_held == 0)
+	{
+	  vl_msg_api_barrier_sync ();
+	  res->n_barriers++;
+	}
+
+      /* the barrier is taken again, recursively, for each message */
+      vl_msg_api_handler_no_free (cm->msg, cm->len);
+      res->n_applied++;
+
+      if (++n_held == barrier_batch || cm == vec_end (msgs) - 1)
+	{
+	  vl_msg_api_barrier_release ();
+	  n_held = 0;
+	}
+
+      vl_api_config_check_replies (vm, rp, cm - msgs, res);
+
+      if (stop_on_error && res->n_failed != n_failed)
+	{
+	  if (n_held)
+	    vl_msg_api_barrier_release ();
+	  error = clib_error_return (0, "stopped at message %u", cm - msgs);
+	  break;
+	}
+    }
+
+  vl_socket_api_local_client_delete (handle);
+
+  vec_foreach (cm, msgs)
+    cJSON_free (cm->msg);
+  vec_free (msgs);
+
+  return error;
+}
+
+static clib_error_t *
+api_config_load_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			    vlib_cli_command_t *cmd)
+{
+  vl_api_config_result_t res = {};
+  u32 barrier_batch = 1024;
+  int stop_on_error = 1;
+  clib_error_t *error;
+  u8 *filename = 0;
+  f64 t;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "continue-on-error"))
+	stop_on_error = 0;
+      else if (unformat (input, "barrier-batch %u", &barrier_batch))
+	;
+      else if (unformat (input, "%s", &filename))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (!filename)
+    return clib_error_return (0, "file name required");
+  if (barrier_batch == 0)
+    barrier_batch = 1;
+  vec_add1 (filename, 0);
+
+  t = vlib_time_now (vm);
+  error = vl_api_config_load (vm, filename, barrier_batch, stop_on_error,
+			      &res);
+  t = vlib_time_now (vm) - t;
+
+  vlib_cli_output (vm, "%u messages applied, %u failed, in %.3fs, %u barriers",
+		   res.n_applied, res.n_failed, t, res.n_barriers);
+
+  vec_free (filename);
+  return error;
+}
+
+/*?
+ * Apply a JSON array of API messages, such as one saved with
+ * "api trace save-json", in the order given. All messages are checked
+ * before any is applied; the name and crc of each must match this
+ * image. By default loading stops at the first message whose reply
+ * has a non-zero retval. The worker barrier is held across
+ * 'barrier-batch' messages at a time (default 1024).
+ *
+ * @cliexpar
+ * @cliexstart{api config load /tmp/routes.json}
+ * 20000 messages applied, 0 failed, in 59.636s, 20 barriers
+ * @cliexend
+ * @cliexstart{api config load /tmp/loopbacks.json}
+ * message 0: delete_loopback_reply: retval -2
+ * 1 messages applied, 1 failed, in .039s, 1 barriers
+ * api config load: stopped at message 0
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (api_config_load_command, static) = {
+  .path = "api config load",
+  .short_help =
+    "api config load <file> [continue-on-error] [barrier-batch <n>]",
+  .function = api_config_load_command_fn,
+  .is_mp_safe = 1,
+};
+
 /** api_trace_command_fn - control the binary API trace / replay feature
 
     Note: this command MUST be marked thread-safe. Replay with
@@ -202,6 +202,24 @@ show_bfd (vlib_main_t * vm, unformat_input_t * input,
 	  vlib_cli_output (vm, "UDP echo source is not set.\n");
 	}
     }
+  else if (unformat (line_input, "threads"))
+    {
+      bfd_per_thread_data_t *ptd;
+      u8 *s = format (NULL, "%=10s %=10s %=16s %=16s %=16s\n", "Thread",
+		      "Sessions", "Expired timers", "Avg late (usec)",
+		      "Max late (usec)");
+      vec_foreach (ptd, bm->per_thread_data)
+	{
+	  f64 avg = ptd->n_expired ?
+		      (f64) ptd->late_sum_nsec / ptd->n_expired / 1e3 :
+		      0;
+	  s = format (s, "%=10u %=10u %=16lu %=16.2f %=16.2f\n",
+		      ptd - bm->per_thread_data, ptd->n_sessions,
+		      ptd->n_expired, avg, ptd->late_max_nsec / 1e3);
+	}
+      vlib_cli_output (vm, "%v", s);
+      vec_free (s);
+    }
   else
     {
       vlib_cli_output (vm, "Number of configured BFD sessions: %lu\n",
@@ -215,7 +233,7 @@ show_bfd (vlib_main_t * vm, unformat_input_t * input,
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (show_bfd_command, static) = {
   .path = "show bfd",
-  .short_help = "show bfd [keys|sessions|echo-source]",
+  .short_help = "show bfd [keys|sessions|echo-source|threads]",
   .function = show_bfd,
 };
 /* *INDENT-ON* */
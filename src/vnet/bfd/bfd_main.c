@@ -77,6 +77,17 @@ bfd_time_now_nsec (vlib_main_t * vm, f64 * vm_time)
 }
 
 static vlib_node_registration_t bfd_process_node;
+static vlib_node_registration_t bfd_worker_timer_node;
+
+typedef enum
+{
+  BFD_WORKER_TIMER_ERROR_NO_BUFFER,
+  BFD_WORKER_TIMER_N_ERROR,
+} bfd_worker_timer_error_t;
+
+static char *bfd_worker_timer_error_strings[] = {
+  [BFD_WORKER_TIMER_ERROR_NO_BUFFER] = "buffer allocation failure",
+};
 
 u8 *
 format_bfd_auth_key (u8 * s, va_list * args)
@@ -327,11 +338,13 @@ bfd_set_timer (bfd_main_t * bm, bfd_session_t * bs, u64 now,
   if (next)
     {
       int send_signal = 0;
+      bfd_per_thread_data_t *ptd =
+	vec_elt_at_index (bm->per_thread_data, bs->thread_index);
       bs->event_time_nsec = next;
       /* add extra tick if it's not even */
       u32 wheel_time_ticks =
-	(bs->event_time_nsec - now) / bm->nsec_per_tw_tick +
-	((bs->event_time_nsec - now) % bm->nsec_per_tw_tick != 0);
+	(bs->event_time_nsec - now) / ptd->nsec_per_tw_tick +
+	((bs->event_time_nsec - now) % ptd->nsec_per_tw_tick != 0);
       BFD_DBG ("event_time_nsec %lu (%lu nsec/%.3fs in future) -> "
 	       "wheel_time_ticks %u", bs->event_time_nsec,
 	       bs->event_time_nsec - now,
@@ -340,19 +353,25 @@ bfd_set_timer (bfd_main_t * bm, bfd_session_t * bs, u64 now,
       bfd_lock (bm);
       if (bs->tw_id)
 	{
-	  TW (tw_timer_update) (&bm->wheel, bs->tw_id, wheel_time_ticks);
-	  BFD_DBG ("tw_timer_update(%p, %u, %lu);", &bm->wheel, bs->tw_id,
+	  TW (tw_timer_update) (&ptd->wheel, bs->tw_id, wheel_time_ticks);
+	  BFD_DBG ("tw_timer_update(%p, %u, %lu);", &ptd->wheel, bs->tw_id,
 		   wheel_time_ticks);
 	}
       else
 	{
 	  bs->tw_id =
-	    TW (tw_timer_start) (&bm->wheel, bs->bs_idx, 0, wheel_time_ticks);
-	  BFD_DBG ("tw_timer_start(%p, %u, 0, %lu) == %u;", &bm->wheel,
+	    TW (tw_timer_start) (&ptd->wheel, bs->bs_idx, 0, wheel_time_ticks);
+	  BFD_DBG ("tw_timer_start(%p, %u, 0, %lu) == %u;", &ptd->wheel,
 		   bs->bs_idx, wheel_time_ticks);
 	}
 
-      if (!handling_wakeup)
+      /* a worker runs its wheel once the first of its timers is due */
+      if (bs->thread_index)
+	{
+	  if (bs->event_time_nsec < ptd->next_wakeup_nsec)
+	    ptd->next_wakeup_nsec = bs->event_time_nsec;
+	}
+      else if (!handling_wakeup)
 	{
 
 	  /* Send only if it is earlier than current awaited wakeup time */
@@ -460,8 +479,17 @@ bfd_session_start (bfd_main_t * bm, bfd_session_t * bs)
 		 format_bfd_session_brief, bs);
   bfd_set_effective_required_min_rx (bs, bs->config_required_min_rx_nsec);
   bfd_recalc_tx_interval (bs);
-  vlib_process_signal_event (bm->vlib_main, bm->bfd_process_node_index,
-			     BFD_EVENT_NEW_SESSION, bs->bs_idx);
+  if (bs->thread_index)
+    {
+      /* the owner sends the first frame on the next tick of its wheel */
+      u64 now = bfd_time_now_nsec (bm->vlib_main, NULL);
+      ASSERT (vlib_worker_thread_barrier_held ());
+      bs->tx_timeout_nsec = now;
+      bfd_set_timer (bm, bs, now, 0);
+    }
+  else
+    vlib_process_signal_event (bm->vlib_main, bm->bfd_process_node_index,
+			       BFD_EVENT_NEW_SESSION, bs->bs_idx);
   bfd_notify_listeners (bm, BFD_LISTEN_EVENT_CREATE, bs);
 }
 
@@ -568,78 +596,108 @@ bfd_input_format_trace (u8 * s, va_list * args)
 
 typedef struct
 {
-  u32 bs_idx;
-} bfd_rpc_event_t;
+  u32 thread_index;
+  u32 n_sessions;
+  bfd_session_t sessions[0];
+} bfd_rpc_state_change_t;
 
 static void
-bfd_rpc_event_cb (const bfd_rpc_event_t * a)
+bfd_rpc_state_change_cb (const bfd_rpc_state_change_t *a)
 {
   bfd_main_t *bm = &bfd_main;
-  u32 bs_idx = a->bs_idx;
-  u32 valid_bs = 0;
+  bfd_per_thread_data_t *ptd;
   bfd_session_t session_data;
+  u32 i;
 
-  bfd_lock (bm);
-  if (!pool_is_free_index (bm->sessions, bs_idx))
-    {
-      bfd_session_t *bs = pool_elt_at_index (bm->sessions, bs_idx);
-      clib_memcpy (&session_data, bs, sizeof (bfd_session_t));
-      valid_bs = 1;
-    }
-  else
+  for (i = 0; i < a->n_sessions; i++)
     {
-      BFD_DBG ("Ignoring event RPC for non-existent session index %u",
-	       bs_idx);
+      u32 bs_idx = a->sessions[i].bs_idx;
+      u32 valid_bs = 0;
+
+      bfd_lock (bm);
+      if (!pool_is_free_index (bm->sessions, bs_idx))
+	{
+	  clib_memcpy (&session_data, &a->sessions[i], sizeof (bfd_session_t));
+	  valid_bs = 1;
+	}
+      else
+	{
+	  BFD_DBG ("Ignoring state change RPC for non-existent session "
+		   "index %u",
+		   bs_idx);
+	}
+      bfd_unlock (bm);
+
+      if (valid_bs)
+	{
+	  bfd_event (bm, &session_data);
+	  bfd_notify_listeners (bm, BFD_LISTEN_EVENT_UPDATE, &session_data);
+	}
     }
-  bfd_unlock (bm);
 
-  if (valid_bs)
-    bfd_event (bm, &session_data);
+  /* the worker may send its next batch */
+  ptd = vec_elt_at_index (bm->per_thread_data, a->thread_index);
+  clib_atomic_store_rel_n (&ptd->state_change_rpc_pending, 0);
 }
 
+/*
+ * Send the snapshots of the sessions which changed state to the main thread,
+ * batched as each RPC costs a barrier sync. Only one RPC is queued at a time:
+ * while the main thread is busy, e.g. with a long CLI, the snapshots pile up
+ * here, one per session, rather than as RPC messages in the API segment.
+ */
 static void
-bfd_event_rpc (u32 bs_idx)
+bfd_flush_state_changes (bfd_main_t *bm, bfd_per_thread_data_t *ptd)
 {
-  const u32 data_size = sizeof (bfd_rpc_event_t);
-  u8 data[data_size];
-  bfd_rpc_event_t *event = (bfd_rpc_event_t *) data;
+  bfd_rpc_state_change_t *a;
+  u32 n = vec_len (ptd->state_changes);
+  u8 *data = 0;
+  u32 i;
 
-  event->bs_idx = bs_idx;
-  vl_api_rpc_call_main_thread (bfd_rpc_event_cb, data, data_size);
-}
+  if (!n || clib_atomic_load_acq_n (&ptd->state_change_rpc_pending))
+    return;
 
-typedef struct
-{
-  u32 bs_idx;
-} bfd_rpc_notify_listeners_t;
+  n = clib_min (n, BFD_STATE_CHANGES_PER_RPC);
+  vec_validate (data, sizeof (*a) + n * sizeof (bfd_session_t) - 1);
+  a = (bfd_rpc_state_change_t *) data;
+  a->thread_index = ptd - bm->per_thread_data;
+  a->n_sessions = n;
+  clib_memcpy_fast (a->sessions, ptd->state_changes,
+		    n * sizeof (bfd_session_t));
+  ptd->state_change_rpc_pending = 1;
+  vl_api_rpc_call_main_thread (bfd_rpc_state_change_cb, data, vec_len (data));
+  vec_free (data);
 
-static void
-bfd_rpc_notify_listeners_cb (const bfd_rpc_notify_listeners_t * a)
-{
-  bfd_main_t *bm = &bfd_main;
-  u32 bs_idx = a->bs_idx;
-  bfd_lock (bm);
-  if (!pool_is_free_index (bm->sessions, bs_idx))
-    {
-      bfd_session_t *bs = pool_elt_at_index (bm->sessions, bs_idx);
-      bfd_notify_listeners (bm, BFD_LISTEN_EVENT_UPDATE, bs);
-    }
-  else
-    {
-      BFD_DBG ("Ignoring notify RPC for non-existent session index %u",
-	       bs_idx);
-    }
-  bfd_unlock (bm);
+  vec_delete (ptd->state_changes, n, 0);
+  hash_free (ptd->state_change_by_bs_idx);
+  vec_foreach_index (i, ptd->state_changes)
+    hash_set (ptd->state_change_by_bs_idx, ptd->state_changes[i].bs_idx, i);
 }
 
+/*
+ * The session belongs to the worker, so the main thread gets a snapshot of
+ * it rather than reading it while the worker keeps changing it. A session
+ * changing state again before the flush only updates its snapshot.
+ */
 static void
-bfd_notify_listeners_rpc (u32 bs_idx)
+bfd_queue_state_change (bfd_main_t *bm, const bfd_session_t *bs)
 {
-  const u32 data_size = sizeof (bfd_rpc_notify_listeners_t);
-  u8 data[data_size];
-  bfd_rpc_notify_listeners_t *notify = (bfd_rpc_notify_listeners_t *) data;
-  notify->bs_idx = bs_idx;
-  vl_api_rpc_call_main_thread (bfd_rpc_notify_listeners_cb, data, data_size);
+  bfd_per_thread_data_t *ptd =
+    vec_elt_at_index (bm->per_thread_data, bs->thread_index);
+  uword *p = hash_get (ptd->state_change_by_bs_idx, bs->bs_idx);
+
+  if (p)
+    {
+      clib_memcpy_fast (vec_elt_at_index (ptd->state_changes, p[0]), bs,
+			sizeof (*bs));
+      return;
+    }
+  hash_set (ptd->state_change_by_bs_idx, bs->bs_idx,
+	    vec_len (ptd->state_changes));
+  vec_add1 (ptd->state_changes, *bs);
+  /* the worker timer node sends the rest on the next loop */
+  if (vec_len (ptd->state_changes) >= BFD_STATE_CHANGES_PER_RPC)
+    bfd_flush_state_changes (bm, ptd);
 }
 
 static void
@@ -652,11 +710,6 @@ bfd_on_state_change (bfd_main_t * bm, bfd_session_t * bs, u64 now,
     {
       bfd_event (bm, bs);
     }
-  else
-    {
-      /* without RPC - a REGRESSION: BFD event are not propagated */
-      bfd_event_rpc (bs->bs_idx);
-    }
 
   switch (bs->local_state)
     {
@@ -702,7 +755,7 @@ bfd_on_state_change (bfd_main_t * bm, bfd_session_t * bs, u64 now,
   else
     {
       /* without RPC - a REGRESSION: state changes are not propagated */
-      bfd_notify_listeners_rpc (bs->bs_idx);
+      bfd_queue_state_change (bm, bs);
     }
 }
 
@@ -902,6 +955,20 @@ bfd_init_control_frame (bfd_session_t *bs, vlib_buffer_t *b)
   b->current_length = bfd_length;
 }
 
+/*
+ * vlib_log may only be used on the main thread, the workers count the
+ * failure on their timer node instead
+ */
+static void
+bfd_buffer_alloc_failure (vlib_main_t *vm, bfd_main_t *bm)
+{
+  if (vm->thread_index)
+    vlib_node_increment_counter (vm, bfd_worker_timer_node.index,
+				 BFD_WORKER_TIMER_ERROR_NO_BUFFER, 1);
+  else
+    vlib_log_crit (bm->log_class, "buffer allocation failure");
+}
+
 static void
 bfd_send_echo (vlib_main_t *vm, bfd_main_t *bm, bfd_session_t *bs, u64 now)
 {
@@ -917,7 +984,7 @@ bfd_send_echo (vlib_main_t *vm, bfd_main_t *bm, bfd_session_t *bs, u64 now)
       u32 bi;
       if (vlib_buffer_alloc (vm, &bi, 1) != 1)
 	{
-	  vlib_log_crit (bm->log_class, "buffer allocation failure");
+	  bfd_buffer_alloc_failure (vm, bm);
 	  return;
 	}
       vlib_buffer_t *b = vlib_get_buffer (vm, bi);
@@ -984,7 +1051,7 @@ bfd_send_periodic (vlib_main_t *vm, bfd_main_t *bm, bfd_session_t *bs, u64 now)
       u32 bi;
       if (vlib_buffer_alloc (vm, &bi, 1) != 1)
 	{
-	  vlib_log_crit (bm->log_class, "buffer allocation failure");
+	  bfd_buffer_alloc_failure (vm, bm);
 	  return;
 	}
       vlib_buffer_t *b = vlib_get_buffer (vm, bi);
@@ -1128,6 +1195,40 @@ bfd_on_timeout (vlib_main_t *vm, bfd_main_t *bm, bfd_session_t *bs, u64 now)
     }
 }
 
+static u32
+bfd_expire_timers (vlib_main_t *vm, bfd_main_t *bm, bfd_per_thread_data_t *ptd,
+		   f64 vm_time, u64 now)
+{
+  u32 *p, n_expired;
+
+  BFD_DBG ("tw_timer_expire_timers_vec(%p, %.04f);", &ptd->wheel, vm_time);
+  ptd->expired =
+    TW (tw_timer_expire_timers_vec) (&ptd->wheel, vm_time, ptd->expired);
+  BFD_DBG ("Expired %d elements", vec_len (ptd->expired));
+  vec_foreach (p, ptd->expired)
+    {
+      const u32 bs_idx = *p;
+      if (!pool_is_free_index (bm->sessions, bs_idx))
+	{
+	  bfd_session_t *bs = pool_elt_at_index (bm->sessions, bs_idx);
+	  bs->tw_id = 0; /* timer is gone because it expired */
+	  if (now > bs->event_time_nsec)
+	    {
+	      u64 late = now - bs->event_time_nsec;
+	      ptd->late_sum_nsec += late;
+	      ptd->late_max_nsec = clib_max (ptd->late_max_nsec, late);
+	    }
+	  bfd_on_timeout (vm, bm, bs, now);
+	  bfd_set_timer (bm, bs, now, 1);
+	}
+    }
+  n_expired = vec_len (ptd->expired);
+  ptd->n_expired += n_expired;
+  vec_reset_length (ptd->expired);
+  bfd_udp_flush_tx_frames (vm);
+  return n_expired;
+}
+
 /*
  * bfd process node function
  */
@@ -1136,7 +1237,7 @@ bfd_process (vlib_main_t *vm, CLIB_UNUSED (vlib_node_runtime_t *rt),
 	     CLIB_UNUSED (vlib_frame_t *f))
 {
   bfd_main_t *bm = &bfd_main;
-  u32 *expired = 0;
+  bfd_per_thread_data_t *ptd = vec_elt_at_index (bm->per_thread_data, 0);
   uword event_type, *event_data = 0;
 
   /* So we can send events to the bfd process */
@@ -1153,37 +1254,41 @@ bfd_process (vlib_main_t *vm, CLIB_UNUSED (vlib_node_runtime_t *rt),
       if (pool_elts (bm->sessions))
 	{
 	  u32 first_expires_in_ticks =
-	    TW (tw_timer_first_expires_in_ticks) (&bm->wheel);
+	    TW (tw_timer_first_expires_in_ticks) (&ptd->wheel);
+	  u64 next_expire_nsec;
 	  if (!first_expires_in_ticks)
 	    {
 	      BFD_DBG
 		("tw_timer_first_expires_in_ticks(%p) returns 0ticks",
-		 &bm->wheel);
-	      timeout = bm->wheel.next_run_time - vm_time;
+		 &ptd->wheel);
+	      timeout = ptd->wheel.next_run_time - vm_time;
 	      BFD_DBG ("wheel.next_run_time is %.9f",
-		       bm->wheel.next_run_time);
-	      u64 next_expire_nsec = now + timeout * SEC_PER_NSEC;
-	      bm->bfd_process_next_wakeup_nsec = next_expire_nsec;
-	      bfd_unlock (bm);
+		       ptd->wheel.next_run_time);
+	      next_expire_nsec = now + timeout * NSEC_PER_SEC;
 	    }
 	  else
 	    {
 	      BFD_DBG ("tw_timer_first_expires_in_ticks(%p) returns %luticks",
-		       &bm->wheel, first_expires_in_ticks);
-	      u64 next_expire_nsec =
-		now + first_expires_in_ticks * bm->nsec_per_tw_tick;
-	      bm->bfd_process_next_wakeup_nsec = next_expire_nsec;
-	      bfd_unlock (bm);
-	      ASSERT (next_expire_nsec - now <= UINT32_MAX);
-	      // cast to u32 to avoid warning
-	      timeout = (u32) (next_expire_nsec - now) * SEC_PER_NSEC;
+		       &ptd->wheel, first_expires_in_ticks);
+	      next_expire_nsec =
+		now + first_expires_in_ticks * ptd->nsec_per_tw_tick;
 	    }
+	  bm->bfd_process_next_wakeup_nsec = next_expire_nsec;
+	  bfd_unlock (bm);
+	  ASSERT (next_expire_nsec <= now ||
+		  next_expire_nsec - now <= UINT32_MAX);
+	  timeout = next_expire_nsec > now ?
+		      // cast to u32 to avoid warning
+		      (u32) (next_expire_nsec - now) * SEC_PER_NSEC :
+		      0;
 	  BFD_DBG ("vlib_process_wait_for_event_or_clock(vm, %.09f)",
 		   timeout);
 	  (void) vlib_process_wait_for_event_or_clock (vm, timeout);
 	}
       else
 	{
+	  /* a stale wakeup time would hold back the signal of a new timer */
+	  bm->bfd_process_next_wakeup_nsec = ~0ULL;
 	  bfd_unlock (bm);
 	  (void) vlib_process_wait_for_event (vm);
 	}
@@ -1246,28 +1351,9 @@ bfd_process (vlib_main_t *vm, CLIB_UNUSED (vlib_node_runtime_t *rt),
 	  vlib_log_err (bm->log_class, "BUG: event type 0x%wx", event_type);
 	  break;
 	}
-      BFD_DBG ("tw_timer_expire_timers_vec(%p, %.04f);", &bm->wheel, vm_time);
       bfd_lock (bm);
-      expired =
-	TW (tw_timer_expire_timers_vec) (&bm->wheel, vm_time, expired);
-      BFD_DBG ("Expired %d elements", vec_len (expired));
-      u32 *p = NULL;
-      vec_foreach (p, expired)
-      {
-	const u32 bs_idx = *p;
-	if (!pool_is_free_index (bm->sessions, bs_idx))
-	  {
-	    bfd_session_t *bs = pool_elt_at_index (bm->sessions, bs_idx);
-	    bs->tw_id = 0;	/* timer is gone because it expired */
-	    bfd_on_timeout (vm, bm, bs, now);
-	    bfd_set_timer (bm, bs, now, 1);
-	  }
-      }
+      bfd_expire_timers (vm, bm, ptd, vm_time, now);
       bfd_unlock (bm);
-      if (expired)
-	{
-	  vec_set_len (expired, 0);
-	}
       if (event_data)
 	{
 	  vec_set_len (event_data, 0);
@@ -1288,6 +1374,60 @@ VLIB_REGISTER_NODE (bfd_process_node, static) = {
   .next_nodes = {},
 };
 
+/*
+ * Note when the first timer of a worker's wheel is due, the worker timer
+ * node leaves the wheel alone until then
+ */
+static void
+bfd_worker_set_next_wakeup (bfd_per_thread_data_t *ptd, f64 vm_time, u64 now)
+{
+  u32 first_expires_in_ticks =
+    TW (tw_timer_first_expires_in_ticks) (&ptd->wheel);
+
+  if (first_expires_in_ticks)
+    ptd->next_wakeup_nsec =
+      now + first_expires_in_ticks * ptd->nsec_per_tw_tick;
+  else
+    ptd->next_wakeup_nsec =
+      now + clib_max (ptd->wheel.next_run_time - vm_time, 0) * NSEC_PER_SEC;
+}
+
+/*
+ * bfd worker timer node function - polls on the workers which own sessions,
+ * runs their wheel when its first timer is due and sends the state changes
+ * queued by the input nodes
+ */
+static uword
+bfd_worker_timer (vlib_main_t *vm, CLIB_UNUSED (vlib_node_runtime_t *rt),
+		  CLIB_UNUSED (vlib_frame_t *f))
+{
+  bfd_main_t *bm = &bfd_main;
+  bfd_per_thread_data_t *ptd =
+    vec_elt_at_index (bm->per_thread_data, vm->thread_index);
+  f64 vm_time;
+  u64 now = bfd_time_now_nsec (vm, &vm_time);
+  uword n_expired = 0;
+
+  if (now >= ptd->next_wakeup_nsec)
+    {
+      n_expired = bfd_expire_timers (vm, bm, ptd, vm_time, now);
+      bfd_worker_set_next_wakeup (ptd, vm_time, now);
+    }
+
+  /* state changes from the timers as well as from the input nodes */
+  bfd_flush_state_changes (bm, ptd);
+  return n_expired;
+}
+
+VLIB_REGISTER_NODE (bfd_worker_timer_node, static) = {
+  .function = bfd_worker_timer,
+  .type = VLIB_NODE_TYPE_INPUT,
+  .name = "bfd-worker-timer",
+  .state = VLIB_NODE_STATE_DISABLED,
+  .n_errors = BFD_WORKER_TIMER_N_ERROR,
+  .error_strings = bfd_worker_timer_error_strings,
+};
+
 static clib_error_t *
 bfd_sw_interface_up_down (CLIB_UNUSED (vnet_main_t *vnm),
 			  CLIB_UNUSED (u32 sw_if_index), u32 flags)
@@ -1333,6 +1473,7 @@ bfd_main_init (vlib_main_t * vm)
 {
   vlib_thread_main_t *tm = &vlib_thread_main;
   u32 n_vlib_mains = tm->n_vlib_mains;
+  bfd_per_thread_data_t *ptd;
 #if BFD_DEBUG
   setbuf (stdout, NULL);
 #endif
@@ -1340,15 +1481,20 @@ bfd_main_init (vlib_main_t * vm)
   bm->random_seed = random_default_seed ();
   bm->vlib_main = vm;
   bm->vnet_main = vnet_get_main ();
-  clib_memset (&bm->wheel, 0, sizeof (bm->wheel));
-  bm->nsec_per_tw_tick = (f64) NSEC_PER_SEC / BFD_TW_TPS;
   bm->default_desired_min_tx_nsec =
     bfd_usec_to_nsec (BFD_DEFAULT_DESIRED_MIN_TX_USEC);
   bm->min_required_min_rx_while_echo_nsec =
     bfd_usec_to_nsec (BFD_REQUIRED_MIN_RX_USEC_WHILE_ECHO);
-  BFD_DBG ("tw_timer_wheel_init(%p, %p, %.04f, %u)", &bm->wheel, NULL,
-	   1.00 / BFD_TW_TPS, ~0);
-  TW (tw_timer_wheel_init) (&bm->wheel, NULL, 1.00 / BFD_TW_TPS, ~0);
+  vec_validate_aligned (bm->per_thread_data, n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_foreach (ptd, bm->per_thread_data)
+    {
+      u32 tps = ptd == bm->per_thread_data ? BFD_TW_TPS : BFD_TW_WORKER_TPS;
+      ptd->nsec_per_tw_tick = (f64) NSEC_PER_SEC / tps;
+      BFD_DBG ("tw_timer_wheel_init(%p, %p, %.04f, %u)", &ptd->wheel, NULL,
+	       1.00 / tps, ~0);
+      TW (tw_timer_wheel_init) (&ptd->wheel, NULL, 1.00 / tps, ~0);
+    }
   bm->log_class = vlib_log_register_class ("bfd", 0);
   vlib_log_debug (bm->log_class, "initialized");
   bm->owner_thread_index = ~0;
@@ -1367,6 +1513,55 @@ bfd_main_init (vlib_main_t * vm)
 
 VLIB_INIT_FUNCTION (bfd_main_init);
 
+/*
+ * With workers, the sessions are spread over them round robin and the main
+ * thread keeps none, otherwise the main thread owns all of them.
+ */
+static u32
+bfd_pick_owner_thread (bfd_main_t *bm)
+{
+  u32 n_workers = vec_len (bm->per_thread_data) - 1;
+
+  if (!n_workers)
+    return 0;
+  bm->last_owner_thread_index = bm->last_owner_thread_index % n_workers + 1;
+  return bm->last_owner_thread_index;
+}
+
+static void
+bfd_session_add_to_thread (bfd_main_t *bm, bfd_session_t *bs)
+{
+  bfd_per_thread_data_t *ptd =
+    vec_elt_at_index (bm->per_thread_data, bs->thread_index);
+
+  if (0 == ptd->n_sessions++ && bs->thread_index)
+    {
+      /* wheel was idle, restart its clock rather than catch up the ticks */
+      ptd->wheel.last_run_time = 0.0;
+      ptd->next_wakeup_nsec = ~0ULL;
+      vlib_node_set_state (vlib_get_main_by_index (bs->thread_index),
+			   bfd_worker_timer_node.index,
+			   VLIB_NODE_STATE_POLLING);
+    }
+}
+
+static void
+bfd_session_del_from_thread (bfd_main_t *bm, bfd_session_t *bs)
+{
+  bfd_per_thread_data_t *ptd =
+    vec_elt_at_index (bm->per_thread_data, bs->thread_index);
+
+  if (bs->tw_id)
+    {
+      TW (tw_timer_stop) (&ptd->wheel, bs->tw_id);
+      bs->tw_id = 0;
+    }
+  if (0 == --ptd->n_sessions && bs->thread_index)
+    vlib_node_set_state (vlib_get_main_by_index (bs->thread_index),
+			 bfd_worker_timer_node.index,
+			 VLIB_NODE_STATE_DISABLED);
+}
+
 bfd_session_t *
 bfd_get_session (bfd_main_t * bm, bfd_transport_e t)
 {
@@ -1378,6 +1573,7 @@ bfd_get_session (bfd_main_t * bm, bfd_transport_e t)
   clib_memset (result, 0, sizeof (*result));
   result->bs_idx = result - bm->sessions;
   result->transport = t;
+  result->thread_index = bfd_pick_owner_thread (bm);
   const unsigned limit = 1000;
   unsigned counter = 0;
   do
@@ -1396,6 +1592,7 @@ bfd_get_session (bfd_main_t * bm, bfd_transport_e t)
     }
   while (hash_get (bm->session_by_disc, result->local_discr));
   bfd_set_defaults (bm, result);
+  bfd_session_add_to_thread (bm, result);
   hash_set (bm->session_by_disc, result->local_discr, result->bs_idx);
   bfd_validate_counters (bm);
   vlib_zero_combined_counter (&bm->rx_counter, result->bs_idx);
@@ -1422,6 +1619,7 @@ bfd_put_session (bfd_main_t * bm, bfd_session_t * bs)
       --bs->auth.next_key->use_count;
     }
   hash_unset (bm->session_by_disc, bs->local_discr);
+  bfd_session_del_from_thread (bm, bs);
   vlib_zero_combined_counter (&bm->rx_counter, bs->bs_idx);
   vlib_zero_combined_counter (&bm->rx_echo_counter, bs->bs_idx);
   vlib_zero_combined_counter (&bm->tx_counter, bs->bs_idx);
@@ -1518,7 +1716,8 @@ bfd_session_switch_auth_to_next (bfd_session_t * bs)
   bs->auth.is_delayed = 0;
   if (bs->auth.curr_key)
     {
-      --bs->auth.curr_key->use_count;
+      /* keys are shared by sessions owned by different threads */
+      clib_atomic_fetch_sub (&bs->auth.curr_key->use_count, 1);
     }
   bs->auth.curr_key = bs->auth.next_key;
   bs->auth.next_key = NULL;
@@ -2168,8 +2367,16 @@ bfd_session_set_params (bfd_main_t * bm, bfd_session_t * bs,
 
       vlib_log_info (bm->log_class, "changed session params: %U",
 		     format_bfd_session_brief, bs);
-      vlib_process_signal_event (bm->vlib_main, bm->bfd_process_node_index,
-				 BFD_EVENT_CONFIG_CHANGED, bs->bs_idx);
+      if (bs->thread_index)
+	{
+	  /* workers are stopped, reschedule on the owner's wheel directly */
+	  ASSERT (vlib_worker_thread_barrier_held ());
+	  bfd_on_config_change (bm, bs,
+				bfd_time_now_nsec (bm->vlib_main, NULL));
+	}
+      else
+	vlib_process_signal_event (bm->vlib_main, bm->bfd_process_node_index,
+				   BFD_EVENT_CONFIG_CHANGED, bs->bs_idx);
     }
   else
     {
@@ -159,6 +159,9 @@ typedef struct bfd_session_s
   /** timing wheel internal id used to manipulate timer (if set) */
   u32 tw_id;
 
+  /** thread owning the session - runs its timer and consumes its packets */
+  u32 thread_index;
+
   /** transmit interval */
   u64 transmit_interval_nsec;
 
@@ -262,6 +265,40 @@ typedef enum
  */
 typedef void (*bfd_notify_fn_t) (bfd_listen_event_e, const bfd_session_t *);
 
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+
+  /** timing wheel for scheduling timeouts of the sessions owned */
+  TWT (tw_timer_wheel) wheel;
+
+  /** how many nanoseconds is one timing wheel tick */
+  u64 nsec_per_tw_tick;
+
+  /** scratch vector of expired timers */
+  u32 *expired;
+
+  /** number of sessions owned by this thread */
+  u32 n_sessions;
+
+  /** snapshots of the sessions which changed state, for the main thread */
+  bfd_session_t *state_changes;
+
+  /** hashmap - index in state_changes by session index */
+  uword *state_change_by_bs_idx;
+
+  /** set while an RPC with state changes waits for the main thread */
+  u32 state_change_rpc_pending;
+
+  /** when the wheel of this worker is to be run next, ~0 if not at all */
+  u64 next_wakeup_nsec;
+
+  /** number of expired timers and how late they were handled */
+  u64 n_expired;
+  u64 late_sum_nsec;
+  u64 late_max_nsec;
+} bfd_per_thread_data_t;
+
 typedef struct
 {
   /** lock to protect data structures */
@@ -284,8 +321,11 @@ typedef struct
   /** pool of bfd sessions context data */
   bfd_session_t *sessions;
 
-  /** timing wheel for scheduling timeouts */
-    TWT (tw_timer_wheel) wheel;
+  /** per thread timing wheels, sessions are spread over the workers */
+  bfd_per_thread_data_t *per_thread_data;
+
+  /** thread which got the last new session */
+  u32 last_owner_thread_index;
 
   /** hashmap - bfd session by discriminator */
   u32 *session_by_disc;
@@ -297,9 +337,6 @@ typedef struct
   vlib_main_t *vlib_main;
   vnet_main_t *vnet_main;
 
-  /** how many nanoseconds is one timing wheel tick */
-  u64 nsec_per_tw_tick;
-
   /** default desired min tx in nsec */
   u64 default_desired_min_tx_nsec;
 
@@ -371,11 +408,19 @@ typedef CLIB_PACKED (struct {
 }) bfd_echo_pkt_t;
 /* *INDENT-ON* */
 
+/*
+ * A session is only ever touched by its owner thread, anything shared is
+ * changed on the main thread under the worker barrier, so only the main
+ * thread takes the lock.
+ */
 static inline void
 bfd_lock (bfd_main_t * bm)
 {
   uword my_thread_index = __os_thread_index;
 
+  if (my_thread_index)
+    return;
+
   if (bm->owner_thread_index == my_thread_index
       && bm->lock_recursion_count > 0)
     {
@@ -392,6 +437,9 @@ static inline void
 bfd_unlock (bfd_main_t * bm)
 {
   uword my_thread_index = __os_thread_index;
+
+  if (my_thread_index)
+    return;
   ASSERT (bm->owner_thread_index == my_thread_index);
 
   if (bm->lock_recursion_count > 1)
@@ -407,7 +455,7 @@ bfd_unlock (bfd_main_t * bm)
 static inline void
 bfd_lock_check (bfd_main_t * bm)
 {
-  if (PREDICT_FALSE (bm->lock_recursion_count < 1))
+  if (PREDICT_FALSE (bm->lock_recursion_count < 1 && !__os_thread_index))
     clib_warning ("lock check failure");
 }
 
@@ -455,6 +503,13 @@ const char *bfd_poll_state_string (bfd_poll_state_e state);
 /** timing wheel tick-rate, 1ms should be good enough */
 #define BFD_TW_TPS (MSEC_PER_SEC)
 
+/** most state changes a worker sends to the main thread in one RPC, a
+ * worker has one such RPC queued at a time */
+#define BFD_STATE_CHANGES_PER_RPC 32
+
+/** workers poll their wheels anyway, 100us ticks suit 3.3ms intervals */
+#define BFD_TW_WORKER_TPS (10 * MSEC_PER_SEC)
+
 /** default, slow transmission interval for BFD packets, per spec at least 1s */
 #define BFD_DEFAULT_DESIRED_MIN_TX_USEC USEC_PER_SEC
 
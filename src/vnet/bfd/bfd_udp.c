@@ -41,6 +41,14 @@
 #include <vnet/bfd/bfd_main.h>
 #include <vnet/bfd/bfd_api.h>
 
+typedef struct
+{
+  /* node the frame goes to */
+  u32 node_index;
+  /* frame being filled, sent when full or when the thread is done */
+  vlib_frame_t *frame;
+} bfd_udp_tx_frame_t;
+
 typedef struct
 {
   bfd_main_t *bfd_main;
@@ -73,6 +81,13 @@ typedef struct
   /* number of active udp6 sessions */
   u32 udp6_sessions_count;
   u32 udp6_sessions_count_stat_seg_entry;
+  /* frame queues handing packets off to the thread owning the session */
+  u32 udp4_fq_index;
+  u32 udp6_fq_index;
+  u32 echo4_fq_index;
+  u32 echo6_fq_index;
+  /* per thread frames being filled with control and echo packets */
+  bfd_udp_tx_frame_t **tx_frames;
 } bfd_udp_main_t;
 
 static vlib_node_registration_t bfd_udp4_input_node;
@@ -179,6 +194,46 @@ bfd_udp_bs_idx_to_sport (u32 bs_idx)
   return 49152 + bs_idx % (65535 - 49152 + 1);
 }
 
+/*
+ * Build the headers of the control frames once, sending only fills in the
+ * lengths and checksums.
+ */
+static void
+bfd_udp_init_headers (bfd_session_t *bs)
+{
+  bfd_udp_session_t *bus = &bs->udp;
+  const bfd_udp_key_t *key = &bus->key;
+  u16 src_port = clib_host_to_net_u16 (bfd_udp_bs_idx_to_sport (bs->bs_idx));
+
+  if (BFD_TRANSPORT_UDP4 == bs->transport)
+    {
+      bfd_udp4_headers_t *h = &bus->headers4;
+      clib_memset (h, 0, sizeof (*h));
+      h->ip4.ip_version_and_header_length = 0x45;
+      h->ip4.ttl = 255;
+      h->ip4.protocol = IP_PROTOCOL_UDP;
+      h->ip4.src_address.as_u32 = key->local_addr.ip4.as_u32;
+      h->ip4.dst_address.as_u32 = key->peer_addr.ip4.as_u32;
+      h->udp.src_port = src_port;
+      h->udp.dst_port = clib_host_to_net_u16 (UDP_DST_PORT_bfd4);
+    }
+  else
+    {
+      bfd_udp6_headers_t *h = &bus->headers6;
+      clib_memset (h, 0, sizeof (*h));
+      h->ip6.ip_version_traffic_class_and_flow_label =
+	clib_host_to_net_u32 (0x6 << 28);
+      h->ip6.hop_limit = 255;
+      h->ip6.protocol = IP_PROTOCOL_UDP;
+      clib_memcpy_fast (&h->ip6.src_address, &key->local_addr.ip6,
+			sizeof (h->ip6.src_address));
+      clib_memcpy_fast (&h->ip6.dst_address, &key->peer_addr.ip6,
+			sizeof (h->ip6.dst_address));
+      h->udp.src_port = src_port;
+      h->udp.dst_port = clib_host_to_net_u16 (UDP_DST_PORT_bfd6);
+    }
+}
+
 int
 bfd_udp_get_echo_src_ip4 (ip4_address_t * addr)
 {
@@ -273,20 +328,10 @@ bfd_add_udp4_transport (vlib_main_t * vm, u32 bi, const bfd_session_t * bs,
   vnet_buffer (b)->ip.adj_index[VLIB_TX] = bus->adj_index;
   vnet_buffer (b)->sw_if_index[VLIB_RX] = 0;
   vnet_buffer (b)->sw_if_index[VLIB_TX] = ~0;
-  typedef struct
-  {
-    ip4_header_t ip4;
-    udp_header_t udp;
-  } ip4_udp_headers;
-  ip4_udp_headers *headers = NULL;
+  bfd_udp4_headers_t *headers = NULL;
   vlib_buffer_advance (b, -sizeof (*headers));
   headers = vlib_buffer_get_current (b);
-  clib_memset (headers, 0, sizeof (*headers));
-  headers->ip4.ip_version_and_header_length = 0x45;
-  headers->ip4.ttl = 255;
-  headers->ip4.protocol = IP_PROTOCOL_UDP;
-  headers->udp.src_port =
-    clib_host_to_net_u16 (bfd_udp_bs_idx_to_sport (bs->bs_idx));
+  clib_memcpy_fast (headers, &bus->headers4, sizeof (*headers));
   if (is_echo)
     {
       int rv;
@@ -297,12 +342,6 @@ bfd_add_udp4_transport (vlib_main_t * vm, u32 bi, const bfd_session_t * bs,
       headers->ip4.dst_address.as_u32 = key->local_addr.ip4.as_u32;
       headers->udp.dst_port = clib_host_to_net_u16 (UDP_DST_PORT_bfd_echo4);
     }
-  else
-    {
-      headers->ip4.src_address.as_u32 = key->local_addr.ip4.as_u32;
-      headers->ip4.dst_address.as_u32 = key->peer_addr.ip4.as_u32;
-      headers->udp.dst_port = clib_host_to_net_u16 (UDP_DST_PORT_bfd4);
-    }
 
   /* fix ip length, checksum and udp length */
   const u16 ip_length = vlib_buffer_length_in_chain (vm, b);
@@ -328,21 +367,10 @@ bfd_add_udp6_transport (vlib_main_t * vm, u32 bi, const bfd_session_t * bs,
   vnet_buffer (b)->ip.adj_index[VLIB_TX] = bus->adj_index;
   vnet_buffer (b)->sw_if_index[VLIB_RX] = 0;
   vnet_buffer (b)->sw_if_index[VLIB_TX] = 0;
-  typedef struct
-  {
-    ip6_header_t ip6;
-    udp_header_t udp;
-  } ip6_udp_headers;
-  ip6_udp_headers *headers = NULL;
+  bfd_udp6_headers_t *headers = NULL;
   vlib_buffer_advance (b, -sizeof (*headers));
   headers = vlib_buffer_get_current (b);
-  clib_memset (headers, 0, sizeof (*headers));
-  headers->ip6.ip_version_traffic_class_and_flow_label =
-    clib_host_to_net_u32 (0x6 << 28);
-  headers->ip6.hop_limit = 255;
-  headers->ip6.protocol = IP_PROTOCOL_UDP;
-  headers->udp.src_port =
-    clib_host_to_net_u16 (bfd_udp_bs_idx_to_sport (bs->bs_idx));
+  clib_memcpy_fast (headers, &bus->headers6, sizeof (*headers));
   if (is_echo)
     {
       int rv;
@@ -355,14 +383,6 @@ bfd_add_udp6_transport (vlib_main_t * vm, u32 bi, const bfd_session_t * bs,
 
       headers->udp.dst_port = clib_host_to_net_u16 (UDP_DST_PORT_bfd_echo6);
     }
-  else
-    {
-      clib_memcpy_fast (&headers->ip6.src_address, &key->local_addr.ip6,
-			sizeof (headers->ip6.src_address));
-      clib_memcpy_fast (&headers->ip6.dst_address, &key->peer_addr.ip6,
-			sizeof (headers->ip6.dst_address));
-      headers->udp.dst_port = clib_host_to_net_u16 (UDP_DST_PORT_bfd6);
-    }
 
   /* fix ip payload length and udp length */
   const u16 udp_length =
@@ -382,21 +402,57 @@ bfd_add_udp6_transport (vlib_main_t * vm, u32 bi, const bfd_session_t * bs,
   return 1;
 }
 
+/*
+ * Packets for the same next node are batched, bfd_udp_flush_tx_frames sends
+ * them once the thread is done with its expired timers.
+ */
 static void
 bfd_create_frame_to_next_node (vlib_main_t *vm, bfd_main_t *bm,
 			       const bfd_session_t *bs, u32 bi, u32 next_node,
 			       vlib_combined_counter_main_t *tx_counter)
 {
-  vlib_frame_t *f = vlib_get_frame_to_node (vm, next_node);
-  u32 *to_next = vlib_frame_vector_args (f);
-  to_next[0] = bi;
-  f->n_vectors = 1;
-  vlib_put_frame_to_node (vm, next_node, f);
+  bfd_udp_tx_frame_t **tfs =
+    vec_elt_at_index (bfd_udp_main.tx_frames, vm->thread_index);
+  bfd_udp_tx_frame_t *tf;
+  u32 *to_next;
+
+  vec_foreach (tf, *tfs)
+    if (tf->node_index == next_node)
+      break;
+  if (tf == vec_end (*tfs))
+    {
+      vec_add2 (*tfs, tf, 1);
+      tf->node_index = next_node;
+      tf->frame = 0;
+    }
+  if (!tf->frame)
+    tf->frame = vlib_get_frame_to_node (vm, next_node);
+  to_next = vlib_frame_vector_args (tf->frame);
+  to_next[tf->frame->n_vectors++] = bi;
+  if (VLIB_FRAME_SIZE == tf->frame->n_vectors)
+    {
+      vlib_put_frame_to_node (vm, next_node, tf->frame);
+      tf->frame = 0;
+    }
   vlib_buffer_t *b = vlib_get_buffer (vm, bi);
   vlib_increment_combined_counter (tx_counter, vm->thread_index, bs->bs_idx, 1,
 				   vlib_buffer_length_in_chain (vm, b));
 }
 
+void
+bfd_udp_flush_tx_frames (vlib_main_t *vm)
+{
+  bfd_udp_tx_frame_t *tf, *tfs =
+    *vec_elt_at_index (bfd_udp_main.tx_frames, vm->thread_index);
+
+  vec_foreach (tf, tfs)
+    if (tf->frame)
+      {
+	vlib_put_frame_to_node (vm, tf->node_index, tf->frame);
+	tf->frame = 0;
+      }
+}
+
 int
 bfd_udp_calc_next_node (const struct bfd_session_s *bs, u32 * next_node)
 {
@@ -530,6 +586,7 @@ bfd_udp_add_session_internal (vlib_main_t * vm, bfd_udp_main_t * bum,
   bus->adj_index = ADJ_INDEX_INVALID;
   bfd_udp_key_t *key = &bus->key;
   bfd_udp_key_init (key, sw_if_index, local_addr, peer_addr);
+  bfd_udp_init_headers (bs);
   const bfd_session_t *tmp = bfd_lookup_session (bum, key);
   if (tmp)
     {
@@ -933,7 +990,9 @@ typedef enum
 /* Packet counters - BFD control frames */
 #define foreach_bfd_udp_error(F)           \
   F (NONE, "good bfd packets (processed)") \
-  F (BAD, "invalid bfd packets")
+  F (BAD, "invalid bfd packets")           \
+  F (HANDOFF, "bfd packets handed off")    \
+  F (HANDOFF_DROP, "bfd packets dropped on handoff congestion")
 
 #define F(sym, string) static char BFD_UDP_ERR_##sym##_STR[] = string;
 foreach_bfd_udp_error (F);
@@ -964,7 +1023,9 @@ typedef enum
 /* Packet counters - BFD ECHO packets */
 #define foreach_bfd_udp_echo_error(F)           \
   F (NONE, "good bfd echo packets (processed)") \
-  F (BAD, "invalid bfd echo packets")
+  F (BAD, "invalid bfd echo packets")           \
+  F (HANDOFF, "bfd echo packets handed off")    \
+  F (HANDOFF_DROP, "bfd echo packets dropped on handoff congestion")
 
 #define F(sym, string) static char BFD_UDP_ECHO_ERR_##sym##_STR[] = string;
 foreach_bfd_udp_echo_error (F);
@@ -1115,6 +1176,11 @@ bfd_udp4_scan (vlib_main_t *vm, vlib_buffer_t *b, bfd_session_t **bs_out)
       return BFD_UDP_ERROR_BAD;
     }
   BFD_DBG ("BFD session found, bs_idx=%u", bs->bs_idx);
+  if (bs->thread_index != vm->thread_index)
+    {
+      *bs_out = bs;
+      return BFD_UDP_ERROR_HANDOFF;
+    }
   if (!bfd_verify_pkt_auth (vm, pkt, b->current_length, bs))
     {
       BFD_ERR ("Packet verification failed, dropping packet");
@@ -1258,6 +1324,11 @@ bfd_udp6_scan (vlib_main_t *vm, vlib_buffer_t *b, bfd_session_t **bs_out)
       return BFD_UDP_ERROR_BAD;
     }
   BFD_DBG ("BFD session found, bs_idx=%u", bs->bs_idx);
+  if (bs->thread_index != vm->thread_index)
+    {
+      *bs_out = bs;
+      return BFD_UDP_ERROR_HANDOFF;
+    }
   if (!bfd_verify_pkt_auth (vm, pkt, b->current_length, bs))
     {
       BFD_ERR ("Packet verification failed, dropping packet");
@@ -1273,6 +1344,25 @@ bfd_udp6_scan (vlib_main_t *vm, vlib_buffer_t *b, bfd_session_t **bs_out)
   return BFD_UDP_ERROR_NONE;
 }
 
+/*
+ * Pass the packets of sessions owned by other threads to their owners, the
+ * owner looks them up again and consumes them.
+ */
+static void
+bfd_udp_handoff (vlib_main_t *vm, vlib_node_runtime_t *rt, u32 fq_index,
+		 u32 *buffer_indices, u16 *thread_indices, u32 n_packets,
+		 u32 handoff_error, u32 drop_error)
+{
+  u32 n_enq;
+
+  n_enq = vlib_buffer_enqueue_to_thread (vm, rt, fq_index, buffer_indices,
+					 thread_indices, n_packets, 1);
+  vlib_node_increment_counter (vm, rt->node_index, handoff_error, n_enq);
+  if (n_enq < n_packets)
+    vlib_node_increment_counter (vm, rt->node_index, drop_error,
+				 n_packets - n_enq);
+}
+
 /*
  * Process a frame of bfd packets
  * Expect 1 packet / frame
@@ -1284,6 +1374,9 @@ bfd_udp_input (vlib_main_t * vm, vlib_node_runtime_t * rt,
   u32 n_left_from, *from;
   bfd_input_trace_t *t0;
   bfd_main_t *bm = &bfd_main;
+  u32 handoff_bi[VLIB_FRAME_SIZE];
+  u16 handoff_ti[VLIB_FRAME_SIZE];
+  u32 n_handoff = 0;
 
   from = vlib_frame_vector_args (f);	/* array of buffer indices */
   n_left_from = f->n_vectors;	/* number of buffer indices */
@@ -1320,6 +1413,15 @@ bfd_udp_input (vlib_main_t * vm, vlib_node_runtime_t * rt,
 	{
 	  error0 = bfd_udp4_scan (vm, b0, &bs);
 	}
+      if (BFD_UDP_ERROR_HANDOFF == error0)
+	{
+	  bfd_unlock (bm);
+	  handoff_bi[n_handoff] = bi0;
+	  handoff_ti[n_handoff++] = bs->thread_index;
+	  from += 1;
+	  n_left_from -= 1;
+	  continue;
+	}
       b0->error = rt->errors[error0];
 
       next0 = BFD_UDP_INPUT_NEXT_NORMAL;
@@ -1375,6 +1477,13 @@ bfd_udp_input (vlib_main_t * vm, vlib_node_runtime_t * rt,
       n_left_from -= 1;
     }
 
+  if (n_handoff)
+    bfd_udp_handoff (vm, rt,
+		     is_ipv6 ? bfd_udp_main.udp6_fq_index :
+			       bfd_udp_main.udp4_fq_index,
+		     handoff_bi, handoff_ti, n_handoff, BFD_UDP_ERROR_HANDOFF,
+		     BFD_UDP_ERROR_HANDOFF_DROP);
+
   return f->n_vectors;
 }
 
@@ -1450,6 +1559,9 @@ bfd_udp_echo_input (vlib_main_t * vm, vlib_node_runtime_t * rt,
   u32 n_left_from, *from;
   bfd_input_trace_t *t0;
   bfd_main_t *bm = &bfd_main;
+  u32 handoff_bi[VLIB_FRAME_SIZE];
+  u16 handoff_ti[VLIB_FRAME_SIZE];
+  u32 n_handoff = 0;
 
   from = vlib_frame_vector_args (f);	/* array of buffer indices */
   n_left_from = f->n_vectors;	/* number of buffer indices */
@@ -1475,7 +1587,19 @@ bfd_udp_echo_input (vlib_main_t * vm, vlib_node_runtime_t * rt,
 	}
 
       bfd_session_t *bs = NULL;
+      bfd_echo_pkt_t *pkt = vlib_buffer_get_current (b0);
       bfd_lock (bm);
+      if (sizeof (*pkt) == b0->current_length &&
+	  (bs = bfd_find_session_by_disc (bm, pkt->discriminator)) &&
+	  bs->thread_index != vm->thread_index)
+	{
+	  bfd_unlock (bm);
+	  handoff_bi[n_handoff] = bi0;
+	  handoff_ti[n_handoff++] = bs->thread_index;
+	  from += 1;
+	  n_left_from -= 1;
+	  continue;
+	}
       if ((bs = bfd_consume_echo_pkt (vm, bfd_udp_main.bfd_main, b0)))
 	{
 	  b0->error = rt->errors[BFD_UDP_ERROR_NONE];
@@ -1513,6 +1637,14 @@ bfd_udp_echo_input (vlib_main_t * vm, vlib_node_runtime_t * rt,
       n_left_from -= 1;
     }
 
+  if (n_handoff)
+    bfd_udp_handoff (vm, rt,
+		     is_ipv6 ? bfd_udp_main.echo6_fq_index :
+			       bfd_udp_main.echo4_fq_index,
+		     handoff_bi, handoff_ti, n_handoff,
+		     BFD_UDP_ECHO_ERROR_HANDOFF,
+		     BFD_UDP_ECHO_ERROR_HANDOFF_DROP);
+
   return f->n_vectors;
 }
 
@@ -1550,7 +1682,7 @@ VLIB_REGISTER_NODE (bfd_udp_echo4_input_node, static) = {
   .type = VLIB_NODE_TYPE_INTERNAL,
 
   .n_errors = BFD_UDP_ECHO_N_ERROR,
-  .error_strings = bfd_udp_error_strings,
+  .error_strings = bfd_udp_echo_error_strings,
 
   .format_trace = bfd_echo_input_format_trace,
 
@@ -1693,6 +1825,16 @@ bfd_udp_init (vlib_main_t * vm)
 
   bfd_udp_stats_init (&bfd_udp_main);
 
+  bfd_udp_main.udp4_fq_index =
+    vlib_frame_queue_main_init (bfd_udp4_input_node.index, 0);
+  bfd_udp_main.udp6_fq_index =
+    vlib_frame_queue_main_init (bfd_udp6_input_node.index, 0);
+  bfd_udp_main.echo4_fq_index =
+    vlib_frame_queue_main_init (bfd_udp_echo4_input_node.index, 0);
+  bfd_udp_main.echo6_fq_index =
+    vlib_frame_queue_main_init (bfd_udp_echo6_input_node.index, 0);
+  vec_validate (bfd_udp_main.tx_frames, vlib_thread_main.n_vlib_mains - 1);
+
   bfd_udp_main.log_class = vlib_log_register_class ("bfd", "udp");
   vlib_log_debug (bfd_udp_main.log_class, "initialized");
   return 0;
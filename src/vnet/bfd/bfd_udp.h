@@ -21,7 +21,9 @@
 
 #include <vppinfra/clib.h>
 #include <vnet/adj/adj_types.h>
+#include <vnet/ip/ip4_packet.h>
 #include <vnet/ip/ip6_packet.h>
+#include <vnet/udp/udp_packet.h>
 #include <vnet/bfd/bfd_api.h>
 
 /** identifier of BFD session based on UDP transport only */
@@ -38,6 +40,18 @@ typedef CLIB_PACKED (struct {
   ip46_address_t peer_addr;
 }) bfd_udp_key_t;
 
+/** ip4 and udp headers in front of a bfd packet */
+typedef CLIB_PACKED (struct {
+  ip4_header_t ip4;
+  udp_header_t udp;
+}) bfd_udp4_headers_t;
+
+/** ip6 and udp headers in front of a bfd packet */
+typedef CLIB_PACKED (struct {
+  ip6_header_t ip6;
+  udp_header_t udp;
+}) bfd_udp6_headers_t;
+
 /** UDP transport specific data embedded in bfd_session's union */
 typedef struct
 {
@@ -45,6 +59,12 @@ typedef struct
   bfd_udp_key_t key;
   /** adjacency index returned from adj lock call */
   adj_index_t adj_index;
+  /** prebuilt headers of control frames, lengths and checksums are zero */
+  union
+  {
+    bfd_udp4_headers_t headers4;
+    bfd_udp6_headers_t headers6;
+  };
 } bfd_udp_session_t;
 
 /** bfd udp echo packet trace capture */
@@ -93,6 +113,11 @@ int bfd_transport_udp4 (vlib_main_t *vm, u32 bi,
 int bfd_transport_udp6 (vlib_main_t *vm, u32 bi,
 			const struct bfd_session_s *bs, int is_echo);
 
+/**
+ * @brief send the frames batched by the transport functions on this thread
+ */
+void bfd_udp_flush_tx_frames (vlib_main_t *vm);
+
 /**
  * @brief check if the bfd udp layer is echo-capable at this time
  *
@@ -1175,7 +1175,7 @@ ethernet_input_trace (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  n_left--;
 	  b0 = vlib_get_buffer (vm, bi0);
 	  if (vnet_is_packet_pcaped (pp, b0, ~0))
-	    pcap_add_buffer (&pp->pcap_main, vm, bi0, pp->max_bytes_per_pkt);
+	    vnet_pcap_add_buffer (pp, vm, bi0);
 	}
     }
 }
@@ -1822,6 +1822,30 @@ fib_entry_get_fib_index (fib_node_index_t fib_entry_index)
     return (fib_entry->fe_fib_index);
 }
 
+/**
+ * The index of the next entry in use after the one given, starting from
+ * FIB_NODE_INDEX_INVALID. No state is kept between calls, so a walk of
+ * all entries can be suspended and resumed while entries come and go.
+ */
+fib_node_index_t
+fib_entry_get_next_index (fib_node_index_t fib_entry_index)
+{
+    uword index;
+
+    if (NULL == fib_entry_pool)
+        return (FIB_NODE_INDEX_INVALID);
+
+    if (FIB_NODE_INDEX_INVALID == fib_entry_index)
+        index = pool_get_first_index(fib_entry_pool);
+    else
+        index = pool_get_next_index(fib_entry_pool, fib_entry_index);
+
+    if (index >= pool_len(fib_entry_pool))
+        return (FIB_NODE_INDEX_INVALID);
+
+    return (index);
+}
+
 u32
 fib_entry_pool_size (void)
 {
@@ -1095,6 +1095,10 @@ typedef struct
   u32 sw_if_index;
   int filter;
   vlib_error_t drop_err;
+  /* bytes a thread captures before they are written, 0 for default */
+  u32 flush_bytes;
+  /* start a new file after this many bytes, 0 for never */
+  u64 rotate_bytes;
 } vnet_pcap_dispatch_trace_args_t;
 
 int vnet_pcap_dispatch_trace_configure (vnet_pcap_dispatch_trace_args_t *);
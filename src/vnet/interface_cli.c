@@ -2066,6 +2066,114 @@ format_vnet_pcap (u8 * s, va_list * args)
   return s;
 }
 
+#define VNET_PCAP_DEFAULT_FLUSH_BYTES (1 << 20)
+
+vlib_node_registration_t vnet_pcap_writer_node;
+
+/* Write a vector of pcap records, starting a new file if it is due */
+static clib_error_t *
+vnet_pcap_write_data (vnet_pcap_t *pp, u8 *data, u32 n_packets)
+{
+  pcap_main_t *pm = &pp->pcap_file;
+  clib_error_t *error;
+  u32 n_bytes = vec_len (data);
+  u8 *rotated;
+
+  if (n_bytes == 0)
+    return 0;
+
+  pm->pcap_data = data;
+  error = pcap_write (pm);
+  pm->pcap_data = 0;
+  if (error)
+    return error;
+
+  pp->n_packets_flushed += n_packets;
+  pp->n_bytes_in_file += n_bytes;
+
+  if (pp->rotate_bytes && pp->n_bytes_in_file >= pp->rotate_bytes)
+    {
+      pcap_close (pm);
+      /* pcap_write () takes a new lock with the next file */
+      clib_spinlock_free (&pm->lock);
+      rotated = format (0, "%s.%u%c", pm->file_name, pp->n_files_rotated++, 0);
+      if (rename (pm->file_name, (char *) rotated) < 0)
+	error = clib_error_return_unix (0, "rename `%s'", pm->file_name);
+      vec_free (rotated);
+      pp->n_bytes_in_file = 0;
+    }
+
+  return error;
+}
+
+/*
+ * Streams the vectors handed over by the capturing threads to the
+ * file, so a long capture is not held in memory.
+ */
+static uword
+vnet_pcap_writer_process (vlib_main_t *vm, vlib_node_runtime_t *rt,
+			  vlib_frame_t *f)
+{
+  vnet_pcap_t *pp = &vnet_get_main ()->pcap;
+  vnet_pcap_thread_t *pt;
+  clib_error_t *error;
+  u8 *data;
+
+  while (1)
+    {
+      if (pp->pcap_rx_enable || pp->pcap_tx_enable || pp->pcap_drop_enable)
+	vlib_process_wait_for_event_or_clock (vm, 10e-3);
+      else
+	vlib_process_wait_for_event (vm);
+      vlib_process_get_events (vm, 0);
+
+      vec_foreach (pt, pp->threads)
+	{
+	  data = clib_atomic_load_acq_n (&pt->pcap_data_full);
+	  if (!data)
+	    continue;
+
+	  error = vnet_pcap_write_data (pp, data, pt->n_packets_full);
+	  if (error)
+	    clib_error_report (error);
+
+	  vec_free (data);
+	  clib_atomic_store_rel_n (&pt->pcap_data_full, 0);
+	}
+    }
+
+  return 0;
+}
+
+VLIB_REGISTER_NODE (vnet_pcap_writer_node) = {
+  .function = vnet_pcap_writer_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "vnet-pcap-writer-process",
+};
+
+/* Write what the threads hold when capture stops; workers are stopped */
+static clib_error_t *
+vnet_pcap_flush_threads (vnet_pcap_t *pp, u32 *n_dropped)
+{
+  clib_error_t *error = 0;
+  vnet_pcap_thread_t *pt;
+
+  *n_dropped = 0;
+  vec_foreach (pt, pp->threads)
+    {
+      if (!error)
+	error = vnet_pcap_write_data (pp, pt->pcap_data_full,
+				      pt->n_packets_full);
+      if (!error)
+	error = vnet_pcap_write_data (pp, pt->pcap_data, pt->n_packets);
+      vec_free (pt->pcap_data_full);
+      vec_free (pt->pcap_data);
+      *n_dropped += pt->n_dropped;
+      pt->n_packets_full = pt->n_packets = pt->n_dropped = 0;
+    }
+
+  return error;
+}
 
 int
 vnet_pcap_dispatch_trace_configure (vnet_pcap_dispatch_trace_args_t * a)
@@ -2083,7 +2191,8 @@ vnet_pcap_dispatch_trace_configure (vnet_pcap_dispatch_trace_args_t * a)
 	  vlib_cli_output
 	    (vm, "pcap %U dispatch capture enabled: %d of %d pkts...",
 	     format_vnet_pcap, pp, 0 /* print type */ ,
-	     pm->n_packets_captured, pm->n_packets_to_capture);
+	     clib_min (pm->n_packets_captured, pm->n_packets_to_capture),
+	     pm->n_packets_to_capture);
 	  vlib_cli_output (vm, "capture to file %s", pm->file_name);
 	}
       else
@@ -2160,13 +2269,34 @@ vnet_pcap_dispatch_trace_configure (vnet_pcap_dispatch_trace_args_t * a)
       pm->file_name = (char *) a->filename;
       pm->n_packets_captured = 0;
       pm->packet_type = PCAP_PACKET_TYPE_ethernet;
-      /* Preallocate the data vector? */
+
+      pp->flush_bytes =
+	a->flush_bytes ? a->flush_bytes : VNET_PCAP_DEFAULT_FLUSH_BYTES;
+      pp->rotate_bytes = a->rotate_bytes;
+      pp->n_bytes_in_file = 0;
+      pp->n_files_rotated = 0;
+      pp->n_packets_flushed = 0;
+      clib_spinlock_free (&pp->pcap_file.lock);
+      clib_memset (&pp->pcap_file, 0, sizeof (pp->pcap_file));
+      pp->pcap_file.file_name = pm->file_name;
+      pp->pcap_file.packet_type = pm->packet_type;
+      vec_validate_aligned (pp->threads, vlib_get_n_threads () - 1,
+			    CLIB_CACHE_LINE_BYTES);
+
+      /* Preallocate the data vectors? */
       if (a->preallocate_data)
 	{
-	  vec_validate
-	    (pm->pcap_data, a->packets_to_capture
-	     * ((sizeof (pcap_packet_header_t) + a->max_bytes_per_pkt)));
-	  vec_reset_length (pm->pcap_data);
+	  vnet_pcap_thread_t *pt;
+	  u64 n_bytes =
+	    (u64) a->packets_to_capture *
+	    (sizeof (pcap_packet_header_t) + a->max_bytes_per_pkt);
+
+	  n_bytes = clib_min (n_bytes, pp->flush_bytes);
+	  vec_foreach (pt, pp->threads)
+	    {
+	      vec_validate (pt->pcap_data, n_bytes);
+	      vec_reset_length (pt->pcap_data);
+	    }
 	}
       pm->n_packets_to_capture = a->packets_to_capture;
       pp->pcap_sw_if_index = a->sw_if_index;
@@ -2180,6 +2310,8 @@ vnet_pcap_dispatch_trace_configure (vnet_pcap_dispatch_trace_args_t * a)
       pp->pcap_tx_enable = a->tx_enable;
       pp->pcap_drop_enable = a->drop_enable;
       pp->max_bytes_per_pkt = a->max_bytes_per_pkt;
+
+      vlib_process_signal_event (vm, vnet_pcap_writer_node.index, 0, 0);
     }
   else
     {
@@ -2190,13 +2322,24 @@ vnet_pcap_dispatch_trace_configure (vnet_pcap_dispatch_trace_args_t * a)
       pp->pcap_error_index = ~0;
       if (pm->n_packets_captured)
 	{
+	  pcap_main_t *pf = &pp->pcap_file;
 	  clib_error_t *error;
-	  pm->n_packets_to_capture = pm->n_packets_captured;
+	  u32 n_dropped;
+
+	  /* the writer may hold a file open already */
+	  error = vnet_pcap_flush_threads (pp, &n_dropped);
+	  pm->n_packets_captured = pm->n_packets_to_capture =
+	    pp->n_packets_flushed;
 	  vlib_cli_output (vm, "Write %d packets to %s, and stop capture...",
 			   pm->n_packets_captured, pm->file_name);
-	  error = pcap_write (pm);
-	  if (pm->flags & PCAP_MAIN_INIT_DONE)
-	    pcap_close (pm);
+	  if (n_dropped)
+	    vlib_cli_output (vm, "%u packets dropped, the writer fell behind",
+			     n_dropped);
+	  /* create the file even if nothing was written */
+	  if (!error)
+	    error = pcap_write (pf);
+	  if (pf->flags & PCAP_MAIN_INIT_DONE)
+	    pcap_close (pf);
 	  /* Report I/O errors... */
 	  if (error)
 	    {
@@ -2235,6 +2378,8 @@ pcap_trace_command_fn (vlib_main_t * vm,
   int free_data = 0;
   u32 sw_if_index = 0;		/* default: any interface */
   vlib_error_t drop_err = ~0;	/* default: any error */
+  uword flush_bytes = 0;
+  uword rotate_bytes = 0;
 
   /* Get a line of input. */
   if (!unformat_user (input, unformat_line_input, line_input))
@@ -2253,6 +2398,14 @@ pcap_trace_command_fn (vlib_main_t * vm,
       else if (unformat (line_input, "max-bytes-per-pkt %u",
 			 &max_bytes_per_pkt))
 	;
+      else if (unformat (line_input, "snaplen %u", &max_bytes_per_pkt))
+	;
+      else if (unformat (line_input, "flush-size %U", unformat_memory_size,
+			 &flush_bytes))
+	;
+      else if (unformat (line_input, "rotate-size %U", unformat_memory_size,
+			 &rotate_bytes))
+	;
       else if (unformat (line_input, "max %d", &max))
 	;
       else if (unformat (line_input, "packets-to-capture %d", &max))
@@ -2303,6 +2456,8 @@ pcap_trace_command_fn (vlib_main_t * vm,
   a->filter = filter;
   a->max_bytes_per_pkt = max_bytes_per_pkt;
   a->drop_err = drop_err;
+  a->flush_bytes = flush_bytes;
+  a->rotate_bytes = rotate_bytes;
 
   rv = vnet_pcap_dispatch_trace_configure (a);
 
@@ -2364,7 +2519,17 @@ pcap_trace_command_fn (vlib_main_t * vm,
  *   to 100. Can only be updated if packet capture is off.
  *
  * - <b>max-bytes-per-pkt <nnnn></b> - Maximum number of bytes to capture
- *   for each packet. Must be >= 32, <= 9000.
+ *   for each packet. Must be >= 32, <= 9000. <b>snaplen</b> is a synonym.
+ *
+ * - <b>flush-size <n></b> - Each thread captures into its own buffer;
+ *   once a buffer holds this many bytes it is written to the file in
+ *   the background. Default 1M. A thread holds at most two buffers; if
+ *   the writer has not taken the previous one when the next fills,
+ *   packets are dropped from the capture and counted.
+ *
+ * - <b>rotate-size <n></b> - Once the file reaches this size, it is
+ *   renamed to '<em>name</em>.0', '<em>name</em>.1', ... and a new one is
+ *   started.
  *
  * - <b>preallocate-data</b> - Preallocate the data buffer, to avoid
  *   vector expansion delays during pcap capture
@@ -2427,7 +2592,8 @@ VLIB_CLI_COMMAND (pcap_tx_trace_command, static) = {
     .short_help =
     "pcap trace [rx] [tx] [drop] [off] [max <nn>] [intfc <interface>|any]\n"
     "           [file <name>] [status] [max-bytes-per-pkt <nnnn>][filter]\n"
-    "           [preallocate-data][free-data]",
+    "           [preallocate-data][free-data][snaplen <nnnn>]\n"
+    "           [flush-size <n>][rotate-size <n>]",
     .function = pcap_trace_command_fn,
 };
 /* *INDENT-ON* */
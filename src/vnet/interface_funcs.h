@@ -525,6 +525,24 @@ u8 *format_vnet_interface_output_trace (u8 * s, va_list * va);
 serialize_function_t serialize_vnet_interface_state,
   unserialize_vnet_interface_state;
 
+/* Copy the first n_left bytes of a buffer chain */
+static inline void
+pcap_copy_buffer (struct vlib_main_t *vm, vlib_buffer_t *b, void *d,
+		  i32 n_left)
+{
+  while (1)
+    {
+      u32 copy_length = clib_min ((u32) n_left, b->current_length);
+      clib_memcpy_fast (d, b->data + b->current_data, copy_length);
+      n_left -= b->current_length;
+      if (n_left <= 0)
+	break;
+      d += b->current_length;
+      ASSERT (b->flags & VLIB_BUFFER_NEXT_PRESENT);
+      b = vlib_get_buffer (vm, b->next_buffer);
+    }
+}
+
 /**
  * @brief Add buffer (vlib_buffer_t) to the trace
  *
@@ -549,21 +567,77 @@ pcap_add_buffer (pcap_main_t *pm, struct vlib_main_t *vm, u32 buffer_index,
       time_now += vm->clib_time.init_reference_time;
       clib_spinlock_lock_if_init (&pm->lock);
       d = pcap_add_packet (pm, time_now, n_left, n);
-      while (1)
-	{
-	  u32 copy_length = clib_min ((u32) n_left, b->current_length);
-	  clib_memcpy_fast (d, b->data + b->current_data, copy_length);
-	  n_left -= b->current_length;
-	  if (n_left <= 0)
-	    break;
-	  d += b->current_length;
-	  ASSERT (b->flags & VLIB_BUFFER_NEXT_PRESENT);
-	  b = vlib_get_buffer (vm, b->next_buffer);
-	}
+      pcap_copy_buffer (vm, b, d, n_left);
       clib_spinlock_unlock_if_init (&pm->lock);
     }
 }
 
+/* Hand a full capture vector over if the writer has taken the last one */
+static inline int
+vnet_pcap_hand_over (vnet_pcap_thread_t *pt)
+{
+  if (clib_atomic_load_acq_n (&pt->pcap_data_full))
+    return 0;
+
+  pt->n_packets_full = pt->n_packets;
+  clib_atomic_store_rel_n (&pt->pcap_data_full, pt->pcap_data);
+  pt->pcap_data = 0;
+  pt->n_packets = 0;
+  return 1;
+}
+
+/**
+ * @brief Add buffer to the interface capture, into the calling thread's
+ * capture vector
+ *
+ * @param *pp - vnet_pcap_t
+ * @param *vm - vlib_main_t
+ * @param buffer_index - u32
+ *
+ */
+static inline void
+vnet_pcap_add_buffer (vnet_pcap_t *pp, struct vlib_main_t *vm,
+		      u32 buffer_index)
+{
+  pcap_main_t *pm = &pp->pcap_main;
+  vnet_pcap_thread_t *pt;
+  vlib_buffer_t *b;
+  f64 time_now;
+  i32 n_left;
+  void *d;
+  u32 n;
+
+  if (PREDICT_FALSE (pm->n_packets_captured >= pm->n_packets_to_capture))
+    return;
+
+  pt = vec_elt_at_index (pp->threads, vm->thread_index);
+
+  /* the writer is behind, drop rather than grow the vector further */
+  if (PREDICT_FALSE (vec_len (pt->pcap_data) >= pp->flush_bytes) &&
+      !vnet_pcap_hand_over (pt))
+    {
+      pt->n_dropped++;
+      return;
+    }
+
+  /* threads racing for the last slots may take a few extra, ignore them */
+  if (clib_atomic_fetch_add_relax (&pm->n_packets_captured, 1) >=
+      pm->n_packets_to_capture)
+    return;
+
+  b = vlib_get_buffer (vm, buffer_index);
+  n = vlib_buffer_length_in_chain (vm, b);
+  n_left = clib_min (pp->max_bytes_per_pkt, n);
+  time_now = vlib_time_now (vm) + vm->clib_time.init_reference_time;
+
+  d = pcap_add_packet_to_vec (&pt->pcap_data, time_now, n_left, n);
+  pcap_copy_buffer (vm, b, d, n_left);
+  pt->n_packets++;
+
+  if (vec_len (pt->pcap_data) >= pp->flush_bytes)
+    vnet_pcap_hand_over (pt);
+}
+
 typedef struct
 {
   vnet_hw_if_caps_t val;
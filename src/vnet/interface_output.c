@@ -359,7 +359,7 @@ vnet_interface_pcap_tx_trace (vlib_main_t *vm, vlib_node_runtime_t *node,
 	}
 
       if (vnet_is_packet_pcaped (pp, b0, sw_if_index))
-	pcap_add_buffer (&pp->pcap_main, vm, bi0, pp->max_bytes_per_pkt);
+	vnet_pcap_add_buffer (pp, vm, bi0);
     }
 }
 
@@ -1166,7 +1166,7 @@ pcap_drop_trace (vlib_main_t * vm,
 			      error_string_len);
 	    last->current_length += drop_string_len;
 	    b0->flags &= ~(VLIB_BUFFER_TOTAL_LENGTH_VALID);
-	    pcap_add_buffer (&pp->pcap_main, vm, bi0, pp->max_bytes_per_pkt);
+	    vnet_pcap_add_buffer (pp, vm, bi0);
 	    last->current_length -= drop_string_len;
 	    b0->current_data = save_current_data;
 	    b0->current_length = save_current_length;
@@ -1178,7 +1178,7 @@ pcap_drop_trace (vlib_main_t * vm,
        * Didn't have space in the last buffer, here's the dropped
        * packet as-is
        */
-      pcap_add_buffer (&pp->pcap_main, vm, bi0, pp->max_bytes_per_pkt);
+      vnet_pcap_add_buffer (pp, vm, bi0);
 
       b0->current_data = save_current_data;
       b0->current_length = save_current_length;
@@ -62,6 +62,7 @@
 #include <vnet/interface_output.h>
 #include <vnet/classify/vnet_classify.h>
 #include <vnet/ip/reass/ip4_full_reass.h>
+#include <vppinfra/vector/flow_hash.h>
 
 /** @brief IPv4 lookup node.
     @node ip4-lookup
@@ -122,6 +123,9 @@ VLIB_NODE_FN (ip4_load_balance_node) (vlib_main_t * vm,
   u32 n_left, *from;
   u32 thread_index = vm->thread_index;
   vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  const load_balance_t *lbs[VLIB_FRAME_SIZE], **lb = lbs;
+  u32 ka[VLIB_FRAME_SIZE], kb[VLIB_FRAME_SIZE], kc[VLIB_FRAME_SIZE];
+  u16 to_hash[VLIB_FRAME_SIZE], n_to_hash = 0;
   u16 nexts[VLIB_FRAME_SIZE], *next;
 
   from = vlib_frame_vector_args (frame);
@@ -130,76 +134,65 @@ VLIB_NODE_FN (ip4_load_balance_node) (vlib_main_t * vm,
 
   vlib_get_buffers (vm, from, bufs, n_left);
 
-  while (n_left >= 4)
+  /*
+   * this node is for via FIBs we can re-use the hash value from the
+   * to node if present.
+   * We don't want to use the same hash value at each level in the recursion
+   * graph as that would lead to polarisation.
+   * Packets without one have their hash key gathered here and are then
+   * hashed together, a vector of flows at a time.
+   */
+  for (u32 i = 0; i < n_left; i++)
     {
-      const load_balance_t *lb0, *lb1;
-      const ip4_header_t *ip0, *ip1;
-      u32 lbi0, hc0, lbi1, hc1;
-      const dpo_id_t *dpo0, *dpo1;
+      if (i + 2 < n_left)
+	{
+	  vlib_prefetch_buffer_header (b[i + 2], LOAD);
+	  CLIB_PREFETCH (b[i + 2]->data, sizeof (ip4_header_t), LOAD);
+	}
 
-      /* Prefetch next iteration. */
-      {
-	vlib_prefetch_buffer_header (b[2], LOAD);
-	vlib_prefetch_buffer_header (b[3], LOAD);
+      lb[i] = load_balance_get (vnet_buffer (b[i])->ip.adj_index[VLIB_TX]);
 
-	CLIB_PREFETCH (b[2]->data, sizeof (ip0[0]), LOAD);
-	CLIB_PREFETCH (b[3]->data, sizeof (ip0[0]), LOAD);
-      }
+      if (PREDICT_TRUE (lb[i]->lb_n_buckets <= 1))
+	continue;
 
-      ip0 = vlib_buffer_get_current (b[0]);
-      ip1 = vlib_buffer_get_current (b[1]);
-      lbi0 = vnet_buffer (b[0])->ip.adj_index[VLIB_TX];
-      lbi1 = vnet_buffer (b[1])->ip.adj_index[VLIB_TX];
+      if (PREDICT_TRUE (vnet_buffer (b[i])->ip.flow_hash))
+	vnet_buffer (b[i])->ip.flow_hash >>= 1;
+      else
+	{
+	  ip4_flow_hash_key (vlib_buffer_get_current (b[i]),
+			     lb[i]->lb_hash_config, ka + n_to_hash,
+			     kb + n_to_hash, kc + n_to_hash);
+	  to_hash[n_to_hash++] = i;
+	}
+    }
 
-      lb0 = load_balance_get (lbi0);
-      lb1 = load_balance_get (lbi1);
+  if (n_to_hash)
+    {
+      clib_flow_hash_v3 (ka, kb, kc, kc, n_to_hash);
+      for (u32 i = 0; i < n_to_hash; i++)
+	vnet_buffer (b[to_hash[i]])->ip.flow_hash = kc[i];
+    }
 
-      /*
-       * this node is for via FIBs we can re-use the hash value from the
-       * to node if present.
-       * We don't want to use the same hash value at each level in the recursion
-       * graph as that would lead to polarisation
-       */
-      hc0 = hc1 = 0;
+  while (n_left >= 2)
+    {
+      const dpo_id_t *dpo0, *dpo1;
+      u32 lbi0, lbi1;
 
-      if (PREDICT_FALSE (lb0->lb_n_buckets > 1))
-	{
-	  if (PREDICT_TRUE (vnet_buffer (b[0])->ip.flow_hash))
-	    {
-	      hc0 = vnet_buffer (b[0])->ip.flow_hash =
-		vnet_buffer (b[0])->ip.flow_hash >> 1;
-	    }
-	  else
-	    {
-	      hc0 = vnet_buffer (b[0])->ip.flow_hash =
-		ip4_compute_flow_hash (ip0, lb0->lb_hash_config);
-	    }
-	  dpo0 = load_balance_get_fwd_bucket
-	    (lb0, (hc0 & (lb0->lb_n_buckets_minus_1)));
-	}
+      lbi0 = vnet_buffer (b[0])->ip.adj_index[VLIB_TX];
+      lbi1 = vnet_buffer (b[1])->ip.adj_index[VLIB_TX];
+
+      if (PREDICT_FALSE (lb[0]->lb_n_buckets > 1))
+	dpo0 = load_balance_get_fwd_bucket (
+	  lb[0], (vnet_buffer (b[0])->ip.flow_hash &
+		  (lb[0]->lb_n_buckets_minus_1)));
       else
-	{
-	  dpo0 = load_balance_get_bucket_i (lb0, 0);
-	}
-      if (PREDICT_FALSE (lb1->lb_n_buckets > 1))
-	{
-	  if (PREDICT_TRUE (vnet_buffer (b[1])->ip.flow_hash))
-	    {
-	      hc1 = vnet_buffer (b[1])->ip.flow_hash =
-		vnet_buffer (b[1])->ip.flow_hash >> 1;
-	    }
-	  else
-	    {
-	      hc1 = vnet_buffer (b[1])->ip.flow_hash =
-		ip4_compute_flow_hash (ip1, lb1->lb_hash_config);
-	    }
-	  dpo1 = load_balance_get_fwd_bucket
-	    (lb1, (hc1 & (lb1->lb_n_buckets_minus_1)));
-	}
+	dpo0 = load_balance_get_bucket_i (lb[0], 0);
+      if (PREDICT_FALSE (lb[1]->lb_n_buckets > 1))
+	dpo1 = load_balance_get_fwd_bucket (
+	  lb[1], (vnet_buffer (b[1])->ip.flow_hash &
+		  (lb[1]->lb_n_buckets_minus_1)));
       else
-	{
-	  dpo1 = load_balance_get_bucket_i (lb1, 0);
-	}
+	dpo1 = load_balance_get_bucket_i (lb[1], 0);
 
       next[0] = dpo0->dpoi_next_node;
       next[1] = dpo1->dpoi_next_node;
@@ -213,42 +206,24 @@ VLIB_NODE_FN (ip4_load_balance_node) (vlib_main_t * vm,
 	(cm, thread_index, lbi1, 1, vlib_buffer_length_in_chain (vm, b[1]));
 
       b += 2;
+      lb += 2;
       next += 2;
       n_left -= 2;
     }
 
   while (n_left > 0)
     {
-      const load_balance_t *lb0;
-      const ip4_header_t *ip0;
       const dpo_id_t *dpo0;
-      u32 lbi0, hc0;
+      u32 lbi0;
 
-      ip0 = vlib_buffer_get_current (b[0]);
       lbi0 = vnet_buffer (b[0])->ip.adj_index[VLIB_TX];
 
-      lb0 = load_balance_get (lbi0);
-
-      hc0 = 0;
-      if (PREDICT_FALSE (lb0->lb_n_buckets > 1))
-	{
-	  if (PREDICT_TRUE (vnet_buffer (b[0])->ip.flow_hash))
-	    {
-	      hc0 = vnet_buffer (b[0])->ip.flow_hash =
-		vnet_buffer (b[0])->ip.flow_hash >> 1;
-	    }
-	  else
-	    {
-	      hc0 = vnet_buffer (b[0])->ip.flow_hash =
-		ip4_compute_flow_hash (ip0, lb0->lb_hash_config);
-	    }
-	  dpo0 = load_balance_get_fwd_bucket
-	    (lb0, (hc0 & (lb0->lb_n_buckets_minus_1)));
-	}
+      if (PREDICT_FALSE (lb[0]->lb_n_buckets > 1))
+	dpo0 = load_balance_get_fwd_bucket (
+	  lb[0], (vnet_buffer (b[0])->ip.flow_hash &
+		  (lb[0]->lb_n_buckets_minus_1)));
       else
-	{
-	  dpo0 = load_balance_get_bucket_i (lb0, 0);
-	}
+	dpo0 = load_balance_get_bucket_i (lb[0], 0);
 
       next[0] = dpo0->dpoi_next_node;
       vnet_buffer (b[0])->ip.adj_index[VLIB_TX] = dpo0->dpoi_index;
@@ -257,6 +232,7 @@ VLIB_NODE_FN (ip4_load_balance_node) (vlib_main_t * vm,
 	(cm, thread_index, lbi0, 1, vlib_buffer_length_in_chain (vm, b[0]));
 
       b += 1;
+      lb += 1;
       next += 1;
       n_left -= 1;
     }
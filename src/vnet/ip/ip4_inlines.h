@@ -46,11 +46,13 @@
 
 #define IP_DF 0x4000		/* don't fragment */
 
-/* Compute flow hash.  We'll use it to select which adjacency to use for this
-   flow.  And other things. */
-always_inline u32
-ip4_compute_flow_hash (const ip4_header_t * ip,
-		       flow_hash_config_t flow_hash_config)
+/*
+ * The three words of the flow hash key, before mixing, so that many keys
+ * can be hashed at once with clib_flow_hash_v3 ().
+ */
+always_inline void
+ip4_flow_hash_key (const ip4_header_t *ip, flow_hash_config_t flow_hash_config,
+		   u32 *ka, u32 *kb, u32 *kc)
 {
   tcp_header_t *tcp = (void *) (ip + 1);
   u32 a, b, c, t1, t2;
@@ -92,6 +94,21 @@ ip4_compute_flow_hash (const ip4_header_t * ip,
     (t1 << 16) | t2 : (t2 << 16) | t1;
   a ^= ip_flow_hash_router_id;
 
+  *ka = a;
+  *kb = b;
+  *kc = c;
+}
+
+/* Compute flow hash.  We'll use it to select which adjacency to use for this
+   flow.  And other things. */
+always_inline u32
+ip4_compute_flow_hash (const ip4_header_t * ip,
+		       flow_hash_config_t flow_hash_config)
+{
+  u32 a, b, c;
+
+  ip4_flow_hash_key (ip, flow_hash_config, &a, &b, &c);
+
   hash_v3_mix32 (a, b, c);
   hash_v3_finalize32 (a, b, c);
 
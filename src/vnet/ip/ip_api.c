@@ -29,6 +29,7 @@
 #include <vnet/ip/ip_punt_drop.h>
 #include <vnet/ip/ip_types_api.h>
 #include <vnet/ip/ip_path_mtu.h>
+#include <vnet/ip/ip_route_snapshot.h>
 #include <vnet/fib/fib_table.h>
 #include <vnet/fib/fib_api.h>
 #include <vnet/ethernet/arp_packet.h>
@@ -297,6 +298,30 @@ vl_api_ip_route_v2_dump_t_handler (vl_api_ip_route_v2_dump_t *mp)
   vec_free (ctx.feis);
 }
 
+static void
+vl_api_ip_route_snapshot_t_handler (vl_api_ip_route_snapshot_t *mp)
+{
+  vl_api_ip_route_snapshot_reply_t *rmp;
+  vl_api_registration_t *reg;
+  int rv = 0;
+
+  reg = vl_api_client_index_to_registration (mp->client_index);
+  if (!reg)
+    return;
+
+  /* the snapshot is handed over as an fd, which needs the socket */
+  if (vl_api_registration_file_index (reg) == VL_API_INVALID_FI)
+    {
+      rv = VNET_API_ERROR_INVALID_REGISTRATION;
+      REPLY_MACRO (VL_API_IP_ROUTE_SNAPSHOT_REPLY);
+      return;
+    }
+
+  /* the reply is sent by the snapshot process once the table is written */
+  ip_route_snapshot_request (mp->client_index, mp->context, mp->table.is_ip6,
+			     ntohl (mp->table.table_id));
+}
+
 static void
 send_ip_mtable_details (vl_api_registration_t * reg,
 			u32 context, const mfib_table_t * mfib_table)
@@ -0,0 +1,790 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include <vnet/ip/ip_checkpoint.h>
+#include <vnet/ip/ip.h>
+#include <vnet/ip/ip_interface.h>
+#include <vnet/ip-neighbor/ip_neighbor.h>
+#include <vnet/fib/fib_table.h>
+#include <vnet/fib/fib_entry.h>
+#include <vppinfra/serialize.h>
+
+/**
+ * Bump when the on-disk layout changes; files of any other version are
+ * refused rather than misinterpreted.
+ */
+#define IP_CHECKPOINT_VERSION 1
+
+static char ip_checkpoint_magic[] = "vpp-ip-checkpoint";
+
+/**
+ * Path flags that can be re-created from the fields serialized below.
+ * Paths with other flags (udp-encap, bier, classify, ...) reference
+ * objects that are not part of the checkpoint, so their routes are skipped.
+ */
+#define IP_CHECKPOINT_PATH_FLAGS_SUPPORTED                                    \
+  (FIB_ROUTE_PATH_RESOLVE_VIA_HOST | FIB_ROUTE_PATH_RESOLVE_VIA_ATTACHED |    \
+   FIB_ROUTE_PATH_LOCAL | FIB_ROUTE_PATH_ATTACHED | FIB_ROUTE_PATH_DROP |     \
+   FIB_ROUTE_PATH_EXCLUSIVE | FIB_ROUTE_PATH_SOURCE_LOOKUP |                  \
+   FIB_ROUTE_PATH_DEAG | FIB_ROUTE_PATH_ICMP_UNREACH |                        \
+   FIB_ROUTE_PATH_ICMP_PROHIBIT | FIB_ROUTE_PATH_POP_PW_CW |                  \
+   FIB_ROUTE_PATH_GLEAN)
+
+typedef struct ip_checkpoint_main_t_
+{
+  /** File saved to on a graceful shutdown, from the startup config */
+  u8 *save_on_exit;
+
+  vlib_log_class_t log_class;
+} ip_checkpoint_main_t;
+
+static ip_checkpoint_main_t ip_checkpoint_main;
+
+#define IP_CKPT_INFO(...)                                                     \
+  vlib_log_notice (ip_checkpoint_main.log_class, __VA_ARGS__)
+
+static void
+serialize_ip46_address (serialize_main_t *m, const ip46_address_t *a)
+{
+  serialize_integer (m, a->as_u64[0], sizeof (u64));
+  serialize_integer (m, a->as_u64[1], sizeof (u64));
+}
+
+static void
+unserialize_ip46_address (serialize_main_t *m, ip46_address_t *a)
+{
+  unserialize_integer (m, &a->as_u64[0], sizeof (u64));
+  unserialize_integer (m, &a->as_u64[1], sizeof (u64));
+}
+
+static void
+serialize_sw_if_index (serialize_main_t *m, u32 sw_if_index)
+{
+  u8 *name = 0;
+
+  if (~0 != sw_if_index)
+    name = format (0, "%U%c", format_vnet_sw_if_index_name, vnet_get_main (),
+		   sw_if_index, 0);
+  else
+    name = format (0, "%c", 0);
+
+  serialize_cstring (m, (char *) name);
+  vec_free (name);
+}
+
+/**
+ * Returns ~0 both for the 'no interface' encoding and for names that do
+ * not exist in this instance; callers distinguish the two by the name.
+ */
+static u32
+unserialize_sw_if_index (serialize_main_t *m, int *missing)
+{
+  unformat_input_t input;
+  u32 sw_if_index = ~0;
+  char *name = 0;
+
+  unserialize_cstring (m, &name);
+
+  if (name && name[0])
+    {
+      unformat_init_string (&input, name, strlen (name));
+      if (!unformat_user (&input, unformat_vnet_sw_interface,
+			  vnet_get_main (), &sw_if_index))
+	*missing = 1;
+      unformat_free (&input);
+    }
+  vec_free (name);
+
+  return (sw_if_index);
+}
+
+static void
+serialize_ip_checkpoint_interfaces (serialize_main_t *m, va_list *va)
+{
+  ip_checkpoint_stats_t *stats = va_arg (*va, ip_checkpoint_stats_t *);
+  vnet_main_t *vnm = vnet_get_main ();
+  ip_interface_address_t *ia;
+  vnet_sw_interface_t *si;
+  ip_lookup_main_t *lm;
+  fib_protocol_t fproto;
+  u32 *sw_if_indices = 0, *sw_if_index;
+
+  pool_foreach (si, vnm->interface_main.sw_interfaces)
+    vec_add1 (sw_if_indices, si->sw_if_index);
+
+  serialize_likely_small_unsigned_integer (m, vec_len (sw_if_indices));
+
+  vec_foreach (sw_if_index, sw_if_indices)
+    {
+      serialize_sw_if_index (m, *sw_if_index);
+      serialize_integer (m, vnet_sw_interface_is_admin_up (vnm, *sw_if_index),
+			 sizeof (u8));
+
+      FOR_EACH_FIB_IP_PROTOCOL (fproto)
+	{
+	  u32 fib_index, *addrs = 0, *ai;
+
+	  fib_index =
+	    fib_table_get_index_for_sw_if_index (fproto, *sw_if_index);
+	  serialize_integer (
+	    m, fib_table_get_table_id (fib_index, fproto), sizeof (u32));
+
+	  lm = (FIB_PROTOCOL_IP4 == fproto ? &ip4_main.lookup_main :
+					       &ip6_main.lookup_main);
+
+	  /* *INDENT-OFF* */
+	  foreach_ip_interface_address (lm, ia, *sw_if_index,
+					0 /* honor unnumbered */, ({
+	    vec_add1 (addrs, ia - lm->if_address_pool);
+	  }));
+	  /* *INDENT-ON* */
+
+	  serialize_likely_small_unsigned_integer (m, vec_len (addrs));
+	  vec_foreach (ai, addrs)
+	    {
+	      ip46_address_t addr = {};
+
+	      ia = pool_elt_at_index (lm->if_address_pool, *ai);
+	      if (FIB_PROTOCOL_IP4 == fproto)
+		addr.ip4 = *(ip4_address_t *)
+		  ip_interface_address_get_address (lm, ia);
+	      else
+		addr.ip6 = *(ip6_address_t *)
+		  ip_interface_address_get_address (lm, ia);
+	      serialize_ip46_address (m, &addr);
+	      serialize_integer (m, ia->address_length, sizeof (u8));
+	    }
+	  vec_free (addrs);
+	}
+      stats->n_interfaces++;
+    }
+
+  vec_free (sw_if_indices);
+}
+
+static void
+unserialize_ip_checkpoint_interfaces (serialize_main_t *m, va_list *va)
+{
+  ip_checkpoint_stats_t *stats = va_arg (*va, ip_checkpoint_stats_t *);
+  vlib_main_t *vm = vlib_get_main ();
+  vnet_main_t *vnm = vnet_get_main ();
+  fib_protocol_t fproto;
+  u32 n_itfs;
+
+  n_itfs = unserialize_likely_small_unsigned_integer (m);
+
+  while (n_itfs--)
+    {
+      u32 sw_if_index, table_id, n_addrs;
+      clib_error_t *error;
+      int missing = 0;
+      u8 admin_up;
+
+      sw_if_index = unserialize_sw_if_index (m, &missing);
+      unserialize_integer (m, &admin_up, sizeof (u8));
+
+      FOR_EACH_FIB_IP_PROTOCOL (fproto)
+	{
+	  unserialize_integer (m, &table_id, sizeof (u32));
+	  n_addrs = unserialize_likely_small_unsigned_integer (m);
+
+	  if (!missing && 0 != table_id)
+	    {
+	      ip_table_create (fproto, table_id, 1, NULL);
+	      ip_table_bind (fproto, sw_if_index, table_id);
+	    }
+
+	  while (n_addrs--)
+	    {
+	      ip46_address_t addr;
+	      u8 len;
+
+	      unserialize_ip46_address (m, &addr);
+	      unserialize_integer (m, &len, sizeof (u8));
+
+	      if (missing)
+		continue;
+
+	      if (FIB_PROTOCOL_IP4 == fproto)
+		error = ip4_add_del_interface_address (vm, sw_if_index,
+						       &addr.ip4, len, 0);
+	      else
+		error = ip6_add_del_interface_address (vm, sw_if_index,
+						       &addr.ip6, len, 0);
+	      /* the address may already be configured, that's fine */
+	      clib_error_free (error);
+	    }
+	}
+
+      if (missing)
+	{
+	  stats->n_skipped++;
+	  continue;
+	}
+
+      if (admin_up)
+	{
+	  error = vnet_sw_interface_set_flags (vnm, sw_if_index,
+					       VNET_SW_INTERFACE_FLAG_ADMIN_UP);
+	  clib_error_free (error);
+	}
+      stats->n_interfaces++;
+    }
+}
+
+typedef struct ip_checkpoint_nbr_walk_ctx_t_
+{
+  index_t *ipnis;
+} ip_checkpoint_nbr_walk_ctx_t;
+
+static walk_rc_t
+ip_checkpoint_nbr_walk (index_t ipni, void *arg)
+{
+  ip_checkpoint_nbr_walk_ctx_t *ctx = arg;
+
+  vec_add1 (ctx->ipnis, ipni);
+
+  return (WALK_CONTINUE);
+}
+
+static void
+serialize_ip_checkpoint_neighbors (serialize_main_t *m, va_list *va)
+{
+  ip_checkpoint_stats_t *stats = va_arg (*va, ip_checkpoint_stats_t *);
+  ip_checkpoint_nbr_walk_ctx_t ctx = {};
+  ip_address_family_t af;
+  index_t *ipni;
+
+  FOR_EACH_IP_ADDRESS_FAMILY (af)
+    ip_neighbor_walk (af, ~0, ip_checkpoint_nbr_walk, &ctx);
+
+  serialize_likely_small_unsigned_integer (m, vec_len (ctx.ipnis));
+
+  vec_foreach (ipni, ctx.ipnis)
+    {
+      const ip_address_t *ip;
+      ip_neighbor_t *ipn;
+
+      ipn = ip_neighbor_get (*ipni);
+      ip = ip_neighbor_get_ip (ipn);
+
+      serialize_sw_if_index (m, ip_neighbor_get_sw_if_index (ipn));
+      serialize_integer (m, ip_addr_version (ip), sizeof (u8));
+      serialize_ip46_address (m, &ip_addr_46 (ip));
+      serialize_multiple (m, (void *) ip_neighbor_get_mac (ipn)->bytes, 1, 1,
+			  sizeof (mac_address_t));
+      serialize_integer (m, ipn->ipn_flags, sizeof (u8));
+      stats->n_neighbors++;
+    }
+
+  vec_free (ctx.ipnis);
+}
+
+static void
+unserialize_ip_checkpoint_neighbors (serialize_main_t *m, va_list *va)
+{
+  ip_checkpoint_stats_t *stats = va_arg (*va, ip_checkpoint_stats_t *);
+  u32 n_nbrs;
+
+  n_nbrs = unserialize_likely_small_unsigned_integer (m);
+
+  while (n_nbrs--)
+    {
+      ip_address_t ip = {};
+      mac_address_t mac;
+      u32 sw_if_index, stats_index;
+      int missing = 0;
+      u8 af, flags;
+
+      sw_if_index = unserialize_sw_if_index (m, &missing);
+      unserialize_integer (m, &af, sizeof (u8));
+      ip_addr_version (&ip) = af;
+      unserialize_ip46_address (m, &ip_addr_46 (&ip));
+      unserialize_multiple (m, mac.bytes, 1, 1, sizeof (mac_address_t));
+      unserialize_integer (m, &flags, sizeof (u8));
+
+      if (missing || ~0 == sw_if_index)
+	{
+	  stats->n_skipped++;
+	  continue;
+	}
+
+      /*
+       * transient state (pending resolution, staleness) is not restored;
+       * the entry starts fresh and ages from now.
+       */
+      flags &= (IP_NEIGHBOR_FLAG_STATIC | IP_NEIGHBOR_FLAG_DYNAMIC |
+		IP_NEIGHBOR_FLAG_NO_FIB_ENTRY);
+
+      if (ip_neighbor_add (&ip, &mac, sw_if_index, flags, &stats_index))
+	stats->n_skipped++;
+      else
+	stats->n_neighbors++;
+    }
+}
+
+typedef struct ip_checkpoint_route_walk_ctx_t_
+{
+  fib_node_index_t *feis;
+} ip_checkpoint_route_walk_ctx_t;
+
+static fib_table_walk_rc_t
+ip_checkpoint_route_walk (fib_node_index_t fei, void *arg)
+{
+  ip_checkpoint_route_walk_ctx_t *ctx = arg;
+  fib_source_t src;
+
+  src = fib_entry_get_best_source (fei);
+
+  if (FIB_SOURCE_API == src || FIB_SOURCE_CLI == src)
+    vec_add1 (ctx->feis, fei);
+
+  return (FIB_TABLE_WALK_CONTINUE);
+}
+
+static int
+ip_checkpoint_rpaths_supported (const fib_route_path_t *rpaths)
+{
+  const fib_route_path_t *rpath;
+
+  vec_foreach (rpath, rpaths)
+    {
+      if (rpath->frp_flags & ~IP_CHECKPOINT_PATH_FLAGS_SUPPORTED)
+	return (0);
+      if (DPO_PROTO_IP4 != rpath->frp_proto &&
+	  DPO_PROTO_IP6 != rpath->frp_proto &&
+	  DPO_PROTO_MPLS != rpath->frp_proto)
+	return (0);
+    }
+  return (1);
+}
+
+static void
+serialize_ip_checkpoint_routes (serialize_main_t *m, va_list *va)
+{
+  ip_checkpoint_stats_t *stats = va_arg (*va, ip_checkpoint_stats_t *);
+  ip_checkpoint_route_walk_ctx_t ctx = {};
+  fib_node_index_t *fei;
+  fib_protocol_t fproto;
+  fib_table_t *fib_table;
+
+  FOR_EACH_FIB_IP_PROTOCOL (fproto)
+    {
+      pool_foreach (fib_table, (FIB_PROTOCOL_IP4 == fproto ? ip4_main.fibs :
+								ip6_main.fibs))
+	{
+	  fib_table_walk (fib_table->ft_index, fproto,
+			  ip_checkpoint_route_walk, &ctx);
+	}
+    }
+
+  serialize_likely_small_unsigned_integer (m, vec_len (ctx.feis));
+
+  vec_foreach (fei, ctx.feis)
+    {
+      fib_route_path_t *rpaths, *rpath;
+      const fib_prefix_t *pfx;
+      fib_source_t src;
+      u32 fib_index;
+      u8 n_paths;
+
+      pfx = fib_entry_get_prefix (*fei);
+      fib_index = fib_entry_get_fib_index (*fei);
+      src = fib_entry_get_best_source (*fei);
+      rpaths = fib_entry_encode (*fei);
+
+      /*
+       * unsupported routes are written with no paths, so the reader
+       * stays in step with the entry count and can report them.
+       */
+      n_paths = (ip_checkpoint_rpaths_supported (rpaths) ?
+		   clib_min (vec_len (rpaths), 0xff) :
+		   0);
+
+      serialize_integer (m, pfx->fp_proto, sizeof (u8));
+      serialize_integer (m, fib_table_get_table_id (fib_index, pfx->fp_proto),
+			 sizeof (u32));
+      serialize_ip46_address (m, &pfx->fp_addr);
+      serialize_integer (m, pfx->fp_len, sizeof (u8));
+      serialize_integer (m, src, sizeof (u8));
+      serialize_integer (m, fib_entry_get_flags_for_source (*fei, src),
+			 sizeof (u32));
+      serialize_integer (m, n_paths, sizeof (u8));
+
+      vec_foreach (rpath, rpaths)
+	{
+	  mpls_label_t table_id = 0;
+	  fib_mpls_label_t *label;
+
+	  if (rpath - rpaths >= n_paths)
+	    break;
+
+	  /* recursive and deag paths carry a table index, save its ID */
+	  if (DPO_PROTO_MPLS != rpath->frp_proto &&
+	      ~0 == rpath->frp_sw_if_index)
+	    table_id = fib_table_get_table_id (
+	      rpath->frp_fib_index, dpo_proto_to_fib (rpath->frp_proto));
+
+	  serialize_integer (m, rpath->frp_proto, sizeof (u8));
+	  serialize_integer (m, rpath->frp_flags, sizeof (u32));
+	  serialize_ip46_address (m, &rpath->frp_addr);
+	  serialize_sw_if_index (m, rpath->frp_sw_if_index);
+	  serialize_integer (m, table_id, sizeof (u32));
+	  serialize_integer (m, rpath->frp_weight, sizeof (u8));
+	  serialize_integer (m, rpath->frp_preference, sizeof (u8));
+
+	  serialize_likely_small_unsigned_integer (
+	    m, vec_len (rpath->frp_label_stack));
+	  vec_foreach (label, rpath->frp_label_stack)
+	    {
+	      serialize_integer (m, label->fml_value, sizeof (u32));
+	      serialize_integer (m, label->fml_mode, sizeof (u8));
+	      serialize_integer (m, label->fml_ttl, sizeof (u8));
+	      serialize_integer (m, label->fml_exp, sizeof (u8));
+	    }
+	}
+
+      if (n_paths)
+	stats->n_routes++;
+      else
+	stats->n_skipped++;
+
+      vec_free (rpaths);
+    }
+
+  vec_free (ctx.feis);
+}
+
+static void
+unserialize_ip_checkpoint_routes (serialize_main_t *m, va_list *va)
+{
+  ip_checkpoint_stats_t *stats = va_arg (*va, ip_checkpoint_stats_t *);
+  fib_route_path_t *rpaths = 0, *rpath;
+  u32 n_routes;
+
+  n_routes = unserialize_likely_small_unsigned_integer (m);
+
+  while (n_routes--)
+    {
+      u32 table_id, entry_flags, fib_index;
+      u8 fproto, len, src, n_paths;
+      fib_prefix_t pfx = {};
+      int missing = 0;
+
+      unserialize_integer (m, &fproto, sizeof (u8));
+      unserialize_integer (m, &table_id, sizeof (u32));
+      unserialize_ip46_address (m, &pfx.fp_addr);
+      unserialize_integer (m, &len, sizeof (u8));
+      unserialize_integer (m, &src, sizeof (u8));
+      unserialize_integer (m, &entry_flags, sizeof (u32));
+      unserialize_integer (m, &n_paths, sizeof (u8));
+
+      pfx.fp_proto = fproto;
+      pfx.fp_len = len;
+
+      vec_reset_length (rpaths);
+      while (n_paths--)
+	{
+	  u8 proto, weight, preference;
+	  u32 flags, path_table_id, n_labels;
+
+	  vec_add2 (rpaths, rpath, 1);
+	  clib_memset (rpath, 0, sizeof (*rpath));
+
+	  unserialize_integer (m, &proto, sizeof (u8));
+	  unserialize_integer (m, &flags, sizeof (u32));
+	  unserialize_ip46_address (m, &rpath->frp_addr);
+	  rpath->frp_sw_if_index = unserialize_sw_if_index (m, &missing);
+	  unserialize_integer (m, &path_table_id, sizeof (u32));
+	  unserialize_integer (m, &weight, sizeof (u8));
+	  unserialize_integer (m, &preference, sizeof (u8));
+
+	  rpath->frp_proto = proto;
+	  rpath->frp_flags = flags;
+	  rpath->frp_weight = weight;
+	  rpath->frp_preference = preference;
+	  rpath->frp_fib_index = 0;
+
+	  if (0 != path_table_id && DPO_PROTO_MPLS != proto)
+	    {
+	      fib_protocol_t nh_proto = dpo_proto_to_fib (proto);
+
+	      rpath->frp_fib_index = fib_table_find (nh_proto, path_table_id);
+	      if (~0 == rpath->frp_fib_index)
+		{
+		  ip_table_create (nh_proto, path_table_id, 1, NULL);
+		  rpath->frp_fib_index =
+		    fib_table_find (nh_proto, path_table_id);
+		}
+	    }
+
+	  n_labels = unserialize_likely_small_unsigned_integer (m);
+	  while (n_labels--)
+	    {
+	      fib_mpls_label_t label = {};
+	      u8 mode;
+
+	      unserialize_integer (m, &label.fml_value, sizeof (u32));
+	      unserialize_integer (m, &mode, sizeof (u8));
+	      unserialize_integer (m, &label.fml_ttl, sizeof (u8));
+	      unserialize_integer (m, &label.fml_exp, sizeof (u8));
+	      label.fml_mode = mode;
+	      vec_add1 (rpath->frp_label_stack, label);
+	    }
+	}
+
+      if (0 == vec_len (rpaths) || missing)
+	{
+	  vec_foreach (rpath, rpaths)
+	    vec_free (rpath->frp_label_stack);
+	  stats->n_skipped++;
+	  continue;
+	}
+
+      fib_index = fib_table_find (pfx.fp_proto, table_id);
+      if (~0 == fib_index)
+	{
+	  ip_table_create (pfx.fp_proto, table_id, 1, NULL);
+	  fib_index = fib_table_find (pfx.fp_proto, table_id);
+	}
+
+      /* the label stacks now belong to the entry's path extensions */
+      fib_table_entry_path_add2 (fib_index, &pfx, src, entry_flags, rpaths);
+      stats->n_routes++;
+    }
+
+  vec_free (rpaths);
+}
+
+static void
+serialize_ip_checkpoint (serialize_main_t *m, va_list *va)
+{
+  ip_checkpoint_stats_t *stats = va_arg (*va, ip_checkpoint_stats_t *);
+
+  serialize_magic (m, ip_checkpoint_magic, strlen (ip_checkpoint_magic));
+  serialize_integer (m, IP_CHECKPOINT_VERSION, sizeof (u32));
+
+  serialize (m, serialize_ip_checkpoint_interfaces, stats);
+  serialize (m, serialize_ip_checkpoint_neighbors, stats);
+  serialize (m, serialize_ip_checkpoint_routes, stats);
+}
+
+static void
+unserialize_ip_checkpoint (serialize_main_t *m, va_list *va)
+{
+  ip_checkpoint_stats_t *stats = va_arg (*va, ip_checkpoint_stats_t *);
+  u32 version;
+
+  unserialize_check_magic (m, ip_checkpoint_magic,
+			   strlen (ip_checkpoint_magic));
+  unserialize_integer (m, &version, sizeof (u32));
+
+  if (IP_CHECKPOINT_VERSION != version)
+    serialize_error_return (m, "checkpoint version %d, expected %d", version,
+			    IP_CHECKPOINT_VERSION);
+
+  /*
+   * interfaces first so the neighbours have somewhere to live, then
+   * neighbours so the routes resolve through complete adjacencies and
+   * forwarding starts without waiting on ARP/ND.
+   */
+  unserialize (m, unserialize_ip_checkpoint_interfaces, stats);
+  unserialize (m, unserialize_ip_checkpoint_neighbors, stats);
+  unserialize (m, unserialize_ip_checkpoint_routes, stats);
+}
+
+/*
+ * The clib file streams leave their descriptor open and, after an error,
+ * their buffers allocated; release both whether or not (un)serialize
+ * succeeded.
+ */
+static void
+ip_checkpoint_file_close (serialize_main_t *m)
+{
+  close (m->stream.data_function_opaque);
+  vec_free (m->stream.buffer);
+  vec_free (m->stream.overflow_buffer);
+}
+
+clib_error_t *
+ip_checkpoint_save (char *file, ip_checkpoint_stats_t *stats)
+{
+  serialize_main_t m;
+  clib_error_t *error;
+
+  clib_memset (stats, 0, sizeof (*stats));
+
+  error = serialize_open_clib_file (&m, file);
+  if (error)
+    return (error);
+
+  error = serialize (&m, serialize_ip_checkpoint, stats);
+  if (!error)
+    serialize_close (&m);
+  ip_checkpoint_file_close (&m);
+
+  IP_CKPT_INFO ("save %s: %U", file, format_ip_checkpoint_stats, stats);
+
+  return (error);
+}
+
+clib_error_t *
+ip_checkpoint_restore (char *file, ip_checkpoint_stats_t *stats)
+{
+  serialize_main_t m;
+  clib_error_t *error;
+
+  clib_memset (stats, 0, sizeof (*stats));
+
+  error = unserialize_open_clib_file (&m, file);
+  if (error)
+    return (error);
+
+  error = unserialize (&m, unserialize_ip_checkpoint, stats);
+  if (!error)
+    unserialize_close (&m);
+  ip_checkpoint_file_close (&m);
+
+  IP_CKPT_INFO ("restore %s: %U", file, format_ip_checkpoint_stats, stats);
+
+  return (error);
+}
+
+u8 *
+format_ip_checkpoint_stats (u8 *s, va_list *args)
+{
+  ip_checkpoint_stats_t *stats = va_arg (*args, ip_checkpoint_stats_t *);
+
+  s = format (s, "interfaces:%d neighbors:%d routes:%d skipped:%d",
+	      stats->n_interfaces, stats->n_neighbors, stats->n_routes,
+	      stats->n_skipped);
+
+  return (s);
+}
+
+static clib_error_t *
+ip_checkpoint_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			  vlib_cli_command_t *cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  ip_checkpoint_stats_t stats;
+  clib_error_t *error = NULL;
+  u8 *file = NULL;
+  int is_save = -1;
+  f64 t;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return (NULL);
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "save %s", &file))
+	is_save = 1;
+      else if (unformat (line_input, "restore %s", &file))
+	is_save = 0;
+      else
+	{
+	  error = unformat_parse_error (line_input);
+	  goto done;
+	}
+    }
+
+  if (-1 == is_save)
+    {
+      error = clib_error_return (0, "save or restore <file> required");
+      goto done;
+    }
+
+  vec_add1 (file, 0);
+  t = vlib_time_now (vm);
+
+  if (is_save)
+    error = ip_checkpoint_save ((char *) file, &stats);
+  else
+    error = ip_checkpoint_restore ((char *) file, &stats);
+
+  if (!error)
+    vlib_cli_output (vm, "%s %s: %U in %.3fs", (is_save ? "saved" : "restored"),
+		     file, format_ip_checkpoint_stats, &stats,
+		     vlib_time_now (vm) - t);
+
+done:
+  unformat_free (line_input);
+  vec_free (file);
+
+  return (error);
+}
+
+/*?
+ * Save or restore a checkpoint of the IP forwarding state: interface
+ * table bindings, addresses and admin state, the neighbour tables and
+ * API/CLI sourced routes. Restoring a checkpoint taken before a restart
+ * lets VPP forward before the control plane has re-synced.
+ * Place the restore in the startup-config script after the interfaces
+ * have been created.
+ *
+ * @cliexpar
+ * @cliexcmd{ip checkpoint save /var/run/vpp/ip.ckpt}
+ * @cliexcmd{ip checkpoint restore /var/run/vpp/ip.ckpt}
+ ?*/
+VLIB_CLI_COMMAND (ip_checkpoint_command, static) = {
+  .path = "ip checkpoint",
+  .short_help = "ip checkpoint [save|restore] <file>",
+  .function = ip_checkpoint_command_fn,
+};
+
+static clib_error_t *
+ip_checkpoint_exit (vlib_main_t *vm)
+{
+  ip_checkpoint_main_t *icm = &ip_checkpoint_main;
+  ip_checkpoint_stats_t stats;
+  clib_error_t *error;
+
+  if (!icm->save_on_exit)
+    return (NULL);
+
+  error = ip_checkpoint_save ((char *) icm->save_on_exit, &stats);
+  if (error)
+    clib_error_report (error);
+
+  return (NULL);
+}
+
+VLIB_MAIN_LOOP_EXIT_FUNCTION (ip_checkpoint_exit);
+
+static clib_error_t *
+ip_checkpoint_config (vlib_main_t *vm, unformat_input_t *input)
+{
+  ip_checkpoint_main_t *icm = &ip_checkpoint_main;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "save-on-exit %s", &icm->save_on_exit))
+	vec_add1 (icm->save_on_exit, 0);
+      else
+	return (clib_error_return (0, "unknown input '%U'",
+				   format_unformat_error, input));
+    }
+
+  return (NULL);
+}
+
+VLIB_CONFIG_FUNCTION (ip_checkpoint_config, "ip-checkpoint");
+
+static clib_error_t *
+ip_checkpoint_init (vlib_main_t *vm)
+{
+  ip_checkpoint_main.log_class =
+    vlib_log_register_class ("ip", "checkpoint");
+
+  return (NULL);
+}
+
+VLIB_INIT_FUNCTION (ip_checkpoint_init);
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
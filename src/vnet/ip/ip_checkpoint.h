@@ -0,0 +1,44 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#ifndef __IP_CHECKPOINT_H__
+#define __IP_CHECKPOINT_H__
+
+#include <vnet/vnet.h>
+
+/**
+ * IP forwarding state checkpoint
+ *
+ * A checkpoint captures the L3 forwarding state that the control plane
+ * has programmed: interface table bindings, addresses and admin state,
+ * the IP neighbour tables and the API/CLI sourced unicast routes.
+ * Restoring it into a freshly started VPP lets forwarding resume before
+ * the control plane has re-synced; the control plane's later (idempotent)
+ * re-programming then lands on existing state.
+ *
+ * Interfaces and tables are referenced by name and table-ID, never by
+ * index, since neither index is stable across a restart.
+ */
+typedef struct ip_checkpoint_stats_t_
+{
+  u32 n_interfaces;
+  u32 n_neighbors;
+  u32 n_routes;
+  u32 n_skipped;
+} ip_checkpoint_stats_t;
+
+extern clib_error_t *ip_checkpoint_save (char *file,
+					 ip_checkpoint_stats_t *stats);
+extern clib_error_t *ip_checkpoint_restore (char *file,
+					    ip_checkpoint_stats_t *stats);
+
+extern u8 *format_ip_checkpoint_stats (u8 *s, va_list *args);
+
+#endif
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,119 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#ifndef __IP_ROUTE_SNAPSHOT_H__
+#define __IP_ROUTE_SNAPSHOT_H__
+
+#include <vppinfra/error_bootstrap.h>
+
+/**
+ * IP route table snapshot
+ *
+ * The reply to an ip_route_snapshot request is followed, on the socket
+ * transport, by a memfd holding the whole table. The client mmaps the fd
+ * and walks the records in place; there is one API message per table
+ * rather than one per route.
+ *
+ * The segment starts with an ip_route_snapshot_hdr_t, followed by
+ * hdr->n_routes variable length route records. Each route record is
+ * followed by route->n_paths path records, each path record by
+ * path->n_labels u32 out-labels. All values are in host byte order; the
+ * type, flags and proto values of a path are the vl_api_fib_path_type_t,
+ * vl_api_fib_path_flags_t and vl_api_fib_path_nh_proto_t encodings.
+ */
+#define IP_ROUTE_SNAPSHOT_MAGIC 0x52504956 /* "VIPR" */
+#define IP_ROUTE_SNAPSHOT_VERSION 1
+
+typedef struct ip_route_snapshot_hdr_t_
+{
+  u32 magic;
+  u32 version;
+  u32 n_routes;
+  u32 table_id;
+  /** bytes used in the segment, including this header */
+  u64 size;
+} ip_route_snapshot_hdr_t;
+
+typedef struct ip_route_snapshot_route_t_
+{
+  u8 addr[16];
+  u32 stats_index;
+  /** AF_IP4 or AF_IP6 */
+  u8 af;
+  u8 len;
+  u8 src;
+  u8 n_paths;
+} ip_route_snapshot_route_t;
+
+typedef struct ip_route_snapshot_path_t_
+{
+  u8 nh[16];
+  u32 sw_if_index;
+  u32 table_id;
+  u32 via_label;
+  u32 obj_id;
+  u8 weight;
+  u8 preference;
+  u8 type;
+  u8 flags;
+  u8 proto;
+  u8 n_labels;
+  u16 __pad;
+} ip_route_snapshot_path_t;
+
+STATIC_ASSERT_SIZEOF (ip_route_snapshot_route_t, 24);
+STATIC_ASSERT_SIZEOF (ip_route_snapshot_path_t, 40);
+
+static inline ip_route_snapshot_route_t *
+ip_route_snapshot_first (ip_route_snapshot_hdr_t *hdr)
+{
+  return ((ip_route_snapshot_route_t *) (hdr + 1));
+}
+
+static inline ip_route_snapshot_path_t *
+ip_route_snapshot_paths (ip_route_snapshot_route_t *route)
+{
+  return ((ip_route_snapshot_path_t *) (route + 1));
+}
+
+static inline u32 *
+ip_route_snapshot_path_labels (ip_route_snapshot_path_t *path)
+{
+  return ((u32 *) (path + 1));
+}
+
+static inline ip_route_snapshot_path_t *
+ip_route_snapshot_path_next (ip_route_snapshot_path_t *path)
+{
+  return ((ip_route_snapshot_path_t *) (ip_route_snapshot_path_labels (path) +
+					path->n_labels));
+}
+
+static inline ip_route_snapshot_route_t *
+ip_route_snapshot_next (ip_route_snapshot_route_t *route)
+{
+  ip_route_snapshot_path_t *path;
+  u32 i;
+
+  path = ip_route_snapshot_paths (route);
+  for (i = 0; i < route->n_paths; i++)
+    path = ip_route_snapshot_path_next (path);
+
+  return ((ip_route_snapshot_route_t *) path);
+}
+
+/**
+ * Queue a snapshot of the table to be built by the snapshot process and
+ * sent to the API client.
+ */
+extern void ip_route_snapshot_request (u32 client_index, u32 context,
+				       u8 is_ip6, u32 table_id);
+
+#endif
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -1450,6 +1450,18 @@ api_ip_route_v2_dump (vat_main_t *vat)
   return -1;
 }
 
+static int
+api_ip_route_snapshot (vat_main_t *vat)
+{
+  return -1;
+}
+
+static void
+vl_api_ip_route_snapshot_reply_t_handler (
+  vl_api_ip_route_snapshot_reply_t *mp)
+{
+}
+
 static void
 vl_api_ip_path_mtu_get_reply_t_handler (vl_api_ip_path_mtu_get_reply_t *mp)
 {
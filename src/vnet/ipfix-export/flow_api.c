@@ -104,9 +104,9 @@ vl_api_set_ipfix_exporter_t_internal (
 	  if (!exp)
 	    {
 	      /* Create a new exporter instead of updating an existing one */
-	      if (pool_elts (frm->exporters) >= IPFIX_EXPORTERS_MAX)
+	      exp = vnet_ipfix_exporter_alloc ();
+	      if (!exp)
 		return VNET_API_ERROR_INVALID_VALUE;
-	      pool_get (frm->exporters, exp);
 	    }
 	}
       else
@@ -116,7 +116,7 @@ vl_api_set_ipfix_exporter_t_internal (
 	  if (!exp)
 	    return VNET_API_ERROR_NO_SUCH_ENTRY;
 
-	  pool_put (frm->exporters, exp);
+	  vnet_ipfix_exporter_free (exp);
 	  return 0;
 	}
     }
@@ -310,32 +310,89 @@ vnet_flow_rewrite_generic_callback (ipfix_exporter_t *exp, flow_report_t *fr,
   return rewrite;
 }
 
+/*
+ * One token per data packet, refilled at the exporter rate shared
+ * evenly between the threads, with at most one second of burst
+ */
+static_always_inline int
+ipfix_exp_rate_limited (vlib_main_t *vm, ipfix_exporter_t *exp)
+{
+  ipfix_exporter_per_thread_t *eptd;
+  f64 now, rate;
+
+  if (PREDICT_TRUE (exp->rate_limit == 0))
+    return 0;
+
+  eptd = vec_elt_at_index (exp->per_thread_data, vm->thread_index);
+  rate = (f64) exp->rate_limit / vlib_get_n_threads ();
+  now = vlib_time_now (vm);
+  eptd->tokens += (now - eptd->last_refill) * rate;
+  eptd->tokens = clib_min (eptd->tokens, clib_max (rate, 1.0));
+  eptd->last_refill = now;
+
+  if (eptd->tokens < 1.0)
+    return 1;
+  eptd->tokens -= 1.0;
+  return 0;
+}
+
 vlib_buffer_t *
 vnet_ipfix_exp_get_buffer (vlib_main_t *vm, ipfix_exporter_t *exp,
 			   flow_report_t *fr, u32 thread_index)
 {
+  flow_report_per_thread_t *ptd = &fr->per_thread_data[thread_index];
   u32 bi0;
   vlib_buffer_t *b0;
 
-  if (fr->per_thread_data[thread_index].buffer)
-    return fr->per_thread_data[thread_index].buffer;
+  if (ptd->buffer)
+    return ptd->buffer;
+
+  if (ipfix_exp_rate_limited (vm, exp))
+    return NULL;
 
   if (vlib_buffer_alloc (vm, &bi0, 1) != 1)
     return NULL;
 
   /* Initialize the buffer */
-  b0 = fr->per_thread_data[thread_index].buffer = vlib_get_buffer (vm, bi0);
+  b0 = ptd->buffer = vlib_get_buffer (vm, bi0);
 
   b0->current_data = 0;
   b0->current_length = exp->all_headers_size;
   b0->flags |= (VLIB_BUFFER_TOTAL_LENGTH_VALID | VNET_BUFFER_F_FLOW_REPORT);
   vnet_buffer (b0)->sw_if_index[VLIB_RX] = 0;
   vnet_buffer (b0)->sw_if_index[VLIB_TX] = exp->fib_index;
-  fr->per_thread_data[thread_index].next_data_offset = b0->current_length;
+  ptd->next_data_offset = b0->current_length;
+  ptd->n_data_records = 0;
+  ptd->buffer_start_time = vlib_time_now (vm);
 
   return b0;
 }
 
+static void
+ipfix_exp_send_frame (vlib_main_t *vm, ipfix_exporter_t *exp,
+		      flow_report_per_thread_t *ptd)
+{
+  u32 n_buffers = vec_len (ptd->buffers_to_send);
+  u32 next_node;
+  vlib_frame_t *f;
+
+  if (n_buffers == 0)
+    return;
+
+  if (ip_addr_version (&exp->ipfix_collector) == AF_IP4)
+    next_node = ip4_lookup_node.index;
+  else
+    next_node = ip6_lookup_node.index;
+
+  f = vlib_get_frame_to_node (vm, next_node);
+  clib_memcpy_fast (vlib_frame_vector_args (f), ptd->buffers_to_send,
+		    n_buffers * sizeof (u32));
+  f->n_vectors = n_buffers;
+  vlib_put_frame_to_node (vm, next_node, f);
+
+  vec_reset_length (ptd->buffers_to_send);
+}
+
 /*
  * Send a buffer that is mostly populated. Has flow records but needs some
  * header fields updated.
@@ -346,7 +403,9 @@ vnet_ipfix_exp_send_buffer (vlib_main_t *vm, ipfix_exporter_t *exp,
 			    u32 thread_index, vlib_buffer_t *b0)
 {
   flow_report_main_t *frm = &flow_report_main;
-  vlib_frame_t *f;
+  flow_report_per_thread_t *ptd = &fr->per_thread_data[thread_index];
+  ipfix_exporter_per_thread_t *eptd =
+    vec_elt_at_index (exp->per_thread_data, thread_index);
   ipfix_set_header_t *s;
   ipfix_message_header_t *h;
   ip4_header_t *ip4 = 0;
@@ -356,8 +415,7 @@ vnet_ipfix_exp_send_buffer (vlib_main_t *vm, ipfix_exporter_t *exp,
   int ip_len;
 
   /* nothing to send */
-  if (fr->per_thread_data[thread_index].next_data_offset <=
-      exp->all_headers_size)
+  if (ptd->next_data_offset <= exp->all_headers_size)
     return;
 
   ip_len = ipfix_write_headers (exp, (void *) vlib_buffer_get_current (b0),
@@ -384,8 +442,7 @@ vnet_ipfix_exp_send_buffer (vlib_main_t *vm, ipfix_exporter_t *exp,
    * the Exporting Process
    */
   h->sequence_number =
-    clib_atomic_fetch_add (&stream->sequence_number,
-			   fr->per_thread_data[thread_index].n_data_records);
+    clib_atomic_fetch_add (&stream->sequence_number, ptd->n_data_records);
   h->sequence_number = clib_host_to_net_u32 (h->sequence_number);
 
   /*
@@ -430,34 +487,89 @@ vnet_ipfix_exp_send_buffer (vlib_main_t *vm, ipfix_exporter_t *exp,
 	udp->checksum = 0xffff;
     }
 
-  /* Find or allocate a frame */
-  f = fr->per_thread_data[thread_index].frame;
-  if (PREDICT_FALSE (f == 0))
+  eptd->n_packets++;
+  eptd->n_records += ptd->n_data_records;
+
+  /* Hold the buffer back until a frame's worth is ready */
+  vec_add1 (ptd->buffers_to_send, vlib_get_buffer_index (vm, b0));
+  if (vec_len (ptd->buffers_to_send) >= IPFIX_EXPORT_BATCH_SIZE)
+    ipfix_exp_send_frame (vm, exp, ptd);
+
+  ptd->buffer = NULL;
+  ptd->next_data_offset = 0;
+  ptd->n_data_records = 0;
+}
+
+int
+vnet_ipfix_exp_buffer_refill (vlib_main_t *vm, ipfix_exporter_t *exp,
+			      flow_report_t *fr, u16 len)
+{
+  u32 thread_index = vm->thread_index;
+  flow_report_per_thread_t *ptd = &fr->per_thread_data[thread_index];
+  ipfix_exporter_per_thread_t *eptd =
+    vec_elt_at_index (exp->per_thread_data, thread_index);
+
+  /* No room left for this record */
+  if (ptd->buffer)
+    vnet_ipfix_exp_send_buffer (vm, exp, fr, &exp->streams[fr->stream_index],
+				thread_index, ptd->buffer);
+
+  if (PREDICT_FALSE (exp->all_headers_size + len > exp->path_mtu) ||
+      vnet_ipfix_exp_get_buffer (vm, exp, fr, thread_index) == 0)
     {
-      u32 *to_next;
-      if (ip_addr_version (&exp->ipfix_collector) == AF_IP4)
-	f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
-      else
-	f = vlib_get_frame_to_node (vm, ip6_lookup_node.index);
-      fr->per_thread_data[thread_index].frame = f;
-      u32 bi0 = vlib_get_buffer_index (vm, b0);
-
-      /* Enqueue the buffer */
-      to_next = vlib_frame_vector_args (f);
-      to_next[0] = bi0;
-      f->n_vectors = 1;
+      eptd->n_records_dropped++;
+      return -1;
     }
 
-  if (ip_addr_version (&exp->ipfix_collector) == AF_IP4)
-    vlib_put_frame_to_node (vm, ip4_lookup_node.index, f);
-  else
-    vlib_put_frame_to_node (vm, ip6_lookup_node.index, f);
+  return 0;
+}
+
+void
+vnet_ipfix_exp_flush (vlib_main_t *vm, ipfix_exporter_t *exp,
+		      flow_report_t *fr, f64 max_age)
+{
+  u32 thread_index = vm->thread_index;
+  flow_report_per_thread_t *ptd;
+
+  if (thread_index >= vec_len (fr->per_thread_data))
+    return;
+
+  ptd = &fr->per_thread_data[thread_index];
+  if (ptd->buffer &&
+      vlib_time_now (vm) >= ptd->buffer_start_time + max_age)
+    vnet_ipfix_exp_send_buffer (vm, exp, fr, &exp->streams[fr->stream_index],
+				thread_index, ptd->buffer);
+
+  ipfix_exp_send_frame (vm, exp, ptd);
+}
+
+static void
+ipfix_exp_flush_thread (vlib_main_t *vm)
+{
+  flow_report_main_t *frm = &flow_report_main;
+  ipfix_exporter_t *exp;
+  flow_report_t *fr;
 
-  fr->per_thread_data[thread_index].frame = NULL;
-  fr->per_thread_data[thread_index].buffer = NULL;
-  fr->per_thread_data[thread_index].next_data_offset = 0;
+  pool_foreach (exp, frm->exporters)
+    pool_foreach (fr, exp->reports)
+      vnet_ipfix_exp_flush (vm, exp, fr, 0);
+}
+
+static uword
+ipfix_export_flush_node_fn (vlib_main_t *vm, vlib_node_runtime_t *rt,
+			    vlib_frame_t *f)
+{
+  ipfix_exp_flush_thread (vm);
+  return 0;
 }
 
+VLIB_REGISTER_NODE (ipfix_export_flush_node) = {
+  .function = ipfix_export_flush_node_fn,
+  .name = "ipfix-export-flush",
+  .type = VLIB_NODE_TYPE_INPUT,
+  .state = VLIB_NODE_STATE_INTERRUPT,
+};
+
 static void
 flow_report_process_send (vlib_main_t *vm, flow_report_main_t *frm,
 			  ipfix_exporter_t *exp, flow_report_t *fr,
@@ -466,6 +578,9 @@ flow_report_process_send (vlib_main_t *vm, flow_report_main_t *frm,
   vlib_frame_t *nf = 0;
   u32 *to_next;
 
+  if (template_bi == ~0 && fr->flow_data_callback == 0)
+    return;
+
   nf = vlib_get_frame_to_node (vm, next_node);
   nf->n_vectors = 0;
   to_next = vlib_frame_vector_args (nf);
@@ -477,7 +592,8 @@ flow_report_process_send (vlib_main_t *vm, flow_report_main_t *frm,
       nf->n_vectors++;
     }
 
-  nf = fr->flow_data_callback (frm, exp, fr, nf, to_next, next_node);
+  if (fr->flow_data_callback)
+    nf = fr->flow_data_callback (frm, exp, fr, nf, to_next, next_node);
   if (nf)
     {
       if (nf->n_vectors)
@@ -537,7 +653,7 @@ flow_report_process (vlib_main_t * vm,
 	  /* 5s delay by default, possibly reduced by template intervals */
 	  wait_time = def_wait_time;
 
-	  vec_foreach (fr, exp->reports)
+	  pool_foreach (fr, exp->reports)
 	    {
 	      f64 next_template;
 	      now = vlib_time_now (vm);
@@ -575,6 +691,12 @@ flow_report_process (vlib_main_t * vm,
 		}
 	    }
 	}
+
+      /* Send what the data path has buffered, on every thread */
+      ipfix_exp_flush_thread (vm);
+      for (u32 i = 1; i < vlib_get_n_threads (); i++)
+	vlib_node_set_interrupt_pending (vlib_get_main_by_index (i),
+					 ipfix_export_flush_node.index);
     }
 
   return 0;			/* not so much */
@@ -608,14 +730,13 @@ vnet_flow_report_add_del (ipfix_exporter_t *exp,
   if (si == -1 && a->is_add == 0)
     return VNET_API_ERROR_NO_SUCH_ENTRY;
 
-  for (i = 0; i < vec_len (exp->reports); i++)
+  pool_foreach (fr, exp->reports)
     {
-      fr = vec_elt_at_index (exp->reports, i);
-      if (fr->opaque.as_uword == a->opaque.as_uword
-	  && fr->rewrite_callback == a->rewrite_callback
-	  && fr->flow_data_callback == a->flow_data_callback)
+      if (fr->opaque.as_uword == a->opaque.as_uword &&
+	  fr->rewrite_callback == a->rewrite_callback &&
+	  fr->flow_data_callback == a->flow_data_callback)
 	{
-	  found_index = i;
+	  found_index = fr - exp->reports;
 	  if (template_id)
 	    *template_id = fr->template_id;
 	  break;
@@ -626,20 +747,23 @@ vnet_flow_report_add_del (ipfix_exporter_t *exp,
     {
       if (found_index != ~0)
 	{
-	  for (int i = 0;
-	       i < vec_len (exp->reports[found_index].per_thread_data); i++)
+	  fr = pool_elt_at_index (exp->reports, found_index);
+	  for (i = 0; i < vec_len (fr->per_thread_data); i++)
 	    {
+	      flow_report_per_thread_t *ptd = &fr->per_thread_data[i];
 	      u32 bi;
-	      if (exp->reports[found_index].per_thread_data[i].buffer)
+	      if (ptd->buffer)
 		{
-		  bi = vlib_get_buffer_index (
-		    vm, exp->reports[found_index].per_thread_data[i].buffer);
+		  bi = vlib_get_buffer_index (vm, ptd->buffer);
 		  vlib_buffer_free (vm, &bi, 1);
 		}
+	      vlib_buffer_free (vm, ptd->buffers_to_send,
+				vec_len (ptd->buffers_to_send));
+	      vec_free (ptd->buffers_to_send);
 	    }
-	  vec_free (exp->reports[found_index].per_thread_data);
+	  vec_free (fr->per_thread_data);
 
-	  vec_delete (exp->reports, 1, found_index);
+	  pool_put (exp->reports, fr);
 	  stream = &exp->streams[si];
 	  stream->n_reports--;
 	  if (stream->n_reports == 0)
@@ -650,7 +774,10 @@ vnet_flow_report_add_del (ipfix_exporter_t *exp,
     }
 
   if (found_index != ~0)
-    return VNET_API_ERROR_VALUE_EXIST;
+    {
+      a->flow_report_index = found_index;
+      return VNET_API_ERROR_VALUE_EXIST;
+    }
 
   if (si == -1)
     {
@@ -666,7 +793,7 @@ vnet_flow_report_add_del (ipfix_exporter_t *exp,
 
   stream->n_reports++;
 
-  vec_add2 (exp->reports, fr, 1);
+  pool_get_zero (exp->reports, fr);
 
   fr->stream_index = si;
   fr->template_id = 256 + stream->next_template_no;
@@ -679,6 +806,8 @@ vnet_flow_report_add_del (ipfix_exporter_t *exp,
   fr->n_report_elements = a->n_report_elements;
   fr->stream_indexp = a->stream_indexp;
   vec_validate (fr->per_thread_data, tm->n_threads);
+  vec_validate_aligned (exp->per_thread_data, tm->n_threads,
+			CLIB_CACHE_LINE_BYTES);
   /* Store the flow_report index back in the args struct */
   a->flow_report_index = fr - exp->reports;
 
@@ -723,7 +852,7 @@ vnet_flow_reports_reset (ipfix_exporter_t *exp)
     if (stream_index_valid (exp, i))
       exp->streams[i].sequence_number = 0;
 
-  vec_foreach (fr, exp->reports)
+  pool_foreach (fr, exp->reports)
     {
       fr->update_rewrite = 1;
       fr->last_template_sent = 0;
@@ -737,8 +866,8 @@ vnet_stream_reset (ipfix_exporter_t *exp, u32 stream_index)
 
   exp->streams[stream_index].sequence_number = 0;
 
-  vec_foreach (fr, exp->reports)
-    if (exp->reports->stream_index == stream_index)
+  pool_foreach (fr, exp->reports)
+    if (fr->stream_index == stream_index)
       {
 	fr->update_rewrite = 1;
 	fr->last_template_sent = 0;
@@ -761,6 +890,29 @@ vnet_stream_change (ipfix_exporter_t *exp, u32 old_domain_id, u16 old_src_port,
   return 0;
 }
 
+ipfix_exporter_t *
+vnet_ipfix_exporter_alloc (void)
+{
+  flow_report_main_t *frm = &flow_report_main;
+  ipfix_exporter_t *exp;
+
+  if (pool_elts (frm->exporters) >= IPFIX_EXPORTERS_MAX)
+    return NULL;
+
+  pool_get_zero (frm->exporters, exp);
+  exp->fib_index = ~0;
+  return exp;
+}
+
+void
+vnet_ipfix_exporter_free (ipfix_exporter_t *exp)
+{
+  flow_report_main_t *frm = &flow_report_main;
+
+  vec_free (exp->per_thread_data);
+  pool_put (frm->exporters, exp);
+}
+
 static clib_error_t *
 set_ipfix_exporter_command_fn (vlib_main_t * vm,
 			       unformat_input_t * input,
@@ -775,6 +927,7 @@ set_ipfix_exporter_command_fn (vlib_main_t * vm,
   u32 path_mtu = 512;		// RFC 7011 section 10.3.3.
   u32 template_interval = 20;
   u8 udp_checksum = 0;
+  u32 rate_limit = 0;
   ipfix_exporter_t *exp = pool_elt_at_index (frm->exporters, 0);
   u32 ip_header_size;
 
@@ -802,6 +955,8 @@ set_ipfix_exporter_command_fn (vlib_main_t * vm,
 	;
       else if (unformat (input, "udp-checksum"))
 	udp_checksum = 1;
+      else if (unformat (input, "rate-limit %u", &rate_limit))
+	;
       else
 	break;
     }
@@ -844,6 +999,7 @@ set_ipfix_exporter_command_fn (vlib_main_t * vm,
   exp->path_mtu = path_mtu;
   exp->template_interval = template_interval;
   exp->udp_checksum = udp_checksum;
+  exp->rate_limit = rate_limit;
 
   if (collector.ip.ip4.as_u32)
     vlib_cli_output (vm,
@@ -871,12 +1027,54 @@ VLIB_CLI_COMMAND (set_ipfix_exporter_command, static) = {
                   "src <ip4-address> [fib-id <fib-id>] "
                   "[path-mtu <path-mtu>] "
                   "[template-interval <template-interval>] "
-                  "[udp-checksum]",
+                  "[udp-checksum] [rate-limit <packets/s>]",
     .function = set_ipfix_exporter_command_fn,
 };
 /* *INDENT-ON* */
 
 
+static clib_error_t *
+show_ipfix_exporter_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				vlib_cli_command_t *cmd)
+{
+  flow_report_main_t *frm = &flow_report_main;
+  ipfix_exporter_per_thread_t *eptd;
+  ipfix_exporter_t *exp;
+
+  pool_foreach (exp, frm->exporters)
+    {
+      vlib_cli_output (vm,
+		       "[%u] collector %U port %u src %U path-mtu %u "
+		       "template-interval %us",
+		       exp - frm->exporters, format_ip_address,
+		       &exp->ipfix_collector, exp->collector_port,
+		       format_ip_address, &exp->src_address, exp->path_mtu,
+		       exp->template_interval);
+      if (exp->rate_limit)
+	vlib_cli_output (vm, "  rate-limit %u packets/s", exp->rate_limit);
+      else
+	vlib_cli_output (vm, "  rate-limit none");
+      vlib_cli_output (vm, "  reports %u", pool_elts (exp->reports));
+      vec_foreach (eptd, exp->per_thread_data)
+	{
+	  if (eptd->n_packets == 0 && eptd->n_records_dropped == 0)
+	    continue;
+	  vlib_cli_output (vm,
+			   "  thread %u: %lu packets, %lu records, "
+			   "%lu records dropped",
+			   eptd - exp->per_thread_data, eptd->n_packets,
+			   eptd->n_records, eptd->n_records_dropped);
+	}
+    }
+  return 0;
+}
+
+VLIB_CLI_COMMAND (show_ipfix_exporter_command, static) = {
+  .path = "show ipfix exporter",
+  .short_help = "show ipfix exporter",
+  .function = show_ipfix_exporter_command_fn,
+};
+
 static clib_error_t *
 ipfix_flush_command_fn (vlib_main_t * vm,
 			unformat_input_t * input, vlib_cli_command_t * cmd)
@@ -909,10 +1107,9 @@ flow_report_init (vlib_main_t * vm)
    * backwards compatibility reasons.
    */
   pool_alloc (frm->exporters, IPFIX_EXPORTERS_MAX);
-  pool_get (frm->exporters, exp);
+  exp = vnet_ipfix_exporter_alloc ();
   /* Verify that this is at index 0 */
   ASSERT (frm->exporters == exp);
-  exp->fib_index = ~0;
   return 0;
 }
 
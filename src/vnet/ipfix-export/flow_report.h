@@ -103,14 +103,16 @@ typedef struct
 typedef struct
 {
   vlib_buffer_t *buffer;
-  vlib_frame_t *frame;
+  /* Completed buffers, sent together in one frame */
+  u32 *buffers_to_send;
+  f64 buffer_start_time;
   u16 next_data_offset;
   /*
    * We need this per stream as the IPFIX sequence number is the count of
    * data record sent, not the count of packets with data records sent.
    * See RFC 7011, Sec 3.1
    */
-  u8 n_data_records;
+  u16 n_data_records;
 } flow_report_per_thread_t;
 
 /*
@@ -144,7 +146,10 @@ typedef struct flow_report
   u32 n_report_elements;
   u32 *stream_indexp;
 
-  /* Send-flow-data callback */
+  /*
+   * Send-flow-data callback, optional for reports whose records are
+   * added from the data path with vnet_ipfix_exp_add_record
+   */
   vnet_flow_data_callback_t *flow_data_callback;
 } flow_report_t;
 
@@ -153,12 +158,35 @@ typedef struct flow_report
  */
 #define IPFIX_EXPORTERS_MAX 5
 
+/*
+ * Completed data packets are held back per thread until this many are
+ * ready, or until the next flush, and then sent as a single frame
+ */
+#define IPFIX_EXPORT_BATCH_SIZE 32
+
+/*
+ * Per thread exporter state: rate limiter and counters
+ */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+
+  /* token bucket, in packets */
+  f64 tokens;
+  f64 last_refill;
+
+  u64 n_packets;
+  u64 n_records;
+  u64 n_records_dropped;
+} ipfix_exporter_per_thread_t;
+
 /*
  * We support multiple exporters. Each one has its own configured
  * destination, and its own set of reports and streams.
  */
 typedef struct ipfix_exporter
 {
+  /* pool of reports, indices are stable */
   flow_report_t *reports;
   flow_report_stream_t *streams;
 
@@ -177,6 +205,11 @@ typedef struct ipfix_exporter
   /* UDP checksum calculation enable flag */
   u8 udp_checksum;
 
+  /* data packets per second across all threads, 0 for no limit */
+  u32 rate_limit;
+
+  ipfix_exporter_per_thread_t *per_thread_data;
+
   /*
    * The amount of data needed for all the headers, prior to the first
    * flowset (template or data or ...) This is mostly dependent on the
@@ -208,6 +241,7 @@ typedef struct flow_report_main
 extern flow_report_main_t flow_report_main;
 
 extern vlib_node_registration_t flow_report_process_node;
+extern vlib_node_registration_t ipfix_export_flush_node;
 
 typedef struct
 {
@@ -246,6 +280,13 @@ int vnet_stream_change (ipfix_exporter_t *exp, u32 old_domain_id,
 ipfix_exporter_t *
 vnet_ipfix_exporter_lookup (const ip_address_t *ipfix_collector);
 
+/*
+ * Allocate a new exporter from the pool, or return NULL when the
+ * maximum is reached. Free it again with vnet_ipfix_exporter_free.
+ */
+ipfix_exporter_t *vnet_ipfix_exporter_alloc (void);
+void vnet_ipfix_exporter_free (ipfix_exporter_t *exp);
+
 /*
  * Get the currently in use buffer for the given stream on the given core.
  * If there is no current buffer then allocate a new one and return that.
@@ -267,6 +308,60 @@ void vnet_ipfix_exp_send_buffer (vlib_main_t *vm, ipfix_exporter_t *exp,
 				 flow_report_stream_t *stream,
 				 u32 thread_index, vlib_buffer_t *b0);
 
+/*
+ * Send the current buffer for the report on the calling thread if it
+ * holds records older than max_age seconds, and any completed buffers
+ * held back for batching.
+ */
+void vnet_ipfix_exp_flush (vlib_main_t *vm, ipfix_exporter_t *exp,
+			   flow_report_t *fr, f64 max_age);
+
+/* Slow path of vnet_ipfix_exp_record_reserve, do not call directly */
+int vnet_ipfix_exp_buffer_refill (vlib_main_t *vm, ipfix_exporter_t *exp,
+				  flow_report_t *fr, u16 len);
+
+/*
+ * Reserve len bytes for one data record in the report's buffer on the
+ * calling thread and return where to write it. A buffer that has no
+ * room left is sent first. Returns NULL, and counts the record as
+ * dropped, when no buffer is available or the exporter rate limit is
+ * reached.
+ */
+static_always_inline u8 *
+vnet_ipfix_exp_record_reserve (vlib_main_t *vm, ipfix_exporter_t *exp,
+			       flow_report_t *fr, u16 len)
+{
+  flow_report_per_thread_t *ptd =
+    vec_elt_at_index (fr->per_thread_data, vm->thread_index);
+  u8 *p;
+
+  if (PREDICT_FALSE (ptd->buffer == 0 ||
+		     ptd->next_data_offset + len > exp->path_mtu))
+    if (vnet_ipfix_exp_buffer_refill (vm, exp, fr, len))
+      return 0;
+
+  p = ptd->buffer->data + ptd->next_data_offset;
+  ptd->next_data_offset += len;
+  ptd->buffer->current_length = ptd->next_data_offset;
+  ptd->n_data_records++;
+  return p;
+}
+
+/*
+ * Append one data record that was built elsewhere
+ */
+static_always_inline int
+vnet_ipfix_exp_add_record (vlib_main_t *vm, ipfix_exporter_t *exp,
+			   flow_report_t *fr, const void *record, u16 len)
+{
+  u8 *p = vnet_ipfix_exp_record_reserve (vm, exp, fr, len);
+
+  if (PREDICT_FALSE (p == 0))
+    return -1;
+  clib_memcpy_fast (p, record, len);
+  return 0;
+}
+
 #endif /* __included_vnet_flow_report_h__ */
 
 /*
@@ -58,6 +58,20 @@ typedef struct _vnet_ip_table_function_list_elt
   clib_error_t *(*fp) (struct vnet_main_t * vnm, u32 table_id, u32 flags);
 } _vnet_ip_table_function_list_elt_t;
 
+/* Per thread interface capture state */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  /* pcap records captured by this thread, and how many */
+  u8 *pcap_data;
+  u32 n_packets;
+  /* packets dropped while the writer had not taken the last vector */
+  u32 n_dropped;
+  /* a filled pcap_data vector handed to the writer process, or 0 */
+  u8 *pcap_data_full;
+  u32 n_packets_full;
+} vnet_pcap_thread_t;
+
 typedef struct
 {
   /* Trace RX pkts */
@@ -72,6 +86,22 @@ typedef struct
   pcap_main_t pcap_main;
   u32 filter_classify_table_index;
   vlib_error_t pcap_error_index;
+
+  /*
+   * Each thread captures into its own vector, without a lock. Once
+   * flush_bytes are captured the vector is handed over to the writer
+   * process, which streams it to the file. pcap_main counts the packets
+   * captured, pcap_file is the writer's file; pcap_write() resets the
+   * count of the pcap_main_t it opens a file for.
+   */
+  vnet_pcap_thread_t *threads;
+  pcap_main_t pcap_file;
+  u32 n_packets_flushed;
+  u32 flush_bytes;
+  /* Start a new file once this many bytes are written, 0 for never */
+  u64 rotate_bytes;
+  u64 n_bytes_in_file;
+  u32 n_files_rotated;
 } vnet_pcap_t;
 
 typedef struct vnet_main_t
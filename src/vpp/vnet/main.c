@@ -113,6 +113,9 @@ main (int argc, char *argv[])
   unformat_input_t input, sub_input;
   u8 *s = 0, *v = 0;
   int main_core = ~0;
+  int main_heap_tags = 0;
+  uword large_alloc_threshold = 0, large_heap_size = (1ULL << 30);
+  clib_mem_page_sz_t large_heap_log2_page_sz = CLIB_MEM_PAGE_SZ_DEFAULT_HUGE;
   cpu_set_t cpuset;
   void *main_heap;
 
@@ -294,6 +297,18 @@ defaulted:
 				 unformat_log2_page_size,
 				 &default_log2_hugepage_sz))
 		;
+	      else if (unformat (&sub_input, "tags"))
+		main_heap_tags = 1;
+	      else if (unformat (&sub_input, "large-alloc-threshold %U",
+				 unformat_memory_size, &large_alloc_threshold))
+		;
+	      else if (unformat (&sub_input, "large-heap-size %U",
+				 unformat_memory_size, &large_heap_size))
+		;
+	      else if (unformat (&sub_input, "large-heap-page-size %U",
+				 unformat_log2_page_size,
+				 &large_heap_log2_page_sz))
+		;
 	      else
 		{
 		  fformat (stderr, "unknown 'memory' config input '%U'\n",
@@ -338,6 +353,16 @@ defaulted:
       if (default_log2_hugepage_sz != CLIB_MEM_PAGE_SZ_UNKNOWN)
 	clib_mem_set_log2_default_hugepage_size (default_log2_hugepage_sz);
 
+      /* charge main heap allocations to the current allocation tag */
+      if (main_heap_tags)
+	clib_mem_heap_enable_tags (main_heap);
+
+      /* serve large main heap allocations from NUMA local large pages */
+      if (large_alloc_threshold)
+	clib_mem_heap_enable_large_alloc (main_heap, large_alloc_threshold,
+					  large_heap_size,
+					  large_heap_log2_page_sz);
+
       /* and use the main heap as that numa's numa heap */
       clib_mem_set_per_numa_heap (main_heap);
       vlib_main_init ();
@@ -27,7 +27,12 @@
 #define BIHASH_USE_HEAP 1
 #endif
 
-static inline void *BV (alloc_aligned) (BVT (clib_bihash) * h, uword nbytes)
+/*
+ * With oom_is_fatal == 0 a heap backed table returns 0 when its heap is
+ * full, so the caller can pick another heap before the table is in use
+ */
+static inline void *BV (alloc_aligned_inline) (BVT (clib_bihash) * h,
+					       uword nbytes, int oom_is_fatal)
 {
   uword rv;
 
@@ -36,7 +41,7 @@ static inline void *BV (alloc_aligned) (BVT (clib_bihash) * h, uword nbytes)
 
   if (BIHASH_USE_HEAP)
     {
-      void *rv, *oldheap;
+      void *rv;
       uword page_sz = sizeof (BVT (clib_bihash_value));
       uword chunk_sz = round_pow2 (page_sz << BIIHASH_MIN_ALLOC_LOG2_PAGES,
 				   CLIB_CACHE_LINE_BYTES);
@@ -55,10 +60,14 @@ static inline void *BV (alloc_aligned) (BVT (clib_bihash) * h, uword nbytes)
       /* requested allocation is bigger than chunk size */
       if (nbytes >= chunk_sz)
 	{
-	  oldheap = clib_mem_set_heap (h->heap);
-	  chunk = clib_mem_alloc_aligned (nbytes + sizeof (*chunk),
-					  CLIB_CACHE_LINE_BYTES);
-	  clib_mem_set_heap (oldheap);
+	  if (oom_is_fatal)
+	    chunk = clib_mem_heap_alloc_aligned (
+	      h->heap, nbytes + sizeof (*chunk), CLIB_CACHE_LINE_BYTES);
+	  else
+	    chunk = clib_mem_heap_alloc_aligned_or_null (
+	      h->heap, nbytes + sizeof (*chunk), CLIB_CACHE_LINE_BYTES);
+	  if (chunk == 0)
+	    return 0;
 	  clib_memset_u8 (chunk, 0, sizeof (*chunk));
 	  chunk->size = nbytes;
 	  rv = (u8 *) (chunk + 1);
@@ -77,10 +86,14 @@ static inline void *BV (alloc_aligned) (BVT (clib_bihash) * h, uword nbytes)
 	  return rv;
 	}
 
-      oldheap = clib_mem_set_heap (h->heap);
-      chunk = clib_mem_alloc_aligned (chunk_sz + sizeof (*chunk),
-				      CLIB_CACHE_LINE_BYTES);
-      clib_mem_set_heap (oldheap);
+      if (oom_is_fatal)
+	chunk = clib_mem_heap_alloc_aligned (h->heap, chunk_sz + sizeof (*chunk),
+					     CLIB_CACHE_LINE_BYTES);
+      else
+	chunk = clib_mem_heap_alloc_aligned_or_null (
+	  h->heap, chunk_sz + sizeof (*chunk), CLIB_CACHE_LINE_BYTES);
+      if (chunk == 0)
+	return 0;
       chunk->size = chunk_sz;
       chunk->bytes_left = chunk_sz;
       chunk->next_alloc = (u8 *) (chunk + 1);
@@ -133,15 +146,50 @@ static inline void *BV (alloc_aligned) (BVT (clib_bihash) * h, uword nbytes)
   return (void *) (uword) (rv + alloc_arena (h));
 }
 
+static inline void *BV (alloc_aligned) (BVT (clib_bihash) * h, uword nbytes)
+{
+  return BV (alloc_aligned_inline) (h, nbytes, /* oom_is_fatal */ 1);
+}
+
 static void BV (clib_bihash_instantiate) (BVT (clib_bihash) * h)
 {
   uword bucket_size;
 
+  bucket_size = h->nbuckets * sizeof (h->buckets[0]);
+
+  if (BIHASH_KVP_AT_BUCKET_LEVEL)
+    bucket_size +=
+      h->nbuckets * BIHASH_KVP_PER_PAGE * sizeof (BVT (clib_bihash_kv));
+
+  h->buckets = 0;
+
   if (BIHASH_USE_HEAP)
     {
-      h->heap = clib_mem_get_heap ();
-      h->chunks = 0;
-      alloc_arena (h) = (uword) clib_mem_get_heap_base (h->heap);
+      clib_mem_heap_t *heap = clib_mem_get_heap ();
+
+      /* big tables live in the local large page heap, if there is one and
+	 it can take the bucket array. All pages must come from one heap,
+	 offsets are relative to it */
+      if ((heap->flags & CLIB_MEM_HEAP_F_LARGE_ALLOC) &&
+	  bucket_size >= clib_mem_main.large_alloc_threshold)
+	{
+	  clib_mem_heap_t *lh = clib_mem_get_large_heap (os_get_numa_index ());
+	  if (lh)
+	    {
+	      h->heap = lh;
+	      h->chunks = 0;
+	      alloc_arena (h) = (uword) clib_mem_get_heap_base (h->heap);
+	      h->buckets = BV (alloc_aligned_inline) (h, bucket_size,
+						      /* oom_is_fatal */ 0);
+	    }
+	}
+
+      if (h->buckets == 0)
+	{
+	  h->heap = heap;
+	  h->chunks = 0;
+	  alloc_arena (h) = (uword) clib_mem_get_heap_base (h->heap);
+	}
     }
   else
     {
@@ -154,13 +202,8 @@ static void BV (clib_bihash_instantiate) (BVT (clib_bihash) * h)
       alloc_arena_mapped (h) = 0;
     }
 
-  bucket_size = h->nbuckets * sizeof (h->buckets[0]);
-
-  if (BIHASH_KVP_AT_BUCKET_LEVEL)
-    bucket_size +=
-      h->nbuckets * BIHASH_KVP_PER_PAGE * sizeof (BVT (clib_bihash_kv));
-
-  h->buckets = BV (alloc_aligned) (h, bucket_size);
+  if (h->buckets == 0)
+    h->buckets = BV (alloc_aligned) (h, bucket_size);
   clib_memset_u8 (h->buckets, 0, bucket_size);
 
   if (BIHASH_KVP_AT_BUCKET_LEVEL)
@@ -315,7 +358,8 @@ void BV (clib_bihash_initiator_init_svm)
   alloc_arena_size (h) = memory_size;
 
   bucket_size = nbuckets * sizeof (h->buckets[0]);
-  h->buckets = BV (alloc_aligned) (h, bucket_size);
+  if (h->buckets == 0)
+    h->buckets = BV (alloc_aligned) (h, bucket_size);
   clib_memset_u8 (h->buckets, 0, bucket_size);
   h->sh->buckets_as_u64 = (u64) BV (clib_bihash_get_offset) (h, h->buckets);
 
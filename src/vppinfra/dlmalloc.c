@@ -4809,12 +4809,46 @@ __clib_nosanitize_addr
 size_t mspace_usable_size(const void* mem) {
   if (mem != 0) {
     mchunkptr p = mem2chunk(mem);
-    if (is_inuse(p))
-      return chunksize(p) - overhead_for(p);
+    if (is_inuse(p)) {
+      size_t sz = chunksize(p) - overhead_for(p);
+      /* vpp: tagged chunks keep the tag in their last bytes */
+      return flag4inuse(p) ? sz - MSPACE_TAG_BYTES : sz;
+    }
   }
   return 0;
 }
 
+/*
+ * vpp: allocation tags. A non-zero tag is stored in the last
+ * MSPACE_TAG_BYTES of the chunk payload and FLAG4_BIT marks the chunk
+ * as tagged, so mspace_usable_size() no longer reports those bytes.
+ * Every path which (re)writes the head of an in-use chunk clears the
+ * flag, so callers must re-tag after mspace_realloc_in_place().
+ */
+__clib_nosanitize_addr
+void mspace_set_tag (void *mem, unsigned tag) {
+  mchunkptr p = mem2chunk(mem);
+  size_t sz = chunksize(p) - overhead_for(p);
+
+  if (tag == 0) {
+    clear_flag4(p);
+    return;
+  }
+  set_flag4(p);
+  *(unsigned *)((char *)mem + sz - MSPACE_TAG_BYTES) = tag;
+}
+
+__clib_nosanitize_addr
+unsigned mspace_get_tag (const void *mem) {
+  mchunkptr p = mem2chunk(mem);
+  size_t sz;
+
+  if (!flag4inuse(p))
+    return 0;
+  sz = chunksize(p) - overhead_for(p);
+  return *(unsigned *)((char *)mem + sz - MSPACE_TAG_BYTES);
+}
+
 int mspace_mallopt(int param_number, int value) {
   return change_mparam(param_number, value);
 }
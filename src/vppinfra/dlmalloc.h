@@ -1467,6 +1467,11 @@ DLMALLOC_EXPORT void mheap_put_trace (uword offset, uword size);
 DLMALLOC_EXPORT int mspace_enable_disable_trace (mspace msp, int enable);
 DLMALLOC_EXPORT int mspace_is_traced (mspace msp);
 
+/* vpp: allocation tags, see mspace_set_tag () */
+#define MSPACE_TAG_BYTES sizeof (unsigned)
+DLMALLOC_EXPORT void mspace_set_tag (void *mem, unsigned tag);
+DLMALLOC_EXPORT unsigned mspace_get_tag (const void *mem);
+
 #endif /* MSPACES */
 
 #ifdef __cplusplus
@@ -100,7 +100,9 @@ typedef struct _clib_mem_vm_map_hdr
 #define foreach_clib_mem_heap_flag                                            \
   _ (0, LOCKED, "locked")                                                     \
   _ (1, UNMAP_ON_DESTROY, "unmap-on-destroy")                                 \
-  _ (2, TRACED, "traced")
+  _ (2, TRACED, "traced")                                                     \
+  _ (3, TAGGED, "tagged")                                                     \
+  _ (4, LARGE_ALLOC, "large-alloc")
 
 typedef enum
 {
@@ -130,6 +132,38 @@ typedef struct
   char name[0];
 } clib_mem_heap_t;
 
+/* Allocation tags, see clib_mem_set_tag (). Tag 0 means untagged. */
+#define CLIB_MEM_MAX_TAGS 512
+#define CLIB_MEM_TAG_NONE 0
+
+typedef struct
+{
+  /* live objects and their bytes, as reported by clib_mem_size () */
+  uword n_objects;
+  uword n_bytes;
+
+  /* allocations since the tag was created */
+  uword n_allocs;
+} clib_mem_tag_counters_t;
+
+/*
+ * Tag counters of one thread, indexed by tag. Each thread only updates
+ * its own, so objects freed by another thread than the one which
+ * allocated them leave negative counts behind which cancel out in the
+ * sum over all threads.
+ */
+typedef struct clib_mem_tag_thread_counters_
+{
+  struct clib_mem_tag_thread_counters_ *next;
+  clib_mem_tag_counters_t counters[CLIB_MEM_MAX_TAGS];
+} clib_mem_tag_thread_counters_t;
+
+typedef struct
+{
+  /* tag name, nul terminated */
+  char *name;
+} clib_mem_tag_t;
+
 typedef struct
 {
   /* log2 system page size */
@@ -158,6 +192,26 @@ typedef struct
 
   /* last error */
   clib_error_t *error;
+
+  /* allocation tags */
+  u8 tag_lock;
+  u32 n_tags;
+  clib_mem_tag_t tags[CLIB_MEM_MAX_TAGS];
+  clib_mem_tag_thread_counters_t *tag_thread_counters;
+
+  /* large allocation policy, see clib_mem_heap_enable_large_alloc () */
+  uword large_alloc_threshold;
+  uword large_heap_size;
+  clib_mem_page_sz_t log2_large_page_sz;
+  clib_mem_heap_flag_t large_heap_flags;
+  u8 large_heap_lock;
+  u32 large_heap_failed_bitmap;
+
+  /* address range covering all large heaps, for fast owner lookup */
+  uword large_heaps_start, large_heaps_end;
+
+  /* per NUMA large allocation heaps, created on first use */
+  clib_mem_heap_t *large_heaps[CLIB_MAX_NUMAS];
 } clib_mem_main_t;
 
 extern clib_mem_main_t clib_mem_main;
@@ -337,6 +391,7 @@ uword clib_mem_get_heap_free_space (clib_mem_heap_t * heap);
 
 u8 *format_clib_mem_usage (u8 * s, va_list * args);
 u8 *format_clib_mem_heap (u8 * s, va_list * va);
+u8 *format_clib_mem_tags (u8 *s, va_list *va);
 u8 *format_clib_mem_page_stats (u8 * s, va_list * va);
 
 /* Allocate virtual address space. */
@@ -424,6 +479,44 @@ void mheap_trace (clib_mem_heap_t * v, int enable);
 uword clib_mem_trace_enable_disable (uword enable);
 void clib_mem_trace (int enable);
 
+/*
+ * Allocation tags. Once tags are enabled on a heap, objects allocated
+ * there while the calling thread has a tag set are charged to that tag
+ * until they are freed. Tagged objects keep their tag across realloc.
+ */
+extern __thread u32 __clib_mem_tag;
+
+u32 clib_mem_tag_get_or_create (char *fmt, ...);
+void clib_mem_heap_enable_tags (clib_mem_heap_t *h);
+void clib_mem_tag_get_counters (u32 tag, clib_mem_tag_counters_t *c);
+
+always_inline u32
+clib_mem_get_tag (void)
+{
+  return __clib_mem_tag;
+}
+
+/* Set the calling thread's tag, returns the previous one */
+always_inline u32
+clib_mem_set_tag (u32 tag)
+{
+  u32 old = __clib_mem_tag;
+  __clib_mem_tag = tag;
+  return old;
+}
+
+/*
+ * Large allocations. Once enabled on a heap, implicit allocations
+ * (no explicit heap given) of at least the threshold size made while
+ * that heap is current are served from a heap backed by large pages
+ * and bound to the NUMA node of the allocating thread. Frees and
+ * reallocs find the owning heap from the object address.
+ */
+void clib_mem_heap_enable_large_alloc (clib_mem_heap_t *h, uword threshold,
+				       uword heap_size,
+				       clib_mem_page_sz_t log2_page_sz);
+clib_mem_heap_t *clib_mem_get_large_heap (u32 numa);
+
 always_inline uword
 clib_mem_round_to_page_size (uword size, clib_mem_page_sz_t log2_page_size)
 {
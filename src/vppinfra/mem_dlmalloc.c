@@ -195,6 +195,128 @@ mheap_trace_main_free (mheap_trace_main_t * tm)
   hash_free (tm->trace_index_by_offset);
 }
 
+__clib_export __thread u32 __clib_mem_tag = 0;
+static __thread clib_mem_tag_thread_counters_t *mheap_tag_counters;
+
+/* mapped outside of any heap, allocating them must not recurse into the
+   tag accounting */
+static never_inline void
+mheap_tag_counters_alloc (void)
+{
+  clib_mem_main_t *mm = &clib_mem_main;
+  clib_mem_tag_thread_counters_t *tc;
+
+  tc = clib_mem_vm_map_internal (0, CLIB_MEM_PAGE_SZ_DEFAULT, sizeof (*tc),
+				 -1, 0, "mem tag counters");
+  if (tc == CLIB_MEM_VM_MAP_FAILED)
+    os_out_of_memory ();
+
+  do
+    tc->next = clib_atomic_load_acq_n (&mm->tag_thread_counters);
+  while (!clib_atomic_bool_cmp_and_swap (&mm->tag_thread_counters, tc->next,
+					 tc));
+
+  mheap_tag_counters = tc;
+}
+
+static_always_inline clib_mem_tag_counters_t *
+mheap_tag_counters_get (u32 tag)
+{
+  if (PREDICT_FALSE (mheap_tag_counters == 0))
+    mheap_tag_counters_alloc ();
+  return mheap_tag_counters->counters + tag;
+}
+
+static_always_inline void
+mheap_tag_get (void *p, u32 tag)
+{
+  clib_mem_tag_counters_t *c = mheap_tag_counters_get (tag);
+
+  mspace_set_tag (p, tag);
+  c->n_objects++;
+  c->n_bytes += clib_mem_size (p);
+  c->n_allocs++;
+}
+
+static_always_inline void
+mheap_tag_put (u32 tag, uword size)
+{
+  clib_mem_tag_counters_t *c = mheap_tag_counters_get (tag);
+
+  c->n_objects--;
+  c->n_bytes -= size;
+}
+
+/* sum of the counters of a tag over all threads */
+__clib_export void
+clib_mem_tag_get_counters (u32 tag, clib_mem_tag_counters_t *c)
+{
+  clib_mem_main_t *mm = &clib_mem_main;
+  clib_mem_tag_thread_counters_t *tc;
+
+  clib_memset (c, 0, sizeof (*c));
+  for (tc = clib_atomic_load_acq_n (&mm->tag_thread_counters); tc;
+       tc = tc->next)
+    {
+      c->n_objects += tc->counters[tag].n_objects;
+      c->n_bytes += tc->counters[tag].n_bytes;
+      c->n_allocs += tc->counters[tag].n_allocs;
+    }
+}
+
+__clib_export u32
+clib_mem_tag_get_or_create (char *fmt, ...)
+{
+  clib_mem_main_t *mm = &clib_mem_main;
+  clib_mem_tag_t *t;
+  va_list va;
+  u32 i, rv = CLIB_MEM_TAG_NONE;
+  u8 *s;
+
+  va_start (va, fmt);
+  s = va_format (0, fmt, &va);
+  va_end (va);
+  vec_add1 (s, 0);
+
+  while (clib_atomic_test_and_set (&mm->tag_lock))
+    CLIB_PAUSE ();
+
+  /* tag 0 is reserved for untagged objects */
+  if (mm->n_tags == 0)
+    {
+      mm->tags[CLIB_MEM_TAG_NONE].name = "untagged";
+      mm->n_tags = 1;
+    }
+
+  for (i = 1; i < mm->n_tags; i++)
+    if (strcmp ((char *) s, mm->tags[i].name) == 0)
+      {
+	rv = i;
+	goto done;
+      }
+
+  if (mm->n_tags == CLIB_MEM_MAX_TAGS)
+    goto done;
+
+  /* the name is allocated on whatever heap and tag are current */
+  t = mm->tags + mm->n_tags;
+  t->name = (char *) s;
+  s = 0;
+  rv = mm->n_tags;
+  clib_atomic_store_rel_n (&mm->n_tags, mm->n_tags + 1);
+
+done:
+  clib_atomic_release (&mm->tag_lock);
+  vec_free (s);
+  return rv;
+}
+
+__clib_export void
+clib_mem_heap_enable_tags (clib_mem_heap_t *h)
+{
+  h->flags |= CLIB_MEM_HEAP_F_TAGGED;
+}
+
 static clib_mem_heap_t *
 clib_mem_create_heap_internal (void *base, uword size,
 			       clib_mem_page_sz_t log2_page_sz, int is_locked,
@@ -295,6 +417,128 @@ clib_mem_destroy (void)
   clib_mem_vm_unmap (heap);
 }
 
+__clib_export void
+clib_mem_heap_enable_large_alloc (clib_mem_heap_t *h, uword threshold,
+				  uword heap_size,
+				  clib_mem_page_sz_t log2_page_sz)
+{
+  clib_mem_main_t *mm = &clib_mem_main;
+
+  mm->large_alloc_threshold = clib_max (threshold, 1);
+  mm->large_heap_size = heap_size;
+  mm->log2_large_page_sz = log2_page_sz;
+
+  /* large heaps account tags the same way their parent heap does */
+  mm->large_heap_flags = h->flags & CLIB_MEM_HEAP_F_TAGGED;
+  h->flags |= CLIB_MEM_HEAP_F_LARGE_ALLOC;
+}
+
+static clib_mem_heap_t *
+clib_mem_create_large_heap (u32 numa)
+{
+  clib_mem_main_t *mm = &clib_mem_main;
+  clib_mem_heap_t *h;
+  char name[32];
+
+  snprintf (name, sizeof (name), "large heap numa %u", numa);
+
+  /* large pages are locked, so they are faulted in on the right node here */
+  clib_mem_set_numa_affinity (numa, 1 /* force */);
+  h = clib_mem_create_heap_internal (0, mm->large_heap_size,
+				     mm->log2_large_page_sz, 1 /* locked */,
+				     name);
+
+  /* out of large pages, keep the NUMA placement with default pages */
+  if (h == 0 && mm->log2_large_page_sz != CLIB_MEM_PAGE_SZ_DEFAULT)
+    h = clib_mem_create_heap_internal (0, mm->large_heap_size,
+				       CLIB_MEM_PAGE_SZ_DEFAULT,
+				       1 /* locked */, name);
+  clib_mem_set_default_numa_affinity ();
+
+  if (h)
+    h->flags |= mm->large_heap_flags;
+  return h;
+}
+
+__clib_export clib_mem_heap_t *
+clib_mem_get_large_heap (u32 numa)
+{
+  clib_mem_main_t *mm = &clib_mem_main;
+  clib_mem_heap_t *h;
+  uword start, end;
+
+  ASSERT (numa < ARRAY_LEN (mm->large_heaps));
+
+  h = clib_atomic_load_acq_n (&mm->large_heaps[numa]);
+  if (PREDICT_TRUE (h != 0))
+    return h;
+
+  if (mm->large_alloc_threshold == 0 ||
+      (mm->large_heap_failed_bitmap & (1 << numa)))
+    return 0;
+
+  while (clib_atomic_test_and_set (&mm->large_heap_lock))
+    CLIB_PAUSE ();
+
+  if ((h = mm->large_heaps[numa]) != 0 ||
+      (mm->large_heap_failed_bitmap & (1 << numa)))
+    goto done;
+
+  if ((h = clib_mem_create_large_heap (numa)) == 0)
+    {
+      mm->large_heap_failed_bitmap |= 1 << numa;
+      goto done;
+    }
+
+  start = pointer_to_uword (h->base);
+  end = start + h->size;
+  if (mm->large_heaps_end == 0)
+    mm->large_heaps_start = start;
+
+  mm->large_heaps_start = clib_min (mm->large_heaps_start, start);
+  mm->large_heaps_end = clib_max (mm->large_heaps_end, end);
+  clib_atomic_store_rel_n (&mm->large_heaps[numa], h);
+
+done:
+  clib_atomic_release (&mm->large_heap_lock);
+  return h;
+}
+
+/* heap owning an object, objects in large heaps are found by address */
+static_always_inline clib_mem_heap_t *
+clib_mem_heap_of_object (clib_mem_heap_t *h, void *p)
+{
+  clib_mem_main_t *mm = &clib_mem_main;
+  uword addr = pointer_to_uword (p);
+  clib_mem_heap_t *lh;
+  int i;
+
+  if (PREDICT_TRUE (addr < mm->large_heaps_start ||
+		    addr >= mm->large_heaps_end))
+    return h;
+
+  for (i = 0; i < ARRAY_LEN (mm->large_heaps); i++)
+    if ((lh = mm->large_heaps[i]) && addr >= pointer_to_uword (lh->base) &&
+	addr < pointer_to_uword (lh->base) + lh->size)
+      return lh;
+
+  return h;
+}
+
+/* implicit allocations of large objects go to the local large heap */
+static_always_inline clib_mem_heap_t *
+clib_mem_heap_for_alloc (void *heap, clib_mem_heap_t *h, uword size)
+{
+  clib_mem_heap_t *lh;
+
+  if (PREDICT_TRUE (heap || !(h->flags & CLIB_MEM_HEAP_F_LARGE_ALLOC) ||
+		    size < clib_mem_main.large_alloc_threshold))
+    return h;
+
+  lh = clib_mem_get_large_heap (os_get_numa_index ());
+  return lh ? lh : h;
+}
+
 __clib_export u8 *
 format_clib_mem_usage (u8 *s, va_list *va)
 {
@@ -416,6 +660,61 @@ format_mheap_trace (u8 * s, va_list * va)
   return s;
 }
 
+typedef struct
+{
+  char *name;
+  clib_mem_tag_counters_t c;
+} clib_mem_tag_usage_t;
+
+static int
+clib_mem_tag_sort (const void *_t1, const void *_t2)
+{
+  const clib_mem_tag_usage_t *t1 = _t1;
+  const clib_mem_tag_usage_t *t2 = _t2;
+
+  if (t1->c.n_bytes != t2->c.n_bytes)
+    return t1->c.n_bytes < t2->c.n_bytes ? 1 : -1;
+  return strcmp (t1->name, t2->name);
+}
+
+__clib_export u8 *
+format_clib_mem_tags (u8 *s, va_list *va)
+{
+  int verbose = va_arg (*va, int);
+  clib_mem_main_t *mm = &clib_mem_main;
+  clib_mem_tag_usage_t *t, *sorted = 0;
+  clib_mem_tag_counters_t c;
+  u32 indent = format_get_indent (s);
+  uword n_bytes = 0, n_objects = 0;
+  u32 i, n_tags = clib_atomic_load_acq_n (&mm->n_tags);
+
+  for (i = 1; i < n_tags; i++)
+    {
+      clib_mem_tag_get_counters (i, &c);
+      if (c.n_allocs || verbose)
+	{
+	  vec_add2 (sorted, t, 1);
+	  t->name = mm->tags[i].name;
+	  t->c = c;
+	}
+      n_bytes += c.n_bytes;
+      n_objects += c.n_objects;
+    }
+
+  vec_sort_with_function (sorted, clib_mem_tag_sort);
+
+  s = format (s, "%-32s%12s%12s%14s", "Tag", "Bytes", "Objects", "Allocations");
+  vec_foreach (t, sorted)
+    s = format (s, "\n%U%-32s%12U%12lu%14lu", format_white_space, indent,
+		t->name, format_msize, t->c.n_bytes, t->c.n_objects,
+		t->c.n_allocs);
+  s = format (s, "\n%U%-32s%12U%12lu", format_white_space, indent, "total",
+	      format_msize, n_bytes, n_objects);
+
+  vec_free (sorted);
+  return s;
+}
+
 __clib_export u8 *
 format_clib_mem_heap (u8 * s, va_list * va)
 {
@@ -600,20 +899,36 @@ static inline void *
 clib_mem_heap_alloc_inline (void *heap, uword size, uword align,
 			    int os_out_of_memory_on_failure)
 {
-  clib_mem_heap_t *h = heap ? heap : clib_mem_get_per_cpu_heap ();
+  clib_mem_heap_t *local = heap ? heap : clib_mem_get_per_cpu_heap ();
+  clib_mem_heap_t *h = clib_mem_heap_for_alloc (heap, local, size);
+  u32 tag = CLIB_MEM_TAG_NONE;
   void *p;
 
   align = clib_max (CLIB_MEM_MIN_ALIGN, align);
 
-  p = mspace_memalign (h->mspace, align, size);
+again:
+  if (PREDICT_FALSE (h->flags & CLIB_MEM_HEAP_F_TAGGED))
+    tag = clib_mem_get_tag ();
+
+  p = mspace_memalign (h->mspace, align, tag ? size + MSPACE_TAG_BYTES : size);
 
   if (PREDICT_FALSE (0 == p))
     {
+      /* a full large heap is not fatal, fall back to the local heap */
+      if (h != local)
+	{
+	  h = local;
+	  tag = CLIB_MEM_TAG_NONE;
+	  goto again;
+	}
       if (os_out_of_memory_on_failure)
 	os_out_of_memory ();
       return 0;
     }
 
+  if (PREDICT_FALSE (tag))
+    mheap_tag_get (p, tag);
+
   if (PREDICT_FALSE (h->flags & CLIB_MEM_HEAP_F_TRACED))
     mheap_get_trace (pointer_to_uword (p), clib_mem_size (p));
 
@@ -685,6 +1000,8 @@ clib_mem_heap_realloc_aligned (void *heap, void *p, uword new_size,
 {
   uword old_alloc_size;
   clib_mem_heap_t *h = heap ? heap : clib_mem_get_per_cpu_heap ();
+  clib_mem_heap_t *new_h;
+  u32 tag = CLIB_MEM_TAG_NONE, old_tag;
   void *new;
 
   ASSERT (count_set_bits (align) == 1);
@@ -694,9 +1011,25 @@ clib_mem_heap_realloc_aligned (void *heap, void *p, uword new_size,
   if (new_size == old_alloc_size)
     return p;
 
-  if (p && pointer_is_aligned (p, align) &&
-      mspace_realloc_in_place (h->mspace, p, new_size))
+  if (p)
+    h = clib_mem_heap_of_object (h, p);
+
+  /* objects growing past the large allocation threshold move */
+  new_h = clib_mem_heap_for_alloc (heap, h, new_size);
+
+  /* tagged objects keep their tag when they grow or shrink */
+  if (p && PREDICT_FALSE (h->flags & CLIB_MEM_HEAP_F_TAGGED))
+    tag = mspace_get_tag (p);
+
+  if (p && new_h == h && pointer_is_aligned (p, align) &&
+      mspace_realloc_in_place (h->mspace, p,
+			       tag ? new_size + MSPACE_TAG_BYTES : new_size))
     {
+      if (PREDICT_FALSE (tag))
+	{
+	  mheap_tag_put (tag, old_alloc_size);
+	  mheap_tag_get (p, tag);
+	}
       clib_mem_unpoison (p, new_size);
       if (PREDICT_FALSE (h->flags & CLIB_MEM_HEAP_F_TRACED))
 	{
@@ -706,7 +1039,11 @@ clib_mem_heap_realloc_aligned (void *heap, void *p, uword new_size,
     }
   else
     {
-      new = clib_mem_heap_alloc_inline (h, new_size, align, 1);
+      old_tag = tag ? clib_mem_set_tag (tag) : CLIB_MEM_TAG_NONE;
+      new = clib_mem_heap_alloc_inline (heap ? new_h : 0, new_size, align,
+					/* os_out_of_memory */ 1);
+      if (tag)
+	clib_mem_set_tag (old_tag);
 
       clib_mem_unpoison (new, new_size);
       if (old_alloc_size)
@@ -743,6 +1080,7 @@ __clib_export __clib_flatten uword
 clib_mem_heap_is_heap_object (void *heap, void *p)
 {
   clib_mem_heap_t *h = heap ? heap : clib_mem_get_per_cpu_heap ();
+  h = clib_mem_heap_of_object (h, p);
   return mspace_is_heap_object (h->mspace, p);
 }
 
@@ -758,9 +1096,18 @@ clib_mem_heap_free (void *heap, void *p)
   clib_mem_heap_t *h = heap ? heap : clib_mem_get_per_cpu_heap ();
   uword size = clib_mem_size (p);
 
+  h = clib_mem_heap_of_object (h, p);
+
   /* Make sure object is in the correct heap. */
   ASSERT (clib_mem_heap_is_heap_object (h, p));
 
+  if (PREDICT_FALSE (h->flags & CLIB_MEM_HEAP_F_TAGGED))
+    {
+      u32 tag = mspace_get_tag (p);
+      if (tag)
+	mheap_tag_put (tag, size);
+    }
+
   if (PREDICT_FALSE (h->flags & CLIB_MEM_HEAP_F_TRACED))
     mheap_put_trace (pointer_to_uword (p), size);
   clib_mem_poison (p, clib_mem_size (p));
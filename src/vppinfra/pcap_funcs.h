@@ -27,9 +27,9 @@ clib_error_t *pcap_read (pcap_main_t * pm);
 clib_error_t *pcap_close (pcap_main_t * pm);
 
 /**
- * @brief Add packet
+ * @brief Add a packet record to a vector of pcap data
  *
- * @param *pm - pcap_main_t
+ * @param **pcap_data - u8
  * @param time_now - f64
  * @param n_bytes_in_trace - u32
  * @param n_bytes_in_packet - u32
@@ -38,22 +38,41 @@ clib_error_t *pcap_close (pcap_main_t * pm);
  *
  */
 static inline void *
-pcap_add_packet (pcap_main_t * pm,
-		 f64 time_now, u32 n_bytes_in_trace, u32 n_bytes_in_packet)
+pcap_add_packet_to_vec (u8 **pcap_data, f64 time_now, u32 n_bytes_in_trace,
+			u32 n_bytes_in_packet)
 {
   pcap_packet_header_t *h;
   u8 *d;
 
-  vec_add2 (pm->pcap_data, d, sizeof (h[0]) + n_bytes_in_trace);
+  vec_add2 (*pcap_data, d, sizeof (h[0]) + n_bytes_in_trace);
   h = (void *) (d);
   h->time_in_sec = time_now;
   h->time_in_usec = 1e6 * (time_now - h->time_in_sec);
   h->n_packet_bytes_stored_in_file = n_bytes_in_trace;
   h->n_bytes_in_packet = n_bytes_in_packet;
-  pm->n_packets_captured++;
   return h->data;
 }
 
+/**
+ * @brief Add packet
+ *
+ * @param *pm - pcap_main_t
+ * @param time_now - f64
+ * @param n_bytes_in_trace - u32
+ * @param n_bytes_in_packet - u32
+ *
+ * @return Packet Data
+ *
+ */
+static inline void *
+pcap_add_packet (pcap_main_t * pm,
+		 f64 time_now, u32 n_bytes_in_trace, u32 n_bytes_in_packet)
+{
+  pm->n_packets_captured++;
+  return pcap_add_packet_to_vec (&pm->pcap_data, time_now, n_bytes_in_trace,
+				 n_bytes_in_packet);
+}
+
 #endif /* included_vppinfra_pcap_funcs_h */
 
 /*
@@ -626,7 +626,7 @@ unserialize_heap (serialize_main_t * m, va_list * va)
   }
 }
 
-void
+__clib_export void
 serialize_magic (serialize_main_t * m, void *magic, u32 magic_bytes)
 {
   void *p;
@@ -635,7 +635,7 @@ serialize_magic (serialize_main_t * m, void *magic, u32 magic_bytes)
   clib_memcpy_fast (p, magic, magic_bytes);
 }
 
-void
+__clib_export void
 unserialize_check_magic (serialize_main_t * m, void *magic, u32 magic_bytes)
 {
   u32 l;
@@ -1350,6 +1350,159 @@ test5_double (tw_timer_test_main_t * tm)
   return 0;
 }
 
+#define TEST_BULK_BATCH_SIZE 256
+
+static u32
+test_bulk_interval (tw_timer_test_main_t * tm)
+{
+  u32 interval;
+
+  do
+    {
+      interval = random_u64 (&tm->seed) & ((1 << 17) - 1);
+    }
+  while (interval == 0);
+
+  return interval;
+}
+
+static clib_error_t *
+test6_bulk (tw_timer_test_main_t * tm)
+{
+  u32 user_ids[TEST_BULK_BATCH_SIZE], handles[TEST_BULK_BATCH_SIZE];
+  u32 i, j, n, interval = 0, max_expiration_time = 0;
+  u32 *all_handles = 0;
+  tw_timer_test_elt_t *e;
+  f64 before, after, now;
+
+  clib_time_init (&tm->clib_time);
+
+  tw_timer_wheel_init_1t_3w_1024sl_ov (&tm->triple_ov_wheel,
+				       expired_timer_triple_ov_callback,
+				       1.0 /* timer interval */ , ~0);
+
+  run_triple_ov_wheel (&tm->triple_ov_wheel, 75700);
+
+  fformat (stdout, "test %d timers, batches of %d, 0x%llx seed\n",
+	   tm->ntimers, TEST_BULK_BATCH_SIZE, tm->seed);
+
+  pool_alloc (tm->test_elts, tm->ntimers);
+  vec_validate (all_handles, tm->ntimers - 1);
+
+  /* one at a time, for reference */
+  before = clib_time_now (&tm->clib_time);
+  for (i = 0; i < tm->ntimers; i++)
+    {
+      if (i % TEST_BULK_BATCH_SIZE == 0)
+	interval = test_bulk_interval (tm);
+      all_handles[i] = tw_timer_start_1t_3w_1024sl_ov
+	(&tm->triple_ov_wheel, i, 0 /* timer id */ , interval);
+    }
+  after = clib_time_now (&tm->clib_time);
+  fformat (stdout, "start: %.2f timers/second\n",
+	   tm->ntimers / (after - before));
+
+  before = clib_time_now (&tm->clib_time);
+  for (i = 0; i < tm->ntimers; i++)
+    tw_timer_stop_1t_3w_1024sl_ov (&tm->triple_ov_wheel, all_handles[i]);
+  after = clib_time_now (&tm->clib_time);
+  fformat (stdout, "stop: %.2f timers/second\n",
+	   tm->ntimers / (after - before));
+
+  /* the same in batches sharing an interval */
+  before = clib_time_now (&tm->clib_time);
+  for (i = 0; i < tm->ntimers; i += n)
+    {
+      n = clib_min (tm->ntimers - i, TEST_BULK_BATCH_SIZE);
+      interval = test_bulk_interval (tm);
+      max_expiration_time = clib_max (max_expiration_time, interval);
+
+      for (j = 0; j < n; j++)
+	{
+	  pool_get (tm->test_elts, e);
+	  e->expected_to_expire = interval +
+	    tm->triple_ov_wheel.current_tick;
+	  user_ids[j] = e - tm->test_elts;
+	}
+
+      tw_timer_start_bulk_1t_3w_1024sl_ov (&tm->triple_ov_wheel, user_ids,
+					   0 /* timer id */ , interval,
+					   handles, n);
+
+      for (j = 0; j < n; j++)
+	{
+	  e = pool_elt_at_index (tm->test_elts, user_ids[j]);
+	  e->stop_timer_handle = handles[j];
+	  all_handles[i + j] = handles[j];
+	}
+    }
+  after = clib_time_now (&tm->clib_time);
+  fformat (stdout, "bulk start: %.2f timers/second\n",
+	   tm->ntimers / (after - before));
+
+  /* rearm the first half, in batches sharing the new interval */
+  before = clib_time_now (&tm->clib_time);
+  for (i = 0; i < tm->ntimers / 2; i += n)
+    {
+      n = clib_min (tm->ntimers / 2 - i, TEST_BULK_BATCH_SIZE);
+      interval = test_bulk_interval (tm);
+      max_expiration_time = clib_max (max_expiration_time, interval);
+
+      tw_timer_update_bulk_1t_3w_1024sl_ov (&tm->triple_ov_wheel,
+					    all_handles + i, n, interval);
+
+      for (j = 0; j < n; j++)
+	{
+	  e = pool_elt_at_index (tm->test_elts, i + j);
+	  e->expected_to_expire = interval +
+	    tm->triple_ov_wheel.current_tick;
+	}
+    }
+  after = clib_time_now (&tm->clib_time);
+  fformat (stdout, "bulk update: %.2f timers/second\n",
+	   (tm->ntimers / 2) / (after - before));
+
+  /* stop the last quarter */
+  before = clib_time_now (&tm->clib_time);
+  n = tm->ntimers / 4;
+  tw_timer_stop_bulk_1t_3w_1024sl_ov (&tm->triple_ov_wheel,
+				      all_handles + tm->ntimers - n, n);
+  after = clib_time_now (&tm->clib_time);
+  fformat (stdout, "bulk stop: %.2f timers/second\n", n / (after - before));
+
+  for (i = tm->ntimers - n; i < tm->ntimers; i++)
+    pool_put_index (tm->test_elts, i);
+
+  /*
+   * Expire everything in a single call, so runs of empty slots are
+   * skipped rather than visited one tick at a time.
+   */
+  before = clib_time_now (&tm->clib_time);
+  now = tm->triple_ov_wheel.last_run_time + max_expiration_time + 1.5;
+  tw_timer_expire_timers_1t_3w_1024sl_ov (&tm->triple_ov_wheel, now);
+  after = clib_time_now (&tm->clib_time);
+  fformat (stdout, "expire: %d ticks in %.2f seconds\n",
+	   max_expiration_time + 1, after - before);
+
+  if (pool_elts (tm->test_elts))
+    fformat (stdout, "Note: %d elements remain in pool\n",
+	     pool_elts (tm->test_elts));
+
+  /* *INDENT-OFF* */
+  pool_foreach (e, tm->test_elts)
+   {
+    fformat (stdout, "[%d] expected to expire %d\n",
+             e - tm->test_elts,
+             e->expected_to_expire);
+  }
+  /* *INDENT-ON* */
+
+  vec_free (all_handles);
+  pool_free (tm->test_elts);
+  tw_timer_wheel_free_1t_3w_1024sl_ov (&tm->triple_ov_wheel);
+  return 0;
+}
+
 static clib_error_t *
 timer_test_command_fn (tw_timer_test_main_t * tm, unformat_input_t * input)
 {
@@ -1360,6 +1513,7 @@ timer_test_command_fn (tw_timer_test_main_t * tm, unformat_input_t * input)
   int is_test3 = 0;
   int is_test4 = 0;
   int is_test5 = 0;
+  int is_test6 = 0;
   int overflow = 0;
 
   clib_memset (tm, 0, sizeof (*tm));
@@ -1385,6 +1539,8 @@ timer_test_command_fn (tw_timer_test_main_t * tm, unformat_input_t * input)
 	is_test4 = 1;
       else if (unformat (input, "linear"))
 	is_test5 = 1;
+      else if (unformat (input, "bulk"))
+	is_test6 = 1;
       else if (unformat (input, "updates"))
 	is_updates = 1;
       else if (unformat (input, "wheels %d", &num_wheels))
@@ -1399,7 +1555,7 @@ timer_test_command_fn (tw_timer_test_main_t * tm, unformat_input_t * input)
 	break;
     }
 
-  if (is_test1 + is_test2 + is_test3 + is_test4 + is_test5 == 0)
+  if (is_test1 + is_test2 + is_test3 + is_test4 + is_test5 + is_test6 == 0)
     return clib_error_return (0, "No test specified [test1..n]");
 
   if (num_wheels < 1 || num_wheels > 3)
@@ -1441,6 +1597,9 @@ timer_test_command_fn (tw_timer_test_main_t * tm, unformat_input_t * input)
   if (is_test5)
     return test5_double (tm);
 
+  if (is_test6)
+    return test6_bulk (tm);
+
   /* NOTREACHED */
   return 0;
 }
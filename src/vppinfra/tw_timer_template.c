@@ -141,6 +141,19 @@ timer_addhead (TWT (tw_timer) * pool, u32 head_index, u32 new_index)
   head->next = new_index;
 }
 
+static inline void
+timer_insert_after (TWT (tw_timer) * pool, u32 prev_index, u32 new_index)
+{
+  TWT (tw_timer) * prev = pool_elt_at_index (pool, prev_index);
+  TWT (tw_timer) * next = pool_elt_at_index (pool, prev->next);
+  TWT (tw_timer) * new = pool_elt_at_index (pool, new_index);
+
+  new->prev = prev_index;
+  new->next = prev->next;
+  next->prev = new_index;
+  prev->next = new_index;
+}
+
 static inline void
 timer_remove (TWT (tw_timer) * pool, TWT (tw_timer) * elt)
 {
@@ -309,6 +322,68 @@ TW (tw_timer_start) (TWT (tw_timer_wheel) * tw, u32 user_id, u32 timer_id,
   return t - tw->timers;
 }
 
+/*
+ * Timers with the same interval all go to the same slot, so the slot is
+ * computed once, for the first timer, and the others are chained after
+ * it. The neighbours touched by each insert are the ones just written.
+ */
+static inline void
+timer_add_bulk (TWT (tw_timer_wheel) * tw, u32 * indices, u32 n_timers,
+		u64 interval)
+{
+  TWT (tw_timer) * first, *t;
+  u32 i, user_handle;
+
+  first = pool_elt_at_index (tw->timers, indices[0]);
+  timer_add (tw, first, interval);
+
+  for (i = 1; i < n_timers; i++)
+    {
+      t = pool_elt_at_index (tw->timers, indices[i]);
+      /* ring offsets, or expiration time on the overflow vector */
+      user_handle = t->user_handle;
+      *t = *first;
+      t->user_handle = user_handle;
+      timer_insert_after (tw->timers, indices[i - 1], indices[i]);
+    }
+}
+
+/**
+ * @brief Start a batch of tw timers with the same interval
+ * @param tw_timer_wheel_t * tw timer wheel object pointer
+ * @param u32 * user_ids user defined timer ids, one per timer
+ * @param u32 timer_id app-specific timer ID, the same for all timers
+ * @param u64 interval timer interval in ticks
+ * @param u32 * handles returns the handles needed to cancel the timers
+ * @param u32 n_timers number of timers to start
+ */
+__clib_export void
+TW (tw_timer_start_bulk) (TWT (tw_timer_wheel) * tw, u32 * user_ids,
+			  u32 timer_id, u64 interval, u32 * handles,
+			  u32 n_timers)
+{
+  TWT (tw_timer) * t;
+  u32 i;
+
+  ASSERT (interval);
+
+  if (n_timers == 0)
+    return;
+
+  pool_alloc (tw->timers, n_timers);
+
+  for (i = 0; i < n_timers; i++)
+    {
+      pool_get (tw->timers, t);
+      clib_memset (t, 0xff, sizeof (*t));
+      t->user_handle = TW (make_internal_timer_handle) (user_ids[i],
+							 timer_id);
+      handles[i] = t - tw->timers;
+    }
+
+  timer_add_bulk (tw, handles, n_timers, interval);
+}
+
 #if TW_TIMER_SCAN_FOR_HANDLE > 0
 int TW (scan_for_handle) (TWT (tw_timer_wheel) * tw, u32 handle)
 {
@@ -376,6 +451,49 @@ __clib_export void TW (tw_timer_stop) (TWT (tw_timer_wheel) * tw, u32 handle)
   pool_put_index (tw->timers, handle);
 }
 
+/*
+ * Unlinking a timer touches the timer and both of its neighbours, which
+ * after some churn are anywhere in the pool. Prefetch the timers two
+ * rounds ahead and their neighbours one round ahead.
+ */
+static inline void
+TW (timer_prefetch_bulk) (TWT (tw_timer_wheel) * tw, u32 * handles,
+			  u32 i, u32 n_handles)
+{
+  TWT (tw_timer) * t;
+
+  if (i + 8 < n_handles)
+    CLIB_PREFETCH (tw->timers + handles[i + 8], sizeof (*t), STORE);
+  if (i + 4 < n_handles)
+    {
+      t = tw->timers + handles[i + 4];
+      CLIB_PREFETCH (tw->timers + t->next, sizeof (*t), STORE);
+      CLIB_PREFETCH (tw->timers + t->prev, sizeof (*t), STORE);
+    }
+}
+
+/**
+ * @brief Stop a batch of tw timers
+ * @param tw_timer_wheel_t * tw timer wheel object pointer
+ * @param u32 * handles timer cancellation handles returned by tw_timer_start
+ * @param u32 n_handles number of timers to stop
+ */
+__clib_export void
+TW (tw_timer_stop_bulk) (TWT (tw_timer_wheel) * tw, u32 * handles,
+			 u32 n_handles)
+{
+  u32 i;
+
+  for (i = 0; i < clib_min (n_handles, 8); i++)
+    CLIB_PREFETCH (tw->timers + handles[i], sizeof (tw->timers[0]), STORE);
+
+  for (i = 0; i < n_handles; i++)
+    {
+      TW (timer_prefetch_bulk) (tw, handles, i, n_handles);
+      TW (tw_timer_stop) (tw, handles[i]);
+    }
+}
+
 __clib_export int
 TW (tw_timer_handle_is_free) (TWT (tw_timer_wheel) * tw, u32 handle)
 {
@@ -397,6 +515,34 @@ TW (tw_timer_update) (TWT (tw_timer_wheel) * tw, u32 handle, u64 interval)
   timer_add (tw, t, interval);
 }
 
+/**
+ * @brief Update a batch of tw timers to the same interval
+ * @param tw_timer_wheel_t * tw timer wheel object pointer
+ * @param u32 * handles timers returned by tw_timer_start
+ * @param u32 n_handles number of timers to update
+ * @param u32 interval timer interval in ticks
+ */
+__clib_export void
+TW (tw_timer_update_bulk) (TWT (tw_timer_wheel) * tw, u32 * handles,
+			   u32 n_handles, u64 interval)
+{
+  u32 i;
+
+  if (n_handles == 0)
+    return;
+
+  for (i = 0; i < clib_min (n_handles, 8); i++)
+    CLIB_PREFETCH (tw->timers + handles[i], sizeof (tw->timers[0]), STORE);
+
+  for (i = 0; i < n_handles; i++)
+    {
+      TW (timer_prefetch_bulk) (tw, handles, i, n_handles);
+      timer_remove (tw->timers, pool_elt_at_index (tw->timers, handles[i]));
+    }
+
+  timer_add_bulk (tw, handles, n_handles, interval);
+}
+
 /**
  * @brief Initialize a tw timer wheel template instance
  * @param tw_timer_wheel_t * tw timer wheel object pointer
@@ -550,6 +696,42 @@ static inline
       if (TW_TIMER_WHEELS > 2)
 	glacier_wheel_index = tw->current_index[TW_TIMER_RING_GLACIER];
 
+#if TW_FAST_WHEEL_BITMAP
+      /*
+       * Skip the run of empty fast ring slots up to the next occupied
+       * one, or up to the end of the ring where the slower rings turn.
+       * The bitmap may have stale bits set, never missing ones.
+       */
+      if (fast_wheel_index < TW_SLOTS_PER_RING &&
+	  !clib_bitmap_get (tw->fast_slot_bitmap, fast_wheel_index))
+	{
+	  u32 next_index, n_skip;
+
+	  next_index =
+	    clib_bitmap_next_set (tw->fast_slot_bitmap, fast_wheel_index);
+	  if (next_index == ~0 || next_index > TW_SLOTS_PER_RING)
+	    next_index = TW_SLOTS_PER_RING;
+	  n_skip = clib_min (next_index - fast_wheel_index, nticks - i);
+
+	  tw->current_tick += n_skip;
+	  fast_wheel_index += n_skip;
+	  tw->current_index[TW_TIMER_RING_FAST] = fast_wheel_index;
+#if TW_TIMER_WHEELS > 1
+	  if (fast_wheel_index == TW_SLOTS_PER_RING)
+	    slow_wheel_index++;
+	  tw->current_index[TW_TIMER_RING_SLOW] = slow_wheel_index;
+#endif
+#if TW_TIMER_WHEELS > 2
+	  if (slow_wheel_index == TW_SLOTS_PER_RING)
+	    glacier_wheel_index++;
+	  tw->current_index[TW_TIMER_RING_GLACIER] = glacier_wheel_index;
+#endif
+	  /* the loop increment accounts for one of the skipped ticks */
+	  i += n_skip - 1;
+	  continue;
+	}
+#endif
+
 #if TW_OVERFLOW_VECTOR > 0
       /* Triple odometer-click? Process the overflow vector... */
       if (PREDICT_FALSE (fast_wheel_index == TW_SLOTS_PER_RING
@@ -81,6 +81,22 @@ Stop a timer:
 
     tw_timer_stop_2t_1w_2048sl (&tm->single_wheel, handle);
 
+Timers started together with the same interval, or rearmed together
+to the same interval, can be handled in one call. The slot is computed
+once and the timers are chained into it:
+
+    tw_timer_start_bulk_2t_1w_2048sl (&tm->single_wheel, elt_indices,
+                                      [0 | 1] / * timer id * / ,
+                                      expiration_time_in_u32_ticks,
+                                      handles, n_timers);
+    tw_timer_update_bulk_2t_1w_2048sl (&tm->single_wheel, handles,
+                                       n_timers, new_interval);
+    tw_timer_stop_bulk_2t_1w_2048sl (&tm->single_wheel, handles,
+                                     n_timers);
+
+With TW_FAST_WHEEL_BITMAP, expiring several ticks at once skips runs of
+empty fast ring slots.
+
 Expired timer callback:
 
     static void
@@ -234,10 +250,18 @@ typedef struct
 u32 TW (tw_timer_start) (TWT (tw_timer_wheel) * tw,
 			 u32 pool_index, u32 timer_id, u64 interval);
 
+void TW (tw_timer_start_bulk) (TWT (tw_timer_wheel) * tw, u32 * user_ids,
+			       u32 timer_id, u64 interval, u32 * handles,
+			       u32 n_timers);
+
 void TW (tw_timer_stop) (TWT (tw_timer_wheel) * tw, u32 handle);
+void TW (tw_timer_stop_bulk) (TWT (tw_timer_wheel) * tw, u32 * handles,
+			      u32 n_handles);
 int TW (tw_timer_handle_is_free) (TWT (tw_timer_wheel) * tw, u32 handle);
 void TW (tw_timer_update) (TWT (tw_timer_wheel) * tw, u32 handle,
 			   u64 interval);
+void TW (tw_timer_update_bulk) (TWT (tw_timer_wheel) * tw, u32 * handles,
+				u32 n_handles, u64 interval);
 
 void TW (tw_timer_wheel_init) (TWT (tw_timer_wheel) * tw,
 			       void *expired_timer_callback,
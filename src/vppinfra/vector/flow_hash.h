@@ -0,0 +1,131 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#ifndef included_vector_flow_hash_h
+#define included_vector_flow_hash_h
+#include <vppinfra/clib.h>
+#include <vppinfra/hash.h>
+
+/*
+ * Bob Jenkins' v3 32 bit mix and finalize, as hash_v3_mix32 and
+ * hash_v3_finalize32, computed for many flows at once. Keys are passed as
+ * three arrays, one per hash input word, so each step of the hash is a
+ * single vector operation over as many flows as the vector holds. The
+ * results are identical to the scalar macros, so a caller may switch to
+ * the batch version without changing which bucket or worker a flow maps
+ * to. Other flow hashes are not v3: the vnet/hash handoff functions use
+ * crc32c and the NAT44-ED handoff adds shifted bytes of the source
+ * address.
+ */
+
+#define clib_flow_hash_v3_rotl(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+#define clib_flow_hash_v3_mix_finalize(a, b, c)                               \
+  do                                                                          \
+    {                                                                         \
+      a -= c;                                                                 \
+      a ^= clib_flow_hash_v3_rotl (c, 4);                                     \
+      c += b;                                                                 \
+      b -= a;                                                                 \
+      b ^= clib_flow_hash_v3_rotl (a, 6);                                     \
+      a += c;                                                                 \
+      c -= b;                                                                 \
+      c ^= clib_flow_hash_v3_rotl (b, 8);                                     \
+      b += a;                                                                 \
+      a -= c;                                                                 \
+      a ^= clib_flow_hash_v3_rotl (c, 16);                                    \
+      c += b;                                                                 \
+      b -= a;                                                                 \
+      b ^= clib_flow_hash_v3_rotl (a, 19);                                    \
+      a += c;                                                                 \
+      c -= b;                                                                 \
+      c ^= clib_flow_hash_v3_rotl (b, 4);                                     \
+      b += a;                                                                 \
+                                                                              \
+      c ^= b;                                                                 \
+      c -= clib_flow_hash_v3_rotl (b, 14);                                    \
+      a ^= c;                                                                 \
+      a -= clib_flow_hash_v3_rotl (c, 11);                                    \
+      b ^= a;                                                                 \
+      b -= clib_flow_hash_v3_rotl (a, 25);                                    \
+      c ^= b;                                                                 \
+      c -= clib_flow_hash_v3_rotl (b, 16);                                    \
+      a ^= c;                                                                 \
+      a -= clib_flow_hash_v3_rotl (c, 4);                                     \
+      b ^= a;                                                                 \
+      b -= clib_flow_hash_v3_rotl (a, 14);                                    \
+      c ^= b;                                                                 \
+      c -= clib_flow_hash_v3_rotl (b, 24);                                    \
+    }                                                                         \
+  while (0)
+
+/** \brief Compute the v3 hash of n_flows keys
+
+    @param a - first key word of each flow
+    @param b - second key word of each flow
+    @param c - third key word of each flow
+    @param hash - hash of each flow, may be the same array as any input
+    @param n_flows - number of flows
+*/
+static_always_inline void
+clib_flow_hash_v3 (u32 *a, u32 *b, u32 *c, u32 *hash, u32 n_flows)
+{
+#if defined(CLIB_HAVE_VEC512)
+  while (n_flows >= 16)
+    {
+      u32x16 va = u32x16_load_unaligned (a);
+      u32x16 vb = u32x16_load_unaligned (b);
+      u32x16 vc = u32x16_load_unaligned (c);
+      clib_flow_hash_v3_mix_finalize (va, vb, vc);
+      u32x16_store_unaligned (vc, hash);
+      a += 16;
+      b += 16;
+      c += 16;
+      hash += 16;
+      n_flows -= 16;
+    }
+#endif
+#if defined(CLIB_HAVE_VEC256)
+  while (n_flows >= 8)
+    {
+      u32x8 va = u32x8_load_unaligned (a);
+      u32x8 vb = u32x8_load_unaligned (b);
+      u32x8 vc = u32x8_load_unaligned (c);
+      clib_flow_hash_v3_mix_finalize (va, vb, vc);
+      u32x8_store_unaligned (vc, hash);
+      a += 8;
+      b += 8;
+      c += 8;
+      hash += 8;
+      n_flows -= 8;
+    }
+#endif
+#if defined(CLIB_HAVE_VEC128)
+  while (n_flows >= 4)
+    {
+      u32x4 va = u32x4_load_unaligned (a);
+      u32x4 vb = u32x4_load_unaligned (b);
+      u32x4 vc = u32x4_load_unaligned (c);
+      clib_flow_hash_v3_mix_finalize (va, vb, vc);
+      u32x4_store_unaligned (vc, hash);
+      a += 4;
+      b += 4;
+      c += 4;
+      hash += 4;
+      n_flows -= 4;
+    }
+#endif
+  while (n_flows)
+    {
+      u32 sa = a[0], sb = b[0], sc = c[0];
+      hash_v3_mix32 (sa, sb, sc);
+      hash_v3_finalize32 (sa, sb, sc);
+      hash[0] = sc;
+      a += 1;
+      b += 1;
+      c += 1;
+      hash += 1;
+      n_flows -= 1;
+    }
+}
+
+#endif
@@ -0,0 +1,134 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include <vppinfra/format.h>
+#include <vppinfra/random.h>
+#include <vppinfra/vector/test/test.h>
+#include <vppinfra/vector/flow_hash.h>
+
+__test_funct_fn void
+wrapper (u32 *a, u32 *b, u32 *c, u32 *hash, u32 n_flows)
+{
+  clib_flow_hash_v3 (a, b, c, hash, n_flows);
+}
+
+static u32
+flow_hash_v3_scalar (u32 a, u32 b, u32 c)
+{
+  hash_v3_mix32 (a, b, c);
+  hash_v3_finalize32 (a, b, c);
+  return c;
+}
+
+static clib_error_t *
+test_clib_flow_hash_v3 (clib_error_t *err)
+{
+  u32 n_flows = 259, seed = 0xdeadbeef;
+  u32 *a, *b, *c, *hash;
+
+  a = test_mem_alloc (n_flows * sizeof (u32));
+  b = test_mem_alloc (n_flows * sizeof (u32));
+  c = test_mem_alloc (n_flows * sizeof (u32));
+  hash = test_mem_alloc (n_flows * sizeof (u32));
+
+  for (u32 i = 0; i < n_flows; i++)
+    {
+      a[i] = random_u32 (&seed);
+      b[i] = random_u32 (&seed);
+      c[i] = random_u32 (&seed);
+    }
+
+  /* every length, so each vector width and the scalar tail are covered */
+  for (u32 n = 0; n <= n_flows; n++)
+    {
+      clib_memset_u32 (hash, 0, n_flows);
+      wrapper (a, b, c, hash, n);
+
+      for (u32 i = 0; i < n_flows; i++)
+	{
+	  u32 expected = i < n ? flow_hash_v3_scalar (a[i], b[i], c[i]) : 0;
+	  if (hash[i] != expected)
+	    {
+	      err = clib_error_return (err,
+				       "hash of flow %u of %u is 0x%08x, "
+				       "expected 0x%08x",
+				       i, n, hash[i], expected);
+	      goto done;
+	    }
+	}
+    }
+
+  /* the result may overwrite one of the inputs */
+  for (u32 i = 0; i < n_flows; i++)
+    hash[i] = flow_hash_v3_scalar (a[i], b[i], c[i]);
+  wrapper (a, b, c, c, n_flows);
+  for (u32 i = 0; i < n_flows; i++)
+    if (c[i] != hash[i])
+      {
+	err = clib_error_return (err, "in place hash of flow %u is 0x%08x, "
+				      "expected 0x%08x",
+				 i, c[i], hash[i]);
+	goto done;
+      }
+
+done:
+  test_mem_free (a);
+  test_mem_free (b);
+  test_mem_free (c);
+  test_mem_free (hash);
+  return err;
+}
+
+void __test_perf_fn
+perftest_scalar (test_perf_t *tp)
+{
+  u32 n = tp->n_ops;
+  u32 *a = test_mem_alloc_and_fill_inc_u8 (n * sizeof (u32), 0, 0);
+  u32 *b = test_mem_alloc_and_fill_inc_u8 (n * sizeof (u32), 1, 0);
+  u32 *c = test_mem_alloc_and_fill_inc_u8 (n * sizeof (u32), 2, 0);
+  u32 *hash = test_mem_alloc (n * sizeof (u32));
+
+  test_perf_event_enable (tp);
+  for (u32 i = 0; i < n; i++)
+    {
+      u32 sa = a[i], sb = b[i], sc = c[i];
+      hash_v3_mix32 (sa, sb, sc);
+      hash_v3_finalize32 (sa, sb, sc);
+      hash[i] = sc;
+    }
+  test_perf_event_disable (tp);
+
+  test_mem_free (a);
+  test_mem_free (b);
+  test_mem_free (c);
+  test_mem_free (hash);
+}
+
+void __test_perf_fn
+perftest_vector (test_perf_t *tp)
+{
+  u32 n = tp->n_ops;
+  u32 *a = test_mem_alloc_and_fill_inc_u8 (n * sizeof (u32), 0, 0);
+  u32 *b = test_mem_alloc_and_fill_inc_u8 (n * sizeof (u32), 1, 0);
+  u32 *c = test_mem_alloc_and_fill_inc_u8 (n * sizeof (u32), 2, 0);
+  u32 *hash = test_mem_alloc (n * sizeof (u32));
+
+  test_perf_event_enable (tp);
+  clib_flow_hash_v3 (a, b, c, hash, n);
+  test_perf_event_disable (tp);
+
+  test_mem_free (a);
+  test_mem_free (b);
+  test_mem_free (c);
+  test_mem_free (hash);
+}
+
+REGISTER_TEST (clib_flow_hash_v3) = {
+  .name = "clib_flow_hash_v3",
+  .fn = test_clib_flow_hash_v3,
+  .perf_tests = PERF_TESTS ({ .name = "scalar (per flow)",
+			      .n_ops = 256,
+			      .fn = perftest_scalar },
+			    { .name = "vector (per flow)",
+			      .n_ops = 256,
+			      .fn = perftest_vector }),
+};
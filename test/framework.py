@@ -294,6 +294,7 @@ class VppTestCase(CPUInterface, unittest.TestCase):
     """
 
     extra_vpp_statseg_config = ""
+    extra_vpp_socksvr_config = ""
     extra_vpp_punt_config = []
     extra_vpp_plugin_config = []
     logger = null_logger
@@ -451,6 +452,7 @@ class VppTestCase(CPUInterface, unittest.TestCase):
                 "{",
                 "socket-name",
                 cls.get_api_sock_path(),
+                cls.extra_vpp_socksvr_config,
                 "}",
                 "node { ",
                 default_variant,
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+
+import unittest
+
+from config import config
+from framework import VppTestCase, VppTestRunner
+from vpp_papi import VPPApiClient
+
+
+class TestAPISocket(VppTestCase):
+    """API socket transport"""
+
+    # a small budget, so that a flood of requests takes many turns
+    rx_msg_budget = 8
+    extra_vpp_socksvr_config = "rx-msg-budget %d" % rx_msg_budget
+
+    def connect(self, name, do_async=False):
+        """Open another API socket connection"""
+        VPPApiClient.apidir = config.vpp_install_dir
+        client = VPPApiClient(
+            logger=self.logger,
+            read_timeout=10,
+            use_socket=True,
+            server_address=self.get_api_sock_path(),
+        )
+        client.connect(name, do_async=do_async)
+        self.addCleanup(client.disconnect)
+        return client
+
+    def client_stats(self, name):
+        """The counters of a client in show api clients"""
+        for line in self.vapi.cli("show api clients").splitlines():
+            fields = line.split()
+            if fields and fields[0] == name:
+                return {
+                    "rx": int(fields[2]),
+                    "tx": int(fields[3]),
+                    "writes": int(fields[6]),
+                    "turns": int(fields[7]),
+                }
+        self.fail("no client %s in: %s" % (name, self.vapi.cli("show api clients")))
+
+    def test_api_socket_clients(self):
+        """API socket clients served in turn"""
+        n_pings = 2000
+
+        #
+        # a client that sends requests without waiting for the replies,
+        # so that they arrive many to a read
+        #
+        flood = self.connect("flood", do_async=True)
+        contexts = [flood.api.control_ping() for i in range(n_pings)]
+
+        #
+        # a client waiting for each reply is served in between
+        #
+        other = self.connect("other")
+        for i in range(20):
+            self.assertEqual(other.api.show_version().retval, 0)
+
+        # every reply comes back, in the order of the requests
+        replies = []
+        for i in range(n_pings):
+            r = flood.read_blocking(timeout=10)
+            self.assertIsNotNone(r)
+            replies.append(r.context)
+        self.assertEqual(replies, contexts)
+
+        stats = self.client_stats("flood")
+        self.logger.info(self.vapi.cli("show api clients"))
+        self.assertGreaterEqual(stats["rx"], n_pings)
+        self.assertGreaterEqual(stats["tx"], n_pings)
+        # no turn handles more than the budget
+        self.assertGreaterEqual(stats["turns"], n_pings // self.rx_msg_budget)
+
+        stats = self.client_stats("other")
+        self.assertGreaterEqual(stats["rx"], 20)
+        self.assertGreaterEqual(stats["tx"], 20)
+
+
+if __name__ == "__main__":
+    unittest.main(testRunner=VppTestRunner)
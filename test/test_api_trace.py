@@ -57,6 +57,57 @@ class TestJsonApiTrace(VppTestCase):
         self.assertEqual(len(r), 1)
         self.assertEqual(r[0].interface_name, "loop0")
 
+    def test_api_config_load(self):
+        """API bulk config load"""
+        fname = "%s/config.json" % self.tempdir
+        msg = {
+            "_msgname": "create_loopback",
+            "_crc": "42bb5d22",
+            "mac_address": "00:00:00:00:00:00",
+        }
+        with open(fname, "w") as f:
+            json.dump([msg] * 3, f)
+        before = self.vapi.sw_interface_dump(
+            name_filter="loop", name_filter_valid=True
+        )
+
+        reply = self.vapi.cli("api config load %s barrier-batch 2" % fname)
+        self.logger.info(reply)
+        self.assertIn("3 messages applied, 0 failed", reply)
+        r = self.vapi.sw_interface_dump(name_filter="loop", name_filter_valid=True)
+        self.assertEqual(len(r), len(before) + 3)
+
+        # nothing is applied if any message is bad
+        with open(fname, "w") as f:
+            json.dump([msg, {"_msgname": "no_such_msg", "_crc": "0"}], f)
+        reply = self.vapi.cli_return_response("api config load %s" % fname)
+        self.assertNotEqual(reply.retval, 0)
+        r = self.vapi.sw_interface_dump(name_filter="loop", name_filter_valid=True)
+        self.assertEqual(len(r), len(before) + 3)
+
+        # a failed reply stops the load unless continue-on-error is given
+        bad = {
+            "_msgname": "delete_loopback",
+            "_crc": "f9e6675e",
+            "sw_if_index": 0xFFFF,
+        }
+        with open(fname, "w") as f:
+            json.dump([bad, msg], f)
+        reply = self.vapi.cli_return_response("api config load %s" % fname)
+        self.assertNotEqual(reply.retval, 0)
+        self.assertIn("1 messages applied, 1 failed", reply.reply)
+        r = self.vapi.sw_interface_dump(name_filter="loop", name_filter_valid=True)
+        self.assertEqual(len(r), len(before) + 3)
+        reply = self.vapi.cli("api config load %s continue-on-error" % fname)
+        self.assertIn("2 messages applied, 1 failed", reply)
+        r = self.vapi.sw_interface_dump(name_filter="loop", name_filter_valid=True)
+        self.assertEqual(len(r), len(before) + 4)
+
+        old = [i.sw_if_index for i in before]
+        for i in r:
+            if i.sw_if_index not in old:
+                self.vapi.delete_loopback(sw_if_index=i.sw_if_index)
+
 
 if __name__ == "__main__":
     unittest.main(testRunner=VppTestRunner)
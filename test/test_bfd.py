@@ -396,6 +396,7 @@ class BFDTestSession(object):
         else:
             self.our_seq_number = our_seq_number
         self.vpp_seq_number = None
+        self.worker = None
         self.my_discriminator = 0
         self.desired_min_tx = 300000
         self.required_min_rx = 300000
@@ -552,7 +553,7 @@ class BFDTestSession(object):
         if interface is None:
             interface = self.phy_interface
         self.test.logger.debug(ppp("Sending packet:", packet))
-        interface.add_stream(packet)
+        interface.add_stream(packet, worker=self.worker)
         self.tx_packets += 1
         self.test.pg_start()
 
@@ -1718,6 +1719,98 @@ class BFD4TestCase(VppTestCase):
         self.assertFalse(vpp_session.query_vpp_config())
 
 
+@tag_run_solo
+class BFD4WorkerTestCase(VppTestCase):
+    """Bidirectional Forwarding Detection (BFD) on workers"""
+
+    vpp_worker_count = 2
+    pg0 = None
+    vpp_clock_offset = None
+    vpp_session = None
+    test_session = None
+
+    @classmethod
+    def setUpClass(cls):
+        super(BFD4WorkerTestCase, cls).setUpClass()
+        cls.vapi.cli("set log class bfd level debug")
+        try:
+            cls.create_pg_interfaces([0])
+            cls.pg0.config_ip4()
+            cls.pg0.configure_ipv4_neighbors()
+            cls.pg0.admin_up()
+            cls.pg0.resolve_arp()
+
+        except Exception:
+            super(BFD4WorkerTestCase, cls).tearDownClass()
+            raise
+
+    @classmethod
+    def tearDownClass(cls):
+        super(BFD4WorkerTestCase, cls).tearDownClass()
+
+    def setUp(self):
+        super(BFD4WorkerTestCase, self).setUp()
+        self.vapi.want_bfd_events()
+        self.pg0.enable_capture()
+        try:
+            self.vpp_session = VppBFDUDPSession(self, self.pg0, self.pg0.remote_ip4)
+            self.vpp_session.add_vpp_config()
+            self.vpp_session.admin_up()
+            self.test_session = BFDTestSession(self, self.pg0, AF_INET)
+        except BaseException:
+            self.vapi.want_bfd_events(enable_disable=0)
+            raise
+
+    def tearDown(self):
+        if not self.vpp_dead:
+            self.vapi.want_bfd_events(enable_disable=0)
+        self.vapi.collect_events()  # clear the event queue
+        super(BFD4WorkerTestCase, self).tearDown()
+
+    def threads(self):
+        """thread index -> (sessions, expired timers) from show bfd threads"""
+        threads = {}
+        for line in self.vapi.cli("show bfd threads").splitlines()[1:]:
+            f = line.split()
+            if len(f) == 5:
+                threads[int(f[0])] = (int(f[1]), int(f[2]))
+        return threads
+
+    def owner(self):
+        owners = [t for t, (n, _) in self.threads().items() if n == 1]
+        self.assert_equal(len(owners), 1, "number of threads owning a session")
+        self.assertNotEqual(owners[0], 0, "session owned by a worker")
+        return owners[0]
+
+    def test_session_up_down(self):
+        """bring BFD session up and down on its worker"""
+        owner = self.owner()
+        # pg worker n runs on thread n + 1
+        self.test_session.worker = owner - 1
+        bfd_session_up(self)
+        for dummy in range(self.test_session.detect_mult * 2):
+            wait_for_bfd_packet(self)
+            self.test_session.send_packet()
+        self.assert_equal(len(self.vapi.collect_events()), 0, "number of bfd events")
+        bfd_session_down(self)
+        # the timers ran on the owner
+        self.assertGreater(self.threads()[owner][1], 0)
+
+    def test_session_handoff(self):
+        """BFD packets received on another worker are handed off"""
+        handoff = "/err/bfd-udp4-input/bfd packets handed off"
+        n_handoff = self.statistics.get_err_counter(handoff)
+        owner = self.owner()
+        self.test_session.worker = 1 if owner == 1 else 0
+        bfd_session_up(self)
+        for dummy in range(self.test_session.detect_mult * 2):
+            wait_for_bfd_packet(self)
+            self.test_session.send_packet()
+        self.assert_equal(len(self.vapi.collect_events()), 0, "number of bfd events")
+        bfd_session_down(self)
+        self.assertGreater(self.statistics.get_err_counter(handoff), n_handoff)
+
+
 @tag_run_solo
 @tag_fixme_vpp_workers
 class BFD6TestCase(VppTestCase):
@@ -2753,6 +2846,7 @@ class BFDCLITestCase(VppTestCase):
         s2.add_vpp_config()
         self.logger.info(self.vapi.ppcli("show bfd keys"))
         self.logger.info(self.vapi.ppcli("show bfd sessions"))
+        self.logger.info(self.vapi.ppcli("show bfd threads"))
         self.logger.info(self.vapi.ppcli("show bfd"))
 
     def test_set_del_sha1_key(self):
@@ -27,3 +27,11 @@ class TestBuffers(VppTestCase):
         if error:
             self.logger.critical(error)
             self.assertNotIn("failed", error)
+
+    def test_pool_cache(self):
+        """Buffer Pool Cache and Lock Counters"""
+        error = self.vapi.cli("test buffer-pool-cache")
+
+        if error:
+            self.logger.critical(error)
+            self.assertNotIn("failed", error)
@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+
+import unittest
+
+from framework import VppTestCase, VppTestRunner
+
+from scapy.layers.inet import IP, UDP
+from scapy.layers.l2 import Ether
+from scapy.packet import Raw
+
+
+class TestBufmon(VppTestCase):
+    """Buffers monitoring plugin Test Case"""
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestBufmon, cls).setUpClass()
+        cls.create_pg_interfaces(range(2))
+        for i in cls.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+
+    @classmethod
+    def tearDownClass(cls):
+        for i in cls.pg_interfaces:
+            i.unconfig_ip4()
+            i.admin_down()
+        super(TestBufmon, cls).tearDownClass()
+
+    def tearDown(self):
+        self.vapi.cli("set buffer traces off")
+        super(TestBufmon, self).tearDown()
+
+    def test_bufmon_lifetime(self):
+        """Sampled buffer lifetime tracking"""
+        p = (
+            Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+            / IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4)
+            / UDP(sport=1234, dport=1234)
+            / Raw(b"\xa5" * 100)
+        )
+
+        self.vapi.cli("set buffer traces on sample 1 leak-threshold 60")
+        self.send_and_expect(self.pg0, p * 65, self.pg1)
+
+        reply = self.vapi.cli("show buffer lifetime verbose leaks")
+        self.logger.info(reply)
+        self.assertIn("sampling 1 in 1 buffers", reply)
+        self.assertIn("ip4-lookup", reply)
+
+        # the scan process updates the stats segment once a second
+        self.sleep(1.5)
+        self.assertEqual(self.statistics.get_counter("/bufmon/suspected-leaks"), 0)
+        buckets = self.statistics.ls(["^/bufmon/nodes/ip4-lookup/residency/lt-"])
+        self.assertEqual(len(buckets), 24)
+        residency = sum(self.statistics.get_counter(b)[0] for b in buckets)
+        self.assertGreaterEqual(residency, 65)
+
+        self.vapi.cli("set buffer traces off")
+        reply = self.vapi.cli("show buffer lifetime")
+        self.assertIn("buffer lifetime tracking is off", reply)
+
+
+if __name__ == "__main__":
+    unittest.main(testRunner=VppTestRunner)
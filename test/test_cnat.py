@@ -1,6 +1,7 @@
 #!/usr/bin/env python3
 
 import unittest
+import re
 
 from framework import VppTestCase, VppTestRunner
 from vpp_ip import DpoProto, INVALID_INDEX
@@ -455,6 +456,10 @@ class TestCNatTranslation(CnatCommonTestCase):
         self.virtual_sleep(2)
         sessions = self.vapi.cnat_session_dump()
         self.assertEqual(len(sessions), 0)
+        reply = self.vapi.cli("show cnat session")
+        self.logger.info(reply)
+        expired = re.findall(r"expired:(\d+) ", reply)
+        self.assertGreater(sum(int(n) for n in expired), 0)
         self.vapi.cli("test cnat scanner off")
 
         #
@@ -599,6 +604,15 @@ class TestCNatTranslation(CnatCommonTestCase):
         self._make_translations_v4()
         self.cnat_translation()
 
+    def test_session_create(self):
+        # """ CNat session creation rate """
+        self.translations = []
+        r = self.vapi.cli_return_response("test cnat session-create count 1000")
+        self.assertEqual(r.retval, 0)
+        self.logger.info(r.reply)
+        self.assertIn("1000 sessions created and freed", r.reply)
+        self.assertFalse(self.vapi.cnat_session_dump())
+
 
 class TestCNatSourceNAT(CnatCommonTestCase):
     """CNat Source NAT"""
@@ -11,7 +11,7 @@ from scapy.contrib.mpls import MPLS
 from scapy.layers.inet import IP, UDP, TCP, ICMP, icmptypes, icmpcodes
 from scapy.layers.l2 import Ether
 from scapy.packet import Raw
-from scapy.layers.dns import DNSRR, DNS, DNSQR
+from scapy.layers.dns import DNSRR, DNS, DNSQR, DNSRRSOA
 
 
 class TestDns(VppTestCase):
@@ -110,6 +110,133 @@ class TestDns(VppTestCase):
         self.assertIn("1.2.3.4", str)
         self.assertIn("[P] no.clown.org:", str)
 
+    def test_dns_negative_cache(self):
+        """DNS Name Resolver Negative Caching Test"""
+
+        # Use the pg interface as the upstream name resolver
+        server = IPv4Address(self.pg0.remote_ip4).packed
+        self.vapi.dns_name_server_add_del(is_ip6=0, is_add=1, server_address=server)
+        self.vapi.dns_enable_disable(enable=1)
+
+        request = (
+            Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+            / IP(src=self.pg0.remote_ip4, dst=self.pg0.local_ip4)
+            / UDP(sport=1234, dport=53)
+            / DNS(rd=1, qd=DNSQR(qname="nx.clown.org"))
+        )
+
+        # A cache miss, the request is forwarded upstream
+        rx = self.send_and_expect(self.pg0, [request], self.pg0)
+        upstream = rx[0]
+        self.assertEqual(upstream[UDP].dport, 53)
+
+        # The name doesn't exist, negative TTL from the SOA record
+        reply = (
+            Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+            / IP(src=self.pg0.remote_ip4, dst=self.pg0.local_ip4)
+            / UDP(sport=53, dport=upstream[UDP].sport)
+            / DNS(
+                id=upstream[DNS].id,
+                qr=1,
+                rd=1,
+                ra=1,
+                rcode=3,
+                qd=upstream[DNS].qd,
+                ns=DNSRRSOA(rrname="clown.org", ttl=300, minimum=30),
+            )
+        )
+        rx = self.send_and_expect(self.pg0, [reply], self.pg0)
+        self.assertEqual(rx[0][UDP].dport, 1234)
+        self.assertEqual(rx[0][DNS].rcode, 3)
+
+        str = self.vapi.cli("show dns cache verbose")
+        self.assertIn("[N] nx.clown.org", str)
+
+        # Answered from the cache, nothing goes upstream
+        rx = self.send_and_expect(self.pg0, [request] * 3, self.pg0)
+        for p in rx:
+            self.assertEqual(p[UDP].sport, 53)
+            self.assertEqual(p[UDP].dport, 1234)
+            self.assertEqual(p[DNS].qr, 1)
+            self.assertEqual(p[DNS].rcode, 3)
+
+        self.vapi.dns_enable_disable(enable=0)
+        self.vapi.dns_name_server_add_del(is_ip6=0, is_add=0, server_address=server)
+
+    def test_dns_positive_reply(self):
+        """DNS Name Resolver In Place Positive Reply Test"""
+
+        # Use the pg interface as the upstream name resolver
+        server = IPv4Address(self.pg0.remote_ip4).packed
+        self.vapi.dns_name_server_add_del(is_ip6=0, is_add=1, server_address=server)
+        self.vapi.dns_enable_disable(enable=1)
+
+        request = (
+            Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+            / IP(src=self.pg0.remote_ip4, dst=self.pg0.local_ip4)
+            / UDP(sport=1234, dport=53)
+            / DNS(id=77, rd=1, qd=DNSQR(qname="www.clown.org"))
+        )
+
+        # A cache miss, the request is forwarded upstream
+        rx = self.send_and_expect(self.pg0, [request], self.pg0)
+        upstream = rx[0]
+        self.assertEqual(upstream[UDP].dport, 53)
+
+        def upstream_reply(address):
+            return (
+                Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+                / IP(src=self.pg0.remote_ip4, dst=self.pg0.local_ip4)
+                / UDP(sport=53, dport=upstream[UDP].sport)
+                / DNS(
+                    id=upstream[DNS].id,
+                    qr=1,
+                    rd=1,
+                    ra=1,
+                    qd=upstream[DNS].qd,
+                    an=DNSRR(rrname="www.clown.org", ttl=300, rdata=address),
+                )
+            )
+
+        rx = self.send_and_expect(self.pg0, [upstream_reply("10.0.0.1")], self.pg0)
+        self.assertEqual(rx[0][UDP].dport, 1234)
+
+        def verify_replies(rx, address):
+            for p in rx:
+                self.assertEqual(p[IP].src, self.pg0.local_ip4)
+                self.assertEqual(p[IP].dst, self.pg0.remote_ip4)
+                self.assertEqual(p[UDP].sport, 53)
+                self.assertEqual(p[UDP].dport, 1234)
+                dns = p[DNS]
+                self.assertEqual(dns.id, 77)
+                self.assertEqual(dns.qr, 1)
+                self.assertEqual(dns.rcode, 0)
+                self.assertEqual(dns.qdcount, 1)
+                self.assertEqual(dns.qd.qname, b"www.clown.org.")
+                self.assertEqual(dns.ancount, 1)
+                self.assertEqual(dns.an[0].type, 1)
+                self.assertEqual(dns.an[0].rdata, address)
+                self.assertLessEqual(dns.an[0].ttl, 300)
+            return rx[0][DNS].an[0].ttl
+
+        # Answered in place from the cache, nothing goes upstream
+        rx = self.send_and_expect(self.pg0, [request] * 3, self.pg0)
+        ttl = verify_replies(rx, "10.0.0.1")
+
+        # The TTL counts down
+        self.sleep(2)
+        rx = self.send_and_expect(self.pg0, [request] * 3, self.pg0)
+        self.assertLess(verify_replies(rx, "10.0.0.1"), ttl)
+
+        # A later upstream response replaces the cached one, and the
+        # threads stop answering from the old one
+        self.send_and_assert_no_replies(self.pg0, [upstream_reply("10.0.0.2")])
+        rx = self.send_and_expect(self.pg0, [request] * 3, self.pg0)
+        verify_replies(rx, "10.0.0.2")
+
+        self.vapi.dns_enable_disable(enable=0)
+        self.vapi.dns_name_server_add_del(is_ip6=0, is_add=0, server_address=server)
+
 
 if __name__ == "__main__":
     unittest.main(testRunner=VppTestRunner)
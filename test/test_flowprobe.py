@@ -572,6 +572,40 @@ class Flowprobe(MethodHolder):
         ipfix.remove_vpp_config()
         self.logger.info("FFP_TEST_FINISH_0004")
 
+    def test_sampling(self):
+        """1-in-N sampling, partial buffers exported without a flush"""
+        self.logger.info("FFP_TEST_START_0005")
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pkts = []
+
+        ipfix = VppCFLOW(test=self)
+        ipfix.add_vpp_config()
+
+        ipfix_decoder = IPFIXDecoder()
+        # template packet should arrive immediately
+        templates = ipfix.verify_templates(ipfix_decoder)
+
+        self.vapi.cli("flowprobe sampling 3")
+        self.assertIn("sampling: 1 in 3", self.vapi.cli("show flowprobe params"))
+
+        self.create_stream(packets=9)
+        self.send_packets()
+
+        # no ipfix flush, the worker sends its buffer once it gets old
+        cflow = self.wait_for_cflow_packet(self.collector, templates[1], 5)
+        data = ipfix_decoder.decode_data_set(cflow.getlayer(Set))
+        self.assertEqual(len(data), 3)
+        self.assertEqual(
+            self.statistics.get_err_counter(
+                "/err/flowprobe-output-l2/Packets skipped by sampling"
+            ),
+            6,
+        )
+
+        self.vapi.cli("flowprobe sampling 1")
+        ipfix.remove_vpp_config()
+        self.logger.info("FFP_TEST_FINISH_0005")
+
 
 class DatapathTestsHolder(object):
     """collect information on Ethernet, IP4 and IP6 datapath (no timers)"""
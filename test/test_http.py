@@ -38,5 +38,82 @@ class TestHttpTps(VppTestCase):
         self.assertEqual(len(r.read()), 1 << 20)
 
 
+@unittest.skipUnless(os.geteuid() == 0, "Requires root")
+class TestHttpProm(VppTestCase):
+    """HTTP prometheus exporter test class"""
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestHttpProm, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestHttpProm, cls).tearDownClass()
+
+    def setUp(self):
+        super(TestHttpProm, self).setUp()
+        self.client_ip4 = "172.0.1.2"
+        self.server_ip4 = "172.0.1.1"
+        self.vapi.cli(f"create tap id 1 host-ip4-addr {self.client_ip4}/24")
+        self.vapi.cli(f"set int ip addr tap1 {self.server_ip4}/24")
+        self.vapi.cli("set int state tap1 up")
+        self.vapi.session_enable_disable(is_enable=1)
+        self.vapi.cli("http static server url-handlers uri tcp://0.0.0.0/8081")
+        self.vapi.cli("prom enable min-scrape-interval 0")
+
+    def tearDown(self):
+        self.vapi.cli("delete tap tap1")
+        super(TestHttpProm, self).tearDown()
+
+    def scrape(self, url):
+        con = http.client.HTTPConnection(f"{self.server_ip4}", 8081, timeout=5)
+        con.request("GET", url)
+        r = con.getresponse()
+        self.assertEqual(r.status, 200)
+        body = r.read().decode()
+        con.close()
+        return [l for l in body.splitlines() if not l.startswith("#")]
+
+    def test_http_prom(self):
+        """Prometheus stats with query filters and labels"""
+
+        # The query string is not part of the handler's path, and the
+        # filter overrides the configured patterns
+        lines = self.scrape("/stats.prom?filter=%5E%2Fif%2Frx%24")
+        self.assertTrue(lines)
+        for l in lines:
+            self.assertTrue(l.startswith("vpp_if_rx_"), l)
+        # Counters are summed across threads by default, and interface
+        # counters are labeled with the interface name
+        self.assertTrue(
+            any(l.startswith('vpp_if_rx_packets{interface="tap1"} ') for l in lines)
+        )
+        self.assertFalse(any("thread=" in l for l in lines))
+
+        # Repeated filters are all applied
+        lines = self.scrape(
+            "/stats.prom?filter=%5E%2Fif%2Frx%24&filter=%5E%2Fif%2Ftx%24"
+        )
+        names = {l.split("{")[0] for l in lines}
+        self.assertIn("vpp_if_rx_packets", names)
+        self.assertIn("vpp_if_tx_packets", names)
+        self.assertFalse(any(n.startswith("vpp_sys_") for n in names))
+
+        # Per thread samples carry a thread label
+        self.vapi.cli("prom per-thread")
+        lines = self.scrape("/stats.prom?filter=%5E%2Fif%2Frx%24")
+        self.assertTrue(
+            any(
+                l.startswith('vpp_if_rx_packets{thread="0",interface="tap1"} ')
+                for l in lines
+            )
+        )
+
+        # And back to sums
+        self.vapi.cli("prom aggregate")
+        lines = self.scrape("/stats.prom?filter=%5E%2Fif%2Frx%24")
+        self.assertFalse(any("thread=" in l for l in lines))
+
+
 if __name__ == "__main__":
     unittest.main(testRunner=VppTestRunner)
@@ -1,6 +1,7 @@
 #!/usr/bin/env python3
 import binascii
 import random
+import re
 import socket
 import unittest
 
@@ -35,6 +36,7 @@ from vpp_papi import vpp_papi, VppEnum
 from vpp_neighbor import VppNeighbor
 from vpp_lo_interface import VppLoInterface
 from vpp_policer import VppPolicer, PolicerAction
+from vpp_papi_provider import CliFailedCommandError
 
 NUM_PKTS = 67
 
@@ -1514,6 +1516,106 @@ class TestIPLoadBalance(VppTestCase):
         )
         self.assertEqual(len(src_pkts), self.total_len(rx))
 
+    @staticmethod
+    def flow_hash_v3(pkt, router_id):
+        """The default IPv4 flow hash, as ip4_compute_flow_hash () has it"""
+
+        def rotl(x, n):
+            return ((x << n) | (x >> (32 - n))) & 0xFFFFFFFF
+
+        def word(b):
+            return int.from_bytes(b, "little")
+
+        ip = pkt[IP]
+        a = word(socket.inet_aton(ip.src)) ^ router_id
+        b = word(socket.inet_aton(ip.dst)) ^ ip.proto
+        c = (word(ip.dport.to_bytes(2, "big")) << 16) | word(
+            ip.sport.to_bytes(2, "big")
+        )
+
+        # hash_v3_mix32 then hash_v3_finalize32, on v = [a, b, c]
+        v = [a, b, c]
+        for x, y, z, r in (
+            (0, 2, 1, 4),
+            (1, 0, 2, 6),
+            (2, 1, 0, 8),
+            (0, 2, 1, 16),
+            (1, 0, 2, 19),
+            (2, 1, 0, 4),
+        ):
+            v[x] = ((v[x] - v[y]) & 0xFFFFFFFF) ^ rotl(v[y], r)
+            v[y] = (v[y] + v[z]) & 0xFFFFFFFF
+        for x, y, r in (
+            (2, 1, 14),
+            (0, 2, 11),
+            (1, 0, 25),
+            (2, 1, 16),
+            (0, 2, 4),
+            (1, 0, 14),
+            (2, 1, 24),
+        ):
+            v[x] = ((v[x] ^ v[y]) - rotl(v[y], r)) & 0xFFFFFFFF
+        return v[2]
+
+    def test_ip_load_balance_recursive_hash(self):
+        """IP Load-Balancing, recursive ECMP bucket choice"""
+
+        #
+        # The flow hash of a recursive ECMP route is computed by
+        # ip4-load-balance for many packets at once. Every flow must land
+        # in the bucket the scalar hash gives it, so that flows keep
+        # their paths.
+        #
+        router_id = 0x12345678
+        self.vapi.set_ip_flow_hash_router_id(router_id=router_id)
+        self.vapi.set_ip_flow_hash(vrf_id=0, src=1, dst=1, proto=1, sport=1, dport=1)
+
+        via = VppIpRoute(
+            self,
+            "1.1.1.1",
+            32,
+            [
+                VppRoutePath(self.pg1.remote_ip4, self.pg1.sw_if_index),
+                VppRoutePath(self.pg2.remote_ip4, self.pg2.sw_if_index),
+            ],
+        )
+        via.add_vpp_config()
+        route = VppIpRoute(
+            self, "10.0.0.5", 32, [VppRoutePath("1.1.1.1", 0xFFFFFFFF)]
+        )
+        route.add_vpp_config()
+
+        n_buckets = int(
+            re.search(r"buckets:(\d+)", self.vapi.cli("show ip fib 1.1.1.1/32"))[1]
+        )
+
+        pkts = []
+        for ii in range(NUM_PKTS):
+            pkts.append(
+                Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+                / IP(dst="10.0.0.5", src="20.0.%d.%d" % (ii % 7, ii))
+                / UDP(sport=1000 + 3 * ii, dport=2000 + ii)
+                / Raw(b"\xa5" * 100)
+            )
+
+        rxs = self.send_and_expect_load_balancing(
+            self.pg0, pkts, [self.pg1, self.pg2]
+        )
+        self.assertEqual(len(pkts), self.total_len(rxs))
+
+        # each bucket is served by a single path
+        paths = {}
+        for itf, rx in zip([self.pg1, self.pg2], rxs):
+            for p in rx:
+                bucket = self.flow_hash_v3(p, router_id) & (n_buckets - 1)
+                paths.setdefault(bucket, set()).add(itf.name)
+        for bucket, itfs in paths.items():
+            self.assertEqual(len(itfs), 1, "bucket %d on %s" % (bucket, itfs))
+
+        route.remove_vpp_config()
+        via.remove_vpp_config()
+        self.vapi.set_ip_flow_hash_router_id(router_id=0)
+
 
 class TestIPVlan0(VppTestCase):
     """IPv4 VLAN-0"""
@@ -3258,5 +3360,136 @@ class TestIPv4ItfRebind(VppTestCase):
             i.admin_down()
 
 
+class TestIPRouteSnapshot(VppTestCase):
+    """IP route table snapshot"""
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestIPRouteSnapshot, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestIPRouteSnapshot, cls).tearDownClass()
+
+    def setUp(self):
+        super(TestIPRouteSnapshot, self).setUp()
+
+        self.create_pg_interfaces(range(2))
+
+        for i in self.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.config_ip6()
+            i.resolve_arp()
+            i.resolve_ndp()
+
+        self.tables = [
+            VppIpTable(self, 10).add_vpp_config(),
+            VppIpTable(self, 10, is_ip6=1).add_vpp_config(),
+        ]
+
+    def tearDown(self):
+        for i in self.pg_interfaces:
+            i.unconfig_ip4()
+            i.unconfig_ip6()
+            i.admin_down()
+        super(TestIPRouteSnapshot, self).tearDown()
+
+    def snapshot(self, table_id, is_ip6=0):
+        """Build a snapshot and return its routes, decoded from the
+        shared memory segment, keyed by prefix"""
+        af = "ip6" if is_ip6 else "ip4"
+        lines = self.vapi.cli(
+            "show ip route-snapshot %s table %d" % (af, table_id)
+        ).splitlines()
+
+        routes = {}
+        for line in lines[1:]:
+            if line.startswith("  "):
+                routes[prefix].append(line.strip())
+            else:
+                prefix = line.split()[0]
+                routes[prefix] = []
+
+        self.assertTrue(
+            lines[0].startswith("table:%d routes:%d " % (table_id, len(routes)))
+        )
+        return routes
+
+    def test_route_snapshot(self):
+        """IP route table snapshot"""
+
+        #
+        # more routes than FIB entries visited between yields, so the
+        # snapshot is built across several suspends of its process
+        #
+        n_routes = 2500
+        for i in range(n_routes):
+            VppIpRoute(
+                self,
+                "10.%d.%d.0" % (i // 256, i % 256),
+                24,
+                [VppRoutePath(self.pg0.remote_ip4, self.pg0.sw_if_index)],
+                table_id=10,
+            ).add_vpp_config()
+
+        VppIpRoute(
+            self,
+            "1.1.1.1",
+            32,
+            [
+                VppRoutePath(
+                    self.pg1.remote_ip4, self.pg1.sw_if_index, labels=[44, 45]
+                )
+            ],
+            table_id=10,
+        ).add_vpp_config()
+        VppIpRoute(
+            self,
+            "2001::",
+            64,
+            [VppRoutePath(self.pg1.remote_ip6, self.pg1.sw_if_index)],
+            table_id=10,
+        ).add_vpp_config()
+
+        #
+        # the snapshot holds the same routes as a dump of the table
+        #
+        routes = self.snapshot(10)
+        dump = self.vapi.ip_route_dump(10)
+        self.assertEqual(len(routes), len(dump))
+        for r in dump:
+            self.assertIn(str(r.route.prefix), routes)
+
+        for i in range(n_routes):
+            paths = routes["10.%d.%d.0/24" % (i // 256, i % 256)]
+            self.assertEqual(len(paths), 1)
+            self.assertIn("nh:%s " % self.pg0.remote_ip4, paths[0])
+            self.assertIn("sw_if_index:%d " % self.pg0.sw_if_index, paths[0])
+
+        paths = routes["1.1.1.1/32"]
+        self.assertEqual(len(paths), 1)
+        self.assertIn("nh:%s " % self.pg1.remote_ip4, paths[0])
+        self.assertTrue(paths[0].endswith(" labels:44 45"))
+
+        #
+        # the tables of the other AF and of other IDs are not included
+        #
+        routes = self.snapshot(10, is_ip6=1)
+        self.assertEqual(len(routes), len(self.vapi.ip_route_dump(10, True)))
+        self.assertIn("2001::/64", routes)
+        self.assertIn("nh:%s " % self.pg1.remote_ip6, routes["2001::/64"][0])
+
+        routes = self.snapshot(0)
+        self.assertEqual(len(routes), len(self.vapi.ip_route_dump(0)))
+        self.assertNotIn("1.1.1.1/32", routes)
+
+        #
+        # a table that does not exist
+        #
+        with self.assertRaises(CliFailedCommandError):
+            self.vapi.cli("show ip route-snapshot ip4 table 11")
+
+
 if __name__ == "__main__":
     unittest.main(testRunner=VppTestRunner)
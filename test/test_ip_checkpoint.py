@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+
+import os
+import unittest
+
+from framework import VppTestCase, VppTestRunner
+from vpp_ip_route import VppIpRoute, VppRoutePath, VppMplsLabel, find_route
+from vpp_neighbor import VppNeighbor, find_nbr
+
+from scapy.layers.inet import IP, UDP
+from scapy.layers.l2 import Ether
+from scapy.packet import Raw
+
+NUM_PKTS = 67
+
+
+class TestIPCheckpoint(VppTestCase):
+    """IP checkpoint save/restore Test Case"""
+
+    def setUp(self):
+        super(TestIPCheckpoint, self).setUp()
+
+        self.create_pg_interfaces(range(2))
+
+        for i in self.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+
+        self.file = os.path.join(self.tempdir, "ip.ckpt")
+
+    def tearDown(self):
+        for i in self.pg_interfaces:
+            i.unconfig_ip4()
+            i.admin_down()
+        super(TestIPCheckpoint, self).tearDown()
+
+    def test_ip_checkpoint(self):
+        """IP checkpoint save and restore"""
+
+        p = (
+            Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+            / IP(src=self.pg0.remote_ip4, dst="10.10.10.1")
+            / UDP(sport=1234, dport=1234)
+            / Raw(b"\xa5" * 100)
+        )
+
+        #
+        # a static neighbour and a route through it
+        #
+        nbr = VppNeighbor(
+            self,
+            self.pg1.sw_if_index,
+            self.pg1.remote_hosts[0].mac,
+            "172.16.1.100",
+            is_static=1,
+        )
+        nbr.add_vpp_config()
+        route = VppIpRoute(
+            self,
+            "10.10.10.0",
+            24,
+            [VppRoutePath("172.16.1.100", self.pg1.sw_if_index)],
+        )
+        route.add_vpp_config()
+
+        self.send_and_expect(self.pg0, p * NUM_PKTS, self.pg1)
+
+        self.vapi.cli("ip checkpoint save %s" % self.file)
+
+        #
+        # remove the state, traffic drops
+        #
+        route.remove_vpp_config()
+        nbr.remove_vpp_config()
+        self.assertFalse(find_route(self, "10.10.10.0", 24))
+        self.send_and_assert_no_replies(self.pg0, p * NUM_PKTS)
+
+        #
+        # restore it; no ARP is needed before traffic flows again
+        #
+        reply = self.vapi.cli("ip checkpoint restore %s" % self.file)
+        self.logger.info(reply)
+
+        self.assertTrue(find_route(self, "10.10.10.0", 24))
+        self.assertTrue(
+            find_nbr(self, self.pg1.sw_if_index, "172.16.1.100", is_static=1)
+        )
+        rx = self.send_and_expect(self.pg0, p * NUM_PKTS, self.pg1)
+        for r in rx:
+            self.assertEqual(r[Ether].dst, self.pg1.remote_hosts[0].mac)
+
+        #
+        # a restore on top of existing state is idempotent
+        #
+        self.vapi.cli("ip checkpoint restore %s" % self.file)
+        self.send_and_expect(self.pg0, p * NUM_PKTS, self.pg1)
+
+        route.remove_vpp_config()
+        nbr.remove_vpp_config()
+
+    def test_ip_checkpoint_labels(self):
+        """IP checkpoint restore of labeled and unlabeled routes"""
+
+        #
+        # labeled and unlabeled routes, alternating, so that whatever the
+        # walk order an unlabeled route is restored after a labeled one
+        #
+        labels = {
+            "10.10.10.0/24": [44, 45],
+            "10.10.11.0/24": [],
+            "10.10.12.0/24": [46],
+            "10.10.13.0/24": [],
+        }
+        routes = []
+        for pfx, stack in labels.items():
+            addr, plen = pfx.split("/")
+            route = VppIpRoute(
+                self,
+                addr,
+                int(plen),
+                [
+                    VppRoutePath(
+                        self.pg1.remote_ip4,
+                        self.pg1.sw_if_index,
+                        labels=[VppMplsLabel(lbl) for lbl in stack],
+                    )
+                ],
+            )
+            route.add_vpp_config()
+            routes.append(route)
+
+        self.vapi.cli("ip checkpoint save %s" % self.file)
+        for route in routes:
+            route.remove_vpp_config()
+
+        reply = self.vapi.cli("ip checkpoint restore %s" % self.file)
+        self.logger.info(reply)
+
+        found = {}
+        for r in self.vapi.ip_route_dump(0, False):
+            pfx = str(r.route.prefix)
+            if pfx in labels:
+                self.assertEqual(r.route.n_paths, 1)
+                path = r.route.paths[0]
+                found[pfx] = [
+                    path.label_stack[i].label for i in range(path.n_labels)
+                ]
+        self.assertEqual(found, labels)
+
+        for route in routes:
+            route.remove_vpp_config()
+
+    def test_ip_checkpoint_bad_file(self):
+        """IP checkpoint restore of a bad file"""
+
+        with open(self.file, "w") as f:
+            f.write("not a checkpoint")
+
+        reply = self.vapi.cli_return_response(
+            "ip checkpoint restore %s" % self.file
+        )
+        self.assertNotEqual(reply.retval, 0)
+
+
+if __name__ == "__main__":
+    unittest.main(testRunner=VppTestRunner)
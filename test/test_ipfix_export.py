@@ -194,3 +194,41 @@ class TestIpfixExporter(VppTestCase):
         self.verify_exporter_detail(
             exp, IPv4Address(self.pg1.remote_ip4), IPv4Address(self.pg0.local_ip4)
         )
+
+    def test_export_engine(self):
+        """data records are batched and rate limited per exporter"""
+
+        self.vapi.set_ipfix_exporter(
+            collector_address=self.pg1.remote_ip4,
+            src_address=self.pg0.local_ip4,
+            collector_port=4739,
+            path_mtu=1400,
+            template_interval=20,
+        )
+
+        # 42 records of 32 bytes fit in a 1400 byte packet
+        reply = self.vapi.cli("test ipfix-export records 1000 size 32")
+        self.logger.info(reply)
+        self.assertIn("24 packets, 0 records dropped", reply)
+        self.assertIn("clocks/record", reply)
+
+        reply = self.vapi.cli("show ipfix exporter")
+        self.logger.info(reply)
+        self.assertIn("rate-limit none", reply)
+        self.assertIn("24 packets, 1000 records", reply)
+
+        self.vapi.cli(
+            "set ipfix exporter collector %s src %s path-mtu 1400 rate-limit 10"
+            % (self.pg1.remote_ip4, self.pg0.local_ip4)
+        )
+        reply = self.vapi.cli("test ipfix-export records 1000 size 32")
+        self.logger.info(reply)
+        dropped = re.search(r"(\d+) records dropped", reply)
+        self.assertIsNotNone(dropped)
+        self.assertGreater(int(dropped.group(1)), 0)
+        self.assertIn("rate-limit 10 packets/s", self.vapi.cli("show ipfix exporter"))
+
+        self.vapi.cli(
+            "set ipfix exporter collector %s src %s path-mtu 1400 rate-limit 0"
+            % (self.pg1.remote_ip4, self.pg0.local_ip4)
+        )
@@ -1,5 +1,7 @@
 #!/usr/bin/env python3
 
+import os
+import subprocess
 import unittest
 
 from scapy.layers.inet import IP, UDP
@@ -300,6 +302,186 @@ class TestLinuxCP(VppTestCase):
         tun6.unconfig_ip6()
 
 
+NL_TEST_NS = "vpp-test-lcp-nl"
+
+
+def nl_ns_exec(*args, input=None):
+    subprocess.run(
+        ["ip", "netns", "exec", NL_TEST_NS] + list(args),
+        input=input,
+        check=True,
+        text=True,
+    )
+
+
+@unittest.skipUnless(os.geteuid() == 0, "Requires root")
+class TestLinuxCPNetlink(VppTestCase):
+    """Linux Control Plane Netlink"""
+
+    extra_vpp_plugin_config = [
+        "plugin",
+        "linux_cp_plugin.so",
+        "{",
+        "enable",
+        "}",
+        "plugin",
+        "linux_nl_plugin.so",
+        "{",
+        "enable",
+        "}",
+        "plugin",
+        "linux_cp_unittest_plugin.so",
+        "{",
+        "enable",
+        "}",
+    ]
+
+    #
+    # a small receive buffer, so that a route storm overruns it and the
+    # resynchronization is exercised
+    #
+    extra_vpp_punt_config = [
+        "linux-cp",
+        "{",
+        "default",
+        "netns",
+        NL_TEST_NS,
+        "}",
+        "linux-nl",
+        "{",
+        "nl-rx-buffer-size",
+        "16384",
+        "}",
+    ]
+
+    @classmethod
+    def setUpClass(cls):
+        # the scripted netlink source is a veth with ifindex 2 in the
+        # namespace VPP listens to
+        subprocess.run(["ip", "netns", "del", NL_TEST_NS], capture_output=True)
+        subprocess.run(["ip", "netns", "add", NL_TEST_NS], check=True)
+        nl_ns_exec(
+            "ip",
+            "link",
+            "add",
+            "vpp0",
+            "index",
+            "2",
+            "type",
+            "veth",
+            "peer",
+            "name",
+            "vpp1",
+        )
+        nl_ns_exec("ip", "link", "set", "vpp1", "up")
+        nl_ns_exec("ip", "link", "set", "vpp0", "up")
+        super(TestLinuxCPNetlink, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestLinuxCPNetlink, cls).tearDownClass()
+        subprocess.run(["ip", "netns", "del", NL_TEST_NS])
+
+    def setUp(self):
+        super(TestLinuxCPNetlink, self).setUp()
+
+        self.create_pg_interfaces(range(4))
+        for i in self.pg_interfaces:
+            i.admin_up()
+
+        # test pairs get host interface indices from 1, vpp0 is the second
+        self.pairs = [
+            VppLcpPair(self, self.pg0, self.pg1).add_vpp_config(),
+            VppLcpPair(self, self.pg2, self.pg3).add_vpp_config(),
+        ]
+        nl_ns_exec("ip", "addr", "add", "10.10.0.1/24", "dev", "vpp0")
+
+    def tearDown(self):
+        nl_ns_exec("ip", "addr", "flush", "dev", "vpp0")
+        for p in self.pairs:
+            p.remove_vpp_config()
+        for i in self.pg_interfaces:
+            i.admin_down()
+        super(TestLinuxCPNetlink, self).tearDown()
+
+    def nl_counters(self):
+        counters = {}
+        for line in self.vapi.cli("show lcp netlink").splitlines():
+            if line.startswith("messages:"):
+                for c in line[len("messages:") :].split(","):
+                    value, name = c.split()
+                    counters[name] = int(value)
+        return counters
+
+    def fib_prefixes(self):
+        return {
+            str(r.route.prefix)
+            for r in self.vapi.ip_route_dump(0, False)
+            if r.route.n_paths == 1
+            and r.route.paths[0].sw_if_index == self.pg2.sw_if_index
+        }
+
+    def wait_for_routes(self, prefixes, present, timeout=30):
+        for _ in range(int(timeout / 0.2)):
+            fib = self.fib_prefixes()
+            if present and prefixes <= fib:
+                break
+            if not present and not (prefixes & fib):
+                break
+            self.sleep(0.2)
+        if present:
+            self.assertEqual(prefixes - fib, set())
+        else:
+            self.assertEqual(prefixes & fib, set())
+
+    def test_linux_cp_netlink_routes(self):
+        """Linux CP netlink route storm"""
+
+        N_ROUTES = 2000
+        prefixes = {"20.%d.%d.0/24" % (i >> 8, i & 0xFF) for i in range(N_ROUTES)}
+
+        #
+        # every route is added, removed and added again. the FIB must match
+        # the kernel whether the messages were coalesced, or lost to an
+        # overrun and resynchronized
+        #
+        batch = ""
+        for p in sorted(prefixes):
+            route = "%s dev vpp0 proto bgp\n" % p
+            batch += "route add " + route
+            batch += "route del " + route
+            batch += "route add " + route
+        nl_ns_exec("ip", "-batch", "-", input=batch)
+        self.wait_for_routes(prefixes, True)
+
+        # a next-hop replace is reflected
+        nl_ns_exec(
+            "ip", "route", "replace", "20.0.1.0/24", "via", "10.10.0.2", "proto", "bgp"
+        )
+        for _ in range(50):
+            if "10.10.0.2" in self.vapi.cli("show ip fib 20.0.1.0/24"):
+                break
+            self.sleep(0.1)
+        self.assertIn("10.10.0.2", self.vapi.cli("show ip fib 20.0.1.0/24"))
+
+        self.logger.info(self.vapi.cli("show lcp netlink"))
+        counters = self.nl_counters()
+        self.assertGreater(counters["received"], 0)
+
+        # messages discarded by a resynchronization are neither
+        if self.statistics["/linux-cp/netlink/overruns"] == 0:
+            self.assertEqual(
+                counters["received"], counters["applied"] + counters["coalesced"]
+            )
+
+        #
+        # withdraw them all
+        #
+        batch = "".join("route del %s proto bgp\n" % p for p in prefixes)
+        nl_ns_exec("ip", "-batch", "-", input=batch)
+        self.wait_for_routes(prefixes, False)
+
+
 class TestLinuxCPIpsec(TemplateIpsec, TemplateIpsecItf4, IpsecTun4):
     """IPsec Interface IPv4"""
 
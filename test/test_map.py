@@ -363,6 +363,67 @@ class TestMAP(VppTestCase):
         pre_res_route.remove_vpp_config()
         self.vapi.ppcli("map params pre-resolve del ip6-nh 4001::1")
 
+    def test_map_e_domain_cover(self):
+        """MAP-E domain lookup falls back to the covering domain"""
+
+        #
+        # Routes to the MAP-BR and to the 1:1 rule's tunnel endpoint
+        #
+        map_route = VppIpRoute(
+            self,
+            "2001::",
+            32,
+            [VppRoutePath(self.pg1.remote_ip6, self.pg1.sw_if_index)],
+        )
+        map_route.add_vpp_config()
+        rule_route = VppIpRoute(
+            self,
+            "4001::",
+            16,
+            [VppRoutePath(self.pg1.remote_ip6, self.pg1.sw_if_index)],
+        )
+        rule_route.add_vpp_config()
+
+        #
+        # A shared domain and a 1:1 domain for one of its addresses
+        #
+        map_translated_addr = "2001:0:101:7000:0:c0a8:101:7"
+        cover = self.vapi.map_add_domain(
+            ip4_prefix="192.168.0.0/16",
+            ip6_prefix="2001::/32",
+            ip6_src="3000::1/128",
+            ea_bits_len=20,
+            psid_offset=4,
+            psid_length=4,
+        ).index
+        specific = self.vapi.map_add_domain(
+            ip4_prefix="192.168.1.1/32",
+            ip6_prefix="4001::1/128",
+            ip6_src="3000::2/128",
+        ).index
+
+        self.vapi.map_if_enable_disable(
+            is_enable=1, sw_if_index=self.pg0.sw_if_index, is_translation=0
+        )
+
+        v4 = (
+            Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+            / IP(src=self.pg0.remote_ip4, dst="192.168.1.1")
+            / UDP(sport=20000, dport=10000)
+            / Raw(b"\xa5" * 100)
+        )
+
+        # the longest match wins
+        self.send_and_assert_encapped(v4 * 4, "3000::2", "4001::1")
+
+        # once it is gone, the cover takes over its address
+        self.vapi.map_del_domain(index=specific)
+        self.send_and_assert_encapped(v4 * 4, "3000::1", map_translated_addr)
+
+        # and with no domain left, MAP leaves the packets alone
+        self.vapi.map_del_domain(index=cover)
+        self.send_and_assert_no_replies(self.pg0, v4 * 4, "no MAP domain")
+
     def test_map_e_inner_frag(self):
         """MAP-E Inner fragmentation"""
 
@@ -949,6 +1010,86 @@ class TestMAP(VppTestCase):
         p6 = p_ether6 / p_ip6 / payload
         self.send_and_assert_no_replies(self.pg1, p6 * 1)
 
+    def test_map_t_ip6_src_96(self):
+        """MAP-T with a /96 ip6-src"""
+
+        #
+        # The domain is found by the IPv6 address of the BR, looked up in
+        # the ip6-src prefix table. Prefixes other than /64 must match too.
+        #
+        map_dst = "2001:db9::/32"
+        map_src = "1234:5678:90ab:cdef::/96"
+        ip4_pfx = "192.168.1.0/24"
+
+        index = self.vapi.map_add_domain(
+            ip6_prefix=map_dst,
+            ip4_prefix=ip4_pfx,
+            ip6_src=map_src,
+            ea_bits_len=16,
+            psid_offset=6,
+            psid_length=4,
+            mtu=1500,
+        ).index
+
+        self.vapi.map_if_enable_disable(
+            is_enable=1, sw_if_index=self.pg0.sw_if_index, is_translation=1
+        )
+        self.vapi.map_if_enable_disable(
+            is_enable=1, sw_if_index=self.pg1.sw_if_index, is_translation=1
+        )
+
+        map_route = VppIpRoute(
+            self,
+            "2001:db9::",
+            32,
+            [
+                VppRoutePath(
+                    self.pg1.remote_ip6,
+                    self.pg1.sw_if_index,
+                    proto=DpoProto.DPO_PROTO_IP6,
+                )
+            ],
+        )
+        map_route.add_vpp_config()
+
+        # The IPv4 host is embedded in the last 32 bits of the /96
+        br_ip6 = str(
+            ipaddress.IPv6Address(
+                int(ipaddress.IPv6Network(map_src).network_address)
+                | int(ipaddress.IPv4Address(self.pg0.remote_ip4))
+            )
+        )
+        payload = TCP(sport=0xABCD, dport=0xABCD)
+
+        # IPv4 to IPv6
+        p4 = (
+            Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+            / IP(src=self.pg0.remote_ip4, dst="192.168.1.1")
+            / payload
+        )
+        p6_translated = (
+            IPv6(src=br_ip6, dst="2001:db9:1f0::c0a8:101:f", hlim=63) / payload
+        )
+        rx = self.send_and_expect(self.pg0, p4 * 1, self.pg1)
+        for p in rx:
+            self.validate(p[1], p6_translated)
+
+        # IPv6 to IPv4, the domain is found by the /96 BR address
+        p6 = (
+            Ether(dst=self.pg1.local_mac, src=self.pg1.remote_mac)
+            / IPv6(src="2001:db9:1f0::c0a8:101:f", dst=br_ip6)
+            / payload
+        )
+        p4_translated = IP(src="192.168.1.1", dst=self.pg0.remote_ip4) / payload
+        p4_translated.id = 0
+        p4_translated.ttl -= 1
+        rx = self.send_and_expect(self.pg1, p6 * 1, self.pg0)
+        for p in rx:
+            self.validate(p[1], p4_translated)
+
+        map_route.remove_vpp_config()
+        self.vapi.map_del_domain(index=index)
+
     def test_map_t_pre_resolve(self):
         """MAP-T pre-resolve"""
 
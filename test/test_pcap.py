@@ -6,6 +6,11 @@ import unittest
 from framework import VppTestCase, VppTestRunner
 from vpp_ip_route import VppIpTable, VppIpRoute, VppRoutePath
 
+from scapy.layers.inet import IP, UDP
+from scapy.layers.l2 import Ether
+from scapy.packet import Raw
+from scapy.utils import rdpcap
+
 
 class TestPcap(VppTestCase):
     """Pcap Unit Test Cases"""
@@ -86,6 +91,128 @@ class TestPcap(VppTestCase):
         os.remove("/tmp/rxtx.pcap")
         os.remove("/tmp/filt.pcap")
 
+    def test_pcap_stream(self):
+        """PCAP streaming capture with snaplen and file rotation"""
+        self.create_pg_interfaces(range(2))
+        for i in self.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+
+        p = (
+            Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+            / IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4)
+            / UDP(sport=1234, dport=1234)
+            / Raw(b"\xa5" * 200)
+        )
+
+        self.vapi.cli(
+            "pcap trace tx max 1000 intfc pg1 file stream.pcap "
+            "snaplen 64 flush-size 1k rotate-size 4k"
+        )
+        for _ in range(10):
+            self.send_and_expect(self.pg0, p * 10, self.pg1)
+        self.vapi.cli("pcap trace tx off")
+
+        files = [
+            "/tmp/%s" % f for f in os.listdir("/tmp") if f.startswith("stream.pcap")
+        ]
+        self.assertGreater(len(files), 1)
+        n_pkts = 0
+        for f in files:
+            for r in rdpcap(f):
+                self.assertEqual(len(r), 64)
+                n_pkts += 1
+            os.remove(f)
+        self.assertEqual(n_pkts, 100)
+
+        for i in self.pg_interfaces:
+            i.unconfig_ip4()
+            i.admin_down()
+
+    def test_pcap_stream_max(self):
+        """PCAP streaming capture stops at max across flushes"""
+        self.create_pg_interfaces(range(2))
+        for i in self.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+
+        p = (
+            Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+            / IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4)
+            / UDP(sport=1234, dport=1234)
+            / Raw(b"\xa5" * 200)
+        )
+
+        # a flush every few packets, the writer must not restart the count
+        self.vapi.cli("pcap trace tx max 50 intfc pg1 file max.pcap flush-size 1k")
+        for _ in range(10):
+            self.send_and_expect(self.pg0, p * 10, self.pg1)
+            self.sleep(0.05)
+        reply = self.vapi.cli("pcap trace status")
+        self.assertIn("50 of 50 pkts", reply)
+        reply = self.vapi.cli("pcap trace off")
+        self.assertIn("Write 50 packets", reply)
+        self.assertEqual(len(rdpcap("/tmp/max.pcap")), 50)
+        os.remove("/tmp/max.pcap")
+
+        # stop after the writer has flushed everything captured
+        self.vapi.cli("pcap trace tx max 1000 intfc pg1 file off.pcap flush-size 1k")
+        self.send_and_expect(self.pg0, p * 20, self.pg1)
+        self.sleep(0.5)
+        reply = self.vapi.cli("pcap trace off")
+        self.assertIn("Write 20 packets", reply)
+        self.assertEqual(len(rdpcap("/tmp/off.pcap")), 20)
+        os.remove("/tmp/off.pcap")
+
+        for i in self.pg_interfaces:
+            i.unconfig_ip4()
+            i.admin_down()
+
+    def test_dispatch_latency(self):
+        """Dispatch latency tracing"""
+        self.create_pg_interfaces(range(2))
+        for i in self.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+
+        p = (
+            Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+            / IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4)
+            / UDP(sport=1234, dport=1234)
+            / Raw(b"\xa5" * 100)
+        )
+
+        self.vapi.cli("dispatch latency trace on sample 4")
+        self.send_and_expect(self.pg0, p * 64, self.pg1)
+
+        reply = self.vapi.cli("show dispatch latency")
+        self.assertIn("sampling 1 in 4 packets", reply)
+        self.assertIn("ip4-lookup", reply)
+        self.assertIn("ip4-rewrite", reply)
+        # every sample ends when its buffer is freed by the tx node
+        self.assertIn(", 0 alive", reply)
+
+        # the scan process updates the stats segment once a second
+        self.sleep(1.5)
+        buckets = self.statistics.ls(
+            ["^/dispatch-trace/latency/ip4-lookup/ip4-rewrite/lt-"]
+        )
+        self.assertEqual(len(buckets), 32)
+        latency = sum(self.statistics.get_counter(b)[0] for b in buckets)
+        self.assertGreater(latency, 0)
+
+        self.vapi.cli("clear dispatch latency")
+        self.vapi.cli("dispatch latency trace off")
+        reply = self.vapi.cli("show dispatch latency")
+        self.assertNotIn("ip4-lookup", reply)
+
+        for i in self.pg_interfaces:
+            i.unconfig_ip4()
+            i.admin_down()
+
 
 if __name__ == "__main__":
     unittest.main(testRunner=VppTestRunner)
@@ -139,6 +139,30 @@ class StatsClientTestCase(VppTestCase):
         for i in self.lo_interfaces:
             i.remove_vpp_config()
 
+    def test_api_handler_stats(self):
+        """Test API message handler stats"""
+        self.vapi.cli("clear api handler-stats")
+        for _ in range(10):
+            self.vapi.show_version()
+
+        reply = self.vapi.cli("show api handler-stats")
+        self.assertIn("show_version", reply)
+        self.logger.info(reply)
+
+        names = self.statistics.ls([r"^/api/msg/show_version_[0-9a-f]+/calls$"])
+        self.assertEqual(len(names), 1)
+        # allow the collector to run at least once since the calls
+        self.sleep(0.2)
+        self.assertGreaterEqual(self.statistics.get_counter(names[0])[0], 10)
+
+        # the handler time histogram, one counter per bucket
+        buckets = self.statistics.ls(
+            [r"^/api/msg/show_version_[0-9a-f]+/handler-clocks/lt-"]
+        )
+        self.assertEqual(len(buckets), 32)
+        calls = sum(self.statistics.get_counter(b)[0] for b in buckets)
+        self.assertGreaterEqual(calls, 10)
+
     @unittest.skip("Manual only")
     def test_mem_leak(self):
         def loop():
@@ -8,6 +8,10 @@ from config import config
 from framework import VppTestCase, VppTestRunner
 from vpp_ip_route import VppIpTable, VppIpRoute, VppRoutePath
 
+from scapy.layers.inet import IP, UDP
+from scapy.layers.l2 import Ether
+from scapy.packet import Raw
+
 
 @unittest.skipUnless(config.gcov, "part of code coverage tests")
 class TestVlib(VppTestCase):
@@ -220,5 +224,115 @@ class TestVlib(VppTestCase):
                     self.logger.info(cmd + " FAIL retval " + str(r.retval))
 
 
+class TestVlibFrameCoalesce(VppTestCase):
+    """Vlib frame coalescing"""
+
+    vpp_worker_count = 1
+
+    def setUp(self):
+        super(TestVlibFrameCoalesce, self).setUp()
+        self.create_pg_interfaces(range(2))
+        for i in self.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+
+    def tearDown(self):
+        self.vapi.cli("set node coalesce disable")
+        self.vapi.cli("set node coalesce ip4-lookup disable")
+        for i in self.pg_interfaces:
+            i.unconfig_ip4()
+            i.admin_down()
+        super(TestVlibFrameCoalesce, self).tearDown()
+
+    def test_frame_coalesce(self):
+        """Frames held back are dispatched within their budget"""
+        p = (
+            Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+            / IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4)
+            / UDP(sport=1234, dport=1234)
+            / Raw(b"\xa5" * 100)
+        )
+
+        self.vapi.cli("set node coalesce target-vectors 64 max-loops 8 max-usec 500")
+        self.vapi.cli("set node coalesce ip4-lookup")
+        reply = self.vapi.cli("show node coalesce")
+        self.assertIn("target 64 vectors", reply)
+        self.assertIn("ip4-lookup", reply)
+
+        # small bursts, none may be held back for good
+        for _ in range(5):
+            self.send_and_expect(self.pg0, p * 5, self.pg1)
+        # adding nodes reforks the worker graph, held frames are flushed
+        self.vapi.cli("set node coalesce ip4-rewrite")
+        self.pg0.add_stream(p * 5)
+        self.pg_start()
+        self.vapi.cli("loopback create")
+        self.vapi.cli("loopback delete-interface intfc loop0")
+        self.pg1.get_capture(5)
+
+        reply = self.vapi.cli("show node coalesce")
+        self.logger.info(reply)
+        self.assertIn("ip4-rewrite", reply)
+
+        self.vapi.cli("clear node coalesce")
+        self.vapi.cli("set node coalesce disable")
+        self.vapi.cli("set node coalesce ip4-rewrite disable")
+        self.send_and_expect(self.pg0, p * 5, self.pg1)
+        self.assertIn("disabled", self.vapi.cli("show node coalesce"))
+
+
+class TestVlibMemTags(VppTestCase):
+    """Vlib heap allocation tags"""
+
+    extra_vpp_punt_config = ["memory", "{", "tags", "}"]
+
+    def test_mem_tags(self):
+        """Allocations are charged to their tag"""
+        r = self.vapi.cli_return_response("test mem-tags objects 1000 rounds 2")
+        self.assertEqual(r.retval, 0)
+        self.logger.info(r.reply)
+        self.assertIn("tags enabled, tag set", r.reply)
+
+        reply = self.vapi.cli("show memory tags")
+        self.logger.info(reply)
+        self.assertIn("libvnet.so", reply)
+        self.assertIn("unittest-mem-tags", reply)
+
+        self.assertGreater(self.statistics["/mem/tags/bytes"][0].sum(), 0)
+
+
+class TestVlibLargeAlloc(VppTestCase):
+    """Vlib large allocation heaps"""
+
+    extra_vpp_punt_config = [
+        "memory",
+        "{",
+        "large-alloc-threshold",
+        "1M",
+        "large-heap-size",
+        "256M",
+        "}",
+    ]
+
+    def test_large_alloc(self):
+        """Large tables are served from the NUMA local large heap"""
+        r = self.vapi.cli_return_response(
+            "test bihash tlb nitems 200000 nbuckets 65536 search 2"
+        )
+        self.assertEqual(r.retval, 0)
+        self.logger.info(r.reply)
+        self.assertIn("clocks/lookup", r.reply)
+        self.assertIn("large heap numa", r.reply)
+
+        reply = self.vapi.cli("show memory large-heaps")
+        self.logger.info(reply)
+        self.assertIn("Large allocation threshold 1m", reply)
+        self.assertIn("large heap numa", reply)
+
+        self.assertIn("large-alloc", self.vapi.cli("show memory main-heap"))
+        self.assertEqual(self.statistics["/mem/large-alloc-threshold"], 1 << 20)
+
+
 if __name__ == "__main__":
     unittest.main(testRunner=VppTestRunner)